@@ -0,0 +1,67 @@
+#include "async_client.hpp"
+
+#include <charconv>
+
+namespace {
+
+// Ответ из заголовка "...<marker>N..." и N строк за ним; заголовок без
+// marker (сообщение об ошибке) - ответ из одной строки
+size_t counted_lines(std::string_view buffer, std::string_view marker) {
+    size_t header_end = buffer.find('\n');
+    if (header_end == std::string_view::npos) {
+        return SIZE_MAX;
+    }
+    std::string_view header = buffer.substr(0, header_end);
+    size_t found = header.find(marker);
+    if (found == std::string_view::npos) {
+        return 1;
+    }
+    std::string_view digits = header.substr(found + marker.size());
+    size_t count = 0;
+    std::from_chars(digits.data(), digits.data() + digits.size(), count);
+    return 1 + count;
+}
+
+size_t response_lines(std::string_view command, std::string_view buffer) {
+    if (command == "/stats") {
+        // Соединения (2 строки), ступень перегрузки и время в ступенях
+        return 4;
+    }
+    if (command == "/sessions") {
+        // "Active sessions: X, top K by traffic" и K строк по сессиям
+        return counted_lines(buffer, ", top ");
+    }
+    if (command == "/latency") {
+        // "..., commands: N" и N строк по командам; без выборки - одна строка
+        return counted_lines(buffer, ", commands: ");
+    }
+    if (command == "/mget") {
+        // "Values: N" и по строке на ключ
+        return counted_lines(buffer, "Values: ");
+    }
+    return 1;
+}
+
+} // namespace
+
+size_t tcp_response_length(std::string_view command, std::string_view buffer) {
+    size_t lines = response_lines(command, buffer);
+    size_t pos = 0;
+    for (size_t i = 0; i < lines; ++i) {
+        size_t newline = buffer.find('\n', pos);
+        if (newline == std::string_view::npos) {
+            return 0;
+        }
+        pos = newline + 1;
+    }
+    return pos;
+}
+
+bool tcp_pooled_command(std::string_view command) {
+    return command != "/subscribe";
+}
+
+uint64_t async_client_now_ms() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
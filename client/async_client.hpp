@@ -0,0 +1,496 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+enum class AsyncStatus { Ok, Timeout, Error };
+
+struct AsyncResponse {
+    AsyncStatus status = AsyncStatus::Ok;
+    std::string body;
+
+    bool ok() const { return status == AsyncStatus::Ok; }
+};
+
+using ResponseCallback = std::function<void(AsyncResponse&&)>;
+
+struct AsyncClientOptions {
+    size_t pool_size = 4;
+    // Запросов в полёте на одно соединение; остальные ждут в очереди клиента
+    size_t max_pipeline = 16;
+    size_t max_queued = 65536;
+    std::chrono::milliseconds timeout{1000};
+};
+
+// Длина полного ответа на command в начале buffer по TCP, включая
+// завершающий \n; 0 - ответ ещё не дочитан. Ответ /stats занимает четыре
+// строки, /sessions, /latency и /mget - заголовок и столько строк, сколько
+// в нём указано.
+size_t tcp_response_length(std::string_view command, std::string_view buffer);
+
+// Можно ли отправить command по соединению пула. /subscribe нельзя: сервер
+// стал бы присылать в соединение строки "message <topic> ...", не связанные
+// ни с одним запросом, и сдвинул бы сопоставление ответов. Для подписки
+// нужно отдельное соединение (TcpClient).
+bool tcp_pooled_command(std::string_view command);
+
+uint64_t async_client_now_ms();
+
+// Асинхронный клиент с пулом постоянных соединений. Сервер отвечает на
+// запросы по порядку, поэтому ответы сопоставляются с запросами очередью
+// (FIFO) каждого соединения. Клиент не заводит своих потоков: вызывающий
+// добавляет get_fd() в свой цикл событий (EPOLLIN) с таймаутом не больше
+// next_timeout_ms() и вызывает process(); колбэки выполняются внутри
+// process(). Протокол задаёт наследник, как и в ClientBase.
+template <typename Derived>
+class AsyncClientBase {
+protected:
+    struct Pending {
+        std::string command;
+        uint64_t deadline_ms;
+        ResponseCallback callback;
+    };
+
+    struct Connection {
+        int fd = -1;
+        bool connected = false;
+        bool want_write = false;
+        std::deque<Pending> in_flight;
+        std::string output;
+        size_t output_offset = 0;
+        std::string input;
+    };
+
+    struct Queued {
+        std::string message;
+        uint64_t deadline_ms;
+        ResponseCallback callback;
+    };
+
+    int epoll_fd_ = -1;
+    sockaddr_in serv_addr_{};
+    std::string server_ip_;
+    uint16_t port_;
+    AsyncClientOptions options_;
+    std::vector<Connection> connections_;
+    std::deque<Queued> queue_;
+    size_t in_flight_ = 0;
+    std::vector<std::pair<ResponseCallback, AsyncResponse>> completions_;
+
+    Derived& derived() { return static_cast<Derived&>(*this); }
+
+    void complete(ResponseCallback& callback, AsyncStatus status, std::string body = {}) {
+        completions_.emplace_back(std::move(callback), AsyncResponse{status, std::move(body)});
+    }
+
+    void complete_head(Connection& conn, std::string body) {
+        Pending& head = conn.in_flight.front();
+        complete(head.callback, AsyncStatus::Ok, std::move(body));
+        conn.in_flight.pop_front();
+        --in_flight_;
+    }
+
+    // Соединение закрывается вместе со всеми запросами в полёте; новое
+    // откроется при следующей отправке
+    void fail_connection(Connection& conn, AsyncStatus status) {
+        for (auto& pending : conn.in_flight) {
+            complete(pending.callback, status);
+        }
+        in_flight_ -= conn.in_flight.size();
+        conn.in_flight.clear();
+        if (conn.fd != -1) {
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+            close(conn.fd);
+        }
+        conn = Connection{};
+    }
+
+    bool open_connection(Connection& conn) {
+        conn.fd = socket(AF_INET, Derived::PROTOCOL_TYPE | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (conn.fd == -1) {
+            return false;
+        }
+        if (connect(conn.fd, reinterpret_cast<sockaddr*>(&serv_addr_), sizeof(serv_addr_)) == 0) {
+            conn.connected = true;
+        } else if (errno != EINPROGRESS) {
+            close(conn.fd);
+            conn.fd = -1;
+            return false;
+        }
+        derived().configure_socket(conn.fd);
+
+        epoll_event ev{};
+        ev.events = conn.connected ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+        ev.data.u64 = static_cast<uint64_t>(&conn - connections_.data());
+        conn.want_write = !conn.connected;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn.fd, &ev) == -1) {
+            close(conn.fd);
+            conn.fd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    void update_events(Connection& conn, bool want_write) {
+        if (want_write == conn.want_write) {
+            return;
+        }
+        epoll_event ev{};
+        ev.events = want_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(&conn - connections_.data());
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+        conn.want_write = want_write;
+    }
+
+    void flush(Connection& conn) {
+        if (!conn.connected) {
+            return;  // допишем, когда connect завершится
+        }
+        if (!derived().write_pending(conn)) {
+            fail_connection(conn, AsyncStatus::Error);
+            return;
+        }
+        bool pending = conn.output_offset < conn.output.size();
+        if (!pending) {
+            conn.output.clear();
+            conn.output_offset = 0;
+        }
+        update_events(conn, pending);
+    }
+
+    // Наименее загруженное соединение со свободным местом в конвейере
+    Connection* pick_connection() {
+        Connection* best = nullptr;
+        for (auto& conn : connections_) {
+            if (conn.in_flight.size() >= options_.max_pipeline) continue;
+            if (!best || conn.in_flight.size() < best->in_flight.size() ||
+                (conn.fd != -1 && best->fd == -1 && conn.in_flight.size() == best->in_flight.size())) {
+                best = &conn;
+            }
+        }
+        return best;
+    }
+
+    void dispatch_queued() {
+        while (!queue_.empty()) {
+            Connection* conn = pick_connection();
+            if (!conn) {
+                return;
+            }
+            Queued request = std::move(queue_.front());
+            queue_.pop_front();
+
+            if (conn->fd == -1 && !open_connection(*conn)) {
+                complete(request.callback, AsyncStatus::Error);
+                continue;
+            }
+            conn->in_flight.push_back(Pending{derived().command_of(request.message), request.deadline_ms,
+                                              std::move(request.callback)});
+            ++in_flight_;
+            derived().encode(*conn, request.message);
+            flush(*conn);
+        }
+    }
+
+    void handle_event(Connection& conn, uint32_t events) {
+        if (!conn.connected && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            int error = 0;
+            socklen_t len = sizeof(error);
+            getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+            if (error != 0) {
+                fail_connection(conn, AsyncStatus::Error);
+                return;
+            }
+            conn.connected = true;
+            flush(conn);
+            if (conn.fd == -1) return;
+        }
+        if (events & EPOLLIN) {
+            if (!derived().read_responses(conn)) {
+                fail_connection(conn, AsyncStatus::Error);
+                return;
+            }
+        } else if (events & (EPOLLERR | EPOLLHUP)) {
+            fail_connection(conn, AsyncStatus::Error);
+            return;
+        }
+        if (events & EPOLLOUT) {
+            flush(conn);
+        }
+    }
+
+    void expire(uint64_t now) {
+        // Дедлайны растут в порядке постановки, достаточно смотреть в голову.
+        // По TCP ответ застрял в потоке, а по UDP опоздавшая датаграмма
+        // сдвинула бы сопоставление - в обоих случаях соединение заменяется
+        for (auto& conn : connections_) {
+            if (!conn.in_flight.empty() && conn.in_flight.front().deadline_ms <= now) {
+                fail_connection(conn, AsyncStatus::Timeout);
+            }
+        }
+        while (!queue_.empty() && queue_.front().deadline_ms <= now) {
+            complete(queue_.front().callback, AsyncStatus::Timeout);
+            queue_.pop_front();
+        }
+    }
+
+    void run_completions() {
+        // Колбэк может поставить новый запрос: выполняем уже собранные
+        auto completions = std::move(completions_);
+        completions_.clear();
+        for (auto& [callback, response] : completions) {
+            if (callback) callback(std::move(response));
+        }
+    }
+
+public:
+    AsyncClientBase(const std::string& server_ip, uint16_t port, AsyncClientOptions options = {})
+        : server_ip_(server_ip), port_(port), options_(options) {
+        options_.pool_size = std::max<size_t>(options_.pool_size, 1);
+        options_.max_pipeline = std::max<size_t>(options_.max_pipeline, 1);
+
+        serv_addr_.sin_family = AF_INET;
+        serv_addr_.sin_port = htons(port_);
+        if (inet_pton(AF_INET, server_ip_.c_str(), &serv_addr_.sin_addr) <= 0) {
+            throw std::runtime_error("Invalid address: " + server_ip_);
+        }
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ == -1) {
+            throw std::runtime_error("epoll_create1 failed");
+        }
+        connections_.resize(options_.pool_size);
+        for (auto& conn : connections_) {
+            open_connection(conn);
+        }
+    }
+
+    ~AsyncClientBase() {
+        for (auto& conn : connections_) {
+            if (conn.fd != -1) close(conn.fd);
+        }
+        if (epoll_fd_ != -1) close(epoll_fd_);
+    }
+
+    AsyncClientBase(const AsyncClientBase&) = delete;
+    AsyncClientBase& operator=(const AsyncClientBase&) = delete;
+
+    // false - очередь переполнена, колбэк не будет вызван. Команда, которую
+    // пул не поддерживает (tcp_pooled_command), завершается с Error
+    bool request(std::string message, ResponseCallback callback) {
+        if (queue_.size() >= options_.max_queued) {
+            return false;
+        }
+        if (!derived().pooled(message)) {
+            complete(callback, AsyncStatus::Error, "ERROR: Command is not supported on pooled connections");
+            return true;
+        }
+        uint64_t deadline = async_client_now_ms() + static_cast<uint64_t>(options_.timeout.count());
+        queue_.push_back(Queued{std::move(message), deadline, std::move(callback)});
+        dispatch_queued();
+        return true;
+    }
+
+    void process() {
+        epoll_event events[64];
+        int n;
+        while ((n = epoll_wait(epoll_fd_, events, 64, 0)) > 0) {
+            for (int i = 0; i < n; ++i) {
+                Connection& conn = connections_[events[i].data.u64];
+                if (conn.fd != -1) {
+                    handle_event(conn, events[i].events);
+                }
+            }
+            if (n < 64) break;
+        }
+        expire(async_client_now_ms());
+        dispatch_queued();
+        run_completions();
+    }
+
+    // Для использования без своего цикла событий
+    void run_once(int timeout_ms) {
+        int next = next_timeout_ms();
+        if (next >= 0 && (timeout_ms < 0 || next < timeout_ms)) {
+            timeout_ms = next;
+        }
+        epoll_event ev;
+        epoll_wait(epoll_fd_, &ev, 1, timeout_ms);
+        process();
+    }
+
+    int get_fd() const { return epoll_fd_; }
+    size_t pending() const { return in_flight_ + queue_.size() + completions_.size(); }
+
+    // Миллисекунды до ближайшего таймаута; -1 - ждать нечего
+    int next_timeout_ms() const {
+        if (!completions_.empty()) {
+            return 0;
+        }
+        uint64_t deadline = UINT64_MAX;
+        for (const auto& conn : connections_) {
+            if (!conn.in_flight.empty()) deadline = std::min(deadline, conn.in_flight.front().deadline_ms);
+        }
+        if (!queue_.empty()) deadline = std::min(deadline, queue_.front().deadline_ms);
+        if (deadline == UINT64_MAX) {
+            return -1;
+        }
+        uint64_t now = async_client_now_ms();
+        return deadline > now ? static_cast<int>(deadline - now) : 0;
+    }
+
+    // co_await client.async_request("/time") в корутине вызывающего;
+    // выполнение продолжается внутри process()
+    struct RequestAwaiter {
+        AsyncClientBase& client;
+        std::string message;
+        AsyncResponse response;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) {
+            bool queued = client.request(std::move(message), [this, handle](AsyncResponse&& result) {
+                response = std::move(result);
+                handle.resume();
+            });
+            if (!queued) {
+                response.status = AsyncStatus::Error;
+            }
+            return queued;
+        }
+        AsyncResponse await_resume() { return std::move(response); }
+    };
+
+    RequestAwaiter async_request(std::string message) {
+        return RequestAwaiter{*this, std::move(message), {}};
+    }
+};
+
+class AsyncTcpClient : public AsyncClientBase<AsyncTcpClient> {
+public:
+    static constexpr int PROTOCOL_TYPE = SOCK_STREAM;
+
+    using AsyncClientBase::AsyncClientBase;
+
+    void configure_socket(int fd) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    std::string command_of(const std::string& message) {
+        return message.substr(0, message.find_first_of(" \r\n"));
+    }
+
+    bool pooled(const std::string& message) { return tcp_pooled_command(command_of(message)); }
+
+    void encode(Connection& conn, const std::string& message) {
+        conn.output += message;
+        if (message.empty() || message.back() != '\n') {
+            conn.output += '\n';
+        }
+    }
+
+    // false - ошибка соединения; неотправленный остаток ждёт EPOLLOUT
+    bool write_pending(Connection& conn) {
+        while (conn.output_offset < conn.output.size()) {
+            ssize_t sent = send(conn.fd, conn.output.data() + conn.output_offset,
+                                conn.output.size() - conn.output_offset, MSG_NOSIGNAL);
+            if (sent > 0) {
+                conn.output_offset += static_cast<size_t>(sent);
+                continue;
+            }
+            return sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+        return true;
+    }
+
+    bool read_responses(Connection& conn) {
+        char buffer[16384];
+        bool open = true;
+        while (true) {
+            ssize_t bytes_read = recv(conn.fd, buffer, sizeof(buffer), 0);
+            if (bytes_read > 0) {
+                conn.input.append(buffer, static_cast<size_t>(bytes_read));
+                continue;
+            }
+            open = bytes_read == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+        }
+
+        size_t consumed = 0;
+        std::string_view input(conn.input);
+        while (!conn.in_flight.empty()) {
+            size_t length = tcp_response_length(conn.in_flight.front().command, input.substr(consumed));
+            if (length == 0) break;
+            complete_head(conn, std::string(input.substr(consumed, length - 1)));
+            consumed += length;
+        }
+        conn.input.erase(0, consumed);
+        // Ответы, дочитанные до закрытия, уже отданы; данные без ожидающего
+        // запроса означают, что рамки ответов потеряны
+        return open && (conn.input.empty() || !conn.in_flight.empty());
+    }
+};
+
+class AsyncUdpClient : public AsyncClientBase<AsyncUdpClient> {
+public:
+    static constexpr int PROTOCOL_TYPE = SOCK_DGRAM;
+
+    using AsyncClientBase::AsyncClientBase;
+
+    void configure_socket(int) {}
+
+    std::string command_of(const std::string&) { return {}; }
+
+    // По UDP подписок нет: сервер сам ответит ошибкой
+    bool pooled(const std::string&) { return true; }
+
+    // Запросы - строки, поэтому в output они разделены \n, а уходят
+    // отдельными датаграммами без него
+    void encode(Connection& conn, const std::string& message) {
+        size_t length = message.size();
+        while (length > 0 && (message[length - 1] == '\n' || message[length - 1] == '\r')) --length;
+        conn.output.append(message, 0, length);
+        conn.output += '\n';
+    }
+
+    bool write_pending(Connection& conn) {
+        while (conn.output_offset < conn.output.size()) {
+            size_t end = conn.output.find('\n', conn.output_offset);
+            ssize_t sent = send(conn.fd, conn.output.data() + conn.output_offset,
+                                end - conn.output_offset, MSG_NOSIGNAL);
+            if (sent < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            conn.output_offset = end + 1;
+        }
+        return true;
+    }
+
+    bool read_responses(Connection& conn) {
+        char buffer[65536];
+        while (true) {
+            ssize_t bytes_read = recv(conn.fd, buffer, sizeof(buffer), 0);
+            if (bytes_read >= 0) {
+                if (conn.in_flight.empty()) continue;  // опоздавший ответ
+                complete_head(conn, std::string(buffer, static_cast<size_t>(bytes_read)));
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+};
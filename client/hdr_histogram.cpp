@@ -0,0 +1,149 @@
+#include "hdr_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+HdrHistogram::HdrHistogram(uint64_t highest_value, int significant_digits)
+    : highest_value_(std::max<uint64_t>(highest_value, 2)) {
+    significant_digits = std::clamp(significant_digits, 1, 5);
+
+    // Подкорзин достаточно, чтобы различать 2 * 10^digits значений
+    uint64_t largest_single_unit = 2;
+    for (int i = 0; i < significant_digits; ++i) {
+        largest_single_unit *= 10;
+    }
+    unsigned sub_bucket_count_magnitude = 0;
+    while ((1ULL << sub_bucket_count_magnitude) < largest_single_unit) {
+        ++sub_bucket_count_magnitude;
+    }
+    sub_bucket_half_count_magnitude_ = sub_bucket_count_magnitude - 1;
+    sub_bucket_half_count_ = 1ULL << sub_bucket_half_count_magnitude_;
+    uint64_t sub_bucket_count = 1ULL << sub_bucket_count_magnitude;
+    sub_bucket_mask_ = sub_bucket_count - 1;
+
+    size_t bucket_count = 1;
+    uint64_t smallest_untrackable = sub_bucket_count;
+    while (smallest_untrackable <= highest_value_) {
+        ++bucket_count;
+        if (smallest_untrackable > UINT64_MAX / 2) {
+            break;
+        }
+        smallest_untrackable <<= 1;
+    }
+    counts_.assign((bucket_count + 1) * sub_bucket_half_count_, 0);
+}
+
+size_t HdrHistogram::bucket_index(uint64_t value) const {
+    unsigned pow2_ceiling = 64 - static_cast<unsigned>(__builtin_clzll(value | sub_bucket_mask_));
+    return pow2_ceiling - (sub_bucket_half_count_magnitude_ + 1);
+}
+
+size_t HdrHistogram::counts_index(uint64_t value) const {
+    size_t bucket = bucket_index(value);
+    uint64_t sub_bucket = value >> bucket;
+    return ((bucket + 1) << sub_bucket_half_count_magnitude_) + (sub_bucket - sub_bucket_half_count_);
+}
+
+uint64_t HdrHistogram::value_from_index(size_t index) const {
+    long bucket = static_cast<long>(index >> sub_bucket_half_count_magnitude_) - 1;
+    uint64_t sub_bucket = (index & (sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+    if (bucket < 0) {
+        sub_bucket -= sub_bucket_half_count_;
+        bucket = 0;
+    }
+    return sub_bucket << bucket;
+}
+
+uint64_t HdrHistogram::highest_equivalent(uint64_t value) const {
+    size_t bucket = bucket_index(value);
+    uint64_t lowest = (value >> bucket) << bucket;
+    return lowest + (1ULL << bucket) - 1;
+}
+
+void HdrHistogram::record(uint64_t value, uint64_t count) {
+    value = std::min(value, highest_value_);
+    counts_[counts_index(value)] += count;
+    total_count_ += count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void HdrHistogram::merge(const HdrHistogram& other) {
+    size_t size = std::min(counts_.size(), other.counts_.size());
+    for (size_t i = 0; i < size; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    if (other.total_count_ != 0) {
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+}
+
+void HdrHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_count_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+}
+
+double HdrHistogram::mean() const {
+    if (total_count_ == 0) {
+        return 0.0;
+    }
+    // Середина корзины как представитель её значений
+    double sum = 0.0;
+    for_each_bucket([&](uint64_t high, uint64_t count) {
+        size_t bucket = bucket_index(high);
+        double width = static_cast<double>(1ULL << bucket);
+        sum += (static_cast<double>(high) - (width - 1) / 2) * static_cast<double>(count);
+    });
+    return sum / static_cast<double>(total_count_);
+}
+
+uint64_t HdrHistogram::value_at_percentile(double percentile) const {
+    if (total_count_ == 0) {
+        return 0;
+    }
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    uint64_t target = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total_count_)));
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(highest_equivalent(value_from_index(i)), max_);
+        }
+    }
+    return max_;
+}
+
+void HdrHistogram::print_percentiles(std::ostream& out, double scale) const {
+    static constexpr double PERCENTILES[] = {
+        0.0, 10.0, 25.0, 50.0, 75.0, 90.0, 95.0, 99.0, 99.5, 99.9, 99.95, 99.99, 99.999, 100.0};
+
+    out << std::setw(12) << "Value" << std::setw(14) << "Percentile"
+        << std::setw(12) << "TotalCount" << std::setw(18) << "1/(1-Percentile)" << "\n";
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed;
+    for (double percentile : PERCENTILES) {
+        uint64_t value = value_at_percentile(percentile);
+        uint64_t below = 0;
+        for (size_t i = 0; i < counts_.size() && value_from_index(i) <= value; ++i) {
+            below += counts_[i];
+        }
+        out << std::setw(12) << std::setprecision(3) << static_cast<double>(value) / scale
+            << std::setw(14) << std::setprecision(6) << percentile / 100.0
+            << std::setw(12) << below;
+        if (percentile < 100.0) {
+            out << std::setw(18) << std::setprecision(2) << 1.0 / (1.0 - percentile / 100.0);
+        }
+        out << "\n";
+    }
+    out.flags(flags);
+    out << "#[Mean = " << mean() / scale << ", Max = " << static_cast<double>(max()) / scale
+        << ", Total count = " << total_count_ << "]\n";
+}
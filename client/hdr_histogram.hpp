@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Гистограмма в духе HdrHistogram: корзины удваиваются по ширине, а
+// внутри каждой идут линейные подкорзины, поэтому относительная
+// погрешность не превышает 10^-significant_digits на всём диапазоне.
+// Значения выше highest_value записываются как highest_value.
+class HdrHistogram {
+public:
+    static constexpr uint64_t DEFAULT_HIGHEST = 60ULL * 1000 * 1000 * 1000;  // 60 с в нс
+
+    explicit HdrHistogram(uint64_t highest_value = DEFAULT_HIGHEST, int significant_digits = 3);
+
+    void record(uint64_t value, uint64_t count = 1);
+    // Гистограммы должны быть созданы с одинаковыми параметрами
+    void merge(const HdrHistogram& other);
+    void reset();
+
+    uint64_t count() const { return total_count_; }
+    uint64_t min() const { return total_count_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const;
+    uint64_t value_at_percentile(double percentile) const;
+
+    // Непустые корзины по возрастанию: f(верхняя граница корзины, количество)
+    template <typename F>
+    void for_each_bucket(F&& f) const {
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            if (counts_[i] != 0) {
+                f(highest_equivalent(value_from_index(i)), counts_[i]);
+            }
+        }
+    }
+
+    // Таблица процентилей в формате HdrHistogram (Value, Percentile,
+    // TotalCount, 1/(1-Percentile)); значения делятся на scale
+    void print_percentiles(std::ostream& out, double scale) const;
+
+private:
+    size_t bucket_index(uint64_t value) const;
+    size_t counts_index(uint64_t value) const;
+    uint64_t value_from_index(size_t index) const;
+    uint64_t highest_equivalent(uint64_t value) const;
+
+    uint64_t highest_value_;
+    unsigned sub_bucket_half_count_magnitude_;
+    uint64_t sub_bucket_half_count_;
+    uint64_t sub_bucket_mask_;
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
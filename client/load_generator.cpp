@@ -0,0 +1,560 @@
+#include "load_generator.hpp"
+#include "async_client.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t PICK_SEQUENCE = 4096;
+constexpr size_t READ_BUFFER_SIZE = 64 * 1024;
+constexpr uint64_t NS_PER_SEC = 1000000000ULL;
+constexpr time_t PROBE_TIMEOUT_SEC = 2;
+
+uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * NS_PER_SEC + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+bool parse_request(std::string_view name, BenchRequest& request) {
+    request.name = std::string(name);
+    if (name == "time") {
+        request.payload = "/time\n";
+    } else if (name == "stats") {
+        request.payload = "/stats\n";
+    } else if (name.substr(0, 4) == "echo") {
+        size_t size = 16;
+        std::string_view digits = name.substr(4);
+        if (!digits.empty()) {
+            auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), size);
+            if (ec != std::errc() || ptr != digits.data() + digits.size() || size == 0 || size > 60000) {
+                return false;
+            }
+        }
+        request.payload.assign(size, 'x');
+        request.payload += '\n';
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void json_histogram(std::ostream& out, const HdrHistogram& histogram) {
+    static constexpr double PERCENTILES[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+    static constexpr const char* NAMES[] = {"p50", "p90", "p99", "p999", "p9999"};
+
+    out << "{\"count\":" << histogram.count()
+        << ",\"min_ns\":" << histogram.min()
+        << ",\"mean_ns\":" << static_cast<uint64_t>(histogram.mean())
+        << ",\"max_ns\":" << histogram.max();
+    for (size_t i = 0; i < std::size(PERCENTILES); ++i) {
+        out << ",\"" << NAMES[i] << "_ns\":" << histogram.value_at_percentile(PERCENTILES[i]);
+    }
+    out << "}";
+}
+
+} // namespace
+
+bool parse_mix(std::string_view spec, std::vector<BenchRequest>& mix, std::string& error) {
+    mix.clear();
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view item = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+
+        BenchRequest request;
+        size_t colon = item.find(':');
+        if (colon != std::string_view::npos) {
+            std::string_view weight = item.substr(colon + 1);
+            auto [ptr, ec] = std::from_chars(weight.data(), weight.data() + weight.size(), request.weight);
+            if (ec != std::errc() || ptr != weight.data() + weight.size() || request.weight == 0) {
+                error = "invalid weight in mix entry '" + std::string(item) + "'";
+                return false;
+            }
+            item = item.substr(0, colon);
+        }
+        if (!parse_request(item, request)) {
+            error = "unknown mix entry '" + std::string(item) + "' (expected time, stats or echo<N>)";
+            return false;
+        }
+        mix.push_back(std::move(request));
+    }
+    if (mix.empty()) {
+        error = "empty request mix";
+        return false;
+    }
+    return true;
+}
+
+bool probe_response_lines(int fd, std::vector<BenchRequest>& mix, std::string& error) {
+    // Таймаут только на случай молчащего сервера: конец ответа определяет
+    // разбор рамок, как в AsyncTcpClient, а не пауза в потоке
+    timeval timeout{PROBE_TIMEOUT_SEC, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char chunk[4096];
+    for (auto& request : mix) {
+        if (send(fd, request.payload.data(), request.payload.size(), MSG_NOSIGNAL) !=
+            static_cast<ssize_t>(request.payload.size())) {
+            error = "failed to send '" + request.name + "' probe: " + std::strerror(errno);
+            return false;
+        }
+        std::string_view line(request.payload.data(), request.payload.size() - 1);
+        std::string_view command = line.substr(0, line.find(' '));
+
+        std::string reply;
+        size_t length = 0;
+        while ((length = tcp_response_length(command, reply)) == 0) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                error = "no response to '" + request.name + "' probe";
+                return false;
+            }
+            reply.append(chunk, static_cast<size_t>(n));
+        }
+        if (length != reply.size()) {
+            error = "unexpected data after '" + request.name + "' probe reply";
+            return false;
+        }
+        request.response_lines = static_cast<size_t>(std::count(reply.begin(), reply.end(), '\n'));
+    }
+    return true;
+}
+
+LoadGenerator::LoadGenerator(LoadOptions options)
+    : options_(std::move(options)), read_buffer_(READ_BUFFER_SIZE) {
+    options_.connections = std::max<size_t>(options_.connections, 1);
+    options_.pipeline = std::max<size_t>(options_.pipeline, 1);
+    request_latency_.resize(options_.mix.size());
+    request_completed_.resize(options_.mix.size(), 0);
+
+    // Фиксированное зерно: одинаковая последовательность команд от запуска к запуску
+    std::vector<unsigned> weights;
+    for (const auto& request : options_.mix) {
+        weights.push_back(request.weight);
+    }
+    std::mt19937 rng(42);
+    std::discrete_distribution<uint32_t> distribution(weights.begin(), weights.end());
+    picks_.resize(PICK_SEQUENCE);
+    for (auto& pick : picks_) {
+        pick = distribution(rng);
+    }
+}
+
+LoadGenerator::~LoadGenerator() {
+    close_connections();
+}
+
+uint32_t LoadGenerator::pick_request() {
+    uint32_t pick = picks_[next_pick_];
+    next_pick_ = (next_pick_ + 1) % picks_.size();
+    return pick;
+}
+
+bool LoadGenerator::probe_responses(std::string& error) {
+    if (options_.udp) {
+        return true;  // ответ UDP - всегда одна датаграмма
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options_.port);
+    inet_pton(AF_INET, options_.server_ip.c_str(), &addr.sin_addr);
+    if (fd == -1 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        error = "connect to " + options_.server_ip + ":" + std::to_string(options_.port) + " failed: " +
+                std::strerror(errno);
+        if (fd != -1) close(fd);
+        return false;
+    }
+    bool probed = probe_response_lines(fd, options_.mix, error);
+    close(fd);
+    return probed;
+}
+
+bool LoadGenerator::open_connections(std::string& error) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == -1) {
+        error = std::string("epoll_create1: ") + std::strerror(errno);
+        return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options_.port);
+    if (inet_pton(AF_INET, options_.server_ip.c_str(), &addr.sin_addr) <= 0) {
+        error = "Invalid address: " + options_.server_ip;
+        return false;
+    }
+
+    connections_.resize(options_.connections);
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        Connection& conn = connections_[i];
+        conn.fd = socket(AF_INET, (options_.udp ? SOCK_DGRAM : SOCK_STREAM) | SOCK_CLOEXEC, 0);
+        // Для UDP connect() фиксирует адрес сервера и отсекает чужие датаграммы
+        if (conn.fd == -1 || connect(conn.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+            error = "connection " + std::to_string(i) + " failed: " + std::strerror(errno);
+            return false;
+        }
+        if (!options_.udp) {
+            int one = 1;
+            setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        fcntl(conn.fd, F_SETFL, fcntl(conn.fd, F_GETFL, 0) | O_NONBLOCK);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn.fd, &ev) == -1) {
+            error = std::string("epoll_ctl: ") + std::strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+void LoadGenerator::close_connections() {
+    for (auto& conn : connections_) {
+        if (conn.fd != -1) {
+            close(conn.fd);
+            conn.fd = -1;
+        }
+    }
+    if (epoll_fd_ != -1) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+void LoadGenerator::schedule(Connection& conn, uint64_t now) {
+    while (conn.next_due_ns <= now && conn.next_due_ns < end_ns_) {
+        conn.backlog.push_back(conn.next_due_ns);
+        conn.next_due_ns += interval_ns_;
+    }
+}
+
+void LoadGenerator::fill(Connection& conn, uint64_t now) {
+    if (!conn.alive) {
+        return;
+    }
+    bool open_loop = options_.rate > 0;
+    if (open_loop) {
+        schedule(conn, now);
+    }
+
+    size_t queued = 0;
+    while (conn.in_flight.size() < options_.pipeline) {
+        uint64_t start;
+        if (open_loop) {
+            if (conn.backlog.empty()) break;
+            start = conn.backlog.front();
+            conn.backlog.pop_front();
+        } else {
+            if (now >= end_ns_) break;
+            start = now;
+        }
+
+        uint32_t request = pick_request();
+        conn.in_flight.push_back(InFlight{start, request});
+        conn.output += options_.mix[request].payload;
+        ++queued;
+    }
+
+    if (queued > 0) {
+        sent_ += queued;
+        flush(conn);
+    }
+}
+
+void LoadGenerator::flush(Connection& conn) {
+    if (options_.udp) {
+        // Каждый запрос - отдельная датаграмма без завершающего \n
+        size_t offset = conn.output_offset;
+        while (offset < conn.output.size()) {
+            size_t end = conn.output.find('\n', offset);
+            ssize_t n = send(conn.fd, conn.output.data() + offset, end - offset, MSG_NOSIGNAL);
+            if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n == -1) { fail(conn); return; }
+            offset = end + 1;
+        }
+        conn.output_offset = offset;
+    } else {
+        while (conn.output_offset < conn.output.size()) {
+            ssize_t n = send(conn.fd, conn.output.data() + conn.output_offset,
+                             conn.output.size() - conn.output_offset, MSG_NOSIGNAL);
+            if (n > 0) {
+                conn.output_offset += static_cast<size_t>(n);
+                continue;
+            }
+            if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            fail(conn);
+            return;
+        }
+    }
+
+    bool pending = conn.output_offset < conn.output.size();
+    if (!pending) {
+        conn.output.clear();
+        conn.output_offset = 0;
+    }
+    if (pending != conn.want_write) {
+        epoll_event ev{};
+        ev.events = pending ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(&conn - connections_.data());
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+        conn.want_write = pending;
+    }
+}
+
+void LoadGenerator::handle_readable(Connection& conn) {
+    while (conn.alive) {
+        ssize_t n = recv(conn.fd, read_buffer_.data(), read_buffer_.size(), 0);
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) {
+            fail(conn);
+            return;
+        }
+
+        uint64_t now = now_ns();
+        if (options_.udp) {
+            complete(conn, now);
+            continue;
+        }
+
+        const char* data = read_buffer_.data();
+        const char* end = data + n;
+        while ((data = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data))))) {
+            ++data;
+            if (conn.in_flight.empty()) {
+                fail(conn);  // лишний ответ: рамки потеряны
+                return;
+            }
+            if (++conn.lines_seen == options_.mix[conn.in_flight.front().request].response_lines) {
+                conn.lines_seen = 0;
+                complete(conn, now);
+            }
+        }
+    }
+    fill(conn, now_ns());
+}
+
+void LoadGenerator::complete(Connection& conn, uint64_t now) {
+    if (conn.in_flight.empty()) {
+        return;
+    }
+    InFlight done = conn.in_flight.front();
+    conn.in_flight.pop_front();
+
+    // Прогрев не учитывается: и соединения, и сервер ещё разгоняются
+    if (done.start_ns >= measure_start_ns_) {
+        uint64_t latency = now > done.start_ns ? now - done.start_ns : 0;
+        latency_.record(latency);
+        request_latency_[done.request].record(latency);
+        ++request_completed_[done.request];
+        ++completed_;
+    }
+}
+
+void LoadGenerator::expire(Connection& conn, uint64_t now) {
+    uint64_t timeout = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(options_.timeout).count());
+    if (!conn.alive || conn.in_flight.empty() || now - conn.in_flight.front().start_ns < timeout) {
+        return;
+    }
+    if (options_.udp) {
+        // Потерянная датаграмма: следующий ответ относится к следующему запросу
+        ++timeouts_;
+        conn.in_flight.pop_front();
+        fill(conn, now);
+        return;
+    }
+    // По TCP ответ не потерялся, а застрял: соединение дальше не пригодно
+    timeouts_ += conn.in_flight.size();
+    conn.in_flight.clear();
+    fail(conn);
+}
+
+void LoadGenerator::fail(Connection& conn) {
+    if (!conn.alive) {
+        return;
+    }
+    conn.alive = false;
+    errors_ += conn.in_flight.size();
+    conn.in_flight.clear();
+    conn.backlog.clear();
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+    close(conn.fd);
+    conn.fd = -1;
+}
+
+bool LoadGenerator::run(std::string& error) {
+    if (options_.mix.empty()) {
+        error = "empty request mix";
+        return false;
+    }
+    if (!probe_responses(error) || !open_connections(error)) {
+        close_connections();
+        return false;
+    }
+
+    auto to_ns = [](auto duration) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    };
+    uint64_t start = now_ns();
+    measure_start_ns_ = start + to_ns(options_.warmup);
+    end_ns_ = measure_start_ns_ + to_ns(options_.duration);
+    uint64_t drain_end = end_ns_ + to_ns(options_.timeout);
+
+    if (options_.rate > 0) {
+        // Соединения сдвинуты по фазе, чтобы суммарный поток был равномерным
+        interval_ns_ = static_cast<uint64_t>(static_cast<double>(options_.connections) * NS_PER_SEC / options_.rate);
+        interval_ns_ = std::max<uint64_t>(interval_ns_, 1);
+        for (size_t i = 0; i < connections_.size(); ++i) {
+            connections_[i].next_due_ns = start + interval_ns_ * i / connections_.size();
+        }
+    }
+
+    std::vector<epoll_event> events(std::min<size_t>(connections_.size(), 1024));
+    uint64_t last_expire_check = start;
+
+    while (true) {
+        uint64_t now = now_ns();
+        size_t outstanding = 0;
+        uint64_t next_due = UINT64_MAX;
+        for (auto& conn : connections_) {
+            if (now < end_ns_) {
+                fill(conn, now);
+            }
+            outstanding += conn.in_flight.size();
+            if (conn.alive && options_.rate > 0 && conn.next_due_ns < end_ns_) {
+                next_due = std::min(next_due, conn.next_due_ns);
+            }
+        }
+        if (now >= end_ns_ && (outstanding == 0 || now >= drain_end)) {
+            break;
+        }
+
+        if (now - last_expire_check >= NS_PER_SEC / 100) {
+            for (auto& conn : connections_) {
+                expire(conn, now);
+            }
+            last_expire_check = now;
+        }
+
+        // Таймаут до ближайшего запроса по расписанию, но не дольше 10 мс
+        uint64_t wait = NS_PER_SEC / 100;
+        if (next_due != UINT64_MAX) {
+            wait = next_due > now ? std::min(wait, next_due - now) : 0;
+        }
+        timespec timeout{static_cast<time_t>(wait / NS_PER_SEC), static_cast<long>(wait % NS_PER_SEC)};
+        int n = epoll_pwait2(epoll_fd_, events.data(), static_cast<int>(events.size()), &timeout, nullptr);
+        for (int i = 0; i < n; ++i) {
+            Connection& conn = connections_[events[i].data.u64];
+            if (!conn.alive) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                handle_readable(conn);
+                fail(conn);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) flush(conn);
+            if (events[i].events & EPOLLIN) handle_readable(conn);
+        }
+    }
+
+    for (auto& conn : connections_) {
+        timeouts_ += conn.in_flight.size();
+        conn.in_flight.clear();
+    }
+    elapsed_s_ = static_cast<double>(std::min(now_ns(), end_ns_) - measure_start_ns_) / NS_PER_SEC;
+    close_connections();
+    return true;
+}
+
+void LoadGenerator::print_text(std::ostream& out) const {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    double throughput = elapsed_s_ > 0 ? static_cast<double>(completed_) / elapsed_s_ : 0.0;
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "Benchmark: " << (options_.udp ? "udp " : "tcp ") << options_.server_ip << ":" << options_.port
+        << ", " << options_.connections << " connections, pipeline " << options_.pipeline << ", ";
+    if (options_.rate > 0) {
+        out << "open loop at " << options_.rate << " req/s";
+    } else {
+        out << "closed loop";
+    }
+    out << ", " << options_.duration.count() << "s (+" << options_.warmup.count() << "s warmup)\n";
+    out << "Requests: " << completed_ << " completed, " << errors_ << " errors, "
+        << timeouts_ << " timeouts (" << sent_ << " sent)\n";
+    out << "Throughput: " << throughput << " req/s\n";
+    out << "Latency (us): min=" << us(latency_.min())
+        << " p50=" << us(latency_.value_at_percentile(50))
+        << " p90=" << us(latency_.value_at_percentile(90))
+        << " p99=" << us(latency_.value_at_percentile(99))
+        << " p99.9=" << us(latency_.value_at_percentile(99.9))
+        << " p99.99=" << us(latency_.value_at_percentile(99.99))
+        << " max=" << us(latency_.max()) << "\n";
+
+    for (size_t i = 0; i < options_.mix.size(); ++i) {
+        const HdrHistogram& histogram = request_latency_[i];
+        out << "  " << std::left << std::setw(10) << options_.mix[i].name << std::right
+            << " count=" << request_completed_[i]
+            << " p50=" << us(histogram.value_at_percentile(50))
+            << " p99=" << us(histogram.value_at_percentile(99))
+            << " p99.9=" << us(histogram.value_at_percentile(99.9)) << "\n";
+    }
+    out.flags(flags);
+
+    out << "\nPercentile distribution (us):\n";
+    latency_.print_percentiles(out, 1000.0);
+}
+
+void LoadGenerator::write_json(std::ostream& out) const {
+    double throughput = elapsed_s_ > 0 ? static_cast<double>(completed_) / elapsed_s_ : 0.0;
+
+    out << "{\"protocol\":\"" << (options_.udp ? "udp" : "tcp") << "\""
+        << ",\"connections\":" << options_.connections
+        << ",\"pipeline\":" << options_.pipeline
+        << ",\"rate\":" << options_.rate
+        << ",\"duration_s\":" << options_.duration.count()
+        << ",\"warmup_s\":" << options_.warmup.count()
+        << ",\"elapsed_s\":" << elapsed_s_
+        << ",\"sent\":" << sent_
+        << ",\"completed\":" << completed_
+        << ",\"errors\":" << errors_
+        << ",\"timeouts\":" << timeouts_
+        << ",\"throughput_rps\":" << throughput
+        << ",\"latency\":";
+    json_histogram(out, latency_);
+
+    out << ",\"commands\":[";
+    for (size_t i = 0; i < options_.mix.size(); ++i) {
+        out << (i ? "," : "") << "{\"name\":\"" << options_.mix[i].name << "\""
+            << ",\"weight\":" << options_.mix[i].weight
+            << ",\"latency\":";
+        json_histogram(out, request_latency_[i]);
+        out << "}";
+    }
+
+    // Непустые корзины: по ним гистограмму можно восстановить и слить с другими
+    out << "],\"histogram\":[";
+    bool first = true;
+    latency_.for_each_bucket([&](uint64_t value, uint64_t count) {
+        out << (first ? "" : ",") << "[" << value << "," << count << "]";
+        first = false;
+    });
+    out << "]}\n";
+}
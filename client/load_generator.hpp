@@ -0,0 +1,120 @@
+#pragma once
+
+#include "hdr_histogram.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Запрос из смеси нагрузки: time, stats или echo<N> (N байт полезной нагрузки)
+struct BenchRequest {
+    std::string name;
+    std::string payload;
+    unsigned weight = 1;
+    // Сколько строк занимает ответ по TCP; определяется пробным запросом
+    size_t response_lines = 1;
+};
+
+struct LoadOptions {
+    bool udp = false;
+    std::string server_ip;
+    uint16_t port = 0;
+    size_t connections = 16;
+    size_t pipeline = 1;
+    // Суммарная целевая частота запросов в секунду; 0 - замкнутый цикл
+    double rate = 0;
+    std::chrono::seconds duration{10};
+    std::chrono::seconds warmup{1};
+    std::chrono::milliseconds timeout{1000};
+    std::vector<BenchRequest> mix;
+    std::string json_path;
+};
+
+// Формат: "time:1,stats:1,echo64:8" - имя и вес через двоеточие
+bool parse_mix(std::string_view spec, std::vector<BenchRequest>& mix, std::string& error);
+
+// Пробные запросы по подключённому TCP-сокету fd: по одному на запрос смеси,
+// ответ выделяется той же разбивкой, что в AsyncTcpClient, и его число строк
+// записывается в response_lines
+bool probe_response_lines(int fd, std::vector<BenchRequest>& mix, std::string& error);
+
+// Генератор нагрузки: много неблокирующих TCP-соединений или UDP-сокетов в
+// одном epoll-цикле, конвейер до pipeline запросов на соединение.
+// В режиме с заданной частотой время старта каждого запроса берётся из
+// расписания, а не из момента фактической отправки: задержка из-за
+// заполненного конвейера или медленного сервера попадает в гистограмму
+// (поправка на coordinated omission).
+class LoadGenerator {
+public:
+    explicit LoadGenerator(LoadOptions options);
+    ~LoadGenerator();
+
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+    bool run(std::string& error);
+
+    void print_text(std::ostream& out) const;
+    void write_json(std::ostream& out) const;
+
+    const HdrHistogram& latency() const { return latency_; }
+    uint64_t completed() const { return completed_; }
+    uint64_t errors() const { return errors_; }
+    uint64_t timeouts() const { return timeouts_; }
+    double throughput() const { return elapsed_s_ > 0 ? static_cast<double>(completed_) / elapsed_s_ : 0.0; }
+
+private:
+    struct InFlight {
+        uint64_t start_ns;
+        uint32_t request;
+    };
+
+    struct Connection {
+        int fd = -1;
+        bool alive = true;
+        uint64_t next_due_ns = 0;
+        std::deque<uint64_t> backlog;      // запланированные, но не отправленные
+        std::deque<InFlight> in_flight;
+        std::string output;
+        size_t output_offset = 0;
+        bool want_write = false;
+        size_t lines_seen = 0;             // строки текущего ответа по TCP
+    };
+
+    bool probe_responses(std::string& error);
+    bool open_connections(std::string& error);
+    void close_connections();
+
+    void schedule(Connection& conn, uint64_t now);
+    void fill(Connection& conn, uint64_t now);
+    void flush(Connection& conn);
+    void handle_readable(Connection& conn);
+    void complete(Connection& conn, uint64_t now);
+    void expire(Connection& conn, uint64_t now);
+    void fail(Connection& conn);
+    uint32_t pick_request();
+
+    LoadOptions options_;
+    int epoll_fd_ = -1;
+    std::vector<Connection> connections_;
+    std::vector<uint32_t> picks_;          // предвычисленная последовательность запросов
+    size_t next_pick_ = 0;
+    std::vector<char> read_buffer_;
+
+    uint64_t interval_ns_ = 0;
+    uint64_t measure_start_ns_ = 0;
+    uint64_t end_ns_ = 0;
+    double elapsed_s_ = 0;
+
+    uint64_t sent_ = 0;
+    uint64_t completed_ = 0;
+    uint64_t errors_ = 0;
+    uint64_t timeouts_ = 0;
+    HdrHistogram latency_;
+    std::vector<HdrHistogram> request_latency_;
+    std::vector<uint64_t> request_completed_;
+};
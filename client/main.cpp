@@ -1,13 +1,12 @@
 #include "client.hpp"
-#include <iostream>
-#include <string>
-
-#include "client.hpp"
+#include "load_generator.hpp"
+#include <fstream>
 #include <iostream>
 #include <string>
 
 void print_usage() {
     std::cout << "Usage: client <protocol> <server_ip> <port>" << std::endl;
+    std::cout << "       client bench <protocol> <server_ip> <port> [options]" << std::endl;
     std::cout << "Arguments:" << std::endl;
     std::cout << "  protocol  - tcp or udp" << std::endl;
     std::cout << "  server_ip - IP address of the server" << std::endl;
@@ -19,9 +18,104 @@ void print_usage() {
     std::cout << std::endl;
     std::cout << "Once connected, you can send messages interactively." << std::endl;
     std::cout << "Type 'quit' to exit or answer 'n' when asked to continue." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Bench options:" << std::endl;
+    std::cout << "  --connections N  - concurrent connections/sockets (default 16)" << std::endl;
+    std::cout << "  --pipeline N     - requests in flight per connection (default 1)" << std::endl;
+    std::cout << "  --rate R         - total requests/s, open loop; 0 = closed loop (default 0)" << std::endl;
+    std::cout << "  --duration S     - measured seconds (default 10)" << std::endl;
+    std::cout << "  --warmup S       - seconds excluded from results (default 1)" << std::endl;
+    std::cout << "  --timeout MS     - response timeout (default 1000)" << std::endl;
+    std::cout << "  --mix SPEC       - weighted commands, e.g. time:1,stats:1,echo64:8 (default echo16)" << std::endl;
+    std::cout << "  --json FILE      - also write results as JSON ('-' for stdout)" << std::endl;
+    std::cout << "Example:" << std::endl;
+    std::cout << "  client bench tcp 127.0.0.1 8080 --connections 64 --pipeline 4 --rate 50000" << std::endl;
+}
+
+static int run_bench(int argc, char* argv[]) {
+    if (argc < 5) {
+        print_usage();
+        return 1;
+    }
+
+    LoadOptions options;
+    std::string protocol = argv[2];
+    if (protocol != "tcp" && protocol != "udp") {
+        std::cerr << "Error: Invalid protocol. Use 'tcp' or 'udp'" << std::endl;
+        return 1;
+    }
+    options.udp = protocol == "udp";
+    options.server_ip = argv[3];
+
+    std::string mix = "echo16";
+    try {
+        options.port = static_cast<uint16_t>(std::stoi(argv[4]));
+        for (int i = 5; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(arg);
+            }
+            std::string value = argv[++i];
+            if (arg == "--connections") {
+                options.connections = std::stoul(value);
+            } else if (arg == "--pipeline") {
+                options.pipeline = std::stoul(value);
+            } else if (arg == "--rate") {
+                options.rate = std::stod(value);
+            } else if (arg == "--duration") {
+                options.duration = std::chrono::seconds(std::stoul(value));
+            } else if (arg == "--warmup") {
+                options.warmup = std::chrono::seconds(std::stoul(value));
+            } else if (arg == "--timeout") {
+                options.timeout = std::chrono::milliseconds(std::stoul(value));
+            } else if (arg == "--mix") {
+                mix = value;
+            } else if (arg == "--json") {
+                options.json_path = value;
+            } else {
+                throw std::invalid_argument(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Invalid bench arguments" << std::endl;
+        print_usage();
+        return 1;
+    }
+
+    std::string error;
+    if (!parse_mix(mix, options.mix, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    std::string json_path = options.json_path;
+    LoadGenerator generator(std::move(options));
+    if (!generator.run(error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    if (json_path == "-") {
+        generator.write_json(std::cout);
+        return 0;
+    }
+    generator.print_text(std::cout);
+    if (!json_path.empty()) {
+        std::ofstream json(json_path);
+        generator.write_json(json);
+        if (!json) {
+            std::cerr << "Error: failed to write " << json_path << std::endl;
+            return 1;
+        }
+    }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        return run_bench(argc, argv);
+    }
+
     if (argc != 4) {
         print_usage();
         return 1;
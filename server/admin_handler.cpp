@@ -0,0 +1,228 @@
+#include "admin_handler.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+
+namespace {
+
+bool contains_ci(std::string_view haystack, std::string_view needle) {
+    auto it = std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(),
+                          [](char a, char b) {
+                              return std::tolower(static_cast<unsigned char>(a)) ==
+                                     std::tolower(static_cast<unsigned char>(b));
+                          });
+    return it != haystack.end();
+}
+
+} // namespace
+
+AdminHandler::AdminHandler(uint16_t port, EventLoop& event_loop)
+    : port_(port), socket_fd_(-1), event_loop_(event_loop) {}
+
+AdminHandler::~AdminHandler() {
+    stop();
+}
+
+bool AdminHandler::start(int inherited_fd) {
+    body_.reserve(16 * 1024);
+    if (inherited_fd != -1) {
+        socket_fd_ = inherited_fd;
+        int flags = fcntl(socket_fd_, F_GETFL, 0);
+        return flags != -1 && fcntl(socket_fd_, F_SETFL, flags | O_NONBLOCK) != -1;
+    }
+
+    socket_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (socket_fd_ == -1) return false;
+
+    int opt = 1;
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        close(socket_fd_);
+        socket_fd_ = -1;
+        return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port_);
+    addr.sin_addr.s_addr = INADDR_ANY;
+
+    if (bind(socket_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(socket_fd_, 16) < 0) {
+        close(socket_fd_);
+        socket_fd_ = -1;
+        return false;
+    }
+
+    return true;
+}
+
+void AdminHandler::stop() {
+    for (auto& [fd, conn] : connections_) {
+        event_loop_.remove_fd(fd);
+        close(fd);
+    }
+    connections_.clear();
+
+    if (socket_fd_ != -1) {
+        event_loop_.remove_fd(socket_fd_);
+        close(socket_fd_);
+        socket_fd_ = -1;
+    }
+}
+
+void AdminHandler::handle_accept() {
+    while (true) {
+        int client_fd = accept4(socket_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd == -1) {
+            return;
+        }
+
+        auto conn = std::make_unique<Connection>();
+        conn->fd = client_fd;
+        conn->input.reserve(READ_CHUNK);
+
+        if (!event_loop_.add_fd(client_fd, EPOLLIN, [this, client_fd](uint32_t events) {
+                handle_event(client_fd, events);
+            })) {
+            close(client_fd);
+            continue;
+        }
+        connections_[client_fd] = std::move(conn);
+    }
+}
+
+void AdminHandler::handle_event(int fd, uint32_t events) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& conn = *it->second;
+
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        close_connection(fd);
+        return;
+    }
+    if ((events & EPOLLIN) && !handle_read(conn)) {
+        close_connection(fd);
+        return;
+    }
+    if ((events & EPOLLOUT) && !handle_write(conn)) {
+        close_connection(fd);
+    }
+}
+
+bool AdminHandler::handle_read(Connection& conn) {
+    char buffer[READ_CHUNK];
+    while (true) {
+        ssize_t bytes_read = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (bytes_read > 0) {
+            conn.input.append(buffer, static_cast<size_t>(bytes_read));
+            if (conn.input.size() > MAX_REQUEST_SIZE) {
+                conn.input.clear();
+                conn.close_after_write = true;
+                respond(conn, "431 Request Header Fields Too Large", "text/plain", "request too large\n");
+                return handle_write(conn);
+            }
+            continue;
+        }
+        if (bytes_read == 0) {
+            return false;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        return false;
+    }
+
+    process_requests(conn);
+    return handle_write(conn);
+}
+
+void AdminHandler::process_requests(Connection& conn) {
+    size_t header_end;
+    while (!conn.close_after_write && (header_end = conn.input.find("\r\n\r\n")) != std::string::npos) {
+        std::string_view request(conn.input.data(), header_end);
+        std::string_view request_line = request.substr(0, request.find("\r\n"));
+
+        size_t method_end = request_line.find(' ');
+        size_t target_end = request_line.find(' ', method_end + 1);
+        std::string_view method = request_line.substr(0, method_end);
+        std::string_view target = method_end == std::string_view::npos
+            ? std::string_view()
+            : request_line.substr(method_end + 1, target_end - method_end - 1);
+        std::string_view version = target_end == std::string_view::npos
+            ? std::string_view()
+            : request_line.substr(target_end + 1);
+
+        if (version != "HTTP/1.1" || contains_ci(request, "connection: close")) {
+            conn.close_after_write = true;
+        }
+
+        size_t query = target.find('?');
+        std::string_view path = target.substr(0, query);
+
+        if (method != "GET") {
+            respond(conn, "405 Method Not Allowed", "text/plain", "only GET is supported\n");
+        } else if (path == "/metrics" && metrics_renderer_) {
+            body_.clear();
+            metrics_renderer_(body_);
+            respond(conn, "200 OK", "text/plain; version=0.0.4; charset=utf-8", body_);
+        } else if (path == "/trace" && trace_dumper_) {
+            body_ = trace_dumper_();
+            body_.push_back('\n');
+            respond(conn, "200 OK", "text/plain", body_);
+        } else {
+            respond(conn, "404 Not Found", "text/plain", "not found\n");
+        }
+
+        conn.input.erase(0, header_end + 4);
+    }
+}
+
+void AdminHandler::respond(Connection& conn, std::string_view status, std::string_view content_type,
+                           std::string_view body) {
+    char length[24];
+    auto [ptr, ec] = std::to_chars(length, length + sizeof(length), body.size());
+
+    conn.output.append("HTTP/1.1 ").append(status).append("\r\n");
+    conn.output.append("Content-Type: ").append(content_type).append("\r\n");
+    conn.output.append("Content-Length: ").append(length, ptr).append("\r\n");
+    if (conn.close_after_write) {
+        conn.output.append("Connection: close\r\n");
+    }
+    conn.output.append("\r\n").append(body);
+}
+
+bool AdminHandler::handle_write(Connection& conn) {
+    while (conn.output_offset < conn.output.size()) {
+        ssize_t sent = ::send(conn.fd, conn.output.data() + conn.output_offset,
+                              conn.output.size() - conn.output_offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn.output_offset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            event_loop_.modify_fd(conn.fd, EPOLLIN | EPOLLOUT);
+            return true;
+        }
+        return false;
+    }
+
+    if (!conn.output.empty()) {
+        // Буфер сохраняет ёмкость между запросами keep-alive
+        conn.output.clear();
+        conn.output_offset = 0;
+        event_loop_.modify_fd(conn.fd, EPOLLIN);
+    }
+    return !conn.close_after_write;
+}
+
+void AdminHandler::close_connection(int fd) {
+    event_loop_.remove_fd(fd);
+    close(fd);
+    connections_.erase(fd);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "eventloop.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <netinet/in.h>
+
+// Служебный HTTP/1.1-листенер на отдельном порту: отдаёт GET /metrics в
+// формате Prometheus, по GET /trace сбрасывает кольцо трассировки в файл.
+// Работает в том же EventLoop, что и основной трафик, поддерживает
+// keep-alive и неполную запись ответа.
+class AdminHandler {
+public:
+    using MetricsRenderer = std::function<void(std::string&)>;
+    using TraceDumper = std::function<std::string()>;
+
+    AdminHandler(uint16_t port, EventLoop& event_loop);
+    ~AdminHandler();
+
+    bool start(int inherited_fd = -1);
+    void stop();
+    void handle_accept();
+    int get_socket_fd() const { return socket_fd_; }
+
+    void set_metrics_renderer(MetricsRenderer renderer) {
+        metrics_renderer_ = std::move(renderer);
+    }
+
+    void set_trace_dumper(TraceDumper dumper) {
+        trace_dumper_ = std::move(dumper);
+    }
+
+private:
+    static constexpr size_t MAX_REQUEST_SIZE = 8192;
+    static constexpr size_t READ_CHUNK = 2048;
+
+    struct Connection {
+        int fd;
+        std::string input;
+        std::string output;
+        size_t output_offset = 0;
+        bool close_after_write = false;
+    };
+
+    void handle_event(int fd, uint32_t events);
+    bool handle_read(Connection& conn);
+    bool handle_write(Connection& conn);
+    void process_requests(Connection& conn);
+    void respond(Connection& conn, std::string_view status, std::string_view content_type,
+                 std::string_view body);
+    void close_connection(int fd);
+
+    uint16_t port_;
+    int socket_fd_;
+    EventLoop& event_loop_;
+    MetricsRenderer metrics_renderer_;
+    TraceDumper trace_dumper_;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    std::string body_;
+};
@@ -0,0 +1,179 @@
+#include "affinity.hpp"
+
+#include <dirent.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool parse_index(std::string_view text, int limit, int& value) {
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    return ec == std::errc() && ptr == end && value >= 0 && value < limit;
+}
+
+// "0-3,8" - формат и конфигурации, и sysfs cpulist
+bool parse_ranges(std::string_view text, std::vector<int>& cpus) {
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view item = trim(text.substr(0, comma));
+        size_t dash = item.find('-');
+        int first = 0;
+        int last = 0;
+        if (!parse_index(item.substr(0, dash), CPU_SETSIZE, first)) {
+            return false;
+        }
+        last = first;
+        if (dash != std::string_view::npos &&
+            (!parse_index(item.substr(dash + 1), CPU_SETSIZE, last) || last < first)) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+    }
+    return true;
+}
+
+bool read_node_cpus(int node, std::vector<int>& cpus) {
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string line;
+    if (!std::getline(in, line)) {
+        return false;
+    }
+    return parse_ranges(trim(line), cpus);
+}
+
+} // namespace
+
+bool parse_cpu_list(std::string_view text, std::vector<int>& cpus, std::string& error) {
+    std::vector<int> parsed;
+    text = trim(text);
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view item = trim(text.substr(0, comma));
+        if (item.substr(0, 5) == "node:") {
+            int node = 0;
+            if (!parse_index(item.substr(5), 1024, node) || !read_node_cpus(node, parsed)) {
+                error = "unknown NUMA node '" + std::string(item.substr(5)) + "'";
+                return false;
+            }
+        } else if (!parse_ranges(item, parsed)) {
+            error = "invalid CPU list item '" + std::string(item) + "'";
+            return false;
+        }
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+    }
+    std::sort(parsed.begin(), parsed.end());
+    parsed.erase(std::unique(parsed.begin(), parsed.end()), parsed.end());
+    cpus = std::move(parsed);
+    return true;
+}
+
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::string out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            ++j;
+        }
+        if (!out.empty()) {
+            out.push_back(',');
+        }
+        out += std::to_string(cpus[i]);
+        if (j > i) {
+            out.push_back('-');
+            out += std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return out;
+}
+
+int cpu_node(int cpu) {
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        return -1;
+    }
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        std::string_view name(entry->d_name);
+        if (name.substr(0, 4) == "node" && parse_index(name.substr(4), 1024, node)) {
+            break;
+        }
+        node = -1;
+    }
+    closedir(dir);
+    return node;
+}
+
+bool pin_thread(pthread_t thread, const std::vector<int>& cpus, std::string& error) {
+    if (cpus.empty()) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    int rc = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (rc != 0) {
+        error = "cannot pin to CPUs " + format_cpu_list(cpus) + ": " + strerror(rc);
+        return false;
+    }
+    return true;
+}
+
+bool bind_memory_to_node(void* addr, size_t length, int node) {
+#ifdef SYS_mbind
+    constexpr int MPOL_PREFERRED_MODE = 1;
+    constexpr unsigned MPOL_MF_MOVE_FLAG = 1u << 1;
+    if (node < 0 || node >= 64) {
+        return false;
+    }
+    uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(addr) + page - 1) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + length) & ~(page - 1);
+    if (end <= begin) {
+        return false;
+    }
+    unsigned long mask = 1ul << node;
+    // Ядро отбрасывает старший бит maxnode, поэтому +1, как в libnuma
+    return syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED_MODE, &mask,
+                   sizeof(mask) * 8 + 1, MPOL_MF_MOVE_FLAG) == 0;
+#else
+    (void)addr;
+    (void)length;
+    (void)node;
+    return false;
+#endif
+}
+
+bool set_incoming_cpu(int fd, int cpu) {
+#ifdef SO_INCOMING_CPU
+    return setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == 0;
+#else
+    (void)fd;
+    (void)cpu;
+    return false;
+#endif
+}
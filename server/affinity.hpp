@@ -0,0 +1,30 @@
+#pragma once
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Список CPU из конфигурации: "3", "0-3,8", "node:1" (все CPU узла NUMA),
+// элементы через запятую. Пустая строка - пустой список (без привязки).
+bool parse_cpu_list(std::string_view text, std::vector<int>& cpus, std::string& error);
+
+// Список в виде "0-3,8" для журнала
+std::string format_cpu_list(const std::vector<int>& cpus);
+
+// NUMA-узел CPU по sysfs; -1, если ядро узлы не показывает
+int cpu_node(int cpu);
+
+// Привязывает поток к набору CPU; пустой набор ничего не меняет
+bool pin_thread(pthread_t thread, const std::vector<int>& cpus, std::string& error);
+
+// mbind(MPOL_PREFERRED) с переносом уже занятых страниц для целых страниц
+// внутри [addr, addr + length). false - ядро без NUMA или mbind недоступен,
+// тогда память остаётся там, где её впервые тронули.
+bool bind_memory_to_node(void* addr, size_t length, int node);
+
+// SO_INCOMING_CPU: при SO_REUSEPORT ядро отдаёт соединение сокету, чей CPU
+// совпадает с CPU, обработавшим пакет
+bool set_incoming_cpu(int fd, int cpu);
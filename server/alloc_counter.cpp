@@ -0,0 +1,56 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> total_allocations{0};
+std::atomic<uint64_t> total_bytes{0};
+thread_local uint64_t local_allocations = 0;
+
+void* counted_malloc(size_t size) noexcept {
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    total_bytes.fetch_add(size, std::memory_order_relaxed);
+    ++local_allocations;
+    return std::malloc(size ? size : 1);
+}
+
+} // namespace
+
+AllocationStats allocation_stats() {
+    return AllocationStats{total_allocations.load(std::memory_order_relaxed),
+                           total_bytes.load(std::memory_order_relaxed)};
+}
+
+uint64_t thread_allocations() {
+    return local_allocations;
+}
+
+void* operator new(size_t size) {
+    void* p = counted_malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    void* p = counted_malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return counted_malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return counted_malloc(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// Счётчики operator new: alloc_counter.cpp подменяет глобальные
+// operator new/delete во всём бинарнике, с которым собран
+struct AllocationStats {
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+// Все потоки процесса
+AllocationStats allocation_stats();
+// Только текущий поток: разница до и после участка кода показывает,
+// обращался ли он к куче
+uint64_t thread_allocations();
@@ -0,0 +1,19 @@
+#include "arena.hpp"
+
+RequestArena::RequestArena(size_t size)
+    : buffer_(std::make_unique<std::byte[]>(size))
+    , monotonic_(buffer_.get(), size, &upstream_) {}
+
+void RequestArena::reset() {
+    if (used_ == 0) {
+        return;
+    }
+    if (used_ > high_water_.load(std::memory_order_relaxed)) {
+        high_water_.store(used_, std::memory_order_relaxed);
+    }
+    bump<uint64_t>(bytes_, used_);
+    bump<uint64_t>(resets_, 1);
+    used_ = 0;
+    // Возвращает блоки из кучи и снова начинает с начала буфера
+    monotonic_.release();
+}
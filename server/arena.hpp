@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+// Арена для временных данных одной итерации цикла событий: ответы команд и
+// промежуточные строки берутся сдвигом указателя в заранее выделенном
+// буфере, а после итерации арена целиком сбрасывается. Если итерации не
+// хватило буфера, остаток берётся из кучи и возвращается при сбросе -
+// такие случаи считаются в overflows. Принадлежит потоку реактора, счётчики
+// можно читать из любого потока.
+class RequestArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t DEFAULT_SIZE = 256 * 1024;
+
+    struct Stats {
+        uint64_t resets;
+        uint64_t bytes;
+        uint64_t overflows;
+        size_t high_water;
+        // operator new за время обработки запросов этого реактора
+        uint64_t request_allocations;
+    };
+
+    explicit RequestArena(size_t size = DEFAULT_SIZE);
+
+    // Всё, что выделено из арены, становится недействительным
+    void reset();
+
+    size_t used() const { return used_; }
+    Stats stats() const {
+        return Stats{resets_.load(std::memory_order_relaxed), bytes_.load(std::memory_order_relaxed),
+                     upstream_.allocations.load(std::memory_order_relaxed),
+                     high_water_.load(std::memory_order_relaxed),
+                     request_allocations_.load(std::memory_order_relaxed)};
+    }
+    void add_request_allocations(uint64_t count) {
+        if (count != 0) {
+            bump(request_allocations_, count);
+        }
+    }
+
+private:
+    // Куча за пределами буфера; monotonic_buffer_resource отдаёт ей блоки
+    // обратно только при сбросе
+    // Пишет только поток-владелец
+    template <typename T>
+    static void bump(std::atomic<T>& counter, T value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    struct Upstream : std::pmr::memory_resource {
+        std::atomic<uint64_t> allocations{0};
+
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            bump<uint64_t>(allocations, 1);
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        used_ += bytes;
+        return monotonic_.allocate(bytes, alignment);
+    }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+
+    std::unique_ptr<std::byte[]> buffer_;
+    Upstream upstream_;
+    std::pmr::monotonic_buffer_resource monotonic_;
+    size_t used_ = 0;
+    std::atomic<size_t> high_water_{0};
+    std::atomic<uint64_t> resets_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> request_allocations_{0};
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Буферы под хвосты незавершённых строк. Соединение берёт буфер, только
+// пока у него есть неразобранные данные, и возвращает его, как только
+// хвост дочитан, поэтому простаивающее соединение не держит памяти в куче.
+// Пул принадлежит потоку реактора (local()), блокировки не нужны.
+class BufferPool {
+public:
+    using Buffer = std::unique_ptr<std::string>;
+
+    static constexpr size_t MAX_FREE = 256;
+    // Разросшиеся буферы не возвращаются: пул не должен копить пики
+    static constexpr size_t MAX_POOLED_CAPACITY = 64 * 1024;
+
+    Buffer acquire() {
+        if (free_.empty()) {
+            return std::make_unique<std::string>();
+        }
+        Buffer buffer = std::move(free_.back());
+        free_.pop_back();
+        return buffer;
+    }
+
+    void release(Buffer buffer) {
+        if (!buffer || free_.size() >= MAX_FREE || buffer->capacity() > MAX_POOLED_CAPACITY) {
+            return;
+        }
+        buffer->clear();
+        free_.push_back(std::move(buffer));
+    }
+
+    size_t free_count() const { return free_.size(); }
+
+    static BufferPool& local() {
+        static thread_local BufferPool pool;
+        return pool;
+    }
+
+private:
+    std::vector<Buffer> free_;
+};
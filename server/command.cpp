@@ -1,29 +1,313 @@
 #include "command.hpp"
 
-std::string TimeCommand::execute() {
+#include <algorithm>
+#include <charconv>
+#include <type_traits>
+
+namespace {
+
+void append_part(Response& out, std::string_view text) {
+    out.append(text);
+}
+
+template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+void append_part(Response& out, T value) {
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, end);
+}
+
+// Ответ из частей (строки и целые), собранный в арене запроса
+template <typename... Parts>
+Response reply(const CommandContext& ctx, const Parts&... parts) {
+    Response out(ctx.arena);
+    (append_part(out, parts), ...);
+    return out;
+}
+
+// Следующее слово аргументов; args сдвигается за него
+std::string_view next_token(std::string_view& args) {
+    size_t begin = args.find_first_not_of(' ');
+    if (begin == std::string_view::npos) {
+        args = {};
+        return {};
+    }
+    args.remove_prefix(begin);
+    size_t end = args.find(' ');
+    std::string_view token = args.substr(0, end);
+    args.remove_prefix(end == std::string_view::npos ? args.size() : end);
+    return token;
+}
+
+template <typename T>
+bool parse_integer(std::string_view text, T& value) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+// Ответ /get и /mget на отсутствующий ключ; /set не принимает его как значение
+constexpr std::string_view MISSING_VALUE = "(nil)";
+
+const char* kv_error(KvStore::Result result) {
+    switch (result) {
+        case KvStore::Result::Full: return "ERROR: Key limit reached";
+        case KvStore::Result::NotInteger: return "ERROR: Value is not an integer";
+        case KvStore::Result::Overflow: return "ERROR: Increment would overflow";
+        default: return "";
+    }
+}
+
+} // namespace
+
+Response TimeCommand::execute(const CommandContext& ctx) {
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
     
     std::tm local_tm{};
     localtime_r(&time_t, &local_tm);
     
-    std::ostringstream oss;
-    oss << std::put_time(&local_tm, "%Y-%m-%d %H:%M:%S");
-    
-    return oss.str();
+    char buffer[32];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local_tm);
+    return reply(ctx, std::string_view(buffer, length));
 }
 
-StatsCommand::StatsCommand(SessionManager& session_manager) 
-    : session_manager_(session_manager) {}
+StatsCommand::StatsCommand(SessionManager& session_manager, const OverloadController* overload)
+    : session_manager_(session_manager), overload_(overload) {}
 
-std::string StatsCommand::execute() {
+Response StatsCommand::execute(const CommandContext& ctx) {
     auto stats = session_manager_.get_stats();
-    std::ostringstream oss;
-    oss << "Total connections: " << stats.total_connections << "\n"
-        << "Current connections: " << stats.current_connections;
-    return oss.str();
+    Response out = reply(ctx, "Total connections: ", stats.total_connections, "\n",
+                         "Current connections: ", stats.current_connections);
+    // Число строк постоянно (STATS_LINES): по нему клиенты разбирают поток ответов
+    if (!overload_) {
+        append_part(out, "\nOverload state: off\nOverload time (ms): -");
+        return out;
+    }
+    auto time = overload_->time_in_state_ns();
+    append_part(out, "\nOverload state: ");
+    append_part(out, overload_state_name(overload_->state()));
+    append_part(out, "\nOverload time (ms):");
+    for (size_t i = 0; i < OVERLOAD_STATE_COUNT; ++i) {
+        append_part(out, " ");
+        append_part(out, overload_state_name(static_cast<OverloadState>(i)));
+        append_part(out, "=");
+        append_part(out, time[i] / 1000000);
+    }
+    return out;
+}
+
+Response ShutdownCommand::execute(const CommandContext& ctx) {
+    return reply(ctx, "/SHUTDOWN_ACK");
 }
 
-std::string ShutdownCommand::execute() {
-    return "/SHUTDOWN_ACK";
-}
\ No newline at end of file
+SessionsCommand::SessionsCommand(SessionManager& session_manager)
+    : session_manager_(session_manager) {}
+
+Response SessionsCommand::execute(const CommandContext& ctx) {
+    SessionTable::Order order = SessionTable::Order::Traffic;
+    size_t limit = DEFAULT_LIMIT;
+
+    std::string_view args = ctx.args;
+    for (std::string_view token = next_token(args); !token.empty(); token = next_token(args)) {
+        if (token == "traffic") {
+            order = SessionTable::Order::Traffic;
+        } else if (token == "idle") {
+            order = SessionTable::Order::Idle;
+        } else {
+            size_t value = 0;
+            if (!parse_integer(token, value) || value == 0) {
+                return reply(ctx, "ERROR: Usage: /sessions [traffic|idle] [N]");
+            }
+            limit = std::min(value, MAX_LIMIT);
+        }
+    }
+
+    const SessionTable& table = session_manager_.sessions();
+    auto sessions = table.top(order, limit);
+
+    Response out = reply(ctx, "Active sessions: ", table.active(), ", top ", sessions.size(), " by ",
+                         order == SessionTable::Order::Traffic ? "traffic" : "idle");
+    for (const auto& session : sessions) {
+        out.append(reply(ctx, "\n", session.peer,
+                         " bytes_in=", session.bytes_in,
+                         " bytes_out=", session.bytes_out,
+                         " msgs_in=", session.messages_in,
+                         " msgs_out=", session.messages_out,
+                         " age=", std::chrono::duration_cast<std::chrono::seconds>(session.age).count(), "s",
+                         " idle=", std::chrono::duration_cast<std::chrono::milliseconds>(session.idle).count(), "ms"));
+    }
+    return out;
+}
+
+LatencyCommand::LatencyCommand(Report report)
+    : report_(std::move(report)) {}
+
+Response LatencyCommand::execute(const CommandContext& ctx) {
+    std::string_view args = ctx.args;
+    return reply(ctx, report_(next_token(args)));
+}
+
+SubscribeCommand::SubscribeCommand(SessionManager& session_manager)
+    : session_manager_(session_manager) {}
+
+Response SubscribeCommand::execute(const CommandContext& ctx) {
+    if (!ctx.subscriber) {
+        return reply(ctx, "ERROR: /subscribe requires a TCP connection");
+    }
+    std::string_view topic = ctx.args;
+    if (!TopicRegistry::valid_topic(topic)) {
+        return reply(ctx, "ERROR: Usage: /subscribe <topic>");
+    }
+    switch (session_manager_.topics().subscribe(topic, ctx.subscriber)) {
+        case TopicRegistry::Result::AlreadySubscribed:
+            return reply(ctx, "ERROR: Already subscribed to '", topic, "'");
+        case TopicRegistry::Result::TooMany:
+            return reply(ctx, "ERROR: Too many subscriptions (max ",
+                         TopicRegistry::MAX_TOPICS_PER_SUBSCRIBER, ")");
+        default:
+            return reply(ctx, "Subscribed to '", topic, "'");
+    }
+}
+
+UnsubscribeCommand::UnsubscribeCommand(SessionManager& session_manager)
+    : session_manager_(session_manager) {}
+
+Response UnsubscribeCommand::execute(const CommandContext& ctx) {
+    if (!ctx.subscriber) {
+        return reply(ctx, "ERROR: /unsubscribe requires a TCP connection");
+    }
+    if (ctx.args.empty()) {
+        size_t removed = session_manager_.topics().unsubscribe_all(ctx.subscriber);
+        return reply(ctx, "Unsubscribed from ", removed, " topics");
+    }
+    std::string_view topic = ctx.args;
+    if (session_manager_.topics().unsubscribe(topic, ctx.subscriber) != TopicRegistry::Result::Ok) {
+        return reply(ctx, "ERROR: Not subscribed to '", topic, "'");
+    }
+    return reply(ctx, "Unsubscribed from '", topic, "'");
+}
+
+PublishCommand::PublishCommand(SessionManager& session_manager)
+    : session_manager_(session_manager) {}
+
+Response PublishCommand::execute(const CommandContext& ctx) {
+    size_t space = ctx.args.find(' ');
+    if (space == std::string_view::npos || space + 1 == ctx.args.size()) {
+        return reply(ctx, "ERROR: Usage: /publish <topic> <message>");
+    }
+    std::string_view topic = ctx.args.substr(0, space);
+    if (!TopicRegistry::valid_topic(topic)) {
+        return reply(ctx, "ERROR: Usage: /publish <topic> <message>");
+    }
+    size_t delivered = session_manager_.topics().publish(topic, ctx.args.substr(space + 1));
+    return reply(ctx, "Published to ", delivered, " subscribers");
+}
+
+
+SetCommand::SetCommand(KvStore& store)
+    : store_(store) {}
+
+Response SetCommand::execute(const CommandContext& ctx) {
+    std::string_view args = ctx.args;
+    std::string_view key = next_token(args);
+    size_t begin = args.find_first_not_of(' ');
+    if (!KvStore::valid_key(key) || begin == std::string_view::npos) {
+        return reply(ctx, "ERROR: Usage: /set <key> <value> [EX <seconds>]");
+    }
+    std::string_view value = args.substr(begin);
+
+    // EX - только два последних слова: " EX " внутри значения остаётся его частью
+    uint64_t ttl_seconds = 0;
+    size_t last = value.rfind(' ');
+    size_t ex = last == std::string_view::npos ? last : value.substr(0, last).rfind(' ');
+    if (ex != std::string_view::npos && value.substr(ex + 1, last - ex - 1) == "EX") {
+        if (!parse_integer(value.substr(last + 1), ttl_seconds) || ttl_seconds == 0 ||
+            ttl_seconds > MAX_TTL_SECONDS) {
+            return reply(ctx, "ERROR: Usage: /set <key> <value> [EX <seconds>]");
+        }
+        value = value.substr(0, ex);
+    }
+    if (value == MISSING_VALUE) {
+        return reply(ctx, "ERROR: Value (nil) is reserved for missing keys");
+    }
+
+    KvStore::Result result = store_.set(key, value, ttl_seconds * 1000);
+    return reply(ctx, result == KvStore::Result::Ok ? "OK" : kv_error(result));
+}
+
+GetCommand::GetCommand(KvStore& store)
+    : store_(store) {}
+
+Response GetCommand::execute(const CommandContext& ctx) {
+    if (!KvStore::valid_key(ctx.args)) {
+        return reply(ctx, "ERROR: Usage: /get <key>");
+    }
+    Response value(ctx.arena);
+    if (!store_.get(ctx.args, value)) {
+        value.assign(MISSING_VALUE);
+    }
+    return value;
+}
+
+DelCommand::DelCommand(KvStore& store)
+    : store_(store) {}
+
+Response DelCommand::execute(const CommandContext& ctx) {
+    std::string_view args = ctx.args;
+    size_t deleted = 0;
+    size_t keys = 0;
+    for (std::string_view key = next_token(args); !key.empty(); key = next_token(args), ++keys) {
+        if (!KvStore::valid_key(key)) {
+            return reply(ctx, "ERROR: Usage: /del <key> [key...]");
+        }
+        deleted += store_.del(key) ? 1 : 0;
+    }
+    if (keys == 0) {
+        return reply(ctx, "ERROR: Usage: /del <key> [key...]");
+    }
+    return reply(ctx, deleted);
+}
+
+IncrCommand::IncrCommand(KvStore& store)
+    : store_(store) {}
+
+Response IncrCommand::execute(const CommandContext& ctx) {
+    std::string_view args = ctx.args;
+    std::string_view key = next_token(args);
+    std::string_view delta_text = next_token(args);
+    int64_t delta = 1;
+    if (!KvStore::valid_key(key) || !next_token(args).empty() ||
+        (!delta_text.empty() && !parse_integer(delta_text, delta))) {
+        return reply(ctx, "ERROR: Usage: /incr <key> [delta]");
+    }
+
+    int64_t value = 0;
+    KvStore::Result result = store_.incr(key, delta, value);
+    return result == KvStore::Result::Ok ? reply(ctx, value) : reply(ctx, kv_error(result));
+}
+
+MgetCommand::MgetCommand(KvStore& store)
+    : store_(store) {}
+
+Response MgetCommand::execute(const CommandContext& ctx) {
+    // Сначала проверяем ключи: заголовок с их числом идёт перед значениями
+    std::string_view args = ctx.args;
+    size_t keys = 0;
+    for (std::string_view key = next_token(args); !key.empty(); key = next_token(args)) {
+        if (!KvStore::valid_key(key) || ++keys > MAX_KEYS) {
+            return reply(ctx, "ERROR: Usage: /mget <key> [key...] (up to ", MAX_KEYS, " keys)");
+        }
+    }
+    if (keys == 0) {
+        return reply(ctx, "ERROR: Usage: /mget <key> [key...]");
+    }
+
+    args = ctx.args;
+    Response response = reply(ctx, "Values: ", keys);
+    Response value(ctx.arena);
+    for (std::string_view key = next_token(args); !key.empty(); key = next_token(args)) {
+        response.push_back('\n');
+        response.append(store_.get(key, value) ? std::string_view(value) : MISSING_VALUE);
+    }
+    return response;
+}
@@ -1,38 +1,185 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <memory>
+#include <memory_resource>
+#include <functional>
+#include "kv_store.hpp"
+#include "overload.hpp"
 #include "session_manager.hpp"
 #include <chrono>
-#include <sstream>
-#include <iomanip>
 #include <ctime>
 
+// Ответ команды живёт до конца итерации цикла событий и выделяется из её
+// арены (CommandContext::arena)
+using Response = std::pmr::string;
+
+struct CommandContext {
+    std::string_view args;
+    // Соединение, которое может получать /publish; nullptr для UDP
+    Subscriber* subscriber = nullptr;
+    std::pmr::memory_resource* arena = std::pmr::get_default_resource();
+};
+
+// При перегрузке (OverloadState::Shed) команды ниже Normal отклоняются
+enum class CommandPriority { Low, Normal, Critical };
+
 class Command {
 public:
     virtual ~Command() = default;
     virtual std::string name() const = 0;
-    virtual std::string execute() = 0;
+    virtual Response execute(const CommandContext& ctx) = 0;
+    virtual CommandPriority priority() const { return CommandPriority::Normal; }
 };
 
 class TimeCommand : public Command {
 public:
     std::string name() const override { return "time"; }
-    std::string execute() override;
+    Response execute(const CommandContext& ctx) override;
 };
 
+// /stats - всегда STATS_LINES строк: соединения, ступень перегрузки и
+// время в каждой (без overload - "off")
 class StatsCommand : public Command {
 public:
-    explicit StatsCommand(SessionManager& session_manager);
+    static constexpr size_t STATS_LINES = 4;
+
+    explicit StatsCommand(SessionManager& session_manager, const OverloadController* overload = nullptr);
     std::string name() const override { return "stats"; }
-    std::string execute() override;
+    Response execute(const CommandContext& ctx) override;
+    CommandPriority priority() const override { return CommandPriority::Critical; }
 
 private:
     SessionManager& session_manager_;
+    const OverloadController* overload_;
 };
 
 class ShutdownCommand : public Command {
 public:
     std::string name() const override { return "shutdown"; }
-    std::string execute() override;
-};
\ No newline at end of file
+    Response execute(const CommandContext& ctx) override;
+    CommandPriority priority() const override { return CommandPriority::Critical; }
+};
+
+// /sessions [traffic|idle] [N] - топ-N клиентов по трафику или времени простоя
+class SessionsCommand : public Command {
+public:
+    static constexpr size_t DEFAULT_LIMIT = 10;
+    static constexpr size_t MAX_LIMIT = 100;
+
+    explicit SessionsCommand(SessionManager& session_manager);
+    std::string name() const override { return "sessions"; }
+    Response execute(const CommandContext& ctx) override;
+    CommandPriority priority() const override { return CommandPriority::Low; }
+
+private:
+    SessionManager& session_manager_;
+};
+
+// /latency [command] - p50/p99 этапов запросов из выборки (latency_sample_rate)
+class LatencyCommand : public Command {
+public:
+    using Report = std::function<std::string(std::string_view command)>;
+
+    explicit LatencyCommand(Report report);
+    std::string name() const override { return "latency"; }
+    Response execute(const CommandContext& ctx) override;
+
+private:
+    Report report_;
+};
+
+// /subscribe <topic> - получать сообщения темы в это TCP-соединение
+class SubscribeCommand : public Command {
+public:
+    explicit SubscribeCommand(SessionManager& session_manager);
+    std::string name() const override { return "subscribe"; }
+    Response execute(const CommandContext& ctx) override;
+
+private:
+    SessionManager& session_manager_;
+};
+
+// /unsubscribe [topic] - без аргумента отписывает от всех тем
+class UnsubscribeCommand : public Command {
+public:
+    explicit UnsubscribeCommand(SessionManager& session_manager);
+    std::string name() const override { return "unsubscribe"; }
+    Response execute(const CommandContext& ctx) override;
+
+private:
+    SessionManager& session_manager_;
+};
+
+// /publish <topic> <message> - разослать подписчикам "message <topic> <message>"
+class PublishCommand : public Command {
+public:
+    explicit PublishCommand(SessionManager& session_manager);
+    std::string name() const override { return "publish"; }
+    Response execute(const CommandContext& ctx) override;
+
+private:
+    SessionManager& session_manager_;
+};
+
+// /set <key> <value> [EX <seconds>] - значение - остаток строки; EX
+// распознаётся только в двух последних словах, "(nil)" - не значение
+class SetCommand : public Command {
+public:
+    static constexpr uint64_t MAX_TTL_SECONDS = 10ULL * 365 * 86400;
+
+    explicit SetCommand(KvStore& store);
+    std::string name() const override { return "set"; }
+    Response execute(const CommandContext& ctx) override;
+
+private:
+    KvStore& store_;
+};
+
+// /get <key> - значение или "(nil)"
+class GetCommand : public Command {
+public:
+    explicit GetCommand(KvStore& store);
+    std::string name() const override { return "get"; }
+    Response execute(const CommandContext& ctx) override;
+
+private:
+    KvStore& store_;
+};
+
+// /del <key> [key...] - число удалённых ключей
+class DelCommand : public Command {
+public:
+    explicit DelCommand(KvStore& store);
+    std::string name() const override { return "del"; }
+    Response execute(const CommandContext& ctx) override;
+
+private:
+    KvStore& store_;
+};
+
+// /incr <key> [delta] - новое значение счётчика
+class IncrCommand : public Command {
+public:
+    explicit IncrCommand(KvStore& store);
+    std::string name() const override { return "incr"; }
+    Response execute(const CommandContext& ctx) override;
+
+private:
+    KvStore& store_;
+};
+
+// /mget <key> [key...] - "Values: N", затем по строке на ключ, "(nil)" для отсутствующих
+class MgetCommand : public Command {
+public:
+    static constexpr size_t MAX_KEYS = 256;
+
+    explicit MgetCommand(KvStore& store);
+    std::string name() const override { return "mget"; }
+    Response execute(const CommandContext& ctx) override;
+    CommandPriority priority() const override { return CommandPriority::Low; }
+
+private:
+    KvStore& store_;
+};
@@ -2,31 +2,73 @@
 
 CommandProcessor::CommandProcessor(std::vector<std::unique_ptr<Command>> &&commands) {
     for (auto &&command : commands) {
-        command_map_[command->name()] = std::move(command);
+        std::string name = command->name();
+        command_map_[name] = CommandEntry{std::move(command), std::make_unique<CommandMetrics>()};
     }
 }
 
-std::string CommandProcessor::process_command(const std::string& input) {
-    std::string trimmed_input = input;
-    trimmed_input.erase(trimmed_input.find_last_not_of(" \t\n\r\f\v") + 1);
+Response CommandProcessor::process_command(std::string_view input, Subscriber* subscriber,
+                                           std::pmr::memory_resource* arena) {
+    uint64_t start_ns = monotonic_ns();
+    RequestSample* sample = RequestSample::current();
+    std::string_view trimmed_input = LineScanner::trim(input);
     
     if (!is_command(trimmed_input)) {
-        return handle_mirror(trimmed_input);
+        Response response = handle_mirror(trimmed_input, arena);
+        record(echo_metrics_, start_ns, sample);
+        return response;
     }
     
-    std::string command_name = trimmed_input.substr(1);
-    auto it = command_map_.find(command_name);
+    std::string_view command_line(trimmed_input);
+    command_line.remove_prefix(1);
+    
+    CommandContext ctx{};
+    ctx.subscriber = subscriber;
+    ctx.arena = arena;
+    size_t space = command_line.find(' ');
+    if (space != std::string_view::npos) {
+        ctx.args = command_line.substr(space + 1);
+        command_line = command_line.substr(0, space);
+    }
+    
+    auto it = command_map_.find(command_line);
     if (it != command_map_.end()) {
-        return it->second->execute();
+        if (it->second.command->priority() < min_priority_.load(std::memory_order_relaxed)) {
+            shed_commands_.fetch_add(1, std::memory_order_relaxed);
+            return Response("BUSY: Server overloaded, try again later", arena);
+        }
+        Response response = it->second.command->execute(ctx);
+        record(*it->second.metrics, start_ns, sample);
+        return response;
     }
     
-    return "ERROR: Unknown command '" + trimmed_input + "'";
+    record(unknown_metrics_, start_ns, sample);
+    Response response("ERROR: Unknown command '", arena);
+    response.append(trimmed_input).push_back('\'');
+    return response;
 }
 
-std::string CommandProcessor::handle_mirror(const std::string& message) {
-    return message;
+std::string CommandProcessor::latency_report(std::string_view command) const {
+    std::string lines;
+    size_t commands = 0;
+    visit_metrics([&](std::string_view name, const CommandMetrics& metrics) {
+        if ((command.empty() || command == name) && append_request_stages(lines, name, metrics)) {
+            ++commands;
+        }
+    });
+    if (commands == 0) {
+        return "No sampled requests (latency_sample_rate=0 disables sampling)";
+    }
+    // Без последнего перевода строки: его добавляет отправка ответа
+    lines.pop_back();
+    return "Stage latency p50/p99 in us (bucket upper bounds), commands: " + std::to_string(commands) +
+           "\n" + lines;
 }
 
-bool CommandProcessor::is_command(const std::string& message) {
+Response CommandProcessor::handle_mirror(std::string_view message, std::pmr::memory_resource* arena) {
+    return Response(message, arena);
+}
+
+bool CommandProcessor::is_command(std::string_view message) {
     return !message.empty() && message[0] == '/';
-}
\ No newline at end of file
+}
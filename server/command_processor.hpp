@@ -1,19 +1,71 @@
 #pragma once
 
 #include "command.hpp"
+#include "line_scanner.hpp"
+#include "metrics.hpp"
+#include "request_sampler.hpp"
 #include <unordered_map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class CommandProcessor {
 public:
     CommandProcessor(std::vector<std::unique_ptr<Command>> &&commands);
-    std::string process_command(const std::string& input);
+    // subscriber - соединение, от имени которого выполняются /subscribe и /unsubscribe;
+    // ответ выделяется из arena (арена итерации цикла событий)
+    Response process_command(std::string_view input, Subscriber* subscriber = nullptr,
+                             std::pmr::memory_resource* arena = std::pmr::get_default_resource());
+    
+    // Обходит метрики всех команд, включая эхо ("echo") и неизвестные ("unknown")
+    template <typename Visitor>
+    void visit_metrics(Visitor&& visit) const {
+        visit(std::string_view("echo"), echo_metrics_);
+        for (const auto& [name, entry] : command_map_) {
+            visit(std::string_view(name), *entry.metrics);
+        }
+        visit(std::string_view("unknown"), unknown_metrics_);
+    }
+    
+    // Ответ /latency: заголовок "..., commands: N" и по строке на каждую из N
+    // команд с запросами из выборки; command пустая - все команды
+    std::string latency_report(std::string_view command) const;
+    
+    // Команды с приоритетом ниже min получают BUSY без выполнения;
+    // вызывается из любого потока
+    void set_min_priority(CommandPriority min) { min_priority_.store(min, std::memory_order_relaxed); }
+    uint64_t shed_commands() const { return shed_commands_.load(std::memory_order_relaxed); }
 
 private:
-    std::string handle_mirror(const std::string& message);
-    bool is_command(const std::string& message);
+    struct CommandEntry {
+        std::unique_ptr<Command> command;
+        std::unique_ptr<CommandMetrics> metrics;
+    };
+    
+    Response handle_mirror(std::string_view message, std::pmr::memory_resource* arena);
+    bool is_command(std::string_view message);
+    
+    static void record(CommandMetrics& metrics, uint64_t start_ns, RequestSample* sample) {
+        uint64_t end_ns = monotonic_ns();
+        metrics.requests.fetch_add(1, std::memory_order_relaxed);
+        metrics.latency.observe(end_ns - start_ns);
+        if (sample) {
+            sample->dispatched = start_ns;
+            sample->executed = end_ns;
+            sample->metrics = &metrics;
+        }
+    }
+    
+    // Прозрачный хеш: поиск по string_view без временной строки
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
     
-    std::unordered_map<std::string, std::unique_ptr<Command>> command_map_;
-};
\ No newline at end of file
+    std::unordered_map<std::string, CommandEntry, NameHash, std::equal_to<>> command_map_;
+    CommandMetrics echo_metrics_;
+    CommandMetrics unknown_metrics_;
+    std::atomic<CommandPriority> min_priority_{CommandPriority::Low};
+    std::atomic<uint64_t> shed_commands_{0};
+};
@@ -0,0 +1,323 @@
+#include "config.hpp"
+#include "affinity.hpp"
+#include "logger.hpp"
+#include "stats_segment.hpp"
+
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+template <typename T>
+bool parse_number(std::string_view value, T min, T max, T& out) {
+    T parsed{};
+    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+    if (ec != std::errc() || ptr != value.data() + value.size() || parsed < min || parsed > max) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+bool parse_signal_mode(std::string_view value, SignalMode& mode) {
+    if (value == "signalfd") {
+        mode = SignalMode::SignalFd;
+    } else if (value == "thread") {
+        mode = SignalMode::Thread;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_subscriber_policy(std::string_view value, SlowSubscriberPolicy& policy) {
+    if (value == "queue") {
+        policy = SlowSubscriberPolicy::Queue;
+    } else if (value == "drop") {
+        policy = SlowSubscriberPolicy::Drop;
+    } else if (value == "disconnect") {
+        policy = SlowSubscriberPolicy::Disconnect;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_journal_fsync(std::string_view value, JournalFsync& policy) {
+    if (value == "none") {
+        policy = JournalFsync::None;
+    } else if (value == "interval") {
+        policy = JournalFsync::Interval;
+    } else if (value == "batch") {
+        policy = JournalFsync::Batch;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_placement_policy(std::string_view value, PlacementPolicy& policy) {
+    if (value == "round_robin") {
+        policy = PlacementPolicy::RoundRobin;
+    } else if (value == "least_connections") {
+        policy = PlacementPolicy::LeastConnections;
+    } else if (value == "least_loaded") {
+        policy = PlacementPolicy::LeastLoaded;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_socket_timestamps(std::string_view value, SocketTimestamps& mode) {
+    if (value == "off") {
+        mode = SocketTimestamps::Off;
+    } else if (value == "rx") {
+        mode = SocketTimestamps::Rx;
+    } else if (value == "rx_tx") {
+        mode = SocketTimestamps::RxTx;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_upstreams(std::string_view value, std::vector<std::string>& upstreams) {
+    std::vector<std::string> parsed;
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        std::string_view item = trim(value.substr(0, comma));
+        if (item.empty() || item.find(':') == std::string_view::npos) {
+            return false;
+        }
+        parsed.emplace_back(item);
+        value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+    }
+    upstreams = std::move(parsed);
+    return true;
+}
+
+bool parse_milliseconds(std::string_view value, long min, long max, std::chrono::milliseconds& out) {
+    long ms = 0;
+    if (!parse_number<long>(value, min, max, ms)) return false;
+    out = std::chrono::milliseconds(ms);
+    return true;
+}
+
+bool apply_key(std::string_view key, std::string_view value, ServerConfig& config, bool& known) {
+    known = true;
+    long seconds = 0;
+
+    if (key == "port") {
+        return parse_number<uint16_t>(value, 1, 65535, config.port);
+    } else if (key == "admin_port") {
+        return parse_number<uint16_t>(value, 0, 65535, config.admin_port);
+    } else if (key == "signal_mode") {
+        return parse_signal_mode(value, config.signal_mode);
+    } else if (key == "stats_shm") {
+        config.stats_shm_name = value == "off" ? std::string() : std::string(value);
+        return true;
+    } else if (key == "log_level") {
+        LogLevel level;
+        if (!parse_log_level(value, level)) {
+            return false;
+        }
+        config.log_level = std::string(value);
+        return true;
+    } else if (key == "log_output") {
+        if (value.empty()) return false;
+        config.log_output = std::string(value);
+        return true;
+    } else if (key == "max_connections") {
+        return parse_number<size_t>(value, 1, 10000000, config.max_connections);
+    } else if (key == "tcp_timeout") {
+        if (!parse_number<long>(value, 0, 86400 * 30, seconds)) return false;
+        config.tcp_timeout = std::chrono::seconds(seconds);
+        return true;
+    } else if (key == "udp_timeout") {
+        if (!parse_number<long>(value, 0, 86400 * 30, seconds)) return false;
+        config.udp_timeout = std::chrono::seconds(seconds);
+        return true;
+    } else if (key == "tcp_buffer_size") {
+        return parse_number<size_t>(value, 64, 16 * 1024 * 1024, config.tcp_buffer_size);
+    } else if (key == "udp_buffer_size") {
+        return parse_number<size_t>(value, 64, 65536, config.udp_buffer_size);
+    } else if (key == "drain_timeout") {
+        if (!parse_number<long>(value, 0, 86400, seconds)) return false;
+        config.drain_timeout = std::chrono::seconds(seconds);
+        return true;
+    } else if (key == "upgrade_timeout") {
+        if (!parse_number<long>(value, 1, 3600, seconds)) return false;
+        config.upgrade_timeout = std::chrono::seconds(seconds);
+        return true;
+    } else if (key == "event_batch_size") {
+        return parse_number<size_t>(value, 1, 4096, config.event_batch_size);
+    } else if (key == "subscriber_policy") {
+        return parse_subscriber_policy(value, config.subscriber_policy);
+    } else if (key == "subscriber_queue_limit") {
+        return parse_number<size_t>(value, 1, 1000000, config.subscriber_queue_limit);
+    } else if (key == "kv_shards") {
+        return parse_number<size_t>(value, 1, 1024, config.kv_shards);
+    } else if (key == "kv_max_keys") {
+        return parse_number<size_t>(value, 0, 1000000000, config.kv_max_keys);
+    } else if (key == "journal_dir") {
+        config.journal_dir = std::string(value);
+        return true;
+    } else if (key == "journal_segment_size") {
+        return parse_number<size_t>(value, Journal::MIN_SEGMENT_SIZE, size_t(1) << 32, config.journal_segment_size);
+    } else if (key == "journal_fsync") {
+        return parse_journal_fsync(value, config.journal_fsync);
+    } else if (key == "journal_fsync_interval_ms") {
+        return parse_milliseconds(value, 1, 3600 * 1000, config.journal_fsync_interval);
+    } else if (key == "upstreams") {
+        return parse_upstreams(value, config.upstreams);
+    } else if (key == "upstream_prefix") {
+        if (value.size() < 2 || value[0] != '/' || value.find(' ') != std::string_view::npos) return false;
+        config.upstream_prefix = std::string(value);
+        return true;
+    } else if (key == "upstream_connections") {
+        return parse_number<size_t>(value, 1, 64, config.upstream_connections);
+    } else if (key == "upstream_max_pending") {
+        return parse_number<size_t>(value, 1, 1000000, config.upstream_max_pending);
+    } else if (key == "upstream_timeout_ms") {
+        return parse_milliseconds(value, 1, 3600 * 1000, config.upstream_timeout);
+    } else if (key == "upstream_health_interval_ms") {
+        return parse_milliseconds(value, 10, 3600 * 1000, config.upstream_health_interval);
+    } else if (key == "upstream_health_check") {
+        config.upstream_health_check = std::string(value);
+        return true;
+    } else if (key == "tcp_workers") {
+        return parse_number<size_t>(value, 0, 256, config.tcp_workers);
+    } else if (key == "worker_placement") {
+        return parse_placement_policy(value, config.worker_placement);
+    } else if (key == "socket_timestamps") {
+        return parse_socket_timestamps(value, config.socket_timestamps);
+    } else if (key == "latency_sample_rate") {
+        return parse_number<uint32_t>(value, 0, 1000000, config.latency_sample_rate);
+    } else if (key == "overload_lag_ms") {
+        return parse_milliseconds(value, 0, 60 * 1000, config.overload_lag);
+    } else if (key == "overload_queued_bytes") {
+        return parse_number<size_t>(value, 0, size_t(1) << 40, config.overload_queued_bytes);
+    } else if (key == "overload_connections") {
+        return parse_number<size_t>(value, 0, 10000000, config.overload_connections);
+    } else if (key == "overload_cooldown_ms") {
+        return parse_milliseconds(value, 0, 3600 * 1000, config.overload_cooldown);
+    } else if (key == "reactor_cpus" || key == "logger_cpus" || key == "signal_cpus") {
+        std::vector<int>& cpus = key == "reactor_cpus" ? config.reactor_cpus
+                               : key == "logger_cpus"  ? config.logger_cpus
+                                                       : config.signal_cpus;
+        std::string error;
+        return parse_cpu_list(value, cpus, error);
+    } else if (key == "trace_events") {
+        return parse_number<size_t>(value, 0, 16 * 1024 * 1024, config.trace_events);
+    } else if (key == "trace_file") {
+        if (value.empty()) return false;
+        config.trace_file = std::string(value);
+        return true;
+    }
+
+    known = false;
+    return true;
+}
+
+} // namespace
+
+bool parse_config(std::istream& in, ServerConfig& config, std::string& error,
+                  std::vector<std::string>* warnings) {
+    std::string line;
+    size_t line_number = 0;
+
+    while (std::getline(in, line)) {
+        ++line_number;
+        std::string_view text = trim(std::string_view(line).substr(0, line.find('#')));
+        if (text.empty()) {
+            continue;
+        }
+
+        size_t eq = text.find('=');
+        if (eq == std::string_view::npos) {
+            error = "line " + std::to_string(line_number) + ": expected key=value";
+            return false;
+        }
+
+        std::string_view key = trim(text.substr(0, eq));
+        std::string_view value = trim(text.substr(eq + 1));
+        bool known = false;
+        if (!apply_key(key, value, config, known)) {
+            error = "line " + std::to_string(line_number) + ": invalid value '" +
+                    std::string(value) + "' for " + std::string(key);
+            return false;
+        }
+        if (!known && warnings) {
+            warnings->push_back("line " + std::to_string(line_number) + ": unknown key '" +
+                                std::string(key) + "' ignored");
+        }
+    }
+    return true;
+}
+
+bool load_config_file(const std::string& path, ServerConfig& config, std::string& error,
+                      std::vector<std::string>* warnings) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    if (!parse_config(in, config, error, warnings)) {
+        error = path + ": " + error;
+        return false;
+    }
+    config.config_path = path;
+    return true;
+}
+
+bool apply_env_overrides(ServerConfig& config, std::string& error) {
+    struct Override {
+        const char* name;
+        const char* key;
+    };
+    static const Override overrides[] = {
+        {"SERVER_PORT", "port"},
+        {"ADMIN_PORT", "admin_port"},
+        {"SIGNAL_MODE", "signal_mode"},
+        {"STATS_SHM", "stats_shm"},
+    };
+
+    for (const auto& item : overrides) {
+        const char* value = std::getenv(item.name);
+        if (value == nullptr) {
+            continue;
+        }
+        bool known = false;
+        std::string_view text(value);
+        if (text.empty() && std::string_view(item.key) == "stats_shm") {
+            text = "off";
+        }
+        if (!apply_key(item.key, text, config, known)) {
+            error = std::string("Invalid ") + item.name + " environment variable";
+            return false;
+        }
+    }
+    return true;
+}
+
+void resolve_config_defaults(ServerConfig& config) {
+    if (config.stats_shm_name == "auto") {
+        config.stats_shm_name = StatsSegment::default_name(config.port);
+    }
+    if (config.trace_file == "auto") {
+        config.trace_file = "async_tcp_udp_server." + std::to_string(config.port) + ".trace.json";
+    }
+}
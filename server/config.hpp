@@ -0,0 +1,136 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "journal.hpp"
+#include "pubsub.hpp"
+#include "timestamping.hpp"
+#include "worker_pool.hpp"
+
+enum class SignalMode {
+    Thread,     // отдельный поток SignalHandler, только завершение работы
+    SignalFd,   // signalfd в EventLoop: SIGHUP/SIGUSR1 обрабатываются в цикле
+};
+
+struct ServerConfig {
+    static constexpr const char* DEFAULT_PATH = "/etc/async-tcp-udp-server/server.conf";
+
+    // Путь к файлу, из которого конфигурация перечитывается по SIGHUP
+    std::string config_path;
+
+    // --- Применяются только при старте ---
+    uint16_t port = 0;
+
+    // Порт HTTP-листенера с GET /metrics (Prometheus); 0 - выключен
+    uint16_t admin_port = 0;
+
+    SignalMode signal_mode = SignalMode::SignalFd;
+
+    // Имя POSIX shm-сегмента со статистикой: "auto" - по номеру порта,
+    // пустая строка - не публиковать
+    std::string stats_shm_name = "auto";
+
+    // Ёмкость кольца трассировки событий цикла; 0 - трассировка выключена
+    size_t trace_events = 16384;
+
+    // Число шардов хранилища /set, /get (округляется до степени двойки)
+    size_t kv_shards = 16;
+
+    // Журнал принятых сообщений: каталог сегментов, пустая строка - выключен
+    std::string journal_dir;
+    size_t journal_segment_size = 64 * 1024 * 1024;
+
+    // Пересылка: строки с префиксом upstream_prefix уходят на бэкенды
+    // upstreams ("host:port,host:port"); пустой список - выключено
+    std::vector<std::string> upstreams;
+    std::string upstream_prefix = "/upstream";
+    size_t upstream_connections = 2;
+    size_t upstream_max_pending = 1024;
+    std::chrono::milliseconds upstream_timeout{5000};
+    std::chrono::milliseconds upstream_health_interval{1000};
+    std::string upstream_health_check;
+
+    // TCP-соединения обслуживают tcp_workers рабочих реакторов, принимает их
+    // отдельный поток акцептора; 0 - всё в основном реакторе
+    size_t tcp_workers = 0;
+
+    // Привязка потоков к CPU: "0-3,8" или "node:1", пустой список - без
+    // привязки. Основной реактор занимает первый CPU списка, рабочий i -
+    // (i + 1)-й по кругу; поток журнала и поток SignalHandler
+    // (signal_mode=thread) - весь свой список.
+    std::vector<int> reactor_cpus;
+    std::vector<int> logger_cpus;
+    std::vector<int> signal_cpus;
+
+    // --- Перечитываются на лету по SIGHUP ---
+    std::string log_level = "info";
+    // stderr, stdout, journald или путь к файлу
+    std::string log_output = "stderr";
+    size_t max_connections = 1000;
+    std::chrono::seconds tcp_timeout{300};
+    std::chrono::seconds udp_timeout{60};
+    size_t tcp_buffer_size = 4096;
+    size_t udp_buffer_size = 1024;
+    size_t event_batch_size = 64;
+    
+    // Какому рабочему реактору акцептор отдаёт соединение:
+    // round_robin | least_connections | least_loaded
+    PlacementPolicy worker_placement = PlacementPolicy::RoundRobin;
+    
+    // Защита от перегрузки: пороги первой ступени (перестать принимать
+    // соединения), 0 - сигнал не учитывается. При двукратном превышении UDP
+    // получает BUSY, при четырёхкратном отклоняются команды низкого приоритета.
+    std::chrono::milliseconds overload_lag{50};
+    size_t overload_queued_bytes = 64 * 1024 * 1024;
+    size_t overload_connections = 0;
+    std::chrono::milliseconds overload_cooldown{1000};
+    
+    // Отметки ядра SO_TIMESTAMPING: off | rx | rx_tx. Разделяют ожидание в
+    // буфере сокета, обработку и отправку; для TCP - только новые соединения.
+    SocketTimestamps socket_timestamps = SocketTimestamps::Off;
+    
+    // Каждый N-й запрос потока трассируется по этапам (разбор, команда,
+    // отправка) для /latency; 0 - выключено
+    uint32_t latency_sample_rate = 0;
+    
+    // Сколько старый процесс ждёт закрытия соединений после передачи
+    // слушающих сокетов новому (SIGUSR2)
+    std::chrono::seconds drain_timeout{30};
+    
+    // Сколько старый процесс ждёт готовности нового после SIGUSR2; не
+    // ответивший вовремя процесс убивается, старый работает дальше
+    std::chrono::seconds upgrade_timeout{30};
+    
+    // Подписчик, не успевающий читать /publish: queue | drop | disconnect
+    SlowSubscriberPolicy subscriber_policy = SlowSubscriberPolicy::Queue;
+    size_t subscriber_queue_limit = 1024;
+    
+    // Когда журнал сбрасывается на диск: none | interval | batch
+    JournalFsync journal_fsync = JournalFsync::Interval;
+    std::chrono::milliseconds journal_fsync_interval{1000};
+    
+    // Предел числа ключей: /set нового ключа сверх него возвращает ошибку
+    size_t kv_max_keys = 1000000;
+    
+    // Куда GET /trace на admin_port и SIGUSR1 сбрасывают кольцо трассировки:
+    // "auto" - по номеру порта в рабочем каталоге
+    std::string trace_file = "auto";
+};
+
+// Формат файла: строки key=value, '#' - комментарий. Неизвестные ключи не
+// считаются ошибкой и попадают в warnings.
+bool parse_config(std::istream& in, ServerConfig& config, std::string& error,
+                  std::vector<std::string>* warnings = nullptr);
+bool load_config_file(const std::string& path, ServerConfig& config, std::string& error,
+                      std::vector<std::string>* warnings = nullptr);
+
+// SERVER_PORT, ADMIN_PORT, SIGNAL_MODE, STATS_SHM имеют приоритет над файлом
+bool apply_env_overrides(ServerConfig& config, std::string& error);
+
+// Подставляет значения, зависящие от других полей (имя shm-сегмента, файл трассировки)
+void resolve_config_defaults(ServerConfig& config);
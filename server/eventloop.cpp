@@ -1,18 +1,48 @@
 #include "eventloop.hpp"
 
+#include <sys/eventfd.h>
+
 EventLoop::EventLoop() : epoll_fd_(-1) {
     epoll_fd_ = epoll_create1(0);
     if (epoll_fd_ == -1) {
         throw std::system_error(errno, std::system_category(), "epoll_create1 failed");
     }
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeup_fd_;
+    if (wakeup_fd_ == -1 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev) == -1) {
+        int error = errno;
+        if (wakeup_fd_ != -1) close(wakeup_fd_);
+        close(epoll_fd_);
+        throw std::system_error(error, std::system_category(), "eventfd setup failed");
+    }
 }
 
 EventLoop::~EventLoop() {
+    if (TraceRing::current() == &trace_) {
+        TraceRing::set_current(nullptr);
+    }
+    if (wakeup_fd_ != -1) {
+        close(wakeup_fd_);
+    }
     if (epoll_fd_ != -1) {
         close(epoll_fd_);
     }
 }
 
+void EventLoop::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        posted_.push_back(std::move(task));
+    }
+    wake();
+}
+
+void EventLoop::wake() {
+    eventfd_write(wakeup_fd_, 1);
+}
+
 bool EventLoop::add_fd(int fd, uint32_t events, EventCallback callback) {
     epoll_event ev{};
     ev.events = events;
@@ -22,7 +52,11 @@ bool EventLoop::add_fd(int fd, uint32_t events, EventCallback callback) {
         return false;
     }
     
+    if (static_cast<size_t>(fd) >= callbacks_.size()) {
+        callbacks_.resize(static_cast<size_t>(fd) + 1);
+    }
     callbacks_[fd] = std::move(callback);
+    ++registered_fds_;
     return true;
 }
 
@@ -34,17 +68,24 @@ bool EventLoop::modify_fd(int fd, uint32_t events) {
 }
 
 bool EventLoop::remove_fd(int fd) {
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) == -1) {
-        return false;
+    bool removed = epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) != -1;
+    
+    if (fd < 0 || static_cast<size_t>(fd) >= callbacks_.size() || !callbacks_[fd]) {
+        return removed;
     }
-    callbacks_.erase(fd);
-    return true;
+    if (dispatching_) {
+        retired_callbacks_.push_back(std::move(callbacks_[fd]));
+    }
+    callbacks_[fd] = nullptr;
+    --registered_fds_;
+    return removed;
 }
 
 void EventLoop::run(int timeout_ms) {
-    epoll_event events[MAX_EVENTS];
+    epoll_event* events = events_.data();
     
-    int num_events = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout_ms);
+    int num_events = epoll_wait(epoll_fd_, events, static_cast<int>(events_.size()), timeout_ms);
+    iterations_.store(iterations_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
     
     if (num_events == -1) {
         if (errno == EINTR) {
@@ -53,13 +94,57 @@ void EventLoop::run(int timeout_ms) {
         return;
     }
     
+    if (num_events == 0) {
+        // Простой тоже сокращает задержку: иначе она застыла бы на последней пачке
+        lag_ns_.store(lag_ns_.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+        return;
+    }
+    
+    TraceRing::set_current(trace_.enabled() ? &trace_ : nullptr);
+    uint64_t start_tsc = trace_clock();
+    uint64_t start_ns = monotonic_ns();
+    dispatching_ = true;
     for (int i = 0; i < num_events; ++i) {
         int fd = events[i].data.fd;
         uint32_t ev_events = events[i].events;
         
-        auto it = callbacks_.find(fd);
-        if (it != callbacks_.end()) {
-            it->second(ev_events);
+        if (fd == wakeup_fd_) {
+            eventfd_t count;
+            eventfd_read(wakeup_fd_, &count);
+            if (wakeup_handler_) {
+                wakeup_handler_();
+            }
+            {
+                std::lock_guard<std::mutex> lock(posted_mutex_);
+                running_tasks_.swap(posted_);
+            }
+            for (auto& task : running_tasks_) {
+                task();
+            }
+            running_tasks_.clear();
+        } else if (static_cast<size_t>(fd) < callbacks_.size() && callbacks_[fd]) {
+            callbacks_[fd](ev_events);
         }
     }
+    dispatching_ = false;
+    retired_callbacks_.clear();
+    uint64_t elapsed_ns = monotonic_ns() - start_ns;
+    SERVER_PROBE(loop, num_events, elapsed_ns);
+    trace_.record(TraceType::Loop, -1, static_cast<uint64_t>(num_events), start_tsc, trace_clock() - start_tsc);
+    
+    events_dispatched_.store(events_dispatched_.load(std::memory_order_relaxed) + num_events,
+                             std::memory_order_relaxed);
+    busy_ns_.store(busy_ns_.load(std::memory_order_relaxed) + elapsed_ns, std::memory_order_relaxed);
+    uint64_t lag = lag_ns_.load(std::memory_order_relaxed);
+    lag_ns_.store(lag - lag / 8 + elapsed_ns / 8, std::memory_order_relaxed);
+    dispatch_latency_.observe(elapsed_ns);
+}
+
+EventLoop::Stats EventLoop::get_stats() const {
+    Stats stats{};
+    stats.iterations = iterations_.load(std::memory_order_relaxed);
+    stats.events = events_dispatched_.load(std::memory_order_relaxed);
+    stats.busy_ns = busy_ns_.load(std::memory_order_relaxed);
+    stats.registered_fds = registered_fds_;
+    return stats;
 }
\ No newline at end of file
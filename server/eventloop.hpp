@@ -1,7 +1,9 @@
 #pragma once
 
+#include <deque>
 #include <functional>
-#include <unordered_map>
+#include <mutex>
+#include <vector>
 #include <atomic>
 #include <unistd.h>
 #include <sys/epoll.h>
@@ -13,10 +15,20 @@
 
 #include <iostream>
 
+#include "metrics.hpp"
+#include "trace.hpp"
+
 class EventLoop {
 public:
     using EventCallback = std::function<void(uint32_t)>;
     
+    struct Stats {
+        uint64_t iterations;
+        uint64_t events;
+        uint64_t busy_ns;
+        size_t registered_fds;
+    };
+    
     EventLoop();
     ~EventLoop();
     
@@ -27,12 +39,52 @@ public:
     void run(int timeout_ms);
     void stop();
     void stop_immediate(); 
+    
+    // Из любого потока: задача выполнится в потоке цикла на ближайшей итерации
+    void post(std::function<void()> task);
+    // Из любого потока: прерывает epoll_wait и вызывает обработчик пробуждения
+    void wake();
+    void set_wakeup_handler(std::function<void()> handler) { wakeup_handler_ = std::move(handler); }
+    
+    // Скользящее среднее времени обработки пачки событий: на сколько
+    // задерживается реакция цикла на новое событие
+    uint64_t lag_ns() const { return lag_ns_.load(std::memory_order_relaxed); }
+    
+    // Сколько событий забирается за один epoll_wait
+    void set_max_events(size_t max_events) { events_.resize(max_events > 0 ? max_events : 1); }
+    
+    Stats get_stats() const;
+    const LatencyHistogram& dispatch_latency() const { return dispatch_latency_; }
+    
+    // Кольцо трассировки этого цикла; ёмкость меняется только до run()
+    void set_trace_capacity(size_t events) { trace_.reset(events); }
+    const TraceRing& trace() const { return trace_; }
 
 private:
     static const int MAX_EVENTS = 64;
     
     int epoll_fd_;
-    int wakeup_fd_[2];
-    std::unordered_map<int, EventCallback> callbacks_;
+    std::vector<epoll_event> events_ = std::vector<epoll_event>(MAX_EVENTS);
+    bool dispatching_ = false;
+    // Колбэки, снятые во время обработки событий, живут до конца итерации:
+    // remove_fd часто вызывается из самого удаляемого колбэка
+    std::vector<EventCallback> retired_callbacks_;
+    // eventfd пробуждения, в registered_fds не считается
+    int wakeup_fd_ = -1;
+    std::function<void()> wakeup_handler_;
+    std::mutex posted_mutex_;
+    std::vector<std::function<void()>> posted_;
+    std::vector<std::function<void()>> running_tasks_;
+    // Индекс - fd. deque не перемещает элементы при росте: колбэк accept
+    // может добавить fd, пока сам выполняется
+    std::deque<EventCallback> callbacks_;
+    size_t registered_fds_ = 0;
     std::atomic<bool> running_{false};
+    
+    std::atomic<uint64_t> iterations_{0};
+    std::atomic<uint64_t> events_dispatched_{0};
+    std::atomic<uint64_t> busy_ns_{0};
+    std::atomic<uint64_t> lag_ns_{0};
+    LatencyHistogram dispatch_latency_;
+    TraceRing trace_;
 };
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include "journal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::array<uint32_t, 256> make_crc_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+constexpr auto CRC_TABLE = make_crc_table();
+
+size_t align8(size_t value) {
+    return (value + 7) & ~size_t(7);
+}
+
+size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+uint64_t realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+bool parse_segment_name(const char* name, uint64_t& index) {
+    unsigned long long value = 0;
+    int consumed = 0;
+    if (std::sscanf(name, "journal-%16llu.seg%n", &value, &consumed) != 1 ||
+        name[consumed] != '\0' || std::strlen(name) != 28) {
+        return false;
+    }
+    index = value;
+    return true;
+}
+
+uint32_t record_crc(const JournalRecordHeader& header, const char* payload) {
+    JournalRecordHeader copy = header;
+    copy.crc = 0;
+    uint32_t crc = journal_crc32(0, &copy, sizeof(copy));
+    return journal_crc32(crc, payload, header.length);
+}
+
+} // namespace
+
+uint32_t journal_crc32(uint32_t crc, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = CRC_TABLE[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+Journal::~Journal() {
+    close();
+}
+
+std::string Journal::segment_name(uint64_t index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "journal-%016llu.seg", static_cast<unsigned long long>(index));
+    return name;
+}
+
+std::vector<std::string> Journal::list_segments(const std::string& dir) {
+    std::vector<std::pair<uint64_t, std::string>> found;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(d)) {
+            uint64_t index = 0;
+            if (parse_segment_name(entry->d_name, index)) {
+                found.emplace_back(index, dir + "/" + entry->d_name);
+            }
+        }
+        closedir(d);
+    }
+    std::sort(found.begin(), found.end());
+
+    std::vector<std::string> paths;
+    for (auto& [index, path] : found) {
+        paths.push_back(std::move(path));
+    }
+    return paths;
+}
+
+bool Journal::open(const std::string& dir, size_t segment_size, std::string& error) {
+    if (segment_size < MIN_SEGMENT_SIZE) {
+        error = "journal segment size must be at least " + std::to_string(MIN_SEGMENT_SIZE);
+        return false;
+    }
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = "cannot create " + dir + ": " + std::strerror(errno);
+        return false;
+    }
+
+    uint64_t index = 0;
+    auto segments = list_segments(dir);
+    if (!segments.empty()) {
+        const std::string& last = segments.back();
+        parse_segment_name(last.c_str() + last.rfind('/') + 1, index);
+        ++index;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    dir_ = dir;
+    segment_size_ = segment_size & ~(page_size() - 1);
+    return open_segment(index, error);
+}
+
+bool Journal::open_segment(uint64_t index, std::string& error) {
+    // Номер может быть занят процессом, которому передали сокеты по SIGUSR2:
+    // тогда берётся следующий свободный
+    std::string path = dir_ + "/" + segment_name(index);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0640);
+    for (int attempt = 0; fd == -1 && errno == EEXIST && attempt < 1000; ++attempt) {
+        path = dir_ + "/" + segment_name(++index);
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0640);
+    }
+    if (fd == -1) {
+        error = "cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    // posix_fallocate резервирует место сразу: нехватка диска всплывает
+    // здесь, а не SIGBUS при записи в отображение
+    int rc = posix_fallocate(fd, 0, static_cast<off_t>(segment_size_));
+    if (rc != 0) {
+        error = "cannot allocate " + path + ": " + std::strerror(rc);
+        ::close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+    void* base = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        unlink(path.c_str());
+        return false;
+    }
+
+    fd_ = fd;
+    base_ = static_cast<char*>(base);
+    path_ = std::move(path);
+    index_ = index;
+
+    auto* header = reinterpret_cast<JournalSegmentHeader*>(base_);
+    std::memcpy(header->magic, JournalSegmentHeader::MAGIC, sizeof(header->magic));
+    header->version = JournalSegmentHeader::VERSION;
+    header->index = index;
+    header->created_ns = realtime_ns();
+    header->committed = sizeof(JournalSegmentHeader);
+    offset_ = committed_ = sizeof(JournalSegmentHeader);
+    synced_ = 0;
+    ++stats_.segments;
+    return true;
+}
+
+void Journal::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (base_) {
+        finish_segment();
+    }
+}
+
+void Journal::finish_segment() {
+    // Хвост сегмента коммитится сразу, не дожидаясь интервала
+    commit_locked();
+    if (fsync_ != JournalFsync::None && synced_ < offset_) {
+        sync(offset_);
+    }
+    munmap(base_, segment_size_);
+    ::close(fd_);
+    base_ = nullptr;
+    fd_ = -1;
+}
+
+bool Journal::append(uint8_t protocol, const sockaddr_in& peer, std::string_view payload) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!base_) {
+        return false;
+    }
+    size_t size = align8(sizeof(JournalRecordHeader) + payload.size());
+    if (offset_ + size > segment_size_) {
+        if (sizeof(JournalSegmentHeader) + size > segment_size_) {
+            ++stats_.errors;
+            return false;
+        }
+        finish_segment();
+        std::string error;
+        if (!open_segment(index_ + 1, error)) {
+            ++stats_.errors;
+            return false;
+        }
+    }
+
+    JournalRecordHeader header{};
+    header.length = static_cast<uint32_t>(payload.size());
+    header.timestamp_ns = realtime_ns();
+    header.peer_addr = peer.sin_addr.s_addr;
+    header.peer_port = ntohs(peer.sin_port);
+    header.protocol = protocol;
+    header.crc = record_crc(header, payload.data());
+
+    char* out = base_ + offset_;
+    std::memcpy(out + sizeof(header), payload.data(), payload.size());
+    std::memcpy(out, &header, sizeof(header));
+    offset_ += size;
+    ++stats_.records;
+    stats_.bytes += size;
+    return true;
+}
+
+void Journal::commit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    commit_locked();
+}
+
+void Journal::commit_locked() {
+    if (!base_) {
+        return;
+    }
+    if (offset_ != committed_) {
+        reinterpret_cast<JournalSegmentHeader*>(base_)->committed = offset_;
+        committed_ = offset_;
+        ++stats_.commits;
+    }
+    if (synced_ >= committed_ || fsync_ == JournalFsync::None) {
+        return;
+    }
+    if (fsync_ == JournalFsync::Interval &&
+        std::chrono::steady_clock::now() - last_sync_ < fsync_interval_) {
+        return;
+    }
+    sync(committed_);
+}
+
+void Journal::sync(size_t end) {
+    // Заголовок с committed лежит на первой странице и сбрасывается
+    // последним: после сбоя он не указывает на несброшенные записи.
+    // Записи самой первой страницы уходят на диск вместе с ним.
+    size_t page = page_size();
+    size_t begin = std::max(synced_ & ~(page - 1), page);
+    if (end > begin) {
+        msync(base_ + begin, end - begin, MS_SYNC);
+    }
+    msync(base_, page, MS_SYNC);
+    synced_ = end;
+    last_sync_ = std::chrono::steady_clock::now();
+    ++stats_.syncs;
+}
+
+JournalReader::~JournalReader() {
+    if (base_) {
+        munmap(const_cast<char*>(base_), size_);
+    }
+}
+
+bool JournalReader::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(JournalSegmentHeader)) {
+        error = path + " is not a journal segment";
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    base_ = static_cast<const char*>(base);
+    size_ = size;
+    const auto& h = header();
+    if (std::memcmp(h.magic, JournalSegmentHeader::MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != JournalSegmentHeader::VERSION) {
+        error = path + " is not a journal segment";
+        return false;
+    }
+    offset_ = sizeof(JournalSegmentHeader);
+    return true;
+}
+
+bool JournalReader::next(JournalRecord& record) {
+    if (!base_ || corrupt_ || offset_ + sizeof(JournalRecordHeader) > size_) {
+        return false;
+    }
+    JournalRecordHeader header;
+    std::memcpy(&header, base_ + offset_, sizeof(header));
+    if (header.length == 0 && header.timestamp_ns == 0) {
+        return false;
+    }
+
+    const char* payload = base_ + offset_ + sizeof(header);
+    if (offset_ + sizeof(header) + header.length > size_ || record_crc(header, payload) != header.crc) {
+        corrupt_ = true;
+        return false;
+    }
+
+    record.timestamp_ns = header.timestamp_ns;
+    record.peer = sockaddr_in{};
+    record.peer.sin_family = AF_INET;
+    record.peer.sin_addr.s_addr = header.peer_addr;
+    record.peer.sin_port = htons(header.peer_port);
+    record.protocol = header.protocol;
+    record.payload = std::string_view(payload, header.length);
+    offset_ += align8(sizeof(header) + header.length);
+    return true;
+}
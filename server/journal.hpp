@@ -0,0 +1,149 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <netinet/in.h>
+
+enum class JournalFsync {
+    None,       // данные сбрасывает ядро (переживают падение процесса, но не ОС)
+    Interval,   // msync не чаще раза в journal_fsync_interval
+    Batch,      // msync после каждой итерации цикла с новыми записями
+};
+
+// Бинарная раскладка сегмента: заголовок, затем записи, выровненные на 8
+// байт. Файл создаётся сразу полного размера и заполнен нулями, поэтому
+// нулевая длина означает конец записей. committed - сколько байт
+// гарантированно записано по правилу journal_fsync.
+struct JournalSegmentHeader {
+    static constexpr char MAGIC[8] = {'A', 'T', 'U', 'J', 'R', 'N', 'L', '1'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t index;
+    uint64_t created_ns;
+    uint64_t committed;
+    uint64_t padding[3];
+};
+
+struct JournalRecordHeader {
+    uint32_t length;      // длина payload
+    uint32_t crc;         // crc32 заголовка (при crc = 0) и payload
+    uint64_t timestamp_ns;  // CLOCK_REALTIME
+    uint32_t peer_addr;   // в сетевом порядке байт, как в sockaddr_in
+    uint16_t peer_port;
+    uint8_t protocol;     // 0 - TCP, 1 - UDP
+    uint8_t reserved;
+};
+
+static_assert(sizeof(JournalSegmentHeader) == 64, "journal segment header layout changed");
+static_assert(sizeof(JournalRecordHeader) == 24, "journal record header layout changed");
+
+struct JournalRecord {
+    uint64_t timestamp_ns;
+    sockaddr_in peer;
+    uint8_t protocol;
+    std::string_view payload;
+};
+
+struct JournalStats {
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t commits;
+    uint64_t syncs;
+    uint64_t segments;
+    uint64_t errors;
+};
+
+uint32_t journal_crc32(uint32_t crc, const void* data, size_t size);
+
+// Журнал принятых сообщений в файлах-сегментах <dir>/journal-<index>.seg,
+// отображённых в память. append() только копирует запись в отображение,
+// commit() раз за итерацию цикла публикует committed и, по правилу fsync,
+// делает msync - групповой коммит для всех записей итерации.
+// open() и close() - из потока основного реактора, append() могут вызывать
+// и рабочие реакторы: запись и коммит идут под мьютексом.
+class Journal {
+public:
+    static constexpr size_t MIN_SEGMENT_SIZE = 1024 * 1024;
+
+    Journal() = default;
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Новый сегмент получает номер после последнего в каталоге: старые
+    // файлы не дописываются
+    bool open(const std::string& dir, size_t segment_size, std::string& error);
+    void close();
+    bool is_open() const { return base_ != nullptr; }
+
+    void set_fsync(JournalFsync policy, std::chrono::milliseconds interval) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fsync_ = policy;
+        fsync_interval_ = interval;
+    }
+
+    bool append(uint8_t protocol, const sockaddr_in& peer, std::string_view payload);
+    void commit();
+
+    JournalStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+    const std::string& segment_path() const { return path_; }
+
+    static std::string segment_name(uint64_t index);
+    // Сегменты каталога в порядке номеров
+    static std::vector<std::string> list_segments(const std::string& dir);
+
+private:
+    bool open_segment(uint64_t index, std::string& error);
+    void finish_segment();
+    void commit_locked();
+    void sync(size_t end);
+
+    mutable std::mutex mutex_;
+    std::string dir_;
+    std::string path_;
+    size_t segment_size_ = 0;
+    uint64_t index_ = 0;
+    int fd_ = -1;
+    char* base_ = nullptr;
+    size_t offset_ = 0;
+    size_t committed_ = 0;
+    size_t synced_ = 0;
+    JournalFsync fsync_ = JournalFsync::Interval;
+    std::chrono::milliseconds fsync_interval_{1000};
+    std::chrono::steady_clock::time_point last_sync_{};
+    JournalStats stats_{};
+};
+
+// Чтение сегмента для журнала-утилиты и тестов. Записи после committed
+// тоже читаются, если сходится crc: после падения процесса они целы.
+class JournalReader {
+public:
+    JournalReader() = default;
+    ~JournalReader();
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    // false - записи кончились; corrupt() отличает обрыв от конца
+    bool next(JournalRecord& record);
+    bool corrupt() const { return corrupt_; }
+    size_t offset() const { return offset_; }
+    const JournalSegmentHeader& header() const { return *reinterpret_cast<const JournalSegmentHeader*>(base_); }
+
+private:
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    bool corrupt_ = false;
+};
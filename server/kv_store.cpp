@@ -0,0 +1,324 @@
+#include "kv_store.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+uint64_t hash_key(std::string_view key) {
+    // std::hash для коротких строк бывает слабым в младших битах: перемешиваем
+    uint64_t h = std::hash<std::string_view>{}(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t round_up_pow2(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+KvTable::KvTable()
+    : entries_(new Entry[MIN_CAPACITY]())
+    , capacity_(MIN_CAPACITY) {}
+
+KvTable::~KvTable() {
+    for (size_t i = 0; i < capacity_; ++i) {
+        if (entries_[i].hash & HASH_BIT) {
+            remove(entries_[i]);
+        }
+    }
+}
+
+size_t KvTable::probe(std::string_view key, uint64_t hash) const {
+    size_t mask = capacity_ - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Entry& entry = entries_[i];
+        if (entry.hash == EMPTY) {
+            return capacity_;
+        }
+        if (entry.hash == hash && entry.key() == key) {
+            return i;
+        }
+    }
+}
+
+const KvTable::Entry* KvTable::find(std::string_view key, uint64_t hash, uint64_t now_ns) {
+    hash |= HASH_BIT;
+    size_t index = probe(key, hash);
+    if (index == capacity_) {
+        return nullptr;
+    }
+    Entry& entry = entries_[index];
+    if (entry.expires_ns != 0 && entry.expires_ns <= now_ns) {
+        remove(entry);
+        return nullptr;
+    }
+    return &entry;
+}
+
+bool KvTable::assign(std::string_view key, uint64_t hash, std::string_view value, uint64_t expires_ns) {
+    hash |= HASH_BIT;
+    size_t index = probe(key, hash);
+    if (index != capacity_) {
+        Entry& entry = entries_[index];
+        if (!entry.is_inline()) {
+            delete[] entry.heap;
+        }
+        store(entry, key, value);
+        entry.expires_ns = expires_ns;
+        return true;
+    }
+
+    // Надгробия тоже занимают цепочки пробирования, поэтому считаются в загрузку
+    if ((size_ + tombstones_ + 1) * 4 > capacity_ * 3) {
+        grow();
+    }
+    size_t mask = capacity_ - 1;
+    size_t i = hash & mask;
+    while (entries_[i].hash & HASH_BIT) {
+        i = (i + 1) & mask;
+    }
+    Entry& entry = entries_[i];
+    if (entry.hash == TOMBSTONE) {
+        --tombstones_;
+    }
+    entry.hash = hash;
+    entry.expires_ns = expires_ns;
+    store(entry, key, value);
+    ++size_;
+    return false;
+}
+
+bool KvTable::erase(std::string_view key, uint64_t hash) {
+    size_t index = probe(key, hash | HASH_BIT);
+    if (index == capacity_) {
+        return false;
+    }
+    remove(entries_[index]);
+    return true;
+}
+
+size_t KvTable::sweep(uint64_t now_ns, size_t max_slots, size_t& cursor) {
+    size_t removed = 0;
+    for (size_t n = 0; n < max_slots && n < capacity_; ++n) {
+        if (cursor >= capacity_) {
+            cursor = 0;
+        }
+        Entry& entry = entries_[cursor++];
+        if ((entry.hash & HASH_BIT) && entry.expires_ns != 0 && entry.expires_ns <= now_ns) {
+            remove(entry);
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+void KvTable::store(Entry& entry, std::string_view key, std::string_view value) {
+    entry.key_size = static_cast<uint32_t>(key.size());
+    entry.value_size = static_cast<uint32_t>(value.size());
+    char* data = entry.inline_data;
+    if (!entry.is_inline()) {
+        entry.heap = new char[key.size() + value.size()];
+        data = entry.heap;
+    }
+    std::memcpy(data, key.data(), key.size());
+    std::memcpy(data + key.size(), value.data(), value.size());
+}
+
+void KvTable::remove(Entry& entry) {
+    if (!entry.is_inline()) {
+        delete[] entry.heap;
+    }
+    entry.hash = TOMBSTONE;
+    entry.key_size = 0;
+    entry.value_size = 0;
+    --size_;
+    ++tombstones_;
+}
+
+void KvTable::grow() {
+    // Если место заняли в основном надгробия, таблица пересобирается того же размера
+    size_t capacity = (size_ + 1) * 2 > capacity_ / 2 ? capacity_ * 2 : capacity_;
+    std::unique_ptr<Entry[]> old = std::move(entries_);
+    entries_.reset(new Entry[capacity]());
+    size_t old_capacity = capacity_;
+    capacity_ = capacity;
+    tombstones_ = 0;
+
+    size_t mask = capacity_ - 1;
+    for (size_t j = 0; j < old_capacity; ++j) {
+        if (!(old[j].hash & HASH_BIT)) {
+            continue;
+        }
+        size_t i = old[j].hash & mask;
+        while (entries_[i].hash != EMPTY) {
+            i = (i + 1) & mask;
+        }
+        // Ячейка переносится побайтно: буфер в куче переходит к новой копии
+        std::memcpy(&entries_[i], &old[j], sizeof(Entry));
+    }
+}
+
+KvStore::KvStore(size_t shards, size_t max_keys)
+    : shard_mask_(round_up_pow2(shards ? shards : 1) - 1)
+    , max_keys_(max_keys) {
+    shards_.reserve(shard_mask_ + 1);
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+KvStore::~KvStore() = default;
+
+bool KvStore::valid_key(std::string_view key) {
+    if (key.empty() || key.size() > MAX_KEY_LENGTH) {
+        return false;
+    }
+    return key.find_first_of(" \t\r\n") == std::string_view::npos;
+}
+
+uint64_t KvStore::now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+KvStore::Result KvStore::set(std::string_view key, std::string_view value, uint64_t ttl_ms) {
+    uint64_t hash = hash_key(key);
+    uint64_t now = now_ns();
+    uint64_t expires = ttl_ms ? now + ttl_ms * 1000000 : 0;
+    Shard& shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    size_t before = shard.table.size();
+    bool exists = shard.table.find(key, hash, now) != nullptr;
+    if (shard.table.size() < before) {
+        keys_.fetch_sub(1, std::memory_order_relaxed);
+        expired_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!exists && keys_.load(std::memory_order_relaxed) >= max_keys_.load(std::memory_order_relaxed)) {
+        return Result::Full;
+    }
+    if (!shard.table.assign(key, hash, value, expires)) {
+        keys_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return Result::Ok;
+}
+
+template <typename String>
+bool KvStore::get_into(std::string_view key, String& value) {
+    uint64_t hash = hash_key(key);
+    Shard& shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    size_t before = shard.table.size();
+    const KvTable::Entry* entry = shard.table.find(key, hash, now_ns());
+    if (!entry) {
+        if (shard.table.size() < before) {
+            keys_.fetch_sub(1, std::memory_order_relaxed);
+            expired_.fetch_add(1, std::memory_order_relaxed);
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    value.assign(entry->value());
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool KvStore::get(std::string_view key, std::string& value) {
+    return get_into(key, value);
+}
+
+bool KvStore::get(std::string_view key, std::pmr::string& value) {
+    return get_into(key, value);
+}
+
+bool KvStore::del(std::string_view key) {
+    uint64_t hash = hash_key(key);
+    Shard& shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    size_t before = shard.table.size();
+    bool live = shard.table.find(key, hash, now_ns()) != nullptr;
+    if (live) {
+        shard.table.erase(key, hash);
+    } else if (shard.table.size() < before) {
+        expired_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (shard.table.size() < before) {
+        keys_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return live;
+}
+
+KvStore::Result KvStore::incr(std::string_view key, int64_t delta, int64_t& result) {
+    uint64_t hash = hash_key(key);
+    uint64_t now = now_ns();
+    Shard& shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    size_t before = shard.table.size();
+    const KvTable::Entry* entry = shard.table.find(key, hash, now);
+    if (shard.table.size() < before) {
+        keys_.fetch_sub(1, std::memory_order_relaxed);
+        expired_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int64_t current = 0;
+    uint64_t expires = 0;
+    if (entry) {
+        std::string_view text = entry->value();
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), current);
+        if (ec != std::errc() || ptr != text.data() + text.size()) {
+            return Result::NotInteger;
+        }
+        expires = entry->expires_ns;
+    } else if (keys_.load(std::memory_order_relaxed) >= max_keys_.load(std::memory_order_relaxed)) {
+        return Result::Full;
+    }
+    if (__builtin_add_overflow(current, delta, &result)) {
+        return Result::Overflow;
+    }
+
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), result);
+    (void)ec;
+    if (!shard.table.assign(key, hash, std::string_view(buffer, static_cast<size_t>(end - buffer)), expires)) {
+        keys_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return Result::Ok;
+}
+
+size_t KvStore::sweep_expired(size_t max_slots) {
+    uint64_t now = now_ns();
+    size_t removed = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        removed += shard->table.sweep(now, max_slots, shard->sweep_cursor);
+    }
+    if (removed > 0) {
+        keys_.fetch_sub(removed, std::memory_order_relaxed);
+        expired_.fetch_add(removed, std::memory_order_relaxed);
+    }
+    return removed;
+}
+
+KvStats KvStore::stats() const {
+    KvStats stats{};
+    stats.keys = keys_.load(std::memory_order_relaxed);
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.expired = expired_.load(std::memory_order_relaxed);
+    return stats;
+}
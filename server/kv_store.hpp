@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Хеш-таблица с открытой адресацией (линейное пробирование, надгробия).
+// Ключ и значение лежат подряд в одной ячейке, если помещаются в
+// INLINE_CAPACITY байт, иначе - в одном буфере в куче. Не потокобезопасна.
+class KvTable {
+public:
+    static constexpr size_t INLINE_CAPACITY = 48;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    struct Entry {
+        uint64_t hash;        // EMPTY, TOMBSTONE или хеш с HASH_BIT
+        uint64_t expires_ns;  // 0 - без срока
+        uint32_t key_size;
+        uint32_t value_size;
+        union {
+            char inline_data[INLINE_CAPACITY];
+            char* heap;
+        };
+
+        bool is_inline() const { return key_size + value_size <= INLINE_CAPACITY; }
+        const char* data() const { return is_inline() ? inline_data : heap; }
+        std::string_view key() const { return {data(), key_size}; }
+        std::string_view value() const { return {data() + key_size, value_size}; }
+    };
+
+    KvTable();
+    ~KvTable();
+    KvTable(const KvTable&) = delete;
+    KvTable& operator=(const KvTable&) = delete;
+
+    // Просроченная запись удаляется при обращении и не находится
+    const Entry* find(std::string_view key, uint64_t hash, uint64_t now_ns);
+    // false - ключа не было (вставка), true - значение заменено
+    bool assign(std::string_view key, uint64_t hash, std::string_view value, uint64_t expires_ns);
+    bool erase(std::string_view key, uint64_t hash);
+    // Проходит до max_slots ячеек с позиции cursor, удаляя просроченные
+    size_t sweep(uint64_t now_ns, size_t max_slots, size_t& cursor);
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr uint64_t EMPTY = 0;
+    static constexpr uint64_t TOMBSTONE = 1;
+    static constexpr uint64_t HASH_BIT = 1ULL << 63;
+
+    size_t probe(std::string_view key, uint64_t hash) const;
+    void store(Entry& entry, std::string_view key, std::string_view value);
+    void remove(Entry& entry);
+    void grow();
+
+    std::unique_ptr<Entry[]> entries_;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    size_t tombstones_ = 0;
+};
+
+struct KvStats {
+    size_t keys;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t expired;
+};
+
+// Хранилище для /set, /get, /del, /incr, /mget: ключ по хешу попадает в
+// один из шардов, у каждого шарда своя таблица и свой мьютекс, так что
+// реакторы, работающие с разными шардами, не мешают друг другу.
+class KvStore {
+public:
+    static constexpr size_t DEFAULT_SHARDS = 16;
+    static constexpr size_t DEFAULT_MAX_KEYS = 1000000;
+    static constexpr size_t MAX_KEY_LENGTH = 256;
+
+    enum class Result { Ok, Full, NotInteger, Overflow };
+
+    explicit KvStore(size_t shards = DEFAULT_SHARDS, size_t max_keys = DEFAULT_MAX_KEYS);
+    ~KvStore();
+
+    // ttl_ms = 0 - без срока
+    Result set(std::string_view key, std::string_view value, uint64_t ttl_ms = 0);
+    bool get(std::string_view key, std::string& value);
+    // Значение копируется прямо в арену запроса
+    bool get(std::string_view key, std::pmr::string& value);
+    bool del(std::string_view key);
+    // Отсутствующий ключ считается нулём; срок жизни сохраняется
+    Result incr(std::string_view key, int64_t delta, int64_t& result);
+
+    // Фоновая очистка: до max_slots ячеек каждого шарда за вызов
+    size_t sweep_expired(size_t max_slots);
+
+    void set_max_keys(size_t max_keys) { max_keys_.store(max_keys, std::memory_order_relaxed); }
+    size_t shard_count() const { return shards_.size(); }
+    KvStats stats() const;
+
+    static bool valid_key(std::string_view key);
+    static uint64_t now_ns();
+
+private:
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        KvTable table;
+        size_t sweep_cursor = 0;
+    };
+
+    Shard& shard_for(uint64_t hash) { return *shards_[(hash >> 32) & shard_mask_]; }
+
+    template <typename String>
+    bool get_into(std::string_view key, String& value);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t shard_mask_;
+    std::atomic<size_t> max_keys_;
+    std::atomic<size_t> keys_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> expired_{0};
+};
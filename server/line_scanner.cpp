@@ -0,0 +1,151 @@
+#include "line_scanner.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINE_SCANNER_X86 1
+#endif
+
+namespace {
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+inline void emit_line(const char* data, size_t begin, size_t newline, std::vector<LineSpan>& lines) {
+    size_t end = newline;
+    while (end > begin && is_space(data[end - 1])) {
+        --end;
+    }
+    lines.push_back({begin, end - begin});
+}
+
+// Хвост буфера, не кратный ширине вектора, дорабатывается скалярно.
+size_t scan_tail(const char* data, size_t pos, size_t size, size_t line_begin,
+                 std::vector<LineSpan>& lines) {
+    for (; pos < size; ++pos) {
+        if (data[pos] == '\n') {
+            emit_line(data, line_begin, pos, lines);
+            line_begin = pos + 1;
+        }
+    }
+    return line_begin;
+}
+
+} // namespace
+
+const LineScanner::Isa LineScanner::active_isa_ = LineScanner::detect_isa();
+const LineScanner::ScanFn LineScanner::scan_fn_ = LineScanner::resolve(LineScanner::active_isa_);
+
+size_t LineScanner::scan_scalar(const char* data, size_t size, std::vector<LineSpan>& lines) {
+    size_t line_begin = 0;
+    const void* found;
+    while ((found = std::memchr(data + line_begin, '\n', size - line_begin)) != nullptr) {
+        size_t nl = static_cast<size_t>(static_cast<const char*>(found) - data);
+        emit_line(data, line_begin, nl, lines);
+        line_begin = nl + 1;
+    }
+    return line_begin;
+}
+
+#ifdef LINE_SCANNER_X86
+
+size_t LineScanner::scan_sse2(const char* data, size_t size, std::vector<LineSpan>& lines) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t line_begin = 0;
+    size_t pos = 0;
+
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        while (mask != 0) {
+            size_t nl = pos + static_cast<size_t>(__builtin_ctz(mask));
+            emit_line(data, line_begin, nl, lines);
+            line_begin = nl + 1;
+            mask &= mask - 1;
+        }
+    }
+
+    return scan_tail(data, pos, size, line_begin, lines);
+}
+
+__attribute__((target("avx2")))
+size_t LineScanner::scan_avx2(const char* data, size_t size, std::vector<LineSpan>& lines) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t line_begin = 0;
+    size_t pos = 0;
+
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        while (mask != 0) {
+            size_t nl = pos + static_cast<size_t>(__builtin_ctz(mask));
+            emit_line(data, line_begin, nl, lines);
+            line_begin = nl + 1;
+            mask &= mask - 1;
+        }
+    }
+
+    return scan_tail(data, pos, size, line_begin, lines);
+}
+
+#else
+
+size_t LineScanner::scan_sse2(const char* data, size_t size, std::vector<LineSpan>& lines) {
+    return scan_scalar(data, size, lines);
+}
+
+size_t LineScanner::scan_avx2(const char* data, size_t size, std::vector<LineSpan>& lines) {
+    return scan_scalar(data, size, lines);
+}
+
+#endif
+
+std::string_view LineScanner::trim(std::string_view text) {
+    size_t end = text.size();
+    while (end > 0 && is_space(text[end - 1])) {
+        --end;
+    }
+    return text.substr(0, end);
+}
+
+bool LineScanner::supported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+#ifdef LINE_SCANNER_X86
+        case Isa::Sse2:
+            return __builtin_cpu_supports("sse2");
+        case Isa::Avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* LineScanner::isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2: return "avx2";
+        case Isa::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+LineScanner::Isa LineScanner::detect_isa() {
+#ifdef LINE_SCANNER_X86
+    __builtin_cpu_init();
+#endif
+    if (supported(Isa::Avx2)) return Isa::Avx2;
+    if (supported(Isa::Sse2)) return Isa::Sse2;
+    return Isa::Scalar;
+}
+
+LineScanner::ScanFn LineScanner::resolve(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2: return &LineScanner::scan_avx2;
+        case Isa::Sse2: return &LineScanner::scan_sse2;
+        default: return &LineScanner::scan_scalar;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+struct LineSpan {
+    size_t offset;
+    size_t length;
+};
+
+// Разбивает буфер чтения на строки по '\n' и обрезает хвостовые пробельные
+// символы (" \t\r\f\v") каждой строки за один проход. Поиск разделителей
+// векторизован (SSE2/AVX2), реализация выбирается при старте по CPUID.
+class LineScanner {
+public:
+    enum class Isa { Scalar, Sse2, Avx2 };
+
+    using ScanFn = size_t (*)(const char* data, size_t size, std::vector<LineSpan>& lines);
+
+    // Добавляет в lines все завершённые строки и возвращает число
+    // поглощённых байт (позиция после последнего '\n').
+    static size_t scan(const char* data, size_t size, std::vector<LineSpan>& lines) {
+        return scan_fn_(data, size, lines);
+    }
+
+    static size_t scan_scalar(const char* data, size_t size, std::vector<LineSpan>& lines);
+    static size_t scan_sse2(const char* data, size_t size, std::vector<LineSpan>& lines);
+    static size_t scan_avx2(const char* data, size_t size, std::vector<LineSpan>& lines);
+
+    static std::string_view trim(std::string_view text);
+
+    static Isa active_isa() { return active_isa_; }
+    static bool supported(Isa isa);
+    static const char* isa_name(Isa isa);
+
+private:
+    static Isa detect_isa();
+    static ScanFn resolve(Isa isa);
+
+    static const Isa active_isa_;
+    static const ScanFn scan_fn_;
+};
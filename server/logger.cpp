@@ -0,0 +1,489 @@
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <ctime>
+#include <csignal>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(50);
+constexpr uint64_t DROP_REPORT_INTERVAL_NS = 1000000000ull;
+constexpr size_t MAX_BUFFERED = 64 * 1024;
+constexpr const char* JOURNALD_SOCKET = "/run/systemd/journal/socket";
+
+uint64_t realtime_ns() {
+    timespec ts{};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+size_t round_up_pow2(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+int syslog_priority(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return 7;
+    case LogLevel::Info: return 6;
+    case LogLevel::Warning: return 4;
+    case LogLevel::Error: return 3;
+    }
+    return 6;
+}
+
+void append_timestamp(std::string& out, uint64_t ns) {
+    time_t seconds = static_cast<time_t>(ns / 1000000000ull);
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char buffer[40];
+    size_t len = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+    len += static_cast<size_t>(std::snprintf(buffer + len, sizeof(buffer) - len, ".%06lluZ",
+                                             static_cast<unsigned long long>(ns % 1000000000ull / 1000)));
+    out.append(buffer, len);
+}
+
+// Подставляет аргументы записи вместо {} в строке формата
+void append_message(std::string& out, const LogRecord& record) {
+    const char* data = record.data;
+    const char* end = record.data + record.size;
+    for (const char* p = record.format; *p; ++p) {
+        if (p[0] != '{' || p[1] != '}' || data >= end) {
+            out.push_back(*p);
+            continue;
+        }
+        ++p;
+        auto type = static_cast<log_detail::ArgType>(*data++);
+        char number[32];
+        switch (type) {
+        case log_detail::ArgType::Int: {
+            int64_t value;
+            std::memcpy(&value, data, sizeof(value));
+            data += sizeof(value);
+            out.append(number, static_cast<size_t>(std::snprintf(number, sizeof(number), "%lld",
+                                                                 static_cast<long long>(value))));
+            break;
+        }
+        case log_detail::ArgType::Uint: {
+            uint64_t value;
+            std::memcpy(&value, data, sizeof(value));
+            data += sizeof(value);
+            out.append(number, static_cast<size_t>(std::snprintf(number, sizeof(number), "%llu",
+                                                                 static_cast<unsigned long long>(value))));
+            break;
+        }
+        case log_detail::ArgType::Double: {
+            double value;
+            std::memcpy(&value, data, sizeof(value));
+            data += sizeof(value);
+            out.append(number, static_cast<size_t>(std::snprintf(number, sizeof(number), "%g", value)));
+            break;
+        }
+        case log_detail::ArgType::Char:
+            out.push_back(*data++);
+            break;
+        case log_detail::ArgType::Bool:
+            out.append(*data++ ? "true" : "false");
+            break;
+        case log_detail::ArgType::String: {
+            uint16_t length;
+            std::memcpy(&length, data, sizeof(length));
+            data += sizeof(length);
+            out.append(data, length);
+            data += length;
+            break;
+        }
+        }
+    }
+    if (record.truncated) {
+        out.append("...");
+    }
+}
+
+} // namespace
+
+void log_detail::Encoder::add_string(std::string_view text) {
+    size_t room = sizeof(record_.data) - record_.size;
+    if (room < 1 + sizeof(uint16_t) + 1) {
+        record_.truncated = true;
+        return;
+    }
+    size_t length = std::min(text.size(), room - 1 - sizeof(uint16_t));
+    if (length < text.size()) {
+        record_.truncated = true;
+    }
+    auto length16 = static_cast<uint16_t>(length);
+    char* out = record_.data + record_.size;
+    out[0] = static_cast<char>(ArgType::String);
+    std::memcpy(out + 1, &length16, sizeof(length16));
+    std::memcpy(out + 1 + sizeof(length16), text.data(), length);
+    record_.size = static_cast<uint16_t>(record_.size + 1 + sizeof(length16) + length);
+    ++record_.args;
+}
+
+bool parse_log_level(std::string_view text, LogLevel& level) {
+    if (text == "debug") {
+        level = LogLevel::Debug;
+    } else if (text == "info") {
+        level = LogLevel::Info;
+    } else if (text == "warning") {
+        level = LogLevel::Warning;
+    } else if (text == "error") {
+        level = LogLevel::Error;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* log_level_name(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return "debug";
+    case LogLevel::Info: return "info";
+    case LogLevel::Warning: return "warning";
+    case LogLevel::Error: return "error";
+    }
+    return "info";
+}
+
+// Голова пишется только владельцем потока, хвост - только фоновым потоком;
+// поля разнесены по строкам кеша
+struct Logger::Ring {
+    explicit Ring(size_t capacity)
+        : mask(capacity - 1)
+        , records(new LogRecord[capacity]) {}
+
+    alignas(64) std::atomic<uint64_t> head{0};
+    uint64_t cached_tail = 0;
+    std::atomic<uint64_t> dropped{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    // Поток-владелец завершился - буфер можно отдать новому потоку
+    std::atomic<bool> owned{true};
+    const size_t mask;
+    std::unique_ptr<LogRecord[]> records;
+};
+
+struct Logger::Sink {
+    int fd = STDERR_FILENO;
+    bool owns_fd = false;
+    bool journald = false;
+    std::string path;
+
+    ~Sink() {
+        if (owns_fd) {
+            ::close(fd);
+        }
+    }
+
+    bool open(std::string& error) {
+        if (path == "stderr" || path == "stdout") {
+            fd = path == "stderr" ? STDERR_FILENO : STDOUT_FILENO;
+            return true;
+        }
+        int new_fd;
+        if (journald) {
+            new_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::strncpy(addr.sun_path, JOURNALD_SOCKET, sizeof(addr.sun_path) - 1);
+            if (new_fd != -1 && connect(new_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+                ::close(new_fd);
+                new_fd = -1;
+            }
+        } else {
+            new_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        }
+        if (new_fd == -1) {
+            error = "cannot open log output " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        if (owns_fd) {
+            ::close(fd);
+        }
+        fd = new_fd;
+        owns_fd = true;
+        return true;
+    }
+};
+
+namespace {
+
+struct RingHandle {
+    uint64_t logger_id = 0;
+    std::shared_ptr<void> ring;
+    std::atomic<bool>* owned = nullptr;
+
+    ~RingHandle() { release(); }
+
+    void release() {
+        if (owned) {
+            owned->store(false, std::memory_order_release);
+        }
+        ring.reset();
+        owned = nullptr;
+        logger_id = 0;
+    }
+};
+
+thread_local RingHandle thread_ring_handle;
+std::atomic<uint64_t> next_logger_id{1};
+
+} // namespace
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger(size_t ring_capacity)
+    : ring_capacity_(round_up_pow2(std::max<size_t>(ring_capacity, 2)))
+    , id_(next_logger_id.fetch_add(1, std::memory_order_relaxed))
+    , sink_(std::make_unique<Sink>()) {
+    sink_->path = "stderr";
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+bool Logger::start(const std::string& output, std::string& error) {
+    if (running_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    auto sink = std::make_unique<Sink>();
+    sink->path = output.empty() ? "stderr" : output;
+    sink->journald = sink->path == "journald";
+    if (!sink->open(error)) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        sink_ = std::move(sink);
+    }
+    stopping_ = false;
+    running_.store(true, std::memory_order_release);
+    // Поток запускается раньше, чем сервер блокирует сигналы для signalfd,
+    // и наследует маску: сигналы процесса ему доставляться не должны
+    sigset_t all;
+    sigset_t previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    thread_ = std::thread([this] { run(); });
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    return true;
+}
+
+void Logger::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    // Записи, попавшие в буферы во время остановки
+    drain();
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    report_dropped(true);
+    flush();
+}
+
+LoggerStats Logger::stats() const {
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (const auto& ring : rings_) {
+            dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    return LoggerStats{records_.load(std::memory_order_relaxed), dropped,
+                       write_errors_.load(std::memory_order_relaxed)};
+}
+
+void Logger::submit(LogRecord& record) {
+    record.timestamp_ns = realtime_ns();
+    if (!running_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        records_.fetch_add(1, std::memory_order_relaxed);
+        emit(record);
+        flush();
+        return;
+    }
+
+    Ring* ring = thread_ring();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->cached_tail > ring->mask) {
+        ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+        if (head - ring->cached_tail > ring->mask) {
+            ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    std::memcpy(static_cast<void*>(&ring->records[head & ring->mask]), &record,
+                offsetof(LogRecord, data) + record.size);
+    ring->head.store(head + 1, std::memory_order_release);
+
+    // Фоновый поток просыпается и сам раз в FLUSH_INTERVAL, поэтому
+    // пропущенное из-за гонки уведомление только задерживает вывод
+    if (waiting_.load(std::memory_order_relaxed) && waiting_.exchange(false)) {
+        wake_.notify_one();
+    }
+}
+
+Logger::Ring* Logger::thread_ring() {
+    RingHandle& handle = thread_ring_handle;
+    if (handle.logger_id == id_) {
+        return static_cast<Ring*>(handle.ring.get());
+    }
+    handle.release();
+
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    std::shared_ptr<Ring> ring;
+    for (const auto& candidate : rings_) {
+        bool expected = false;
+        if (candidate->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            ring = candidate;
+            break;
+        }
+    }
+    if (!ring) {
+        ring = std::make_shared<Ring>(ring_capacity_);
+        rings_.push_back(ring);
+    }
+    handle.logger_id = id_;
+    handle.owned = &ring->owned;
+    handle.ring = ring;
+    return ring.get();
+}
+
+void Logger::run() {
+    while (true) {
+        if (drain() > 0) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        if (stopping_) {
+            break;
+        }
+        waiting_.store(true, std::memory_order_relaxed);
+        wake_.wait_for(lock, FLUSH_INTERVAL);
+        waiting_.store(false, std::memory_order_relaxed);
+    }
+    drain();
+}
+
+size_t Logger::drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    if (reopen_.exchange(false, std::memory_order_relaxed) && sink_->owns_fd && !sink_->journald) {
+        std::string error;
+        if (!sink_->open(error)) {
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    size_t count = 0;
+    for (const auto& ring : rings) {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            emit(ring->records[tail & ring->mask]);
+            ++count;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+    records_.fetch_add(count, std::memory_order_relaxed);
+    report_dropped(false);
+    flush();
+    return count;
+}
+
+void Logger::emit(const LogRecord& record) {
+    if (sink_->journald) {
+        // Нативный протокол journald: MESSAGE в двоичной форме с длиной
+        std::string message;
+        append_message(message, record);
+        std::string datagram = "PRIORITY=" + std::to_string(syslog_priority(record.level)) +
+                               "\nSYSLOG_IDENTIFIER=async_tcp_udp_server\nMESSAGE\n";
+        uint64_t length = message.size();
+        for (int i = 0; i < 8; ++i) {
+            datagram.push_back(static_cast<char>((length >> (8 * i)) & 0xff));
+        }
+        datagram.append(message).push_back('\n');
+        if (::send(sink_->fd, datagram.data(), datagram.size(), MSG_NOSIGNAL) == -1) {
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    append_timestamp(buffer_, record.timestamp_ns);
+    buffer_.push_back(' ');
+    buffer_.append(log_level_name(record.level));
+    buffer_.push_back(' ');
+    append_message(buffer_, record);
+    buffer_.push_back('\n');
+    if (buffer_.size() >= MAX_BUFFERED) {
+        flush();
+    }
+}
+
+void Logger::flush() {
+    size_t offset = 0;
+    while (offset < buffer_.size()) {
+        ssize_t written = ::write(sink_->fd, buffer_.data() + offset, buffer_.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        offset += static_cast<size_t>(written);
+    }
+    buffer_.clear();
+}
+
+void Logger::report_dropped(bool force) {
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (const auto& ring : rings_) {
+            dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    uint64_t now = realtime_ns();
+    if (dropped == reported_dropped_ || (!force && now - last_drop_report_ns_ < DROP_REPORT_INTERVAL_NS)) {
+        return;
+    }
+
+    LogRecord record;
+    record.timestamp_ns = now;
+    record.format = "Logger: {} record(s) dropped, buffers full";
+    record.level = LogLevel::Warning;
+    record.args = 0;
+    record.size = 0;
+    record.truncated = false;
+    log_detail::Encoder(record).add(dropped - reported_dropped_);
+    reported_dropped_ = dropped;
+    last_drop_report_ns_ = now;
+    emit(record);
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel : uint8_t { Debug, Info, Warning, Error };
+
+bool parse_log_level(std::string_view text, LogLevel& level);
+const char* log_level_name(LogLevel level);
+
+struct LoggerStats {
+    uint64_t records;
+    uint64_t dropped;
+    uint64_t write_errors;
+};
+
+// Запись журнала фиксированного размера: строка формата - литерал, хранится
+// указателем, аргументы закодированы в data и форматируются фоновым потоком
+struct LogRecord {
+    uint64_t timestamp_ns;
+    const char* format;
+    LogLevel level;
+    uint8_t args;
+    uint16_t size;
+    bool truncated;
+    char data[256 - 24];
+};
+static_assert(sizeof(LogRecord) == 256, "LogRecord must stay one fixed slot");
+
+namespace log_detail {
+
+enum class ArgType : uint8_t { Int, Uint, Double, Char, Bool, String };
+
+class Encoder {
+public:
+    explicit Encoder(LogRecord& record) : record_(record) {}
+
+    template <typename T>
+    void add(const T& value) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, bool>) {
+            put(ArgType::Bool, static_cast<uint8_t>(value));
+        } else if constexpr (std::is_same_v<U, char>) {
+            put(ArgType::Char, value);
+        } else if constexpr (std::is_enum_v<U>) {
+            add(static_cast<std::underlying_type_t<U>>(value));
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            put(ArgType::Int, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<U>) {
+            put(ArgType::Uint, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_floating_point_v<U>) {
+            put(ArgType::Double, static_cast<double>(value));
+        } else {
+            add_string(std::string_view(value));
+        }
+    }
+
+private:
+    template <typename T>
+    void put(ArgType type, T value) {
+        if (record_.size + 1 + sizeof(T) > sizeof(record_.data)) {
+            record_.truncated = true;
+            return;
+        }
+        record_.data[record_.size] = static_cast<char>(type);
+        std::memcpy(record_.data + record_.size + 1, &value, sizeof(T));
+        record_.size = static_cast<uint16_t>(record_.size + 1 + sizeof(T));
+        ++record_.args;
+    }
+
+    void add_string(std::string_view text);
+
+    LogRecord& record_;
+};
+
+} // namespace log_detail
+
+// Асинхронный журнал: каждый поток пишет в свой SPSC-кольцевой буфер без
+// блокировок и системных вызовов, фоновый поток форматирует записи и пишет
+// их в stderr, файл или journald. При переполнении буфера запись
+// отбрасывается и учитывается в счётчике, о потерях фоновый поток сообщает
+// не чаще раза в секунду.
+class Logger {
+public:
+    static constexpr size_t DEFAULT_RING_CAPACITY = 1024;
+
+    static Logger& instance();
+
+    explicit Logger(size_t ring_capacity = DEFAULT_RING_CAPACITY);
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // output: "stderr", "stdout", "journald" или путь к файлу
+    bool start(const std::string& output, std::string& error);
+    // Дописывает накопленные записи и останавливает поток; после этого
+    // записи выводятся синхронно
+    void stop();
+    // Переоткрыть файл после ротации (SIGHUP)
+    void reopen() { reopen_.store(true, std::memory_order_relaxed); }
+
+    void set_level(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= level_.load(std::memory_order_relaxed); }
+
+    template <size_t N, typename... Args>
+    void write(LogLevel level, const char (&format)[N], const Args&... args) {
+        LogRecord record;
+        record.timestamp_ns = 0;
+        record.format = format;
+        record.level = level;
+        record.args = 0;
+        record.size = 0;
+        record.truncated = false;
+        log_detail::Encoder encoder(record);
+        (encoder.add(args), ...);
+        submit(record);
+    }
+
+    LoggerStats stats() const;
+    // Фоновый поток, для привязки к CPU после start()
+    pthread_t native_handle() { return thread_.native_handle(); }
+
+private:
+    struct Ring;
+    struct Sink;
+
+    void submit(LogRecord& record);
+    Ring* thread_ring();
+    void run();
+    size_t drain();
+    void emit(const LogRecord& record);
+    void flush();
+    void report_dropped(bool force);
+
+    size_t ring_capacity_;
+    // Отличает экземпляры в thread_local-привязке потока к буферу
+    uint64_t id_;
+    std::atomic<LogLevel> level_{LogLevel::Info};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> waiting_{false};
+    std::atomic<bool> reopen_{false};
+    std::atomic<uint64_t> records_{0};
+    std::atomic<uint64_t> write_errors_{0};
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    // Только фоновый поток (или вызывающий, пока поток не запущен)
+    std::mutex sink_mutex_;
+    std::unique_ptr<Sink> sink_;
+    std::string buffer_;
+    uint64_t reported_dropped_ = 0;
+    uint64_t last_drop_report_ns_ = 0;
+};
+
+#define LOG_AT(level, ...)                                  \
+    do {                                                    \
+        Logger& server_logger_ = Logger::instance();        \
+        if (server_logger_.enabled(level)) {                \
+            server_logger_.write(level, __VA_ARGS__);       \
+        }                                                   \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
@@ -1,52 +1,149 @@
 #include "server.hpp"
+#include "affinity.hpp"
+#include "logger.hpp"
 #include <iostream>
 #include <cstdlib>
 #include <memory>
+#include <fstream>
+#include <climits>
+#include <unistd.h>
+
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--config <path>] [port]" << std::endl;
+    std::cerr << "Or set SERVER_PORT environment variable" << std::endl;
+    std::cerr << "Config file: --config, SERVER_CONFIG or " << ServerConfig::DEFAULT_PATH << std::endl;
+}
+
+// Путь берётся при старте: после замены файла /proc/self/exe указывает
+// на удалённый старый бинарник, а exec по этому пути запустит новый
+static std::vector<std::string> upgrade_command(int argc, char* argv[]) {
+    std::vector<std::string> command;
+    char path[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) {
+        return command;
+    }
+    command.emplace_back(path, static_cast<size_t>(length));
+    for (int i = 1; i < argc; ++i) {
+        command.emplace_back(argv[i]);
+    }
+    return command;
+}
 
 int main(int argc, char* argv[]) {
-    uint16_t port = 0;
+    std::string config_path;
+    std::string port_arg;
     
-    char* env_port = std::getenv("SERVER_PORT");
-    if (env_port != nullptr) {
-        try {
-            port = static_cast<uint16_t>(std::stoi(env_port));
-            std::cout << "Using port from environment: " << port << std::endl;
-        } catch (const std::exception& e) {
-            std::cerr << "Error: Invalid SERVER_PORT environment variable" << std::endl;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (port_arg.empty() && arg.rfind("--", 0) != 0) {
+            port_arg = arg;
+        } else {
+            print_usage(argv[0]);
             return 1;
         }
-    } else if (argc == 2) {
+    }
+    
+    char* env_config = std::getenv("SERVER_CONFIG");
+    if (config_path.empty() && env_config != nullptr) {
+        config_path = env_config;
+    }
+    if (config_path.empty() && std::ifstream(ServerConfig::DEFAULT_PATH)) {
+        config_path = ServerConfig::DEFAULT_PATH;
+    }
+    
+    ServerConfig config;
+    std::string error;
+    std::vector<std::string> warnings;
+    
+    if (!config_path.empty() && !load_config_file(config_path, config, error, &warnings)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    
+    if (!port_arg.empty()) {
         try {
-            port = static_cast<uint16_t>(std::stoi(argv[1]));
-            std::cout << "Using port from command line: " << port << std::endl;
+            config.port = static_cast<uint16_t>(std::stoi(port_arg));
         } catch (const std::exception& e) {
             std::cerr << "Error: Invalid port number" << std::endl;
             return 1;
         }
-    } else {
-        std::cerr << "Usage: " << argv[0] << " <port>" << std::endl;
-        std::cerr << "Or set SERVER_PORT environment variable" << std::endl;
+    }
+    
+    if (!apply_env_overrides(config, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    
+    if (config.port == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    resolve_config_defaults(config);
+    
+    // До этой точки ошибки разбора аргументов печатаются напрямую
+    Logger& logger = Logger::instance();
+    LogLevel level = LogLevel::Info;
+    parse_log_level(config.log_level, level);
+    logger.set_level(level);
+    if (!logger.start(config.log_output, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    if (!config_path.empty()) {
+        for (const auto& warning : warnings) {
+            LOG_WARNING("Config warning: {}", warning);
+        }
+        LOG_INFO("Using configuration file: {}", config_path);
+    }
+    if (std::getenv("SERVER_PORT") != nullptr) {
+        LOG_INFO("Using port from environment: {}", config.port);
+    } else if (!port_arg.empty()) {
+        LOG_INFO("Using port from command line: {}", config.port);
+    }
+    
+    if (!pin_thread(logger.native_handle(), config.logger_cpus, error)) {
+        LOG_ERROR("Log thread: {}", error);
+        logger.stop();
         return 1;
     }
+    // Реактор привязывается до создания Server: таблица сессий, хранилище и
+    // арена, впервые тронутые этим потоком, окажутся на его узле NUMA.
+    // Потоки, созданные позже без своего списка, наследуют этот CPU.
+    if (!config.reactor_cpus.empty()) {
+        int cpu = config.reactor_cpus.front();
+        if (!pin_thread(pthread_self(), {cpu}, error)) {
+            LOG_ERROR("Reactor: {}", error);
+            logger.stop();
+            return 1;
+        }
+        LOG_INFO("Reactor pinned to CPU {} (NUMA node {})", cpu, cpu_node(cpu));
+    }
 
     try {
-        auto server = std::make_shared<Server>(port);
+        auto server = std::make_shared<Server>(config);
+        server->set_upgrade_command(upgrade_command(argc, argv));
         
         if (!server->start()) {
-            std::cerr << "Failed to start server" << std::endl;
+            LOG_ERROR("Failed to start server");
+            logger.stop();
             return 1;
         }
         
-        std::cout << "Server running on port " << port << std::endl;
-        std::cout << "Press Ctrl+C or send /shutdown to exit..." << std::endl;
+        LOG_INFO("Server running on port {}", config.port);
+        LOG_INFO("Press Ctrl+C or send /shutdown to exit...");
         
         server->run();
         
-        std::cout << "Server stopped gracefully" << std::endl;
+        LOG_INFO("Server stopped gracefully");
     } catch (const std::exception& e) {
-        std::cerr << "Exception: " << e.what() << std::endl;
+        LOG_ERROR("Exception: {}", e.what());
+        logger.stop();
         return 1;
     }
 
+    logger.stop();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+inline uint64_t monotonic_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Гистограмма задержек с фиксированными границами корзин в стиле Prometheus.
+// Счётчики атомарные (relaxed), поэтому читать её можно из любого потока.
+class LatencyHistogram {
+public:
+    static constexpr std::array<uint64_t, 16> BOUNDS_NS = {
+        1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000,
+        500000, 1000000, 2500000, 5000000, 10000000, 25000000, 50000000, 100000000,
+    };
+    // Последняя корзина - +Inf
+    static constexpr size_t BUCKET_COUNT = BOUNDS_NS.size() + 1;
+
+    void observe(uint64_t ns) {
+        size_t i = 0;
+        while (i < BOUNDS_NS.size() && ns > BOUNDS_NS[i]) {
+            ++i;
+        }
+        buckets_[i].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum_ns() const { return sum_ns_.load(std::memory_order_relaxed); }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_ns_{0};
+};
+
+// Этапы запроса для выборочной трассировки (latency_sample_rate): промежутки
+// между отметками recv -> строка разобрана -> передана командам -> execute
+// вернул ответ -> ответ отдан соединению -> последний байт записан в сокет
+enum class RequestStage { Parse, Dispatch, Execute, Queue, Write, Total };
+
+constexpr size_t REQUEST_STAGE_COUNT = 6;
+
+struct CommandMetrics {
+    std::atomic<uint64_t> requests{0};
+    LatencyHistogram latency;
+    // Только запросы из выборки, индекс - RequestStage
+    std::array<LatencyHistogram, REQUEST_STAGE_COUNT> stages;
+};
@@ -0,0 +1,80 @@
+#include "overload.hpp"
+
+#include <algorithm>
+
+const char* overload_state_name(OverloadState state) {
+    switch (state) {
+        case OverloadState::Normal: return "normal";
+        case OverloadState::NoAccept: return "no_accept";
+        case OverloadState::RejectUdp: return "reject_udp";
+        case OverloadState::Shed: return "shed";
+    }
+    return "unknown";
+}
+
+OverloadController::OverloadController(Clock::time_point now) : last_update_(now) {}
+
+bool OverloadController::enabled() const {
+    return thresholds_.lag.count() > 0 || thresholds_.queued_bytes > 0 || thresholds_.connections > 0;
+}
+
+OverloadState OverloadController::target(const OverloadLoad& load) const {
+    // Нагрузка в долях порога по самому загруженному сигналу
+    double pressure = 0;
+    auto consider = [&pressure](double value, double threshold) {
+        if (threshold > 0) {
+            pressure = std::max(pressure, value / threshold);
+        }
+    };
+    consider(static_cast<double>(load.lag_ns), static_cast<double>(thresholds_.lag.count()));
+    consider(static_cast<double>(load.queued_bytes), static_cast<double>(thresholds_.queued_bytes));
+    consider(static_cast<double>(load.connections), static_cast<double>(thresholds_.connections));
+    if (pressure >= 4) return OverloadState::Shed;
+    if (pressure >= 2) return OverloadState::RejectUdp;
+    if (pressure >= 1) return OverloadState::NoAccept;
+    return OverloadState::Normal;
+}
+
+bool OverloadController::update(const OverloadLoad& load, Clock::time_point now) {
+    OverloadState current = state();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_update_).count();
+    auto& time = time_ns_[static_cast<size_t>(current)];
+    time.store(time.load(std::memory_order_relaxed) + static_cast<uint64_t>(std::max<int64_t>(elapsed, 0)),
+               std::memory_order_relaxed);
+    last_update_ = now;
+
+    OverloadState next = current;
+    OverloadState wanted = enabled() ? target(load) : OverloadState::Normal;
+    if (wanted > current) {
+        // Вверх - сразу, через ступени
+        next = wanted;
+        calm_ = false;
+    } else if (wanted < current) {
+        // Вниз - по одной ступени после cooldown, чтобы не колебаться на пороге
+        if (!calm_) {
+            calm_ = true;
+            calm_since_ = now;
+        }
+        if (now - calm_since_ >= thresholds_.cooldown || !enabled()) {
+            next = static_cast<OverloadState>(static_cast<int>(current) - 1);
+            calm_since_ = now;
+        }
+    } else {
+        calm_ = false;
+    }
+
+    if (next == current) {
+        return false;
+    }
+    state_.store(next, std::memory_order_relaxed);
+    transitions_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::array<uint64_t, OVERLOAD_STATE_COUNT> OverloadController::time_in_state_ns() const {
+    std::array<uint64_t, OVERLOAD_STATE_COUNT> result{};
+    for (size_t i = 0; i < OVERLOAD_STATE_COUNT; ++i) {
+        result[i] = time_ns_[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Ступени защиты от перегрузки; каждая включает меры предыдущих
+enum class OverloadState {
+    Normal,
+    NoAccept,   // новые соединения ждут в очереди listen
+    RejectUdp,  // UDP-запросы получают BUSY без обработки
+    Shed,       // команды низкого приоритета отклоняются
+};
+
+constexpr size_t OVERLOAD_STATE_COUNT = 4;
+
+const char* overload_state_name(OverloadState state);
+
+// Пороги первой ступени; 0 - сигнал не учитывается. Следующая ступень
+// включается при вдвое большем превышении: нагрузка / порог >= 1, 2, 4.
+struct OverloadThresholds {
+    std::chrono::nanoseconds lag{0};
+    size_t queued_bytes = 0;
+    size_t connections = 0;
+    // Спуск на ступень ниже - только после стольких подряд ниже её порога
+    std::chrono::nanoseconds cooldown{std::chrono::seconds(1)};
+};
+
+// Сигналы перегрузки, снятые основным реактором
+struct OverloadLoad {
+    uint64_t lag_ns;        // наибольшая задержка среди циклов событий
+    size_t queued_bytes;    // байты в очередях на отправку всех соединений
+    size_t connections;
+};
+
+// Обновляется основным реактором; состояние и счётчики читаются из любого
+// потока (UDP, рабочие реакторы, /stats, метрики)
+class OverloadController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit OverloadController(Clock::time_point now = Clock::now());
+
+    void set_thresholds(const OverloadThresholds& thresholds) { thresholds_ = thresholds; }
+    bool enabled() const;
+
+    // true - ступень сменилась
+    bool update(const OverloadLoad& load, Clock::time_point now);
+    // Ступень, которой соответствует нагрузка без учёта cooldown
+    OverloadState target(const OverloadLoad& load) const;
+
+    OverloadState state() const { return state_.load(std::memory_order_relaxed); }
+    bool accepting() const { return state() < OverloadState::NoAccept; }
+    bool rejecting_udp() const { return state() >= OverloadState::RejectUdp; }
+
+    void record_udp_rejected() { udp_rejected_.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t udp_rejected() const { return udp_rejected_.load(std::memory_order_relaxed); }
+    uint64_t transitions() const { return transitions_.load(std::memory_order_relaxed); }
+    // Время в каждой ступени на момент последнего update()
+    std::array<uint64_t, OVERLOAD_STATE_COUNT> time_in_state_ns() const;
+
+private:
+    OverloadThresholds thresholds_;
+    std::atomic<OverloadState> state_{OverloadState::Normal};
+    Clock::time_point last_update_;
+    Clock::time_point calm_since_{};  // нагрузка ниже текущей ступени с этого момента
+    bool calm_ = false;
+    std::array<std::atomic<uint64_t>, OVERLOAD_STATE_COUNT> time_ns_{};
+    std::atomic<uint64_t> transitions_{0};
+    std::atomic<uint64_t> udp_rejected_{0};
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "metrics.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Пишет метрики в текстовом формате Prometheus прямо в переданный буфер.
+// Числа форматируются через std::to_chars без промежуточных строк, так что
+// при переиспользовании буфера отрисовка не выделяет память.
+class PrometheusWriter {
+public:
+    explicit PrometheusWriter(std::string& out) : out_(out) {}
+
+    void header(std::string_view name, std::string_view help, std::string_view type) {
+        out_.append("# HELP ").append(name).append(" ").append(help).append("\n");
+        out_.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+    }
+
+    void sample(std::string_view name, uint64_t value) {
+        out_.append(name).append(" ");
+        append_number(value);
+        out_.push_back('\n');
+    }
+
+    void sample(std::string_view name, std::string_view label, std::string_view label_value, uint64_t value) {
+        out_.append(name);
+        append_label(label, label_value);
+        out_.push_back(' ');
+        append_number(value);
+        out_.push_back('\n');
+    }
+
+    void sample_seconds(std::string_view name, uint64_t ns) {
+        out_.append(name).append(" ");
+        append_seconds(ns);
+        out_.push_back('\n');
+    }
+
+    void sample_seconds(std::string_view name, std::string_view label, std::string_view label_value, uint64_t ns) {
+        out_.append(name);
+        append_label(label, label_value);
+        out_.push_back(' ');
+        append_seconds(ns);
+        out_.push_back('\n');
+    }
+
+    // label может быть пустым - тогда гистограмма без меток
+    void histogram(std::string_view name, std::string_view label, std::string_view label_value,
+                   const LatencyHistogram& histogram) {
+        this->histogram(name, label, label_value, {}, {}, histogram);
+    }
+
+    // Вторая метка (label2) может быть пустой
+    void histogram(std::string_view name, std::string_view label, std::string_view label_value,
+                   std::string_view label2, std::string_view label2_value, const LatencyHistogram& histogram) {
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+            cumulative += histogram.bucket(i);
+            out_.append(name).append("_bucket{");
+            if (!label.empty()) {
+                out_.append(label).append("=\"").append(label_value).append("\",");
+            }
+            if (!label2.empty()) {
+                out_.append(label2).append("=\"").append(label2_value).append("\",");
+            }
+            out_.append("le=\"");
+            if (i < LatencyHistogram::BOUNDS_NS.size()) {
+                append_seconds(LatencyHistogram::BOUNDS_NS[i]);
+            } else {
+                out_.append("+Inf");
+            }
+            out_.append("\"} ");
+            append_number(cumulative);
+            out_.push_back('\n');
+        }
+
+        out_.append(name).append("_sum");
+        append_labels(label, label_value, label2, label2_value);
+        out_.push_back(' ');
+        append_seconds(histogram.sum_ns());
+        out_.push_back('\n');
+
+        out_.append(name).append("_count");
+        append_labels(label, label_value, label2, label2_value);
+        out_.push_back(' ');
+        append_number(cumulative);
+        out_.push_back('\n');
+    }
+
+private:
+    void append_label(std::string_view label, std::string_view value) {
+        if (!label.empty()) {
+            out_.append("{").append(label).append("=\"").append(value).append("\"}");
+        }
+    }
+
+    void append_labels(std::string_view label, std::string_view value,
+                       std::string_view label2, std::string_view value2) {
+        if (label2.empty()) {
+            append_label(label, value);
+            return;
+        }
+        out_.append("{");
+        if (!label.empty()) {
+            out_.append(label).append("=\"").append(value).append("\",");
+        }
+        out_.append(label2).append("=\"").append(value2).append("\"}");
+    }
+
+    void append_number(uint64_t value) {
+        char buf[24];
+        auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+        out_.append(buf, ptr);
+    }
+
+    // Секунды с точностью до наносекунды без double: "<целые>.<9 знаков>"
+    void append_seconds(uint64_t ns) {
+        append_number(ns / 1000000000ull);
+        char frac[10];
+        uint64_t rest = ns % 1000000000ull;
+        frac[0] = '.';
+        for (int i = 9; i >= 1; --i) {
+            frac[i] = static_cast<char>('0' + rest % 10);
+            rest /= 10;
+        }
+        size_t len = 10;
+        while (len > 2 && frac[len - 1] == '0') {
+            --len;
+        }
+        out_.append(frac, len);
+    }
+
+    std::string& out_;
+};
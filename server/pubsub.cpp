@@ -0,0 +1,149 @@
+#include "pubsub.hpp"
+
+#include <algorithm>
+
+bool TopicRegistry::valid_topic(std::string_view topic) {
+    if (topic.empty() || topic.size() > MAX_TOPIC_LENGTH) {
+        return false;
+    }
+    return std::none_of(topic.begin(), topic.end(), [](char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    });
+}
+
+TopicRegistry::Result TopicRegistry::subscribe(std::string_view topic, Subscriber* subscriber) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& topics = by_subscriber_[subscriber];
+    if (std::find(topics.begin(), topics.end(), topic) != topics.end()) {
+        return Result::AlreadySubscribed;
+    }
+    if (topics.size() >= MAX_TOPICS_PER_SUBSCRIBER) {
+        return Result::TooMany;
+    }
+    topics.emplace_back(topic);
+    auto entry = topics_.find(topic);
+    if (entry == topics_.end()) {
+        entry = topics_.emplace(topics.back(), std::vector<Subscriber*>()).first;
+    }
+    entry->second.push_back(subscriber);
+    ++subscriber->subscriptions_;
+    ++subscriptions_;
+    return Result::Ok;
+}
+
+TopicRegistry::Result TopicRegistry::unsubscribe(std::string_view topic, Subscriber* subscriber) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto owner = by_subscriber_.find(subscriber);
+    if (owner == by_subscriber_.end()) {
+        return Result::NotSubscribed;
+    }
+    auto& topics = owner->second;
+    auto it = std::find(topics.begin(), topics.end(), topic);
+    if (it == topics.end()) {
+        return Result::NotSubscribed;
+    }
+    topics.erase(it);
+    if (topics.empty()) {
+        by_subscriber_.erase(owner);
+    }
+
+    auto entry = topics_.find(topic);
+    auto& subscribers = entry->second;
+    subscribers.erase(std::find(subscribers.begin(), subscribers.end(), subscriber));
+    if (subscribers.empty()) {
+        topics_.erase(entry);
+    }
+    --subscriber->subscriptions_;
+    --subscriptions_;
+    return Result::Ok;
+}
+
+size_t TopicRegistry::unsubscribe_all(Subscriber* subscriber) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto owner = by_subscriber_.find(subscriber);
+    if (owner == by_subscriber_.end()) {
+        return 0;
+    }
+    size_t removed = owner->second.size();
+    for (const auto& topic : owner->second) {
+        auto entry = topics_.find(topic);
+        auto& subscribers = entry->second;
+        subscribers.erase(std::find(subscribers.begin(), subscribers.end(), subscriber));
+        if (subscribers.empty()) {
+            topics_.erase(entry);
+        }
+    }
+    by_subscriber_.erase(owner);
+    subscriber->subscriptions_ = 0;
+    subscriptions_ -= removed;
+    return removed;
+}
+
+size_t TopicRegistry::publish(std::string_view topic, std::string_view payload) {
+    // Доставка идёт без блокировки: отключение медленного подписчика
+    // снимает его с реестра прямо из deliver()
+    static thread_local std::vector<Subscriber*> targets;
+    targets.clear();
+    SharedMessage message;
+    size_t accepted = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto entry = topics_.find(topic);
+        if (entry != topics_.end()) {
+            std::string text;
+            text.reserve(8 + topic.size() + 1 + payload.size() + 1);
+            text.append("message ").append(topic).append(" ").append(payload).append("\n");
+            message = std::make_shared<const std::string>(std::move(text));
+            // Чужой подписчик не закроется, пока реестр заблокирован:
+            // отписка при закрытии идёт под той же блокировкой
+            for (Subscriber* subscriber : entry->second) {
+                if (subscriber->owned_by_current_thread()) {
+                    targets.push_back(subscriber);
+                } else {
+                    subscriber->post_delivery(message);
+                    ++accepted;
+                }
+            }
+        }
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+
+    for (Subscriber* subscriber : targets) {
+        Subscriber::Delivery delivery = subscriber->deliver(message);
+        record(delivery);
+        if (delivery == Subscriber::Delivery::Sent || delivery == Subscriber::Delivery::Queued) {
+            ++accepted;
+        }
+    }
+    return accepted;
+}
+
+void TopicRegistry::record(Subscriber::Delivery delivery) {
+    switch (delivery) {
+        case Subscriber::Delivery::Sent:
+            sent_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case Subscriber::Delivery::Queued:
+            queued_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case Subscriber::Delivery::Dropped:
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case Subscriber::Delivery::Disconnected:
+            disconnected_.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+}
+
+PubSubStats TopicRegistry::stats() const {
+    PubSubStats stats{};
+    stats.published = published_.load(std::memory_order_relaxed);
+    stats.sent = sent_.load(std::memory_order_relaxed);
+    stats.queued = queued_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.disconnected = disconnected_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.topics = topics_.size();
+    stats.subscriptions = subscriptions_;
+    return stats;
+}
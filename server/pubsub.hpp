@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Неизменяемое сообщение, разделяемое очередями всех подписчиков
+using SharedMessage = std::shared_ptr<const std::string>;
+
+// Что делать с подписчиком, который не успевает читать:
+// Queue - копить до subscriber_queue_limit сообщений, лишние отбрасывать;
+// Drop - не ставить в очередь ничего, пока не ушло предыдущее;
+// Disconnect - копить до лимита, при переполнении разорвать соединение
+enum class SlowSubscriberPolicy { Queue, Drop, Disconnect };
+
+class Subscriber {
+public:
+    enum class Delivery { Sent, Queued, Dropped, Disconnected };
+
+    virtual ~Subscriber() = default;
+    virtual Delivery deliver(const SharedMessage& message) = 0;
+
+    // Подписчик рабочего реактора, чужого для публикующего потока: вместо
+    // deliver() сообщение передаётся его потоку, который учтёт результат
+    // через TopicRegistry::record. Вызывается под блокировкой реестра.
+    virtual bool owned_by_current_thread() const { return true; }
+    virtual void post_delivery(const SharedMessage&) {}
+
+    // Ненулевое значение - подписчика надо снять с реестра при закрытии
+    uint32_t subscriptions() const { return subscriptions_; }
+
+private:
+    friend class TopicRegistry;
+    uint32_t subscriptions_ = 0;
+};
+
+struct PubSubStats {
+    uint64_t published;
+    uint64_t sent;
+    uint64_t queued;
+    uint64_t dropped;
+    uint64_t disconnected;
+    size_t topics;
+    size_t subscriptions;
+};
+
+// Реестр тем: тема -> подписчики и обратный индекс для отписки при
+// закрытии соединения. Доставка идёт в потоке публикующего, подписчикам
+// других реакторов - через их цикл событий.
+class TopicRegistry {
+public:
+    static constexpr size_t MAX_TOPIC_LENGTH = 128;
+    static constexpr size_t MAX_TOPICS_PER_SUBSCRIBER = 64;
+
+    enum class Result { Ok, AlreadySubscribed, NotSubscribed, TooMany };
+
+    // Строка темы копируется только при первой подписке на неё
+    Result subscribe(std::string_view topic, Subscriber* subscriber);
+    Result unsubscribe(std::string_view topic, Subscriber* subscriber);
+    size_t unsubscribe_all(Subscriber* subscriber);
+
+    // Сообщение "message <topic> <payload>\n" собирается один раз и
+    // раздаётся подписчикам по ссылке; возвращает число принявших
+    size_t publish(std::string_view topic, std::string_view payload);
+
+    PubSubStats stats() const;
+    void record(Subscriber::Delivery delivery);
+
+    static bool valid_topic(std::string_view topic);
+
+private:
+    // Прозрачный хеш: /publish ищет тему по string_view без временной строки
+    struct TopicHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view topic) const { return std::hash<std::string_view>{}(topic); }
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<Subscriber*>, TopicHash, std::equal_to<>> topics_;
+    std::unordered_map<Subscriber*, std::vector<std::string>> by_subscriber_;
+    size_t subscriptions_ = 0;
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> sent_{0};
+    std::atomic<uint64_t> queued_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> disconnected_{0};
+};
@@ -0,0 +1,95 @@
+#include "request_sampler.hpp"
+
+#include <charconv>
+
+thread_local RequestSample* RequestSample::current_ = nullptr;
+thread_local uint32_t RequestSample::counter_ = 0;
+
+namespace {
+
+void observe(CommandMetrics& metrics, RequestStage stage, uint64_t from, uint64_t to) {
+    if (from != 0 && to >= from) {
+        metrics.stages[static_cast<size_t>(stage)].observe(to - from);
+    }
+}
+
+// Верхняя граница корзины, в которую попадает доля q наблюдений;
+// UINT64_MAX - корзина +Inf
+uint64_t quantile_bound_ns(const LatencyHistogram& histogram, uint64_t count, double q) {
+    uint64_t rank = static_cast<uint64_t>(static_cast<double>(count) * q + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < LatencyHistogram::BOUNDS_NS.size(); ++i) {
+        cumulative += histogram.bucket(i);
+        if (cumulative >= rank) {
+            return LatencyHistogram::BOUNDS_NS[i];
+        }
+    }
+    return UINT64_MAX;
+}
+
+// Границы корзин кратны 500 нс: "2.5", "100", "inf"
+void append_micros(std::string& out, uint64_t ns) {
+    if (ns == UINT64_MAX) {
+        out.append("inf");
+        return;
+    }
+    char buf[24];
+    auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), ns / 1000);
+    out.append(buf, ptr);
+    if (uint64_t tenths = ns % 1000 / 100) {
+        out.push_back('.');
+        out.push_back(static_cast<char>('0' + tenths));
+    }
+}
+
+} // namespace
+
+const char* request_stage_name(RequestStage stage) {
+    switch (stage) {
+        case RequestStage::Parse: return "parse";
+        case RequestStage::Dispatch: return "dispatch";
+        case RequestStage::Execute: return "execute";
+        case RequestStage::Queue: return "queue";
+        case RequestStage::Write: return "write";
+        case RequestStage::Total: return "total";
+    }
+    return "unknown";
+}
+
+void RequestSample::record(uint64_t written) const {
+    if (!metrics) {
+        return;
+    }
+    observe(*metrics, RequestStage::Parse, received, parsed);
+    observe(*metrics, RequestStage::Dispatch, parsed, dispatched);
+    observe(*metrics, RequestStage::Execute, dispatched, executed);
+    observe(*metrics, RequestStage::Queue, executed, queued);
+    observe(*metrics, RequestStage::Write, queued, written);
+    observe(*metrics, RequestStage::Total, received, written);
+}
+
+bool append_request_stages(std::string& out, std::string_view command, const CommandMetrics& metrics) {
+    uint64_t samples = metrics.stages[static_cast<size_t>(RequestStage::Total)].count();
+    if (samples == 0) {
+        return false;
+    }
+    out.append(command).append(" samples=").append(std::to_string(samples));
+    for (size_t i = 0; i < REQUEST_STAGE_COUNT; ++i) {
+        const LatencyHistogram& histogram = metrics.stages[i];
+        uint64_t count = histogram.count();
+        out.push_back(' ');
+        out.append(request_stage_name(static_cast<RequestStage>(i))).push_back('=');
+        if (count == 0) {
+            out.push_back('-');
+            continue;
+        }
+        append_micros(out, quantile_bound_ns(histogram, count, 0.5));
+        out.push_back('/');
+        append_micros(out, quantile_bound_ns(histogram, count, 0.99));
+    }
+    out.push_back('\n');
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "metrics.hpp"
+
+const char* request_stage_name(RequestStage stage);
+
+// Отметки monotonic_ns одного запроса из выборки. Запрос, не дошедший до
+// команды (переслан бэкенду, отклонён при перегрузке), в гистограммы не попадает.
+struct RequestSample {
+    uint64_t received = 0;    // recv вернул последний байт строки
+    uint64_t parsed = 0;      // строка выделена из буфера
+    uint64_t dispatched = 0;  // строка передана CommandProcessor
+    uint64_t executed = 0;    // команда вернула ответ
+    uint64_t queued = 0;      // ответ отдан соединению
+    CommandMetrics* metrics = nullptr;  // выставляет CommandProcessor
+
+    // Каждый rate-й запрос потока; 0 - выборка выключена
+    static bool take(uint32_t rate) {
+        if (rate == 0 || ++counter_ < rate) {
+            return false;
+        }
+        counter_ = 0;
+        return true;
+    }
+
+    // Запрос из выборки, который сейчас обрабатывается в этом потоке
+    static RequestSample* current() { return current_; }
+    static void set_current(RequestSample* sample) { current_ = sample; }
+
+    // Пишет этапы в metrics->stages; written - последний байт ответа ушёл в сокет
+    void record(uint64_t written) const;
+
+private:
+    static thread_local RequestSample* current_;
+    static thread_local uint32_t counter_;
+};
+
+// Строка /latency: "<команда> samples=N <этап>=p50/p99 ..." в микросекундах
+// по верхним границам корзин; false - у команды нет запросов из выборки
+bool append_request_stages(std::string& out, std::string_view command, const CommandMetrics& metrics);
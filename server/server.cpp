@@ -1,28 +1,72 @@
 #include "server.hpp"
+#include "affinity.hpp"
+#include "alloc_counter.hpp"
+#include "logger.hpp"
+#include "prometheus.hpp"
 
-#include <iostream>
 #include <cstdlib>
 #include <memory>
 #include <csignal>
+#include <algorithm>
+#include <arpa/inet.h>
 
 
-static std::vector<std::unique_ptr<Command>> create_commands(SessionManager& session_manager) {
+static uint16_t local_port(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+static std::vector<std::unique_ptr<Command>> create_commands(SessionManager& session_manager,
+                                                             KvStore& kv_store,
+                                                             const OverloadController& overload,
+                                                             LatencyCommand::Report latency_report) {
     std::vector<std::unique_ptr<Command>> commands;
     commands.push_back(std::make_unique<TimeCommand>());
-    commands.push_back(std::make_unique<StatsCommand>(session_manager));  // нужен session_manager
+    commands.push_back(std::make_unique<StatsCommand>(session_manager, &overload));  // нужен session_manager
     commands.push_back(std::make_unique<ShutdownCommand>());
+    commands.push_back(std::make_unique<SessionsCommand>(session_manager));
+    commands.push_back(std::make_unique<LatencyCommand>(std::move(latency_report)));
+    commands.push_back(std::make_unique<SubscribeCommand>(session_manager));
+    commands.push_back(std::make_unique<UnsubscribeCommand>(session_manager));
+    commands.push_back(std::make_unique<PublishCommand>(session_manager));
+    commands.push_back(std::make_unique<SetCommand>(kv_store));
+    commands.push_back(std::make_unique<GetCommand>(kv_store));
+    commands.push_back(std::make_unique<DelCommand>(kv_store));
+    commands.push_back(std::make_unique<IncrCommand>(kv_store));
+    commands.push_back(std::make_unique<MgetCommand>(kv_store));
     return commands;
 }
 
-Server::Server(uint16_t port) 
-    : port_(port)
-    , session_manager_(std::make_shared<SessionManager>())
-    , command_processor_(create_commands(*session_manager_))  
+// Настройки из apply_runtime_config, которые рабочий реактор применяет в своём потоке
+static void configure_worker(Worker& worker, const ServerConfig& config) {
+    worker.tcp_handler().set_buffer_size(config.tcp_buffer_size);
+    worker.tcp_handler().set_timestamps(config.socket_timestamps);
+    worker.tcp_handler().set_sample_rate(config.latency_sample_rate);
+    worker.tcp_handler().set_subscriber_policy(config.subscriber_policy, config.subscriber_queue_limit);
+    worker.loop().set_max_events(config.event_batch_size);
+}
+
+Server::Server(const ServerConfig& config) 
+    : config_(config)
+    , port_(config.port)
+    , session_manager_(std::make_shared<SessionManager>(
+          std::max(config.max_connections, SessionTable::DEFAULT_CAPACITY)))
+    , kv_store_(config.kv_shards, config.kv_max_keys)
+    , command_processor_(create_commands(*session_manager_, kv_store_, overload_,
+                                         [this](std::string_view command) {
+                                             return command_processor_.latency_report(command);
+                                         }))
     , shutdown_requested_(false) {
 
     std::signal(SIGPIPE, SIG_IGN);
     tcp_handler_ = std::make_unique<TcpHandler>(port_, session_manager_);
-    udp_handler_ = std::make_unique<UdpHandler>(port_);
+    udp_handler_ = std::make_unique<UdpHandler>(port_, session_manager_);
+    event_loop_.set_trace_capacity(config_.trace_events);
+    apply_runtime_config(config_);
 }
 
 Server::~Server() {
@@ -32,24 +76,70 @@ Server::~Server() {
 
 bool Server::start() {
     setup_signal_handler();
-    if (!tcp_handler_->start() || !udp_handler_->start()) {
-        std::cerr << "Failed to start TCP or UDP handler" << std::endl;
+    ListenSockets inherited = inherit_listen_sockets();
+    if (!tcp_handler_->start(inherited.tcp_fd) || !udp_handler_->start(inherited.udp_fd)) {
+        LOG_ERROR("Failed to start TCP or UDP handler");
         return false;
     }
     setup_tcp_handler();
     setup_udp_handler();
+    setup_stats_segment();
+    bind_reactor_memory();
+    if (config_.socket_timestamps != SocketTimestamps::Off) {
+        LOG_INFO("Kernel socket timestamps enabled ({})", socket_timestamps_name(config_.socket_timestamps));
+    }
+    if (config_.latency_sample_rate > 0) {
+        LOG_INFO("Tracing 1 in {} requests by stage (/latency)", config_.latency_sample_rate);
+    }
     
+    if (!config_.journal_dir.empty()) {
+        std::string error;
+        if (!journal_.open(config_.journal_dir, config_.journal_segment_size, error)) {
+            LOG_ERROR("Failed to open journal: {}", error);
+            return false;
+        }
+        LOG_INFO("Journaling messages to {}", journal_.segment_path());
+    }
+    
+    if (!setup_upstreams() || !setup_workers()) {
+        return false;
+    }
+    
+    if (!setup_admin_handler(inherited.admin_fd)) {
+        LOG_ERROR("Failed to start admin listener on port {}", config_.admin_port);
+        return false;
+    }
+    
+    if (inherited.tcp_fd != -1) {
+        upgrade_channel_.notify_ready();
+        notify_service_manager("MAINPID=" + std::to_string(getpid()) + "\nREADY=1");
+    } else {
+        notify_service_manager("READY=1");
+    }
     return true;
 }
 
 void Server::stop() {
-    if (shutdown_requested_) return;
+    // run() выходит по shutdown_requested_, поэтому повторный вызов
+    // отсекается отдельным флагом
+    if (stopped_) return;
     
+    stopped_ = true;
     shutdown_requested_ = true;
     
+    // Ожидающие ответа бэкендов клиенты получают ошибку, пока живы соединения
+    if (upstreams_) upstreams_->stop();
+    if (workers_) workers_->stop();
     if (tcp_handler_) tcp_handler_->stop();
     if (udp_handler_) udp_handler_->stop();
+    if (admin_handler_) admin_handler_->stop();
     
+    stats_segment_.close();
+    journal_.close();
+    if (signal_fd_.get_fd() != -1) {
+        event_loop_.remove_fd(signal_fd_.get_fd());
+        signal_fd_.close();
+    }
     reset_signal_handler();
 }
 
@@ -57,8 +147,19 @@ void Server::run() {
     while (!shutdown_requested_) {
         try {
             event_loop_.run(100);
+            if (upstreams_) upstreams_->poll();
+            journal_.commit();
+            tcp_handler_->release_closed();
+            publish_stats();
+            close_idle_connections();
+            sweep_expired_keys();
+            check_drain();
+            check_upgrade();
+            update_overload();
+            // Ответы итерации уже отправлены или скопированы в очереди
+            arena_.reset();
         } catch (const std::exception& e) {
-            std::cerr << "Event loop error: " << e.what() << std::endl;
+            LOG_ERROR("Event loop error: {}", e.what());
             break;
         }
     }
@@ -67,11 +168,17 @@ void Server::run() {
 }
 
 void Server::request_shutdown() {
-    std::cout << "\nShutdown requested via signal..." << std::endl;
+    LOG_INFO("Shutdown requested via signal...");
     shutdown_requested_ = true;
 }
 
 void Server::setup_signal_handler() {
+    if (config_.signal_mode == SignalMode::SignalFd) {
+        if (setup_signal_fd()) {
+            return;
+        }
+        LOG_WARNING("signalfd setup failed, falling back to signal thread: {}", strerror(errno));
+    }
 
     std::weak_ptr<Server> weak_this = shared_from_this();
     set_signal_handler({SIGINT, SIGTERM, SIGQUIT}, [weak_this]() {
@@ -79,62 +186,921 @@ void Server::setup_signal_handler() {
             server->request_shutdown();
         }
     });
+    std::string error;
+    if (!pin_thread(SignalHandler::instance().native_handle(), config_.signal_cpus, error)) {
+        LOG_WARNING("Signal thread: {}", error);
+    }
 }
 
-void Server::setup_tcp_handler() {
-    tcp_handler_->set_connection_callback([this](auto connection) {
-        handle_tcp_connection(connection);
+void Server::bind_reactor_memory() {
+    if (config_.reactor_cpus.empty()) {
+        return;
+    }
+    int cpu = config_.reactor_cpus.front();
+    // Соединения, принятые ядром на CPU реактора, достаются его сокетам
+    if (!set_incoming_cpu(tcp_handler_->get_socket_fd(), cpu) ||
+        !set_incoming_cpu(udp_handler_->get_socket_fd(), cpu)) {
+        LOG_WARNING("SO_INCOMING_CPU is not supported: {}", strerror(errno));
+    }
+    int node = cpu_node(cpu);
+    if (node < 0) {
+        return;
+    }
+    // Таблица уже тронута этим потоком после привязки; mbind закрепляет
+    // политику и переносит страницы, если сервер создан до привязки
+    if (session_manager_->sessions().bind_to_node(node)) {
+        LOG_DEBUG("Session table bound to NUMA node {}", node);
+    }
+}
+
+bool Server::setup_signal_fd() {
+    if (!signal_fd_.open({SIGINT, SIGTERM, SIGQUIT, SIGHUP, SIGUSR1, SIGUSR2})) {
+        return false;
+    }
+    
+    auto shutdown = [this](const signalfd_siginfo&) { request_shutdown(); };
+    signal_fd_.set_handler(SIGINT, shutdown);
+    signal_fd_.set_handler(SIGTERM, shutdown);
+    signal_fd_.set_handler(SIGQUIT, shutdown);
+    signal_fd_.set_handler(SIGHUP, [this](const signalfd_siginfo&) { handle_sighup(); });
+    signal_fd_.set_handler(SIGUSR1, [this](const signalfd_siginfo&) { dump_stats(); });
+    signal_fd_.set_handler(SIGUSR2, [this](const signalfd_siginfo&) { begin_upgrade(); });
+    
+    if (!event_loop_.add_fd(signal_fd_.get_fd(), EPOLLIN, [this](uint32_t events) {
+            if (events & EPOLLIN) signal_fd_.handle_read();
+        })) {
+        signal_fd_.close();
+        return false;
+    }
+    return true;
+}
+
+void Server::handle_sighup() {
+    LOG_INFO("SIGHUP received, reloading configuration");
+    Logger::instance().reopen();
+    reload_config();
+}
+
+void Server::reload_config() {
+    if (config_.config_path.empty()) {
+        LOG_INFO("No configuration file in use, nothing to reload");
+        return;
+    }
+    
+    ServerConfig reloaded;
+    std::string error;
+    std::vector<std::string> warnings;
+    if (!load_config_file(config_.config_path, reloaded, error, &warnings) ||
+        !apply_env_overrides(reloaded, error)) {
+        LOG_ERROR("Config reload failed, keeping current settings: {}", error);
+        return;
+    }
+    for (const auto& warning : warnings) {
+        LOG_WARNING("Config warning: {}", warning);
+    }
+    resolve_config_defaults(reloaded);
+    
+    // Листенеры и способ обработки сигналов меняются только перезапуском
+    if (reloaded.port != config_.port || reloaded.admin_port != config_.admin_port ||
+        reloaded.signal_mode != config_.signal_mode || reloaded.stats_shm_name != config_.stats_shm_name ||
+        reloaded.log_output != config_.log_output || reloaded.tcp_workers != config_.tcp_workers ||
+        reloaded.reactor_cpus != config_.reactor_cpus || reloaded.logger_cpus != config_.logger_cpus ||
+        reloaded.signal_cpus != config_.signal_cpus) {
+        LOG_WARNING("Config reload: port, admin_port, signal_mode, stats_shm, log_output, tcp_workers "
+                    "and *_cpus require a restart and were left unchanged");
+    }
+    reloaded.port = config_.port;
+    reloaded.admin_port = config_.admin_port;
+    reloaded.signal_mode = config_.signal_mode;
+    reloaded.stats_shm_name = config_.stats_shm_name;
+    reloaded.log_output = config_.log_output;
+    reloaded.tcp_workers = config_.tcp_workers;
+    reloaded.reactor_cpus = config_.reactor_cpus;
+    reloaded.logger_cpus = config_.logger_cpus;
+    reloaded.signal_cpus = config_.signal_cpus;
+    
+    // Таблица сессий размечена при старте: соединения сверх неё не попали бы
+    // ни в /sessions, ни под закрытие по простою
+    size_t capacity = session_manager_->sessions().capacity();
+    if (reloaded.max_connections > capacity) {
+        LOG_WARNING("Config reload: max_connections={} exceeds the session table sized at startup, "
+                    "using {}; a larger limit requires a restart", reloaded.max_connections, capacity);
+        reloaded.max_connections = capacity;
+    }
+    
+    apply_runtime_config(reloaded);
+    config_ = reloaded;
+    
+    LOG_INFO("Configuration reloaded from {}: max_connections={} tcp_timeout={}s tcp_buffer_size={} "
+             "udp_buffer_size={} event_batch_size={} log_level={} socket_timestamps={} latency_sample_rate={}",
+             config_.config_path, config_.max_connections, config_.tcp_timeout.count(),
+             config_.tcp_buffer_size, config_.udp_buffer_size, config_.event_batch_size, config_.log_level,
+             socket_timestamps_name(config_.socket_timestamps), config_.latency_sample_rate);
+}
+
+void Server::apply_runtime_config(const ServerConfig& config) {
+    LogLevel level = LogLevel::Info;
+    parse_log_level(config.log_level, level);
+    Logger::instance().set_level(level);
+    tcp_handler_->set_max_connections(config.max_connections);
+    tcp_handler_->set_buffer_size(config.tcp_buffer_size);
+    udp_handler_->set_buffer_size(config.udp_buffer_size);
+    tcp_handler_->set_timestamps(config.socket_timestamps);
+    udp_handler_->set_timestamps(config.socket_timestamps);
+    tcp_handler_->set_sample_rate(config.latency_sample_rate);
+    udp_handler_->set_sample_rate(config.latency_sample_rate);
+    tcp_handler_->set_subscriber_policy(config.subscriber_policy, config.subscriber_queue_limit);
+    kv_store_.set_max_keys(config.kv_max_keys);
+    journal_.set_fsync(config.journal_fsync, config.journal_fsync_interval);
+    OverloadThresholds thresholds;
+    thresholds.lag = config.overload_lag;
+    thresholds.queued_bytes = config.overload_queued_bytes;
+    thresholds.connections = config.overload_connections;
+    thresholds.cooldown = config.overload_cooldown;
+    overload_.set_thresholds(thresholds);
+    event_loop_.set_max_events(config.event_batch_size);
+    if (workers_) {
+        workers_->set_policy(config.worker_placement);
+        for (size_t i = 0; i < workers_->size(); ++i) {
+            Worker& worker = workers_->worker(i);
+            worker.loop().post([&worker, config] { configure_worker(worker, config); });
+        }
+    }
+}
+
+void Server::close_idle_connections() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_idle_sweep_ < IDLE_SWEEP_INTERVAL) {
+        return;
+    }
+    last_idle_sweep_ = now;
+    
+    size_t closed = tcp_handler_->close_idle_connections(config_.tcp_timeout);
+    if (closed > 0) {
+        LOG_INFO("Closed {} idle TCP connection(s)", closed);
+    }
+    if (!workers_) {
+        return;
+    }
+    for (size_t i = 0; i < workers_->size(); ++i) {
+        Worker& worker = workers_->worker(i);
+        worker.loop().post([&worker, timeout = config_.tcp_timeout] {
+            size_t closed = worker.tcp_handler().close_idle_connections(timeout);
+            if (closed > 0) {
+                LOG_INFO("Worker {}: closed {} idle TCP connection(s)", worker.index(), closed);
+            }
+        });
+    }
+}
+
+void Server::update_overload() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_overload_check_ < OVERLOAD_CHECK_INTERVAL) {
+        return;
+    }
+    last_overload_check_ = now;
+    
+    ServerStats stats = session_manager_->get_stats();
+    OverloadLoad load{event_loop_.lag_ns(), stats.queued_bytes, stats.current_connections};
+    if (workers_) {
+        for (size_t i = 0; i < workers_->size(); ++i) {
+            load.lag_ns = std::max(load.lag_ns, workers_->worker(i).lag_ns());
+        }
+    }
+    OverloadState previous = overload_.state();
+    if (!overload_.update(load, now)) {
+        return;
+    }
+    OverloadState state = overload_.state();
+    if (state > previous) {
+        LOG_WARNING("Overload: {} -> {} (loop lag {}us, {} bytes queued, {} connections)",
+                    overload_state_name(previous), overload_state_name(state),
+                    load.lag_ns / 1000, load.queued_bytes, load.connections);
+    } else {
+        LOG_INFO("Overload: {} -> {}", overload_state_name(previous), overload_state_name(state));
+    }
+    set_accepting(overload_.accepting());
+    command_processor_.set_min_priority(state >= OverloadState::Shed ? CommandPriority::Normal
+                                                                     : CommandPriority::Low);
+}
+
+void Server::set_accepting(bool accepting) {
+    // При выводе из работы слушающий сокет уже снят с опроса
+    if (draining_) {
+        return;
+    }
+    if (workers_) {
+        workers_->set_accepting(accepting);
+    } else {
+        event_loop_.modify_fd(tcp_handler_->get_socket_fd(), accepting ? uint32_t(EPOLLIN) : 0u);
+    }
+}
+
+void Server::sweep_expired_keys() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_kv_sweep_ < KV_SWEEP_INTERVAL) {
+        return;
+    }
+    last_kv_sweep_ = now;
+    kv_store_.sweep_expired(KV_SWEEP_SLOTS);
+}
+
+void Server::dump_stats() {
+    ServerStats stats = session_manager_->get_stats();
+    EventLoop::Stats loop = event_loop_.get_stats();
+    
+    LOG_INFO("Stats dump (SIGUSR1): connections total={} current={}, messages tcp={} udp={}, "
+             "bytes received={} sent={}", stats.total_connections, stats.current_connections,
+             stats.tcp_messages, stats.udp_messages, stats.bytes_received, stats.bytes_sent);
+    LOG_INFO("Stats dump (SIGUSR1): event loop iterations={} events={} busy_ms={} fds={}",
+             loop.iterations, loop.events, loop.busy_ns / 1000000, loop.registered_fds);
+    if (workers_) {
+        for (size_t i = 0; i < workers_->size(); ++i) {
+            Worker::Stats worker = workers_->worker(i).stats();
+            LOG_INFO("Stats dump (SIGUSR1): worker {} connections={} accepted={} lag_us={} busy_ms={}",
+                     i, worker.connections, worker.accepted, worker.lag_ns / 1000, worker.loop.busy_ns / 1000000);
+        }
+    }
+    LOG_INFO("Stats dump (SIGUSR1): {}", dump_trace());
+}
+
+std::string Server::dump_trace() {
+    if (!event_loop_.trace().enabled()) {
+        return "Tracing disabled (trace_events=0)";
+    }
+    // Кольца рабочих реакторов и акцептора - отдельными потоками трассы
+    std::vector<const TraceRing*> rings{&event_loop_.trace()};
+    if (workers_) {
+        for (size_t i = 0; i < workers_->size(); ++i) {
+            rings.push_back(&workers_->worker(i).loop().trace());
+        }
+        if (workers_->acceptor_loop()) {
+            rings.push_back(&workers_->acceptor_loop()->trace());
+        }
+    }
+    size_t events = 0;
+    std::string error;
+    if (!write_chrome_trace_file(config_.trace_file, rings, events, error)) {
+        return "Trace dump failed: " + error;
+    }
+    return "Trace written to " + config_.trace_file + " (" + std::to_string(events) + " events)";
+}
+
+ListenSockets Server::inherit_listen_sockets() {
+    ListenSockets sockets;
+    if (!UpgradeChannel::requested()) {
+        return sockets;
+    }
+    
+    std::string error;
+    if (!upgrade_channel_.inherit(sockets, error)) {
+        LOG_ERROR("Upgrade: failed to receive listening sockets: {}", error);
+        return ListenSockets{};
+    }
+    
+    // Порт мог поменяться в конфигурации между версиями: такие сокеты не берём
+    auto keep = [](int& fd, uint16_t port) {
+        if (fd != -1 && (port == 0 || local_port(fd) != port)) {
+            close(fd);
+            fd = -1;
+        }
+    };
+    keep(sockets.tcp_fd, config_.port);
+    keep(sockets.udp_fd, config_.port);
+    keep(sockets.admin_fd, config_.admin_port);
+    if (sockets.tcp_fd == -1 && sockets.udp_fd != -1) {
+        close(sockets.udp_fd);
+        sockets.udp_fd = -1;
+    }
+    
+    LOG_INFO("Upgrade: inherited listening sockets from parent process");
+    return sockets;
+}
+
+void Server::begin_upgrade() {
+    if (draining_ || upgrade_channel_.get_fd() != -1) {
+        LOG_WARNING("Upgrade already in progress");
+        return;
+    }
+    if (upgrade_argv_.empty()) {
+        LOG_ERROR("Upgrade: executable path is unknown");
+        return;
+    }
+    
+    LOG_INFO("SIGUSR2 received, starting {}", upgrade_argv_[0]);
+    
+    // Новый процесс откроет сегмент под тем же именем: одновременно
+    // писать в него двум процессам seqlock не позволяет
+    stats_segment_.detach();
+    
+    ListenSockets sockets;
+    sockets.tcp_fd = tcp_handler_->get_socket_fd();
+    sockets.udp_fd = udp_handler_->get_socket_fd();
+    sockets.admin_fd = admin_handler_ ? admin_handler_->get_socket_fd() : -1;
+    
+    std::string error;
+    if (!upgrade_channel_.spawn(upgrade_argv_, sockets, error)) {
+        LOG_ERROR("Upgrade failed: {}", error);
+        setup_stats_segment();
+        return;
+    }
+    
+    upgrade_deadline_ = std::chrono::steady_clock::now() + config_.upgrade_timeout;
+    event_loop_.add_fd(upgrade_channel_.get_fd(), EPOLLIN, [this](uint32_t) {
+        handle_upgrade_event();
     });
+}
+
+void Server::handle_upgrade_event() {
+    int fd = upgrade_channel_.get_fd();
+    pid_t child = upgrade_channel_.child_pid();
+    
+    UpgradeChannel::Status status = upgrade_channel_.handle_read();
+    if (status == UpgradeChannel::Status::Pending) {
+        return;
+    }
+    event_loop_.remove_fd(fd);
+    
+    if (status == UpgradeChannel::Status::Ready) {
+        LOG_INFO("Upgrade: process {} took over listening sockets", child);
+        start_drain();
+    } else {
+        LOG_ERROR("Upgrade: process {} exited before becoming ready, continuing to serve", child);
+        setup_stats_segment();
+    }
+}
+
+void Server::check_upgrade() {
+    int fd = upgrade_channel_.get_fd();
+    if (fd != -1 && std::chrono::steady_clock::now() >= upgrade_deadline_) {
+        LOG_ERROR("Upgrade: process {} not ready after {}s, killing it and continuing to serve",
+                  upgrade_channel_.child_pid(), config_.upgrade_timeout.count());
+        event_loop_.remove_fd(fd);
+        upgrade_channel_.abort();
+        setup_stats_segment();
+    }
+    upgrade_channel_.reap_failed();
+}
+
+void Server::start_drain() {
+    if (workers_) {
+        workers_->stop_acceptor();
+    } else {
+        event_loop_.remove_fd(tcp_handler_->get_socket_fd());
+    }
+    tcp_handler_->stop_listening();
+    event_loop_.remove_fd(udp_handler_->get_socket_fd());
+    udp_handler_->stop();
+    if (admin_handler_) {
+        admin_handler_->stop();
+    }
     
+    draining_ = true;
+    drain_deadline_ = std::chrono::steady_clock::now() + config_.drain_timeout;
+    LOG_INFO("Draining {} connection(s), deadline {}s", open_connections(),
+             config_.drain_timeout.count());
+}
+
+void Server::check_drain() {
+    if (!draining_) {
+        return;
+    }
+    
+    size_t remaining = open_connections();
+    if (remaining == 0) {
+        LOG_INFO("Drain complete");
+        shutdown_requested_ = true;
+    } else if (std::chrono::steady_clock::now() >= drain_deadline_) {
+        LOG_WARNING("Drain deadline reached, closing {} connection(s)", remaining);
+        shutdown_requested_ = true;
+    }
+}
+
+size_t Server::open_connections() const {
+    return tcp_handler_->connection_count() + (workers_ ? workers_->connections() : 0);
+}
+
+void Server::setup_tcp_handler() {
+    setup_tcp_callbacks(*tcp_handler_, event_loop_, arena_, -1);
+    if (config_.tcp_workers > 0) {
+        // Слушающий сокет обслуживает поток акцептора, см. setup_workers()
+        return;
+    }
     event_loop_.add_fd(tcp_handler_->get_socket_fd(), EPOLLIN, [this](uint32_t events) {
         if (events & EPOLLIN) tcp_handler_->handle_accept();
     });
 }
 
+void Server::setup_tcp_callbacks(TcpHandler& handler, EventLoop& loop, RequestArena& arena, int worker) {
+    handler.set_connection_callback([this, &loop](TcpConnection& connection) {
+        handle_tcp_connection(connection, loop);
+    });
+    handler.set_message_handler([this, &arena, worker](TcpConnection& connection, std::string_view message) {
+        handle_tcp_message(message, connection, arena, worker);
+    });
+    handler.set_close_handler([&handler, &loop](int fd) {
+        loop.remove_fd(fd);
+        handler.remove_connection(fd);
+    });
+    handler.set_want_write_handler([&loop](int fd, bool want) {
+        loop.modify_fd(fd, want ? EPOLLIN | EPOLLOUT : EPOLLIN);
+    });
+}
+
+bool Server::setup_workers() {
+    if (config_.tcp_workers == 0) {
+        return true;
+    }
+    WorkerPool::Options options;
+    options.workers = config_.tcp_workers;
+    options.policy = config_.worker_placement;
+    options.cpus = config_.reactor_cpus;
+    options.trace_events = config_.trace_events;
+    workers_ = std::make_unique<WorkerPool>(options, session_manager_);
+    
+    std::string error;
+    if (!workers_->start([this](Worker& worker) {
+            setup_tcp_callbacks(worker.tcp_handler(), worker.loop(), worker.arena(),
+                                static_cast<int>(worker.index()));
+            configure_worker(worker, config_);
+        }, error)) {
+        LOG_ERROR("Failed to start TCP workers: {}", error);
+        workers_.reset();
+        return false;
+    }
+    if (!workers_->start_acceptor(*tcp_handler_)) {
+        LOG_ERROR("Failed to start TCP acceptor: {}", strerror(errno));
+        workers_.reset();
+        return false;
+    }
+    LOG_INFO("Accepting TCP on a dedicated thread for {} worker reactor(s), placement {}",
+             workers_->size(), placement_policy_name(config_.worker_placement));
+    return true;
+}
+
 void Server::setup_udp_handler() {
     udp_handler_->set_message_callback([this](const auto& message, const auto& client_addr) {
         handle_udp_message(message, client_addr);
     });
     
     event_loop_.add_fd(udp_handler_->get_socket_fd(), EPOLLIN, [this](uint32_t events) {
+        if (events & EPOLLERR) udp_handler_->handle_error_queue();
         if (events & EPOLLIN) udp_handler_->handle_message();
     });
 }
 
-void Server::handle_tcp_connection(std::shared_ptr<TcpConnection> connection) {
-    connection->set_message_callback([this, connection](const auto& message) {
-        handle_tcp_message(message, connection);
+void Server::setup_stats_segment() {
+    if (config_.stats_shm_name.empty()) {
+        return;
+    }
+    
+    if (stats_segment_.open(config_.stats_shm_name)) {
+        LOG_INFO("Publishing stats to shared memory segment {}", config_.stats_shm_name);
+        publish_stats();
+    } else {
+        LOG_ERROR("Failed to create stats segment {}: {}", config_.stats_shm_name, strerror(errno));
+    }
+}
+
+void Server::publish_stats() {
+    if (!stats_segment_.is_open()) {
+        return;
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_stats_publish_ < STATS_PUBLISH_INTERVAL) {
+        return;
+    }
+    last_stats_publish_ = now;
+    
+    auto to_ns = [](std::chrono::system_clock::time_point tp) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            tp.time_since_epoch()).count());
+    };
+    
+    ServerStats stats = session_manager_->get_stats();
+    StatsValues values{};
+    values[static_cast<size_t>(StatsField::StartTimeNs)] = to_ns(stats.start_time);
+    values[static_cast<size_t>(StatsField::PublishTimeNs)] = to_ns(std::chrono::system_clock::now());
+    values[static_cast<size_t>(StatsField::TotalConnections)] = stats.total_connections;
+    values[static_cast<size_t>(StatsField::CurrentConnections)] = stats.current_connections;
+    values[static_cast<size_t>(StatsField::ActiveSessions)] = session_manager_->sessions().active();
+    values[static_cast<size_t>(StatsField::TcpMessages)] = stats.tcp_messages;
+    values[static_cast<size_t>(StatsField::UdpMessages)] = stats.udp_messages;
+    values[static_cast<size_t>(StatsField::BytesReceived)] = stats.bytes_received;
+    values[static_cast<size_t>(StatsField::BytesSent)] = stats.bytes_sent;
+    stats_segment_.publish(values);
+}
+
+bool Server::setup_admin_handler(int inherited_fd) {
+    if (config_.admin_port == 0) {
+        return true;
+    }
+    
+    admin_handler_ = std::make_unique<AdminHandler>(config_.admin_port, event_loop_);
+    if (!admin_handler_->start(inherited_fd)) {
+        admin_handler_.reset();
+        return false;
+    }
+    
+    admin_handler_->set_metrics_renderer([this](std::string& out) {
+        render_metrics(out);
     });
+    admin_handler_->set_trace_dumper([this] { return dump_trace(); });
     
-    connection->set_close_callback([this, connection]() {
-        event_loop_.remove_fd(connection->get_fd());
+    event_loop_.add_fd(admin_handler_->get_socket_fd(), EPOLLIN, [this](uint32_t events) {
+        if (events & EPOLLIN) admin_handler_->handle_accept();
     });
     
-    event_loop_.add_fd(connection->get_fd(), EPOLLIN, [connection](uint32_t events) {
-        if (events & EPOLLIN) connection->handle_read();
+    LOG_INFO("Metrics available at http://0.0.0.0:{}/metrics", config_.admin_port);
+    return true;
+}
+
+void Server::render_metrics(std::string& out) const {
+    PrometheusWriter writer(out);
+    ServerStats stats = session_manager_->get_stats();
+    
+    auto uptime = std::chrono::system_clock::now() - stats.start_time;
+    writer.header("async_server_uptime_seconds", "Time since the server started.", "gauge");
+    writer.sample_seconds("async_server_uptime_seconds", static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(uptime).count()));
+    
+    writer.header("async_server_connections_total", "TCP connections accepted.", "counter");
+    writer.sample("async_server_connections_total", stats.total_connections);
+    writer.header("async_server_connections", "TCP connections currently open.", "gauge");
+    writer.sample("async_server_connections", stats.current_connections);
+    writer.header("async_server_connections_rejected_total", "Connections refused over max_connections.", "counter");
+    writer.sample("async_server_connections_rejected_total", tcp_handler_->rejected_connections());
+    writer.header("async_server_sessions_tracked", "Connections tracked in the session table.", "gauge");
+    writer.sample("async_server_sessions_tracked", session_manager_->sessions().active());
+    
+    writer.header("async_server_messages_total", "Requests received.", "counter");
+    writer.sample("async_server_messages_total", "protocol", "tcp", stats.tcp_messages);
+    writer.sample("async_server_messages_total", "protocol", "udp", stats.udp_messages);
+    writer.header("async_server_received_bytes_total", "Bytes received from clients.", "counter");
+    writer.sample("async_server_received_bytes_total", stats.bytes_received);
+    writer.header("async_server_sent_bytes_total", "Bytes sent to clients.", "counter");
+    writer.sample("async_server_sent_bytes_total", stats.bytes_sent);
+    
+    writer.header("async_server_command_requests_total", "Requests handled per command.", "counter");
+    command_processor_.visit_metrics([&](std::string_view name, const CommandMetrics& metrics) {
+        writer.sample("async_server_command_requests_total", "command", name,
+                      metrics.requests.load(std::memory_order_relaxed));
+    });
+    writer.header("async_server_command_duration_seconds", "Command processing time.", "histogram");
+    command_processor_.visit_metrics([&](std::string_view name, const CommandMetrics& metrics) {
+        writer.histogram("async_server_command_duration_seconds", "command", name, metrics.latency);
+    });
+    if (config_.latency_sample_rate > 0) {
+        writer.header("async_server_request_stage_seconds",
+                      "Per-stage latency of sampled requests (latency_sample_rate).", "histogram");
+        command_processor_.visit_metrics([&](std::string_view name, const CommandMetrics& metrics) {
+            if (metrics.stages[static_cast<size_t>(RequestStage::Total)].count() == 0) {
+                return;
+            }
+            for (size_t i = 0; i < REQUEST_STAGE_COUNT; ++i) {
+                writer.histogram("async_server_request_stage_seconds", "command", name,
+                                 "stage", request_stage_name(static_cast<RequestStage>(i)), metrics.stages[i]);
+            }
+        });
+    }
+    
+    PubSubStats pubsub = session_manager_->topics().stats();
+    writer.header("async_server_pubsub_published_total", "Messages published with /publish.", "counter");
+    writer.sample("async_server_pubsub_published_total", pubsub.published);
+    writer.header("async_server_pubsub_deliveries_total", "Per-subscriber deliveries by outcome.", "counter");
+    writer.sample("async_server_pubsub_deliveries_total", "result", "sent", pubsub.sent);
+    writer.sample("async_server_pubsub_deliveries_total", "result", "queued", pubsub.queued);
+    writer.sample("async_server_pubsub_deliveries_total", "result", "dropped", pubsub.dropped);
+    writer.sample("async_server_pubsub_deliveries_total", "result", "disconnected", pubsub.disconnected);
+    writer.header("async_server_pubsub_topics", "Topics with at least one subscriber.", "gauge");
+    writer.sample("async_server_pubsub_topics", pubsub.topics);
+    writer.header("async_server_pubsub_subscriptions", "Active topic subscriptions.", "gauge");
+    writer.sample("async_server_pubsub_subscriptions", pubsub.subscriptions);
+    
+    KvStats kv = kv_store_.stats();
+    writer.header("async_server_kv_keys", "Keys stored by /set and /incr.", "gauge");
+    writer.sample("async_server_kv_keys", kv.keys);
+    writer.header("async_server_kv_lookups_total", "Key lookups by /get and /mget.", "counter");
+    writer.sample("async_server_kv_lookups_total", "result", "hit", kv.hits);
+    writer.sample("async_server_kv_lookups_total", "result", "miss", kv.misses);
+    writer.header("async_server_kv_expired_total", "Keys removed after their TTL.", "counter");
+    writer.sample("async_server_kv_expired_total", kv.expired);
+    
+    RequestArena::Stats arena = arena_.stats();
+    if (workers_) {
+        for (size_t i = 0; i < workers_->size(); ++i) {
+            RequestArena::Stats worker = workers_->worker(i).stats().arena;
+            arena.bytes += worker.bytes;
+            arena.overflows += worker.overflows;
+            arena.high_water = std::max(arena.high_water, worker.high_water);
+            arena.request_allocations += worker.request_allocations;
+        }
+    }
+    writer.header("async_server_arena_bytes_total", "Bytes bump-allocated from the per-iteration request arena.", "counter");
+    writer.sample("async_server_arena_bytes_total", arena.bytes);
+    writer.header("async_server_arena_high_water_bytes", "Largest arena usage in one loop iteration.", "gauge");
+    writer.sample("async_server_arena_high_water_bytes", arena.high_water);
+    writer.header("async_server_arena_overflows_total", "Heap blocks taken when an iteration outgrew the arena.", "counter");
+    writer.sample("async_server_arena_overflows_total", arena.overflows);
+    AllocationStats heap = allocation_stats();
+    writer.header("async_server_heap_allocations_total", "operator new calls in the process.", "counter");
+    writer.sample("async_server_heap_allocations_total", heap.allocations);
+    writer.header("async_server_heap_allocated_bytes_total", "Bytes requested from operator new.", "counter");
+    writer.sample("async_server_heap_allocated_bytes_total", heap.bytes);
+    writer.header("async_server_request_heap_allocations_total",
+                  "operator new calls made while handling TCP/UDP messages (0 per request in steady state).", "counter");
+    writer.sample("async_server_request_heap_allocations_total", arena.request_allocations);
+    
+    writer.header("async_server_overload_state", "Overload stage: 0 normal, 1 no_accept, 2 reject_udp, 3 shed.", "gauge");
+    writer.sample("async_server_overload_state", static_cast<uint64_t>(overload_.state()));
+    writer.header("async_server_overload_state_seconds_total", "Time spent in each overload stage.", "counter");
+    auto overload_time = overload_.time_in_state_ns();
+    for (size_t i = 0; i < OVERLOAD_STATE_COUNT; ++i) {
+        writer.sample_seconds("async_server_overload_state_seconds_total", "state",
+                              overload_state_name(static_cast<OverloadState>(i)), overload_time[i]);
+    }
+    writer.header("async_server_overload_transitions_total", "Overload stage changes.", "counter");
+    writer.sample("async_server_overload_transitions_total", overload_.transitions());
+    writer.header("async_server_overload_udp_rejected_total", "UDP requests answered BUSY under overload.", "counter");
+    writer.sample("async_server_overload_udp_rejected_total", overload_.udp_rejected());
+    writer.header("async_server_overload_commands_shed_total", "Low-priority commands answered BUSY under overload.", "counter");
+    writer.sample("async_server_overload_commands_shed_total", command_processor_.shed_commands());
+    writer.header("async_server_queued_bytes", "Bytes waiting in TCP output queues.", "gauge");
+    writer.sample("async_server_queued_bytes", stats.queued_bytes);
+    
+    if (config_.socket_timestamps != SocketTimestamps::Off) {
+        const PacketLatency& latency = session_manager_->packet_latency();
+        auto histograms = [&](std::string_view name, std::string_view help,
+                              const std::array<LatencyHistogram, 2>& by_protocol) {
+            writer.header(name, help, "histogram");
+            writer.histogram(name, "protocol", "tcp", by_protocol[static_cast<size_t>(Protocol::Tcp)]);
+            writer.histogram(name, "protocol", "udp", by_protocol[static_cast<size_t>(Protocol::Udp)]);
+        };
+        histograms("async_server_socket_queue_seconds",
+                   "Time from the kernel receive timestamp until the server read the data.", latency.socket_queue);
+        histograms("async_server_processing_seconds",
+                   "Time from reading a request until its responses were handed to the kernel.", latency.processing);
+        histograms("async_server_tx_completion_seconds",
+                   "Time from send() until the kernel transmit timestamp (rx_tx only).", latency.tx);
+    }
+    
+    LoggerStats log = Logger::instance().stats();
+    writer.header("async_server_log_records_total", "Log records written.", "counter");
+    writer.sample("async_server_log_records_total", log.records);
+    writer.header("async_server_log_dropped_total", "Log records dropped because a thread buffer was full.", "counter");
+    writer.sample("async_server_log_dropped_total", log.dropped);
+    writer.header("async_server_log_write_errors_total", "Failed writes to the log output.", "counter");
+    writer.sample("async_server_log_write_errors_total", log.write_errors);
+    
+    if (upstreams_) {
+        auto upstreams = upstreams_->stats();
+        writer.header("async_server_upstream_up", "Whether the upstream is considered healthy.", "gauge");
+        for (const auto& upstream : upstreams) {
+            writer.sample("async_server_upstream_up", "upstream", upstream.name, upstream.healthy ? 1 : 0);
+        }
+        writer.header("async_server_upstream_connections", "Established connections to the upstream.", "gauge");
+        for (const auto& upstream : upstreams) {
+            writer.sample("async_server_upstream_connections", "upstream", upstream.name, upstream.connections);
+        }
+        writer.header("async_server_upstream_outstanding", "Forwarded requests awaiting a response.", "gauge");
+        for (const auto& upstream : upstreams) {
+            writer.sample("async_server_upstream_outstanding", "upstream", upstream.name, upstream.outstanding);
+        }
+        writer.header("async_server_upstream_requests_total", "Requests forwarded to the upstream.", "counter");
+        for (const auto& upstream : upstreams) {
+            writer.sample("async_server_upstream_requests_total", "upstream", upstream.name, upstream.requests);
+        }
+        writer.header("async_server_upstream_failures_total", "Connection failures and failed health checks.", "counter");
+        for (const auto& upstream : upstreams) {
+            writer.sample("async_server_upstream_failures_total", "upstream", upstream.name, upstream.failures);
+        }
+    }
+    
+    if (journal_.is_open()) {
+        JournalStats journal = journal_.stats();
+        writer.header("async_server_journal_records_total", "Messages written to the journal.", "counter");
+        writer.sample("async_server_journal_records_total", journal.records);
+        writer.header("async_server_journal_bytes_total", "Journal bytes including record headers.", "counter");
+        writer.sample("async_server_journal_bytes_total", journal.bytes);
+        writer.header("async_server_journal_commits_total", "Group commits (loop iterations with new records).", "counter");
+        writer.sample("async_server_journal_commits_total", journal.commits);
+        writer.header("async_server_journal_syncs_total", "msync calls.", "counter");
+        writer.sample("async_server_journal_syncs_total", journal.syncs);
+        writer.header("async_server_journal_segments_total", "Segment files created.", "counter");
+        writer.sample("async_server_journal_segments_total", journal.segments);
+        writer.header("async_server_journal_errors_total", "Records that could not be journaled.", "counter");
+        writer.sample("async_server_journal_errors_total", journal.errors);
+    }
+    
+    EventLoop::Stats loop = event_loop_.get_stats();
+    writer.header("async_server_event_loop_iterations_total", "epoll_wait calls.", "counter");
+    writer.sample("async_server_event_loop_iterations_total", loop.iterations);
+    writer.header("async_server_event_loop_events_total", "Events dispatched by the loop.", "counter");
+    writer.sample("async_server_event_loop_events_total", loop.events);
+    writer.header("async_server_event_loop_busy_seconds_total", "Time spent in event callbacks.", "counter");
+    writer.sample_seconds("async_server_event_loop_busy_seconds_total", loop.busy_ns);
+    writer.header("async_server_event_loop_registered_fds", "File descriptors registered in epoll.", "gauge");
+    writer.sample("async_server_event_loop_registered_fds", loop.registered_fds);
+    writer.header("async_server_event_loop_dispatch_seconds", "Time to dispatch one batch of events.", "histogram");
+    writer.histogram("async_server_event_loop_dispatch_seconds", "", "", event_loop_.dispatch_latency());
+    
+    if (workers_) {
+        std::vector<Worker::Stats> workers;
+        for (size_t i = 0; i < workers_->size(); ++i) {
+            workers.push_back(workers_->worker(i).stats());
+        }
+        auto label = [](size_t index) { return std::to_string(index); };
+        writer.header("async_server_worker_connections", "TCP connections owned by the worker reactor.", "gauge");
+        for (size_t i = 0; i < workers.size(); ++i) {
+            writer.sample("async_server_worker_connections", "worker", label(i), workers[i].connections);
+        }
+        writer.header("async_server_worker_accepted_total", "Connections handed to the worker by the acceptor.", "counter");
+        for (size_t i = 0; i < workers.size(); ++i) {
+            writer.sample("async_server_worker_accepted_total", "worker", label(i), workers[i].accepted);
+        }
+        writer.header("async_server_worker_loop_lag_seconds", "Moving average of the worker's event batch time.", "gauge");
+        for (size_t i = 0; i < workers.size(); ++i) {
+            writer.sample_seconds("async_server_worker_loop_lag_seconds", "worker", label(i), workers[i].lag_ns);
+        }
+        writer.header("async_server_worker_busy_seconds_total", "Time the worker spent in event callbacks.", "counter");
+        for (size_t i = 0; i < workers.size(); ++i) {
+            writer.sample_seconds("async_server_worker_busy_seconds_total", "worker", label(i), workers[i].loop.busy_ns);
+        }
+    }
+}
+
+void Server::handle_tcp_connection(TcpConnection& connection, EventLoop& loop) {
+    // Соединением владеет TcpHandler; указатель помещается во встроенный
+    // буфер std::function, отдельной аллокации на колбэк нет
+    TcpConnection* conn = &connection;
+    loop.add_fd(connection.get_fd(), EPOLLIN, [conn](uint32_t events) {
+        if (events & EPOLLERR) conn->handle_error_queue();
+        if (events & EPOLLOUT) conn->handle_write();
+        if ((events & EPOLLIN) && conn->get_fd() != -1) conn->handle_read();
     });
 }
 
-void Server::handle_tcp_message(const std::string& message, std::shared_ptr<TcpConnection> connection) {
-    std::string response = command_processor_.process_command(message);
+void Server::handle_tcp_message(std::string_view message, TcpConnection& connection,
+                                RequestArena& arena, int worker) {
+    uint64_t start = trace_clock();
+    uint64_t allocations = thread_allocations();
+    if (journal_.is_open()) {
+        journal_.append(JOURNAL_TCP, connection.get_client_addr(), message);
+    }
+    Response response(&arena);
+    ResponseTarget target{ResponseTarget::Kind::Tcp, connection.get_fd(), connection.get_id(), {}, worker};
+    bool forwarded = forward_to_upstream(message, target, response, &connection);
+    if (!forwarded) {
+        response = command_processor_.process_command(message, &connection, &arena);
+    }
+    trace_dispatch(connection.get_fd(), message.size(), start);
     
     if (response == "/SHUTDOWN_ACK") {
         shutdown_requested_ = true;
-        connection->send("Server shutting down gracefully...\n");
-        return;
+        connection.send("Server shutting down gracefully...\n");
+    } else if (!forwarded || !response.empty()) {
+        response.push_back('\n');
+        connection.send(response);
     }
-    
-    connection->send(response + "\n");
+    arena.add_request_allocations(thread_allocations() - allocations);
 }
 
-void Server::handle_udp_message(const std::string& message, const sockaddr_in& client_addr) {
-    std::string response = command_processor_.process_command(message);
+void Server::handle_udp_message(std::string_view message, const sockaddr_in& client_addr) {
+    // Быстрый отказ до журнала и разбора команды: датаграммы не ждут в очередях
+    if (overload_.rejecting_udp()) {
+        overload_.record_udp_rejected();
+        udp_handler_->send_message("BUSY", client_addr);
+        return;
+    }
+    uint64_t start = trace_clock();
+    uint64_t allocations = thread_allocations();
+    if (journal_.is_open()) {
+        journal_.append(JOURNAL_UDP, client_addr, message);
+    }
+    Response response(&arena_);
+    ResponseTarget target{ResponseTarget::Kind::Udp, -1, 0, client_addr};
+    bool forwarded = forward_to_upstream(message, target, response, nullptr);
+    if (!forwarded) {
+        response = command_processor_.process_command(message, nullptr, &arena_);
+    }
+    trace_dispatch(udp_handler_->get_socket_fd(), message.size(), start);
     
     if (response == "/SHUTDOWN_ACK") {
         shutdown_requested_ = true;
         udp_handler_->send_message("Server shutting down gracefully...", client_addr);
+    } else if (!forwarded || !response.empty()) {
+        udp_handler_->send_message(response, client_addr);
+    }
+    arena_.add_request_allocations(thread_allocations() - allocations);
+}
+
+bool Server::setup_upstreams() {
+    if (config_.upstreams.empty()) {
+        return true;
+    }
+    UpstreamPool::Options options;
+    options.connections_per_upstream = config_.upstream_connections;
+    options.max_pending = config_.upstream_max_pending;
+    options.timeout = config_.upstream_timeout;
+    options.health_interval = config_.upstream_health_interval;
+    options.health_check = config_.upstream_health_check;
+    upstreams_ = std::make_unique<UpstreamPool>(event_loop_, options,
+        [this](const ResponseTarget& target, std::string_view response) {
+            handle_upstream_response(target, response);
+        });
+    for (const auto& address : config_.upstreams) {
+        if (!upstreams_->add_upstream(address)) {
+            LOG_ERROR("Invalid upstream address: {}", address);
+            upstreams_.reset();
+            return false;
+        }
+    }
+    upstreams_->start();
+    LOG_INFO("Forwarding {} to {} upstream(s)", config_.upstream_prefix, config_.upstreams.size());
+    return true;
+}
+
+bool Server::forward_to_upstream(std::string_view message, ResponseTarget target, Response& response,
+                                 TcpConnection* connection) {
+    if (!upstreams_) {
+        return false;
+    }
+    const std::string& prefix = config_.upstream_prefix;
+    if (message.substr(0, prefix.size()) != prefix ||
+        (message.size() > prefix.size() && message[prefix.size()] != ' ')) {
+        return false;
+    }
+    size_t begin = message.find_first_not_of(' ', prefix.size());
+    if (begin == std::string_view::npos) {
+        response.append("ERROR: Usage: ").append(prefix).append(" <line>");
+        return true;
+    }
+    // Ответы на строки после этой клиент получит только вслед за ответом бэкенда
+    if (connection) {
+        target.sequence = connection->defer_reply();
+    }
+    if (target.worker >= 0) {
+        // Пул бэкендов живёт в основном реакторе: строка копируется туда,
+        // ошибка вернётся как ответ бэкенда
+        event_loop_.post([this, line = std::string(message.substr(begin)), target] {
+            if (const char* error = submit_upstream(line, target)) {
+                handle_upstream_response(target, error);
+            }
+        });
+        return true;
+    }
+    if (const char* error = submit_upstream(message.substr(begin), target)) {
+        handle_upstream_response(target, error);
+    }
+    return true;
+}
+
+const char* Server::submit_upstream(std::string_view line, const ResponseTarget& target) {
+    switch (upstreams_->forward(line, target)) {
+    case UpstreamPool::Result::Ok:
+        return nullptr;
+    case UpstreamPool::Result::NoUpstream:
+        return "ERROR: No upstream available";
+    case UpstreamPool::Result::Busy:
+        return "ERROR: Upstream busy";
+    }
+    return nullptr;
+}
+
+void Server::handle_upstream_response(const ResponseTarget& target, std::string_view response) {
+    if (target.kind == ResponseTarget::Kind::Udp) {
+        udp_handler_->send_message(response, target.peer);
         return;
     }
-    
-    udp_handler_->send_message(response, client_addr);
-}
\ No newline at end of file
+    if (target.worker >= 0) {
+        Worker& worker = workers_->worker(static_cast<size_t>(target.worker));
+        worker.loop().post([this, &worker, target, response = std::string(response)] {
+            send_upstream_response(worker.tcp_handler(), target, response, worker.arena());
+        });
+        return;
+    }
+    send_upstream_response(*tcp_handler_, target, response, arena_);
+}
+
+void Server::send_upstream_response(TcpHandler& handler, const ResponseTarget& target,
+                                    std::string_view response, RequestArena& arena) {
+    // Клиент мог отключиться, а fd - достаться новому соединению
+    TcpConnection* connection = handler.find_connection(target.fd);
+    if (!connection || connection->get_id() != target.connection_id || connection->get_fd() == -1) {
+        return;
+    }
+    Response line(&arena);
+    line.reserve(response.size() + 1);
+    line.append(response).push_back('\n');
+    connection->complete_reply(target.sequence, line);
+}
+
+
+void Server::trace_dispatch(int fd, size_t bytes, uint64_t start) {
+    uint64_t duration = trace_clock() - start;
+    SERVER_PROBE(dispatch, fd, bytes, duration);
+    if (TraceRing* ring = TraceRing::current()) {
+        ring->record(TraceType::Dispatch, fd, bytes, start, duration ? duration : 1);
+    }
+}
@@ -5,16 +5,27 @@
 #include <atomic>
 #include <vector>
 #include <functional>
+#include "admin_handler.hpp"
+#include "arena.hpp"
+#include "config.hpp"
+#include "signal_fd.hpp"
 #include "signal_handler.hpp"
 #include "tcp_handler.hpp"
 #include "udp_handler.hpp"
 #include "command_processor.hpp"
+#include "kv_store.hpp"
 #include "session_manager.hpp"
 #include "eventloop.hpp"
+#include "journal.hpp"
+#include "overload.hpp"
+#include "stats_segment.hpp"
+#include "upgrade.hpp"
+#include "upstream.hpp"
+#include "worker_pool.hpp"
 
 class Server : public std::enable_shared_from_this<Server> {
 public:
-    Server(uint16_t port);
+    explicit Server(const ServerConfig& config);
     ~Server();
     
     bool start();
@@ -23,23 +34,96 @@ public:
     
     void request_shutdown();
     
+    // Команда, которой запускается новый бинарник по SIGUSR2
+    void set_upgrade_command(std::vector<std::string> argv) { upgrade_argv_ = std::move(argv); }
+    
 private:
     void setup_signal_handler();
+    bool setup_signal_fd();
+    void handle_sighup();
+    void reload_config();
+    void apply_runtime_config(const ServerConfig& config);
+    void close_idle_connections();
+    void sweep_expired_keys();
+    void dump_stats();
+    std::string dump_trace();
+    void trace_dispatch(int fd, size_t bytes, uint64_t start);
+    ListenSockets inherit_listen_sockets();
+    void begin_upgrade();
+    void handle_upgrade_event();
+    void check_upgrade();
+    void start_drain();
+    void check_drain();
     void setup_tcp_handler();
+    // Обработчики соединений для реактора: основного (worker = -1) или рабочего
+    void setup_tcp_callbacks(TcpHandler& handler, EventLoop& loop, RequestArena& arena, int worker);
+    bool setup_workers();
+    size_t open_connections() const;
     void setup_udp_handler();
+    void setup_stats_segment();
+    void bind_reactor_memory();
+    bool setup_admin_handler(int inherited_fd);
+    void render_metrics(std::string& out) const;
+    void publish_stats();
+    void update_overload();
+    void set_accepting(bool accepting);
+    
+    void handle_tcp_connection(TcpConnection& connection, EventLoop& loop);
+    void handle_tcp_message(std::string_view message, TcpConnection& connection,
+                            RequestArena& arena, int worker);
+    void handle_udp_message(std::string_view message, const sockaddr_in& client_addr);
+    bool setup_upstreams();
+    // true - строка адресована бэкендам; response остаётся пустым, если
+    // ответ (или ошибка отправки) придёт через handle_upstream_response,
+    // иначе в нём ошибка разбора. connection - TCP-клиент, чьи следующие
+    // ответы ждут ответа бэкенда
+    bool forward_to_upstream(std::string_view message, ResponseTarget target, Response& response,
+                             TcpConnection* connection);
+    // Только основной реактор; nullptr - запрос принят, иначе текст ошибки
+    const char* submit_upstream(std::string_view line, const ResponseTarget& target);
+    void handle_upstream_response(const ResponseTarget& target, std::string_view response);
+    void send_upstream_response(TcpHandler& handler, const ResponseTarget& target,
+                                std::string_view response, RequestArena& arena);
     
-    void handle_tcp_connection(std::shared_ptr<TcpConnection> connection);
-    void handle_tcp_message(const std::string& message, std::shared_ptr<TcpConnection> connection);
-    void handle_udp_message(const std::string& message, const sockaddr_in& client_addr);
+    static constexpr auto STATS_PUBLISH_INTERVAL = std::chrono::milliseconds(10);
+    static constexpr auto IDLE_SWEEP_INTERVAL = std::chrono::seconds(1);
+    static constexpr auto OVERLOAD_CHECK_INTERVAL = std::chrono::milliseconds(10);
+    // Ключи с истёкшим сроком удаляются при обращении, а неиспользуемые -
+    // порциями по KV_SWEEP_SLOTS ячеек шарда, чтобы не задерживать цикл
+    static constexpr auto KV_SWEEP_INTERVAL = std::chrono::milliseconds(100);
+    static constexpr size_t KV_SWEEP_SLOTS = 1024;
+    static constexpr uint8_t JOURNAL_TCP = 0;
+    static constexpr uint8_t JOURNAL_UDP = 1;
     
+    ServerConfig config_;
     uint16_t port_;
     std::shared_ptr<SessionManager> session_manager_;
+    KvStore kv_store_;
+    OverloadController overload_;
     CommandProcessor command_processor_;
     std::atomic<bool> shutdown_requested_;
+    bool stopped_ = false;
     
     std::unique_ptr<TcpHandler> tcp_handler_;
     std::unique_ptr<UdpHandler> udp_handler_;
     EventLoop event_loop_;
+    RequestArena arena_;
+    std::unique_ptr<WorkerPool> workers_;
+    SignalFd signal_fd_;
+    std::unique_ptr<AdminHandler> admin_handler_;
+    StatsSegment stats_segment_;
+    Journal journal_;
+    std::unique_ptr<UpstreamPool> upstreams_;
+    std::chrono::steady_clock::time_point last_stats_publish_{};
+    std::chrono::steady_clock::time_point last_idle_sweep_{};
+    std::chrono::steady_clock::time_point last_kv_sweep_{};
+    std::chrono::steady_clock::time_point last_overload_check_{};
+    
+    std::vector<std::string> upgrade_argv_;
+    UpgradeChannel upgrade_channel_;
+    std::chrono::steady_clock::time_point upgrade_deadline_{};
+    bool draining_ = false;
+    std::chrono::steady_clock::time_point drain_deadline_{};
 };
 
 #endif // SERVER_HPP
\ No newline at end of file
@@ -1,7 +1,8 @@
 #include "session_manager.hpp"
 
-SessionManager::SessionManager() 
-    : start_time_(std::chrono::system_clock::now()) {}
+SessionManager::SessionManager(size_t session_capacity) 
+    : start_time_(std::chrono::system_clock::now())
+    , sessions_(session_capacity) {}
 
 void SessionManager::add_connection() {
     total_connections_++;
@@ -16,10 +17,25 @@ void SessionManager::increment_total_connections() {
     total_connections_++;
 }
 
+void SessionManager::record_received(Protocol protocol, size_t bytes, size_t messages) {
+    auto& counter = protocol == Protocol::Tcp ? tcp_messages_ : udp_messages_;
+    counter.fetch_add(messages, std::memory_order_relaxed);
+    bytes_received_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void SessionManager::record_sent(size_t bytes) {
+    bytes_sent_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
 ServerStats SessionManager::get_stats() const {
     ServerStats stats{};
     stats.total_connections = total_connections_.load();
     stats.current_connections = current_connections_.load();
+    stats.tcp_messages = tcp_messages_.load(std::memory_order_relaxed);
+    stats.udp_messages = udp_messages_.load(std::memory_order_relaxed);
+    stats.bytes_received = bytes_received_.load(std::memory_order_relaxed);
+    stats.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+    stats.queued_bytes = queued_bytes_.load(std::memory_order_relaxed);
     stats.start_time = start_time_;
     return stats;
 }
\ No newline at end of file
@@ -5,26 +5,58 @@
 #include <atomic>
 #include <mutex>
 #include <chrono>
+#include "pubsub.hpp"
+#include "session_table.hpp"
+#include "timestamping.hpp"
 
+enum class Protocol { Tcp, Udp };
 
 struct ServerStats {
     size_t total_connections;
     size_t current_connections;
+    uint64_t tcp_messages;
+    uint64_t udp_messages;
+    uint64_t bytes_received;
+    uint64_t bytes_sent;
+    size_t queued_bytes;  // ждут отправки в очередях TCP-соединений
     std::chrono::system_clock::time_point start_time;
 };
 
 class SessionManager {
 public:
-    SessionManager();
+    explicit SessionManager(size_t session_capacity = SessionTable::DEFAULT_CAPACITY);
     
     void add_connection();
     void remove_connection();
     void increment_total_connections();
     
+    void record_received(Protocol protocol, size_t bytes, size_t messages);
+    void record_sent(size_t bytes);
+    void record_queued(size_t bytes) { queued_bytes_.fetch_add(bytes, std::memory_order_relaxed); }
+    void record_dequeued(size_t bytes) { queued_bytes_.fetch_sub(bytes, std::memory_order_relaxed); }
+    
     ServerStats get_stats() const;
+    
+    SessionTable& sessions() { return sessions_; }
+    const SessionTable& sessions() const { return sessions_; }
+    
+    TopicRegistry& topics() { return topics_; }
+    const TopicRegistry& topics() const { return topics_; }
+    
+    // Заполняется только при socket_timestamps != off
+    PacketLatency& packet_latency() { return packet_latency_; }
+    const PacketLatency& packet_latency() const { return packet_latency_; }
 
 private:
     std::atomic<size_t> total_connections_{0};
     std::atomic<size_t> current_connections_{0};
+    std::atomic<uint64_t> tcp_messages_{0};
+    std::atomic<uint64_t> udp_messages_{0};
+    std::atomic<uint64_t> bytes_received_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<size_t> queued_bytes_{0};
     std::chrono::system_clock::time_point start_time_;
+    SessionTable sessions_;
+    TopicRegistry topics_;
+    PacketLatency packet_latency_;
 };
\ No newline at end of file
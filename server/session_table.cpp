@@ -0,0 +1,139 @@
+#include "session_table.hpp"
+#include "affinity.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+
+namespace {
+
+template <typename T>
+std::unique_ptr<std::atomic<T>[]> make_column(size_t capacity) {
+    auto column = std::make_unique<std::atomic<T>[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        column[i].store(0, std::memory_order_relaxed);
+    }
+    return column;
+}
+
+} // namespace
+
+SessionTable::SessionTable(size_t capacity)
+    : capacity_(capacity)
+    , in_use_(make_column<uint8_t>(capacity))
+    , peer_ip_(make_column<uint32_t>(capacity))
+    , peer_port_(make_column<uint16_t>(capacity))
+    , connect_time_(make_column<uint64_t>(capacity))
+    , last_activity_(make_column<uint64_t>(capacity))
+    , bytes_in_(make_column<uint64_t>(capacity))
+    , bytes_out_(make_column<uint64_t>(capacity))
+    , messages_in_(make_column<uint64_t>(capacity))
+    , messages_out_(make_column<uint64_t>(capacity))
+{
+    free_slots_.reserve(capacity);
+    for (size_t i = capacity; i > 0; --i) {
+        free_slots_.push_back(static_cast<int>(i - 1));
+    }
+}
+
+bool SessionTable::bind_to_node(int node) {
+    auto bind = [this, node](const auto& column) {
+        return bind_memory_to_node(column.get(), capacity_ * sizeof(column[0]), node);
+    };
+    // Мелкие колонки короче страницы не привязываются, результат - по самой крупной
+    bind(in_use_);
+    bind(peer_ip_);
+    bind(peer_port_);
+    bind(connect_time_);
+    bind(last_activity_);
+    bind(bytes_in_);
+    bind(bytes_out_);
+    bind(messages_in_);
+    return bind(messages_out_);
+}
+
+int SessionTable::open(const sockaddr_in& peer) {
+    int slot;
+    {
+        std::lock_guard<std::mutex> lock(free_mutex_);
+        if (free_slots_.empty()) {
+            return INVALID_SLOT;
+        }
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+
+    uint64_t now = now_ns();
+    peer_ip_[slot].store(peer.sin_addr.s_addr, std::memory_order_relaxed);
+    peer_port_[slot].store(peer.sin_port, std::memory_order_relaxed);
+    connect_time_[slot].store(now, std::memory_order_relaxed);
+    last_activity_[slot].store(now, std::memory_order_relaxed);
+    bytes_in_[slot].store(0, std::memory_order_relaxed);
+    bytes_out_[slot].store(0, std::memory_order_relaxed);
+    messages_in_[slot].store(0, std::memory_order_relaxed);
+    messages_out_[slot].store(0, std::memory_order_relaxed);
+    in_use_[slot].store(1, std::memory_order_release);
+    active_.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+void SessionTable::close(int slot) {
+    if (slot < 0 || static_cast<size_t>(slot) >= capacity_) {
+        return;
+    }
+    in_use_[slot].store(0, std::memory_order_release);
+    active_.fetch_sub(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    free_slots_.push_back(slot);
+}
+
+SessionInfo SessionTable::get(int slot) const {
+    uint64_t now = now_ns();
+    in_addr addr{};
+    addr.s_addr = peer_ip_[slot].load(std::memory_order_relaxed);
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr, ip, INET_ADDRSTRLEN);
+
+    SessionInfo info{};
+    info.slot = slot;
+    info.peer = std::string(ip) + ":" + std::to_string(ntohs(peer_port_[slot].load(std::memory_order_relaxed)));
+    info.age = std::chrono::nanoseconds(now - connect_time_[slot].load(std::memory_order_relaxed));
+    info.idle = std::chrono::nanoseconds(now - std::min(now, last_activity_[slot].load(std::memory_order_relaxed)));
+    info.bytes_in = bytes_in_[slot].load(std::memory_order_relaxed);
+    info.bytes_out = bytes_out_[slot].load(std::memory_order_relaxed);
+    info.messages_in = messages_in_[slot].load(std::memory_order_relaxed);
+    info.messages_out = messages_out_[slot].load(std::memory_order_relaxed);
+    return info;
+}
+
+std::vector<SessionInfo> SessionTable::top(Order order, size_t limit) const {
+    // Первый проход читает только ключевые столбцы, остальные поля
+    // собираются лишь для попавших в топ слотов.
+    uint64_t now = now_ns();
+    std::vector<std::pair<uint64_t, int>> keys;
+    keys.reserve(active());
+
+    for (size_t i = 0; i < capacity_; ++i) {
+        if (!in_use_[i].load(std::memory_order_acquire)) {
+            continue;
+        }
+        uint64_t key;
+        if (order == Order::Traffic) {
+            key = bytes_in_[i].load(std::memory_order_relaxed) + bytes_out_[i].load(std::memory_order_relaxed);
+        } else {
+            key = now - std::min(now, last_activity_[i].load(std::memory_order_relaxed));
+        }
+        keys.emplace_back(key, static_cast<int>(i));
+    }
+
+    limit = std::min(limit, keys.size());
+    std::partial_sort(keys.begin(), keys.begin() + limit, keys.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<SessionInfo> result;
+    result.reserve(limit);
+    for (size_t i = 0; i < limit; ++i) {
+        result.push_back(get(keys[i].second));
+    }
+    return result;
+}
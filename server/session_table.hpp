@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+struct SessionInfo {
+    int slot;
+    std::string peer;
+    std::chrono::nanoseconds age;
+    std::chrono::nanoseconds idle;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t messages_in;
+    uint64_t messages_out;
+};
+
+// Таблица сессий в виде параллельных массивов, индексированных слотом
+// соединения. Счётчики пишет только реактор, владеющий соединением,
+// поэтому обновления идут relaxed-записями без блокировок; мьютекс
+// защищает лишь список свободных слотов при подключении/отключении.
+class SessionTable {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+    static constexpr int INVALID_SLOT = -1;
+
+    enum class Order { Traffic, Idle };
+
+    explicit SessionTable(size_t capacity = DEFAULT_CAPACITY);
+
+    int open(const sockaddr_in& peer);
+    void close(int slot);
+
+    void record_read(int slot, size_t bytes, size_t messages) {
+        if (slot < 0) return;
+        uint64_t now = now_ns();
+        add(bytes_in_[slot], bytes);
+        add(messages_in_[slot], messages);
+        last_activity_[slot].store(now, std::memory_order_relaxed);
+    }
+
+    // Запись тоже активность: подписчик, который только получает /publish,
+    // не должен закрываться по tcp_timeout
+    void record_write(int slot, size_t bytes) {
+        if (slot < 0) return;
+        add(bytes_out_[slot], bytes);
+        add(messages_out_[slot], 1);
+        last_activity_[slot].store(now_ns(), std::memory_order_relaxed);
+    }
+
+    uint64_t last_activity_ns(int slot) const {
+        return last_activity_[slot].load(std::memory_order_relaxed);
+    }
+
+    std::vector<SessionInfo> top(Order order, size_t limit) const;
+    SessionInfo get(int slot) const;
+
+    size_t capacity() const { return capacity_; }
+
+    // Переносит колонки на узел NUMA реактора; false - mbind недоступен
+    bool bind_to_node(int node);
+    size_t active() const { return active_.load(std::memory_order_relaxed); }
+
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    template <typename T>
+    using Column = std::unique_ptr<std::atomic<T>[]>;
+
+    // Единственный писатель на слот: load + store вместо атомарного RMW
+    static void add(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    size_t capacity_;
+    std::atomic<size_t> active_{0};
+
+    Column<uint8_t> in_use_;
+    Column<uint32_t> peer_ip_;
+    Column<uint16_t> peer_port_;
+    Column<uint64_t> connect_time_;
+    Column<uint64_t> last_activity_;
+    Column<uint64_t> bytes_in_;
+    Column<uint64_t> bytes_out_;
+    Column<uint64_t> messages_in_;
+    Column<uint64_t> messages_out_;
+
+    std::mutex free_mutex_;
+    std::vector<int> free_slots_;
+};
@@ -0,0 +1,64 @@
+#include "signal_fd.hpp"
+#include "logger.hpp"
+
+#include <cerrno>
+#include <pthread.h>
+#include <unistd.h>
+
+SignalFd::~SignalFd() {
+    close();
+}
+
+bool SignalFd::open(const std::vector<int>& signals) {
+    close();
+
+    sigemptyset(&mask_);
+    for (int sig : signals) {
+        sigaddset(&mask_, sig);
+    }
+
+    if (pthread_sigmask(SIG_BLOCK, &mask_, &previous_mask_) != 0) {
+        return false;
+    }
+
+    fd_ = signalfd(-1, &mask_, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd_ == -1) {
+        pthread_sigmask(SIG_SETMASK, &previous_mask_, nullptr);
+        return false;
+    }
+    return true;
+}
+
+void SignalFd::close() {
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+        pthread_sigmask(SIG_SETMASK, &previous_mask_, nullptr);
+    }
+}
+
+void SignalFd::handle_read() {
+    signalfd_siginfo info[8];
+    while (fd_ != -1) {
+        ssize_t bytes_read = read(fd_, info, sizeof(info));
+        if (bytes_read <= 0) {
+            if (bytes_read == -1 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        size_t count = static_cast<size_t>(bytes_read) / sizeof(signalfd_siginfo);
+        for (size_t i = 0; i < count; ++i) {
+            auto it = handlers_.find(static_cast<int>(info[i].ssi_signo));
+            if (it == handlers_.end()) {
+                continue;
+            }
+            try {
+                it->second(info[i]);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Exception in signal callback: {}", e.what());
+            }
+        }
+    }
+}
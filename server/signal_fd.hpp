@@ -0,0 +1,40 @@
+#pragma once
+
+#include <signal.h>
+#include <sys/signalfd.h>
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Приём сигналов через signalfd внутри EventLoop: сигналы блокируются
+// маской, а их обработчики выполняются в потоке цикла событий как обычные
+// колбэки - без отдельного потока и без гонок с остальным состоянием.
+// open() нужно вызывать до запуска любых других потоков, чтобы они
+// унаследовали маску и сигнал не был доставлен им напрямую.
+class SignalFd {
+public:
+    using Handler = std::function<void(const signalfd_siginfo&)>;
+
+    SignalFd() = default;
+    ~SignalFd();
+
+    SignalFd(const SignalFd&) = delete;
+    SignalFd& operator=(const SignalFd&) = delete;
+
+    bool open(const std::vector<int>& signals);
+    void close();
+
+    void set_handler(int signo, Handler handler) {
+        handlers_[signo] = std::move(handler);
+    }
+
+    void handle_read();
+    int get_fd() const { return fd_; }
+
+private:
+    int fd_ = -1;
+    sigset_t mask_{};
+    sigset_t previous_mask_{};
+    std::unordered_map<int, Handler> handlers_;
+};
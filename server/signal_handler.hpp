@@ -10,7 +10,6 @@
 #include <atomic>
 #include <csignal>
 #include <functional>
-#include <iostream>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
@@ -20,6 +19,8 @@
 #include <tuple>
 #include <utility>
 
+#include "logger.hpp"
+
 class SignalHandler {
 public:
 
@@ -96,6 +97,10 @@ public:
         return running_;
     }
 
+    pthread_t native_handle() {
+        return thread_.native_handle();
+    }
+
 private:
     SignalHandler() = default;
 
@@ -154,14 +159,14 @@ private:
                 if (errno == EINTR) {
                     continue;
                 }
-                std::cerr << "Failed on poll: " << strerror(errno) << std::endl;
+                LOG_ERROR("Failed on poll: {}", strerror(errno));
                 break;
             }
 
             if (pfds[0].revents & POLLIN) {
                 auto count = read(terminate_event_fd_, &val, sizeof(val));
                 if (count < 0) {
-                    std::cerr << "Failed to read termination event: " << strerror(errno) << std::endl;
+                    LOG_ERROR("Failed to read termination event: {}", strerror(errno));
                 }
                 break;
             }
@@ -169,14 +174,14 @@ private:
             if (pfds[1].revents & POLLIN) {
                 auto count = read(trigger_event_fd_, &val, sizeof(val));
                 if (count < 0) {
-                    std::cerr << "Failed to read trigger event: " << strerror(errno) << std::endl;
+                    LOG_ERROR("Failed to read trigger event: {}", strerror(errno));
                     break;
                 }
                 
                 try {
                     std::forward<CallbackT>(callback)(std::get<I>(std::forward<ArgsTuple>(args))...);
                 } catch (const std::exception& e) {
-                    std::cerr << "Exception in signal callback: " << e.what() << std::endl;
+                    LOG_ERROR("Exception in signal callback: {}", e.what());
                 }
             }
         }
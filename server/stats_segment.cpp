@@ -0,0 +1,151 @@
+#include "stats_segment.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+StatsSegment::~StatsSegment() {
+    close();
+}
+
+bool StatsSegment::open(const std::string& name) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return false;
+    }
+    if (ftruncate(fd, sizeof(StatsSegmentLayout)) == -1) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* addr = mmap(nullptr, sizeof(StatsSegmentLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // Заголовок пишется последним: magic служит признаком готовности
+    auto* layout = static_cast<StatsSegmentLayout*>(addr);
+    layout->magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    new (&layout->sequence) std::atomic<uint64_t>(0);
+    for (auto& value : layout->values) {
+        new (&value) std::atomic<uint64_t>(0);
+    }
+    layout->version = StatsSegmentLayout::VERSION;
+    layout->field_count = static_cast<uint16_t>(STATS_FIELD_COUNT);
+    layout->pid = static_cast<uint32_t>(getpid());
+    layout->reserved = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    layout->magic = StatsSegmentLayout::MAGIC;
+
+    name_ = name;
+    layout_ = layout;
+    return true;
+}
+
+void StatsSegment::close() {
+    if (layout_) {
+        munmap(layout_, sizeof(StatsSegmentLayout));
+        shm_unlink(name_.c_str());
+        layout_ = nullptr;
+    }
+}
+
+void StatsSegment::detach() {
+    if (layout_) {
+        munmap(layout_, sizeof(StatsSegmentLayout));
+        layout_ = nullptr;
+    }
+}
+
+void StatsSegment::publish(const StatsValues& values) {
+    if (!layout_) {
+        return;
+    }
+
+    uint64_t seq = layout_->sequence.load(std::memory_order_relaxed);
+    layout_->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < STATS_FIELD_COUNT; ++i) {
+        layout_->values[i].store(values[i], std::memory_order_relaxed);
+    }
+
+    layout_->sequence.store(seq + 2, std::memory_order_release);
+}
+
+std::string StatsSegment::default_name(uint16_t port) {
+    return "/async_tcp_udp_server." + std::to_string(port);
+}
+
+StatsSegmentReader::~StatsSegmentReader() {
+    if (layout_) {
+        munmap(const_cast<StatsSegmentLayout*>(layout_), sizeof(StatsSegmentLayout));
+    }
+}
+
+bool StatsSegmentReader::open(const std::string& name, std::string& error) {
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd == -1) {
+        error = "shm_open(" + name + "): " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(StatsSegmentLayout)) {
+        ::close(fd);
+        error = "segment " + name + " is truncated";
+        return false;
+    }
+
+    void* addr = mmap(nullptr, sizeof(StatsSegmentLayout), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        error = std::string("mmap: ") + std::strerror(errno);
+        return false;
+    }
+
+    const auto* layout = static_cast<const StatsSegmentLayout*>(addr);
+    if (layout->magic != StatsSegmentLayout::MAGIC || layout->version != StatsSegmentLayout::VERSION) {
+        munmap(addr, sizeof(StatsSegmentLayout));
+        error = "segment " + name + " has unknown layout (magic/version mismatch)";
+        return false;
+    }
+
+    layout_ = layout;
+    return true;
+}
+
+bool StatsSegmentReader::read(StatsValues& values, size_t& field_count) const {
+    if (!layout_) {
+        return false;
+    }
+
+    field_count = std::min<size_t>(layout_->field_count, STATS_FIELD_COUNT);
+    values.fill(0);
+
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        uint64_t before = layout_->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        for (size_t i = 0; i < field_count; ++i) {
+            values[i] = layout_->values[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (layout_->sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Индексы счётчиков в сегменте. Новые поля добавляются только в конец:
+// читатель старой версии просто не увидит их (см. field_count), а
+// несовместимые изменения раскладки требуют увеличить VERSION.
+enum class StatsField : uint32_t {
+    StartTimeNs,
+    PublishTimeNs,
+    TotalConnections,
+    CurrentConnections,
+    ActiveSessions,
+    TcpMessages,
+    UdpMessages,
+    BytesReceived,
+    BytesSent,
+    Count
+};
+
+inline constexpr size_t STATS_FIELD_COUNT = static_cast<size_t>(StatsField::Count);
+
+inline constexpr std::array<const char*, STATS_FIELD_COUNT> STATS_FIELD_NAMES = {
+    "start_time_ns",
+    "publish_time_ns",
+    "total_connections",
+    "current_connections",
+    "active_sessions",
+    "tcp_messages",
+    "udp_messages",
+    "bytes_received",
+    "bytes_sent",
+};
+
+using StatsValues = std::array<uint64_t, STATS_FIELD_COUNT>;
+
+// Бинарная раскладка сегмента в /dev/shm. Снимок защищён seqlock'ом:
+// нечётное значение sequence означает, что писатель обновляет values.
+struct StatsSegmentLayout {
+    static constexpr uint32_t MAGIC = 0x53555441; // "ATUS"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t MAX_FIELDS = 64;
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t field_count;
+    uint32_t pid;
+    uint32_t reserved;
+    alignas(64) std::atomic<uint64_t> sequence;
+    alignas(64) std::atomic<uint64_t> values[MAX_FIELDS];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "stats segment requires lock-free 64-bit atomics");
+static_assert(STATS_FIELD_COUNT <= StatsSegmentLayout::MAX_FIELDS, "too many stats fields");
+
+// Сторона сервера: создаёт сегмент и публикует снимки.
+class StatsSegment {
+public:
+    StatsSegment() = default;
+    ~StatsSegment();
+
+    StatsSegment(const StatsSegment&) = delete;
+    StatsSegment& operator=(const StatsSegment&) = delete;
+
+    bool open(const std::string& name);
+    void close();
+    // Отключается, не удаляя имя: сегмент переходит к новому процессу
+    void detach();
+    bool is_open() const { return layout_ != nullptr; }
+
+    void publish(const StatsValues& values);
+
+    static std::string default_name(uint16_t port);
+
+private:
+    std::string name_;
+    StatsSegmentLayout* layout_ = nullptr;
+};
+
+// Сторона монитора: отображает сегмент только на чтение.
+class StatsSegmentReader {
+public:
+    StatsSegmentReader() = default;
+    ~StatsSegmentReader();
+
+    StatsSegmentReader(const StatsSegmentReader&) = delete;
+    StatsSegmentReader& operator=(const StatsSegmentReader&) = delete;
+
+    bool open(const std::string& name, std::string& error);
+    bool read(StatsValues& values, size_t& field_count) const;
+    uint32_t pid() const { return layout_ ? layout_->pid : 0; }
+
+private:
+    const StatsSegmentLayout* layout_ = nullptr;
+};
@@ -1,12 +1,25 @@
 #include "tcp_connection.hpp"
 
-TcpConnection::TcpConnection(int fd, const sockaddr_in& client_addr, std::shared_ptr<SessionManager> session_manager)
+#include <atomic>
+#include <cerrno>
+#include <sys/uio.h>
+
+namespace {
+const TcpSettings default_settings{};
+std::atomic<uint64_t> next_connection_id{1};
+}
+
+TcpConnection::TcpConnection(int fd, const sockaddr_in& client_addr, SessionManager* session_manager,
+                             const TcpSettings* settings)
     : fd_(fd)
+    , id_(next_connection_id.fetch_add(1, std::memory_order_relaxed))
     , client_addr_(client_addr)
     , session_manager_(session_manager) 
+    , settings_(settings ? settings : &default_settings)
 {
     if (session_manager_) {
         session_manager_->add_connection();
+        session_slot_ = session_manager_->sessions().open(client_addr_);
     }
 }
 
@@ -14,24 +27,276 @@ TcpConnection::~TcpConnection() {
     close();
 }
 
-void TcpConnection::send(const std::string& message) {
-    if (fd_ != -1) {
-        ::send(fd_, message.c_str(), message.length(), 0);
+void TcpConnection::send(std::string_view message) {
+    if (fd_ == -1) {
+        return;
+    }
+    // Ответ ждёт отложенного ответа бэкенда; в выборку такой запрос не попадает
+    if (order_) {
+        if (order_->slots.size() >= MAX_QUEUED_MESSAGES) {
+            close();
+            return;
+        }
+        order_->slots.push_back({true, std::string(message)});
+        return;
+    }
+    write_reply(message);
+}
+
+uint64_t TcpConnection::defer_reply() {
+    if (!order_) {
+        order_ = std::make_unique<ReplyOrder>();
+    }
+    order_->slots.emplace_back();
+    return order_->first + order_->slots.size() - 1;
+}
+
+void TcpConnection::complete_reply(uint64_t sequence, std::string_view message) {
+    if (fd_ == -1 || !order_ || sequence < order_->first || sequence - order_->first >= order_->slots.size()) {
+        return;
+    }
+    ReplyOrder::Slot& slot = order_->slots[sequence - order_->first];
+    slot.ready = true;
+    slot.data.assign(message);
+    release_replies();
+}
+
+void TcpConnection::release_replies() {
+    while (fd_ != -1 && order_ && order_->slots.front().ready) {
+        std::string data = std::move(order_->slots.front().data);
+        order_->slots.pop_front();
+        ++order_->first;
+        if (order_->slots.empty()) {
+            order_.reset();
+        }
+        write_reply(data);
+    }
+}
+
+void TcpConnection::write_reply(std::string_view message) {
+    RequestSample* sample = RequestSample::current();
+    if (sample && sample->metrics) {
+        sample->queued = monotonic_ns();
+    } else {
+        sample = nullptr;
+    }
+    // За очередью ответ не обгоняет уже поставленные сообщения
+    if (output_) {
+        if (output_->messages.size() >= MAX_QUEUED_MESSAGES) {
+            close();
+            return;
+        }
+        push_queued(std::make_shared<const std::string>(message));
+        finish_sample(sample);
+        return;
+    }
+    size_t sent = write_now(message.data(), message.size());
+    if (fd_ != -1 && sent < message.size()) {
+        enqueue(std::make_shared<const std::string>(message.substr(sent)), 0);
+    }
+    finish_sample(sample);
+}
+
+void TcpConnection::finish_sample(RequestSample* sample) {
+    if (!sample || fd_ == -1) {
+        return;
+    }
+    if (!output_) {
+        sample->record(monotonic_ns());
+    } else if (!output_->sample.metrics) {
+        // Ждёт в очереди; если там уже есть ответ из выборки, этот не учитывается
+        output_->sample = *sample;
+        output_->sample_bytes = output_->bytes;
     }
+    sample->metrics = nullptr;
+}
+
+Subscriber::Delivery TcpConnection::deliver(const SharedMessage& message) {
+    if (fd_ == -1) {
+        return Delivery::Dropped;
+    }
+    if (!output_) {
+        size_t sent = write_now(message->data(), message->size());
+        if (sent == message->size()) {
+            return Delivery::Sent;
+        }
+        if (fd_ == -1) {
+            return Delivery::Disconnected;
+        }
+        enqueue(message, sent);
+        return Delivery::Queued;
+    }
+    
+    // Сокет уже не успевает: решает политика медленного подписчика
+    if (settings_->subscriber_policy == SlowSubscriberPolicy::Drop) {
+        return Delivery::Dropped;
+    }
+    if (output_->messages.size() < settings_->subscriber_queue_limit) {
+        push_queued(message);
+        return Delivery::Queued;
+    }
+    if (settings_->subscriber_policy == SlowSubscriberPolicy::Disconnect) {
+        close();
+        return Delivery::Disconnected;
+    }
+    return Delivery::Dropped;
+}
+
+void TcpConnection::handle_write() {
+    if (fd_ == -1 || !output_) {
+        return;
+    }
+    
+    iovec iov[IOV_BATCH];
+    size_t count = 0;
+    size_t offset = output_->offset;
+    for (const auto& message : output_->messages) {
+        if (count == IOV_BATCH) {
+            break;
+        }
+        iov[count].iov_base = const_cast<char*>(message->data() + offset);
+        iov[count].iov_len = message->size() - offset;
+        offset = 0;
+        ++count;
+    }
+    
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    uint64_t send_ns = tx_clock();
+    ssize_t sent = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+    SERVER_TRACE(send, TraceType::Send, fd_, sent > 0 ? static_cast<uint64_t>(sent) : 0);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            close();
+        }
+        return;
+    }
+    record_sent(static_cast<size_t>(sent), send_ns);
+    output_->bytes -= static_cast<size_t>(sent);
+    if (session_manager_) {
+        session_manager_->record_dequeued(static_cast<size_t>(sent));
+    }
+    if (output_->sample.metrics) {
+        if (static_cast<size_t>(sent) >= output_->sample_bytes) {
+            output_->sample.record(monotonic_ns());
+            output_->sample.metrics = nullptr;
+        } else {
+            output_->sample_bytes -= static_cast<size_t>(sent);
+        }
+    }
+    
+    size_t remaining = static_cast<size_t>(sent);
+    while (remaining > 0) {
+        size_t left = output_->messages.front()->size() - output_->offset;
+        if (remaining < left) {
+            output_->offset += remaining;
+            break;
+        }
+        remaining -= left;
+        output_->messages.pop_front();
+        output_->offset = 0;
+    }
+    
+    if (output_->messages.empty()) {
+        output_.reset();
+        if (settings_->on_want_write) {
+            settings_->on_want_write(fd_, false);
+        }
+    }
+}
+
+size_t TcpConnection::write_now(const char* data, size_t size) {
+    uint64_t send_ns = tx_clock();
+    ssize_t sent = ::send(fd_, data, size, MSG_NOSIGNAL);
+    SERVER_TRACE(send, TraceType::Send, fd_, sent > 0 ? static_cast<uint64_t>(sent) : 0);
+    if (sent > 0) {
+        record_sent(static_cast<size_t>(sent), send_ns);
+        return static_cast<size_t>(sent);
+    }
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        close();
+    }
+    return 0;
+}
+
+void TcpConnection::enqueue(SharedMessage message, size_t offset) {
+    output_ = std::make_unique<OutputQueue>();
+    output_->offset = offset;
+    output_->bytes = message->size() - offset;
+    if (session_manager_) {
+        session_manager_->record_queued(output_->bytes);
+    }
+    output_->messages.push_back(std::move(message));
+    if (settings_->on_want_write) {
+        settings_->on_want_write(fd_, true);
+    }
+}
+
+void TcpConnection::push_queued(SharedMessage message) {
+    output_->bytes += message->size();
+    if (session_manager_) {
+        session_manager_->record_queued(message->size());
+    }
+    output_->messages.push_back(std::move(message));
+}
+
+void TcpConnection::record_sent(size_t bytes, uint64_t send_ns) {
+    if (session_manager_) {
+        session_manager_->sessions().record_write(session_slot_, bytes);
+        session_manager_->record_sent(bytes);
+    }
+    if (settings_->timestamps == SocketTimestamps::RxTx) {
+        // Ключ OPT_ID в TCP - смещение последнего байта вызова send()
+        tx_bytes_ += static_cast<uint32_t>(bytes);
+        tx_key_ = tx_bytes_ - 1;
+        tx_sent_ns_ = send_ns;
+    }
+}
+
+void TcpConnection::handle_error_queue() {
+    if (fd_ == -1) {
+        return;
+    }
+    read_tx_timestamps(fd_, [this](uint32_t key, uint64_t sent_ns) {
+        if (key != tx_key_ || tx_sent_ns_ == 0 || !session_manager_) {
+            return;
+        }
+        if (sent_ns >= tx_sent_ns_) {
+            session_manager_->packet_latency().tx[static_cast<size_t>(Protocol::Tcp)]
+                .observe(sent_ns - tx_sent_ns_);
+        }
+        tx_sent_ns_ = 0;
+    });
 }
 
 void TcpConnection::close() {
     if (fd_ != -1) {
-        ::close(fd_);
+        int fd = fd_;
         fd_ = -1;
+        SERVER_TRACE(close, TraceType::Close, fd, 0);
         
         if (session_manager_) {
             session_manager_->remove_connection();
+            session_manager_->sessions().close(session_slot_);
+            session_slot_ = SessionTable::INVALID_SLOT;
+            if (subscriptions() > 0) {
+                session_manager_->topics().unsubscribe_all(this);
+            }
         }
         
-        if (close_callback_) {
-            close_callback_();
+        release_pending();
+        if (output_ && session_manager_) {
+            session_manager_->record_dequeued(output_->bytes);
         }
+        output_.reset();
+        order_.reset();
+        
+        // Колбэк снимает fd с epoll, поэтому вызывается до закрытия дескриптора
+        if (settings_->on_close) {
+            settings_->on_close(fd);
+        }
+        ::close(fd);
     }
 }
 
@@ -42,18 +307,105 @@ std::string TcpConnection::get_client_info() const {
 }
 
 void TcpConnection::handle_read() {
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_read = recv(fd_, buffer, BUFFER_SIZE - 1, 0);
+    static thread_local std::vector<char> read_buffer;
+    if (read_buffer.size() != settings_->buffer_size) {
+        read_buffer.resize(settings_->buffer_size);
+    }
+    char* buffer = read_buffer.data();
+    bool timestamped = settings_->timestamps != SocketTimestamps::Off && session_manager_;
+    uint64_t kernel_ns = 0;
+    uint64_t read_ns = 0;
+    ssize_t bytes_read = 0;
+    if (timestamped) {
+        bytes_read = recv_timestamped(fd_, buffer, read_buffer.size(), nullptr, kernel_ns);
+        read_ns = realtime_ns();
+    } else {
+        bytes_read = recv(fd_, buffer, read_buffer.size(), 0);
+    }
+    SERVER_TRACE(read, TraceType::Read, fd_, bytes_read > 0 ? static_cast<uint64_t>(bytes_read) : 0);
+    
+    if (bytes_read > 0 && timestamped && kernel_ns != 0 && read_ns > kernel_ns) {
+        session_manager_->packet_latency().socket_queue[static_cast<size_t>(Protocol::Tcp)]
+            .observe(read_ns - kernel_ns);
+    }
     
     if (bytes_read > 0) {
-        buffer[bytes_read] = '\0';
-        std::string message(buffer);
-        message.erase(message.find_last_not_of(" \t\n\r\f\v") + 1);
+        size_t size = static_cast<size_t>(bytes_read);
+        uint64_t received_ns = settings_->sample_rate ? monotonic_ns() : 0;
+        if (!pending_) {
+            size_t consumed = dispatch_lines(buffer, size, received_ns);
+            if (consumed < size && fd_ != -1) {
+                pending_ = BufferPool::local().acquire();
+                pending_->assign(buffer + consumed, size - consumed);
+            }
+        } else {
+            pending_->append(buffer, size);
+            size_t consumed = dispatch_lines(pending_->data(), pending_->size(), received_ns);
+            if (pending_) {
+                pending_->erase(0, consumed);
+            }
+        }
         
-        if (message_callback_) {
-            message_callback_(message);
+        // Строка без '\n' не должна расти бесконечно: отдаём её как есть
+        if (pending_ && pending_->size() > MAX_LINE_LENGTH) {
+            if (session_manager_) {
+                session_manager_->sessions().record_read(session_slot_, pending_->size(), 1);
+                session_manager_->record_received(Protocol::Tcp, pending_->size(), 1);
+            }
+            // Обработчик читает строку прямо из буфера, поэтому буфер
+            // забирается у соединения: close() в обработчике его не тронет
+            BufferPool::Buffer line = std::move(pending_);
+            if (settings_->on_message) {
+                settings_->on_message(*this, LineScanner::trim(*line));
+            }
+            BufferPool::local().release(std::move(line));
+        }
+        if (pending_ && pending_->empty()) {
+            release_pending();
+        }
+        if (timestamped) {
+            uint64_t done_ns = realtime_ns();
+            if (done_ns > read_ns) {
+                session_manager_->packet_latency().processing[static_cast<size_t>(Protocol::Tcp)]
+                    .observe(done_ns - read_ns);
+            }
         }
     } else if (bytes_read == 0) {
         close();
     }
-}
\ No newline at end of file
+}
+
+void TcpConnection::release_pending() {
+    if (pending_) {
+        BufferPool::local().release(std::move(pending_));
+    }
+}
+
+size_t TcpConnection::dispatch_lines(const char* data, size_t size, uint64_t received_ns) {
+    // Разметка строк общая для потока: обработчик сообщения не читает сокеты
+    static thread_local std::vector<LineSpan> lines;
+    lines.clear();
+    size_t consumed = LineScanner::scan(data, size, lines);
+    uint64_t parsed_ns = received_ns ? monotonic_ns() : 0;
+    
+    if (session_manager_ && consumed > 0) {
+        session_manager_->sessions().record_read(session_slot_, consumed, lines.size());
+        session_manager_->record_received(Protocol::Tcp, consumed, lines.size());
+    }
+    
+    for (const auto& line : lines) {
+        if (fd_ == -1 || !settings_->on_message) {
+            break;
+        }
+        std::string_view message(data + line.offset, line.length);
+        if (received_ns && RequestSample::take(settings_->sample_rate)) {
+            RequestSample sample{received_ns, parsed_ns};
+            RequestSample::set_current(&sample);
+            settings_->on_message(*this, message);
+            RequestSample::set_current(nullptr);
+        } else {
+            settings_->on_message(*this, message);
+        }
+    }
+    return consumed;
+}
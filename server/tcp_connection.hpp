@@ -1,9 +1,17 @@
 #pragma once
 
+#include "buffer_pool.hpp"
+#include "pubsub.hpp"
 #include "session_manager.hpp"
+#include "line_scanner.hpp"
+#include "request_sampler.hpp"
+#include "trace.hpp"
+#include <deque>
 #include <memory>
 #include <functional>
 #include <string>
+#include <thread>
+#include <vector>
 #include <netinet/in.h>
 
 #include <iostream>
@@ -12,31 +20,126 @@
 #include <unistd.h>
 #include <cstring>
 
-class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
+class TcpConnection;
+
+// Настройки и обработчики, общие для всех соединений обработчика: в самом
+// соединении хранится только указатель. buffer_size меняется на лету при
+// перечитывании конфигурации.
+struct TcpSettings {
+    size_t buffer_size = 4096;
+    std::function<void(TcpConnection&, std::string_view)> on_message;
+    // Вызывается до закрытия дескриптора: обработчик снимает fd с epoll
+    std::function<void(int)> on_close;
+    // Появилась (true) или опустела (false) очередь на отправку: обработчик
+    // включает или выключает EPOLLOUT
+    std::function<void(int, bool)> on_want_write;
+    SlowSubscriberPolicy subscriber_policy = SlowSubscriberPolicy::Queue;
+    size_t subscriber_queue_limit = 1024;
+    SocketTimestamps timestamps = SocketTimestamps::Off;
+    // Каждый N-й запрос трассируется по этапам, 0 - выключено
+    uint32_t sample_rate = 0;
+    // Рабочий реактор: поток-владелец соединений и передача ему /publish из
+    // других потоков. Без post_delivery все потоки считаются своими.
+    std::thread::id owner_thread;
+    std::function<void(int fd, uint64_t id, const SharedMessage&)> post_delivery;
+};
+
+// Соединение держит в простое только дескриптор, слот сессии, адрес и
+// указатели; буфер под хвост строки берётся из BufferPool на время чтения,
+// очередь на отправку - пока сокет не принимает данные
+class TcpConnection : public Subscriber {
 public:
-    TcpConnection(int fd, const sockaddr_in& client_addr, std::shared_ptr<SessionManager> session_manager);
-    ~TcpConnection();
+    TcpConnection(int fd, const sockaddr_in& client_addr, SessionManager* session_manager,
+                  const TcpSettings* settings = nullptr);
+    ~TcpConnection() override;
+    
+    TcpConnection(const TcpConnection&) = delete;
+    TcpConnection& operator=(const TcpConnection&) = delete;
     
-    void send(const std::string& message);
+    void send(std::string_view message);
+    // Ответ на строку, пересланную бэкенду, придёт позже: ответы на
+    // следующие строки ждут его, чтобы клиент получил их в порядке запросов.
+    // Возвращает номер, с которым ответ передаётся в complete_reply
+    uint64_t defer_reply();
+    // Каждый отложенный ответ завершается ровно один раз, в том числе ошибкой
+    void complete_reply(uint64_t sequence, std::string_view message);
+    size_t deferred_replies() const { return order_ ? order_->slots.size() : 0; }
+    Delivery deliver(const SharedMessage& message) override;
+    bool owned_by_current_thread() const override {
+        return !settings_->post_delivery || settings_->owner_thread == std::this_thread::get_id();
+    }
+    void post_delivery(const SharedMessage& message) override { settings_->post_delivery(fd_, id_, message); }
     void close();
     void handle_read();
+    void handle_write();
+    // EPOLLERR: отметки отправки из очереди ошибок (socket_timestamps=rx_tx)
+    void handle_error_queue();
     int get_fd() const { return fd_; }
+    // Уникален за время жизни процесса, в отличие от переиспользуемого fd
+    uint64_t get_id() const { return id_; }
+    int get_session_slot() const { return session_slot_; }
     std::string get_client_info() const;
+    const sockaddr_in& get_client_addr() const { return client_addr_; }
+    bool has_pending_input() const { return pending_ != nullptr; }
+    size_t queued_messages() const { return output_ ? output_->messages.size() : 0; }
+
+private:
+    static const size_t MAX_LINE_LENGTH = 64 * 1024;
+    // Клиент, не читающий собственные ответы, отключается
+    static const size_t MAX_QUEUED_MESSAGES = 64 * 1024;
+    static const size_t IOV_BATCH = 64;
     
-    void set_message_callback(std::function<void(const std::string&)> callback) {
-        message_callback_ = std::move(callback);
-    }
+    // Сообщения ссылаются на общие буферы /publish; offset - сколько байт
+    // первого уже ушло в сокет
+    struct OutputQueue {
+        std::deque<SharedMessage> messages;
+        size_t offset = 0;
+        size_t bytes = 0;  // не отправлено, учтено в SessionManager::record_queued
+        // Ответ запроса из выборки ждёт в очереди: sample_bytes - сколько
+        // осталось отправить до его последнего байта
+        RequestSample sample;
+        size_t sample_bytes = 0;
+    };
+    
+    // Ответы за ещё не пришедшим ответом бэкенда; front() всегда не готов
+    struct ReplyOrder {
+        struct Slot {
+            bool ready = false;
+            std::string data;
+        };
+        std::deque<Slot> slots;
+        uint64_t first = 0;  // номер slots.front()
+    };
     
-    void set_close_callback(std::function<void()> callback) {
-        close_callback_ = std::move(callback);
+    // received_ns - отметка чтения для выборки, 0 - без трассировки
+    size_t dispatch_lines(const char* data, size_t size, uint64_t received_ns);
+    void release_pending();
+    void write_reply(std::string_view message);
+    // Отправляет готовые ответы из начала ReplyOrder
+    void release_replies();
+    size_t write_now(const char* data, size_t size);
+    void enqueue(SharedMessage message, size_t offset);
+    void push_queued(SharedMessage message);
+    // Ответ запроса из выборки отдан в send(): записан целиком или ждёт в очереди
+    void finish_sample(RequestSample* sample);
+    // send_ns - время перед вызовом send(), 0 без отметок отправки
+    void record_sent(size_t bytes, uint64_t send_ns);
+    uint64_t tx_clock() const {
+        return settings_->timestamps == SocketTimestamps::RxTx ? realtime_ns() : 0;
     }
-
-private:
-    static const size_t BUFFER_SIZE = 1024;
     
     int fd_;
+    uint64_t id_;
+    int session_slot_ = SessionTable::INVALID_SLOT;
     sockaddr_in client_addr_;
-    std::shared_ptr<SessionManager> session_manager_;
-    std::function<void(const std::string&)> message_callback_;
-    std::function<void()> close_callback_;
+    SessionManager* session_manager_;
+    const TcpSettings* settings_;
+    BufferPool::Buffer pending_;  // хвост незавершённой строки, nullptr в простое
+    std::unique_ptr<OutputQueue> output_;  // nullptr, пока сокет успевает
+    std::unique_ptr<ReplyOrder> order_;    // nullptr без отложенных ответов
+    // Отметка отправки сопоставляется только с последним send(): под
+    // нагрузкой это выборка, зато без очереди на соединение
+    uint32_t tx_bytes_ = 0;
+    uint32_t tx_key_ = 0;
+    uint64_t tx_sent_ns_ = 0;
 };
\ No newline at end of file
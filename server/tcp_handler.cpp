@@ -8,8 +8,14 @@ TcpHandler::~TcpHandler() {
     stop();
 }
 
-bool TcpHandler::start() {
-    socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+bool TcpHandler::start(int inherited_fd) {
+    if (inherited_fd != -1) {
+        socket_fd_ = inherited_fd;
+        int flags = fcntl(socket_fd_, F_GETFL, 0);
+        return flags != -1 && fcntl(socket_fd_, F_SETFL, flags | O_NONBLOCK) != -1;
+    }
+    
+    socket_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (socket_fd_ == -1) return false;
     
     int opt = 1;
@@ -43,29 +49,108 @@ bool TcpHandler::start() {
 }
 
 void TcpHandler::stop() {
+    stop_listening();
+    
+    // close() вызывает колбэки, которые удаляют соединение из connections_,
+    // поэтому закрываем уже вынутые из таблицы соединения
+    auto connections = std::move(connections_);
+    connections_.clear();
+    connection_count_ = 0;
+    for (auto& connection : connections) {
+        if (connection) {
+            connection->close();
+        }
+    }
+    closed_.clear();
+}
+
+void TcpHandler::stop_listening() {
     if (socket_fd_ != -1) {
         close(socket_fd_);
         socket_fd_ = -1;
     }
-    connections_.clear();
 }
 
 void TcpHandler::handle_accept() {
     sockaddr_in client_addr{};
     socklen_t client_len = sizeof(client_addr);
-    int client_fd = accept(socket_fd_, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
+    int client_fd = accept4(socket_fd_, reinterpret_cast<sockaddr*>(&client_addr), &client_len, SOCK_CLOEXEC);
     
     if (client_fd != -1) {
+        SERVER_TRACE(accept, TraceType::Accept, client_fd, 0);
+        size_t max_connections = max_connections_.load(std::memory_order_relaxed);
+        if (max_connections != 0 && session_manager_ &&
+            session_manager_->get_stats().current_connections >= max_connections) {
+            // Принимаем и сразу закрываем, чтобы не копить очередь listen
+            ::close(client_fd);
+            rejected_connections_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        
         int flags = fcntl(client_fd, F_GETFL, 0);
         if (flags != -1) {
             fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
         }
         
-        auto connection = std::make_shared<TcpConnection>(client_fd, client_addr, session_manager_);
-        connections_[client_fd] = connection;
+        if (handoff_) {
+            if (!handoff_(client_fd, client_addr)) {
+                ::close(client_fd);
+                rejected_connections_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        adopt(client_fd, client_addr);
+    }
+}
+
+void TcpHandler::adopt(int client_fd, const sockaddr_in& client_addr) {
+    if (static_cast<size_t>(client_fd) >= connections_.size()) {
+        connections_.resize(static_cast<size_t>(client_fd) + 1);
+    }
+    if (settings_.timestamps != SocketTimestamps::Off) {
+        enable_timestamping(client_fd, settings_.timestamps);
+    }
+    auto& connection = connections_[client_fd];
+    connection = std::make_unique<TcpConnection>(client_fd, client_addr, session_manager_.get(), &settings_);
+    ++connection_count_;
+    
+    if (connection_callback_) {
+        connection_callback_(*connection);
+    }
+}
+
+void TcpHandler::remove_connection(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= connections_.size() || !connections_[fd]) {
+        return;
+    }
+    closed_.push_back(std::move(connections_[fd]));
+    --connection_count_;
+}
+
+size_t TcpHandler::close_idle_connections(std::chrono::nanoseconds timeout) {
+    if (!session_manager_ || timeout.count() <= 0) {
+        return 0;
+    }
+    
+    const SessionTable& sessions = session_manager_->sessions();
+    uint64_t now = SessionTable::now_ns();
+    size_t closed = 0;
+    
+    // close() переносит соединение в closed_, индексы таблицы не сдвигаются
+    for (size_t fd = 0; fd < connections_.size(); ++fd) {
+        TcpConnection* connection = connections_[fd].get();
+        if (!connection) {
+            continue;
+        }
         
-        if (connection_callback_) {
-            connection_callback_(connection);
+        int slot = connection->get_session_slot();
+        if (slot == SessionTable::INVALID_SLOT) {
+            continue;
+        }
+        if (now - sessions.last_activity_ns(slot) > static_cast<uint64_t>(timeout.count())) {
+            connection->close();
+            ++closed;
         }
     }
+    return closed;
 }
\ No newline at end of file
@@ -1,10 +1,10 @@
 #pragma once
 
-#pragma once
-
 #include "tcp_connection.hpp"
+#include <atomic>
+#include <chrono>
 #include <memory>
-#include <unordered_map>
+#include <vector>
 #include <functional>
 #include <arpa/inet.h>
 
@@ -20,19 +20,73 @@ public:
     TcpHandler(uint16_t port, std::shared_ptr<SessionManager> session_manager);
     ~TcpHandler();
     
-    bool start();
+    // inherited_fd - слушающий сокет, полученный от предыдущего процесса
+    bool start(int inherited_fd = -1);
     void stop();
+    void stop_listening();
     void handle_accept();
+    // Соединение, принятое другим потоком (акцептором), в таблицу этого обработчика
+    void adopt(int client_fd, const sockaddr_in& client_addr);
     int get_socket_fd() const { return socket_fd_; }
     
-    void set_connection_callback(std::function<void(std::shared_ptr<TcpConnection>)> callback) {
+    // Закрытое соединение доживает до release_closed(): remove_connection
+    // обычно вызывается из его же handle_read
+    void remove_connection(int fd);
+    void release_closed() { closed_.clear(); }
+    size_t connection_count() const { return connection_count_; }
+    TcpConnection* find_connection(int fd) const {
+        return fd >= 0 && static_cast<size_t>(fd) < connections_.size() ? connections_[fd].get() : nullptr;
+    }
+    size_t close_idle_connections(std::chrono::nanoseconds timeout);
+    
+    void set_max_connections(size_t max_connections) {
+        max_connections_.store(max_connections, std::memory_order_relaxed);
+    }
+    size_t rejected_connections() const { return rejected_connections_.load(std::memory_order_relaxed); }
+    void set_buffer_size(size_t buffer_size) { settings_.buffer_size = buffer_size; }
+    // Действует на соединения, принятые после вызова
+    void set_timestamps(SocketTimestamps mode) { settings_.timestamps = mode; }
+    void set_sample_rate(uint32_t rate) { settings_.sample_rate = rate; }
+    void set_subscriber_policy(SlowSubscriberPolicy policy, size_t queue_limit) {
+        settings_.subscriber_policy = policy;
+        settings_.subscriber_queue_limit = queue_limit;
+    }
+    
+    void set_connection_callback(std::function<void(TcpConnection&)> callback) {
         connection_callback_ = std::move(callback);
     }
+    void set_message_handler(std::function<void(TcpConnection&, std::string_view)> handler) {
+        settings_.on_message = std::move(handler);
+    }
+    void set_close_handler(std::function<void(int)> handler) {
+        settings_.on_close = std::move(handler);
+    }
+    void set_want_write_handler(std::function<void(int, bool)> handler) {
+        settings_.on_want_write = std::move(handler);
+    }
+    // Режим акцептора: принятый fd отдаётся рабочему реактору вместо
+    // создания соединения здесь; false - отдать некому, fd закрывается
+    void set_handoff(std::function<bool(int, const sockaddr_in&)> handoff) {
+        handoff_ = std::move(handoff);
+    }
+    void set_owner(std::thread::id thread,
+                   std::function<void(int, uint64_t, const SharedMessage&)> post_delivery) {
+        settings_.owner_thread = thread;
+        settings_.post_delivery = std::move(post_delivery);
+    }
 
 private:
     uint16_t port_;
     int socket_fd_;
     std::shared_ptr<SessionManager> session_manager_;
-    std::unordered_map<int, std::shared_ptr<TcpConnection>> connections_;
-    std::function<void(std::shared_ptr<TcpConnection>)> connection_callback_;
+    TcpSettings settings_;
+    // Акцептор читает и пишет из своего потока, перезагрузка и метрики - из основного
+    std::atomic<size_t> max_connections_{0};
+    std::atomic<size_t> rejected_connections_{0};
+    // Индекс - fd: без узлов хеш-таблицы и счётчиков ссылок на соединение
+    std::vector<std::unique_ptr<TcpConnection>> connections_;
+    size_t connection_count_ = 0;
+    std::vector<std::unique_ptr<TcpConnection>> closed_;
+    std::function<void(TcpConnection&)> connection_callback_;
+    std::function<bool(int, const sockaddr_in&)> handoff_;
 };
\ No newline at end of file
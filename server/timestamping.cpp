@@ -0,0 +1,102 @@
+#include "timestamping.hpp"
+
+#include <cerrno>
+#include <ctime>
+#include <sys/socket.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+
+namespace {
+
+uint64_t to_ns(const timespec& ts) {
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// ts[0] - программная отметка, ts[2] - аппаратная (не запрашивается)
+uint64_t software_timestamp(const cmsghdr* cmsg) {
+    const auto* stamps = reinterpret_cast<const scm_timestamping*>(CMSG_DATA(cmsg));
+    return to_ns(stamps->ts[0]);
+}
+
+} // namespace
+
+const char* socket_timestamps_name(SocketTimestamps mode) {
+    switch (mode) {
+        case SocketTimestamps::Off: return "off";
+        case SocketTimestamps::Rx: return "rx";
+        case SocketTimestamps::RxTx: return "rx_tx";
+    }
+    return "unknown";
+}
+
+bool enable_timestamping(int fd, SocketTimestamps mode) {
+    unsigned flags = 0;
+    if (mode != SocketTimestamps::Off) {
+        flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    }
+    if (mode == SocketTimestamps::RxTx) {
+        // Без копии пакета в очереди ошибок: нужен только ключ и время
+        flags |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    }
+    return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+}
+
+uint64_t realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return to_ns(ts);
+}
+
+ssize_t recv_timestamped(int fd, char* buffer, size_t size, sockaddr_in* from, uint64_t& kernel_ns) {
+    iovec iov{buffer, size};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(scm_timestamping))];
+    msghdr msg{};
+    msg.msg_name = from;
+    msg.msg_namelen = from ? sizeof(*from) : 0;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received = recvmsg(fd, &msg, 0);
+    kernel_ns = 0;
+    if (received <= 0) {
+        return received;
+    }
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            kernel_ns = software_timestamp(cmsg);
+        }
+    }
+    return received;
+}
+
+size_t read_tx_timestamps(int fd, const std::function<void(uint32_t, uint64_t)>& on_tx) {
+    size_t count = 0;
+    for (;;) {
+        alignas(cmsghdr) char control[256];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+        ++count;
+
+        uint64_t sent_ns = 0;
+        const sock_extended_err* error = nullptr;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                sent_ns = software_timestamp(cmsg);
+            } else if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                       (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+                error = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cmsg));
+            }
+        }
+        if (sent_ns != 0 && error && error->ee_errno == ENOMSG &&
+            error->ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+            on_tx(error->ee_data, sent_ns);
+        }
+    }
+    return count;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <sys/types.h>
+#include <netinet/in.h>
+
+#include "metrics.hpp"
+
+// Программные отметки времени ядра (SO_TIMESTAMPING)
+enum class SocketTimestamps {
+    Off,
+    Rx,    // момент, когда ядро приняло пакет
+    RxTx,  // и момент, когда отправленные данные ушли в драйвер
+};
+
+const char* socket_timestamps_name(SocketTimestamps mode);
+
+// Off выключает отметки на сокете. Для TCP ключ отметки отправки (OPT_ID) -
+// смещение последнего байта от момента включения, для UDP - номер датаграммы.
+bool enable_timestamping(int fd, SocketTimestamps mode);
+
+// Часы отметок ядра
+uint64_t realtime_ns();
+
+// recvmsg с отметкой приёма; kernel_ns = 0, если ядро её не приложило
+ssize_t recv_timestamped(int fd, char* buffer, size_t size, sockaddr_in* from, uint64_t& kernel_ns);
+
+// Разбирает очередь ошибок сокета: on_tx(ключ, время ухода в драйвер) для
+// каждой отметки отправки. Возвращает число прочитанных сообщений.
+size_t read_tx_timestamps(int fd, const std::function<void(uint32_t, uint64_t)>& on_tx);
+
+// Где запрос провёл время; индекс - Protocol (0 - TCP, 1 - UDP)
+struct PacketLatency {
+    std::array<LatencyHistogram, 2> socket_queue;  // ядро приняло -> сервер прочитал
+    std::array<LatencyHistogram, 2> processing;    // прочитал -> ответы отданы ядру
+    std::array<LatencyHistogram, 2> tx;            // send() -> данные ушли в драйвер
+};
@@ -0,0 +1,148 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <unistd.h>
+
+thread_local TraceRing* TraceRing::current_ = nullptr;
+
+const char* trace_type_name(TraceType type) {
+    switch (type) {
+        case TraceType::Accept: return "accept";
+        case TraceType::Read: return "read";
+        case TraceType::Dispatch: return "dispatch";
+        case TraceType::Send: return "send";
+        case TraceType::Close: return "close";
+        case TraceType::UdpRead: return "udp_read";
+        case TraceType::UdpSend: return "udp_send";
+        case TraceType::Loop: return "loop";
+    }
+    return "unknown";
+}
+
+TraceRing::TraceRing(size_t capacity) {
+    reset(capacity);
+}
+
+void TraceRing::reset(size_t capacity) {
+    base_tsc_ = trace_clock();
+    base_ns_ = monotonic_ns();
+    head_.store(0, std::memory_order_relaxed);
+    if (capacity == 0) {
+        slots_.reset();
+        mask_ = SIZE_MAX;
+        return;
+    }
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    slots_ = std::make_unique<Slot[]>(size);
+    mask_ = size - 1;
+}
+
+std::vector<TraceEvent> TraceRing::snapshot() const {
+    std::vector<TraceEvent> events;
+    if (!enabled()) {
+        return events;
+    }
+
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t size = mask_ + 1;
+    uint64_t first = head > size ? head - size : 0;
+    events.reserve(head - first);
+    for (uint64_t i = first; i < head; ++i) {
+        const Slot& slot = slots_[i & mask_];
+        uint64_t kind = slot.words[2].load(std::memory_order_relaxed);
+        events.push_back(TraceEvent{
+            slot.words[0].load(std::memory_order_relaxed),
+            slot.words[1].load(std::memory_order_relaxed),
+            static_cast<TraceType>(kind >> 32),
+            static_cast<int32_t>(static_cast<uint32_t>(kind)),
+            static_cast<uint32_t>(slot.words[3].load(std::memory_order_relaxed)),
+        });
+    }
+
+    // Писатель мог уйти вперёд и затереть начало скопированного окна
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = head_.load(std::memory_order_relaxed);
+    uint64_t valid = after + 1 > size ? after + 1 - size : 0;
+    if (valid > first) {
+        events.erase(events.begin(), events.begin() + static_cast<ptrdiff_t>(std::min(valid - first, head - first)));
+    }
+    return events;
+}
+
+double TraceRing::ticks_per_ns() const {
+    uint64_t elapsed_ns = monotonic_ns() - base_ns_;
+    uint64_t elapsed_ticks = trace_clock() - base_tsc_;
+    // На коротком интервале калибровка неточна
+    if (elapsed_ns < 1000000 || elapsed_ticks == 0) {
+        return 1.0;
+    }
+    return static_cast<double>(elapsed_ticks) / static_cast<double>(elapsed_ns);
+}
+
+uint64_t TraceRing::to_ns(uint64_t tsc, double ticks_per_ns) const {
+    double offset = static_cast<double>(static_cast<int64_t>(tsc - base_tsc_)) / ticks_per_ns;
+    return base_ns_ + static_cast<uint64_t>(std::max(offset, -static_cast<double>(base_ns_)));
+}
+
+size_t write_chrome_trace(std::ostream& out, const std::vector<const TraceRing*>& rings, int pid) {
+    size_t written = 0;
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    const char* separator = "\n";
+    out << std::fixed << std::setprecision(3);
+
+    for (size_t tid = 0; tid < rings.size(); ++tid) {
+        const TraceRing& ring = *rings[tid];
+        out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+            << ",\"args\":{\"name\":\"reactor-" << tid << "\"}}";
+        separator = ",\n";
+
+        double ticks_per_ns = ring.ticks_per_ns();
+        for (const TraceEvent& event : ring.snapshot()) {
+            double ts_us = static_cast<double>(ring.to_ns(event.tsc, ticks_per_ns)) / 1000.0;
+            out << separator << "{\"name\":\"" << trace_type_name(event.type) << "\",\"pid\":" << pid
+                << ",\"tid\":" << tid << ",\"ts\":" << ts_us;
+            if (event.duration != 0) {
+                out << ",\"ph\":\"X\",\"dur\":" << static_cast<double>(event.duration) / ticks_per_ns / 1000.0;
+            } else {
+                out << ",\"ph\":\"i\",\"s\":\"t\"";
+            }
+            if (event.type == TraceType::Loop) {
+                out << ",\"args\":{\"events\":" << event.bytes << "}}";
+            } else {
+                out << ",\"args\":{\"fd\":" << event.fd << ",\"bytes\":" << event.bytes << "}}";
+            }
+            ++written;
+        }
+    }
+    out << "\n]}\n";
+    return written;
+}
+
+bool write_chrome_trace_file(const std::string& path, const std::vector<const TraceRing*>& rings,
+                             size_t& events, std::string& error) {
+    // Пишем во временный файл и переименовываем: читатель не увидит половину
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        if (!out) {
+            error = "cannot open " + temp;
+            return false;
+        }
+        events = write_chrome_trace(out, rings, static_cast<int>(getpid()));
+        if (!out) {
+            error = "write failed: " + temp;
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        error = "cannot rename " + temp + " to " + path;
+        return false;
+    }
+    return true;
+}
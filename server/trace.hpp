@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "metrics.hpp"
+
+// USDT-пробы для SystemTap/bpftrace: provider async_server, имена совпадают
+// с типами событий трассировки. Без <sys/sdt.h> пробы компилируются в пустоту.
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SERVER_HAVE_USDT 1
+#endif
+#endif
+
+#ifdef SERVER_HAVE_USDT
+#define SERVER_PROBE(name, ...) STAP_PROBEV(async_server, name, ##__VA_ARGS__)
+#else
+#define SERVER_PROBE(name, ...) do {} while (0)
+#endif
+
+enum class TraceType : uint8_t {
+    Accept,
+    Read,
+    Dispatch,
+    Send,
+    Close,
+    UdpRead,
+    UdpSend,
+    Loop,
+};
+
+const char* trace_type_name(TraceType type);
+
+// Счётчик TSC там, где он есть, иначе монотонные наносекунды
+inline uint64_t trace_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return monotonic_ns();
+#endif
+}
+
+struct TraceEvent {
+    uint64_t tsc;
+    uint64_t duration;  // в тиках trace_clock, 0 - мгновенное событие
+    TraceType type;
+    int32_t fd;
+    uint32_t bytes;     // для Loop - число событий в пачке
+};
+
+// Кольцо последних событий одного реактора. Пишет только поток цикла:
+// слот заполняется relaxed-записями, затем head_ публикуется release,
+// поэтому снимок можно брать из любого потока без блокировок.
+// Ёмкость округляется вверх до степени двойки; 0 - трассировка выключена.
+class TraceRing {
+public:
+    explicit TraceRing(size_t capacity = 0);
+
+    void reset(size_t capacity);
+    bool enabled() const { return mask_ != SIZE_MAX; }
+    size_t capacity() const { return enabled() ? mask_ + 1 : 0; }
+
+    void record(TraceType type, int fd, uint64_t bytes, uint64_t start = 0, uint64_t duration = 0) {
+        if (!enabled()) return;
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[head & mask_];
+        slot.words[0].store(start ? start : trace_clock(), std::memory_order_relaxed);
+        slot.words[1].store(duration, std::memory_order_relaxed);
+        slot.words[2].store(static_cast<uint64_t>(type) << 32 | static_cast<uint32_t>(fd),
+                            std::memory_order_relaxed);
+        slot.words[3].store(bytes, std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // События в порядке записи; перезаписанные во время копирования отбрасываются
+    std::vector<TraceEvent> snapshot() const;
+    uint64_t recorded() const { return head_.load(std::memory_order_acquire); }
+
+    // Перевод тиков trace_clock в наносекунды монотонных часов; частота
+    // калибруется по интервалу с момента reset()
+    double ticks_per_ns() const;
+    uint64_t to_ns(uint64_t tsc, double ticks_per_ns) const;
+
+    // Кольцо реактора, который сейчас выполняется в этом потоке
+    static TraceRing* current() { return current_; }
+    static void set_current(TraceRing* ring) { current_ = ring; }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> words[4];
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = SIZE_MAX;
+    std::atomic<uint64_t> head_{0};
+    uint64_t base_tsc_ = 0;
+    uint64_t base_ns_ = 0;
+
+    static thread_local TraceRing* current_;
+};
+
+// Событие в кольцо текущего реактора плюс USDT-проба с теми же аргументами
+#define SERVER_TRACE(name, type, fd, bytes)                                   \
+    do {                                                                      \
+        SERVER_PROBE(name, (fd), (bytes));                                    \
+        if (TraceRing* trace_ring_ = TraceRing::current()) {                  \
+            trace_ring_->record((type), (fd), (bytes));                       \
+        }                                                                     \
+    } while (0)
+
+// Chrome trace (chrome://tracing, Perfetto): каждое кольцо - отдельный tid.
+// Мгновенные события - "ph":"i", события с длительностью - "ph":"X".
+// Возвращает число записанных событий.
+size_t write_chrome_trace(std::ostream& out, const std::vector<const TraceRing*>& rings, int pid);
+bool write_chrome_trace_file(const std::string& path, const std::vector<const TraceRing*>& rings,
+                             size_t& events, std::string& error);
@@ -1,15 +1,24 @@
 #include "udp_handler.hpp"
 
 
-UdpHandler::UdpHandler(uint16_t port) 
-    : port_(port), socket_fd_(-1) {}
+UdpHandler::UdpHandler(uint16_t port, std::shared_ptr<SessionManager> session_manager) 
+    : port_(port), socket_fd_(-1), session_manager_(session_manager) {}
 
 UdpHandler::~UdpHandler() {
     stop();
 }
 
-bool UdpHandler::start() {
-    socket_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+bool UdpHandler::start(int inherited_fd) {
+    if (inherited_fd != -1) {
+        socket_fd_ = inherited_fd;
+        int flags = fcntl(socket_fd_, F_GETFL, 0);
+        if (timestamps_ != SocketTimestamps::Off) {
+            enable_timestamping(socket_fd_, timestamps_);
+        }
+        return flags != -1 && fcntl(socket_fd_, F_SETFL, flags | O_NONBLOCK) != -1;
+    }
+    
+    socket_fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
     if (socket_fd_ == -1) return false;
     
     sockaddr_in addr{};
@@ -27,10 +36,26 @@ bool UdpHandler::start() {
         close(socket_fd_);
         return false;
     }
+    if (timestamps_ != SocketTimestamps::Off) {
+        enable_timestamping(socket_fd_, timestamps_);
+    }
     
     return true;
 }
 
+void UdpHandler::set_timestamps(SocketTimestamps mode) {
+    if (mode == timestamps_) {
+        return;
+    }
+    // Ядро начинает нумерацию отправок заново, когда OPT_ID включается
+    timestamps_ = mode;
+    tx_count_ = 0;
+    tx_sent_ns_.fill(0);
+    if (socket_fd_ != -1) {
+        enable_timestamping(socket_fd_, mode);
+    }
+}
+
 void UdpHandler::stop() {
     if (socket_fd_ != -1) {
         close(socket_fd_);
@@ -39,27 +64,92 @@ void UdpHandler::stop() {
 }
 
 void UdpHandler::handle_message() {
-    char buffer[1024];
+    char* buffer = recv_buffer_.data();
     sockaddr_in client_addr{};
     socklen_t addr_len = sizeof(client_addr);
+    bool timestamped = timestamps_ != SocketTimestamps::Off && session_manager_;
+    uint64_t kernel_ns = 0;
+    uint64_t read_ns = 0;
     
-    ssize_t bytes_read = recvfrom(socket_fd_, buffer, sizeof(buffer) - 1, 0,
-                                reinterpret_cast<sockaddr*>(&client_addr), &addr_len);
+    ssize_t bytes_read = 0;
+    if (timestamped) {
+        bytes_read = recv_timestamped(socket_fd_, buffer, recv_buffer_.size(), &client_addr, kernel_ns);
+        read_ns = realtime_ns();
+    } else {
+        bytes_read = recvfrom(socket_fd_, buffer, recv_buffer_.size(), 0,
+                              reinterpret_cast<sockaddr*>(&client_addr), &addr_len);
+    }
     
     if (bytes_read > 0) {
-        buffer[bytes_read] = '\0';
-        std::string message(buffer);
-        message.erase(message.find_last_not_of(" \t\n\r\f\v") + 1);
+        SERVER_TRACE(udp_read, TraceType::UdpRead, socket_fd_, static_cast<uint64_t>(bytes_read));
+        uint64_t received_ns = sample_rate_ ? monotonic_ns() : 0;
+        std::string_view message = LineScanner::trim(std::string_view(buffer, static_cast<size_t>(bytes_read)));
+        if (session_manager_) {
+            session_manager_->record_received(Protocol::Udp, static_cast<size_t>(bytes_read), 1);
+        }
         
         if (message_callback_) {
-            message_callback_(message, client_addr);
+            if (received_ns && RequestSample::take(sample_rate_)) {
+                // Датаграмма - готовый кадр: разбор сводится к отрезанию пробелов
+                RequestSample sample{received_ns, monotonic_ns()};
+                RequestSample::set_current(&sample);
+                message_callback_(message, client_addr);
+                RequestSample::set_current(nullptr);
+            } else {
+                message_callback_(message, client_addr);
+            }
+        }
+        if (timestamped) {
+            PacketLatency& latency = session_manager_->packet_latency();
+            uint64_t done_ns = realtime_ns();
+            if (kernel_ns != 0 && read_ns > kernel_ns) {
+                latency.socket_queue[static_cast<size_t>(Protocol::Udp)].observe(read_ns - kernel_ns);
+            }
+            if (done_ns > read_ns) {
+                latency.processing[static_cast<size_t>(Protocol::Udp)].observe(done_ns - read_ns);
+            }
         }
     }
 }
 
-void UdpHandler::send_message(const std::string& message, const sockaddr_in& client_addr) {
+void UdpHandler::send_message(std::string_view message, const sockaddr_in& client_addr) {
     if (socket_fd_ != -1) {
-        sendto(socket_fd_, message.c_str(), message.length(), 0,
-               reinterpret_cast<const sockaddr*>(&client_addr), sizeof(client_addr));
+        RequestSample* sample = RequestSample::current();
+        if (sample && sample->metrics) {
+            sample->queued = monotonic_ns();
+        } else {
+            sample = nullptr;
+        }
+        uint64_t send_ns = timestamps_ == SocketTimestamps::RxTx ? realtime_ns() : 0;
+        ssize_t sent = sendto(socket_fd_, message.data(), message.size(), 0,
+                              reinterpret_cast<const sockaddr*>(&client_addr), sizeof(client_addr));
+        SERVER_TRACE(udp_send, TraceType::UdpSend, socket_fd_, sent > 0 ? static_cast<uint64_t>(sent) : 0);
+        if (sent > 0 && session_manager_) {
+            session_manager_->record_sent(static_cast<size_t>(sent));
+        }
+        if (sent >= 0 && send_ns != 0) {
+            tx_sent_ns_[tx_count_++ % TX_SLOTS] = send_ns;
+        }
+        if (sample && sent >= 0) {
+            sample->record(monotonic_ns());
+            sample->metrics = nullptr;
+        }
     }
+}
+
+void UdpHandler::handle_error_queue() {
+    if (socket_fd_ == -1) {
+        return;
+    }
+    read_tx_timestamps(socket_fd_, [this](uint32_t key, uint64_t sent_ns) {
+        // Ключ старше TX_SLOTS отправок уже перезаписан
+        if (!session_manager_ || tx_count_ - key > TX_SLOTS) {
+            return;
+        }
+        uint64_t& send_ns = tx_sent_ns_[key % TX_SLOTS];
+        if (send_ns != 0 && sent_ns >= send_ns) {
+            session_manager_->packet_latency().tx[static_cast<size_t>(Protocol::Udp)].observe(sent_ns - send_ns);
+        }
+        send_ns = 0;
+    });
 }
\ No newline at end of file
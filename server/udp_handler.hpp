@@ -1,7 +1,15 @@
 #pragma once
 
+#include "line_scanner.hpp"
+#include "request_sampler.hpp"
+#include "session_manager.hpp"
+#include "timestamping.hpp"
+#include "trace.hpp"
+#include <array>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 #include <netinet/in.h>
 #include <arpa/inet.h>  
 #include <sys/socket.h>
@@ -12,21 +20,35 @@
 
 class UdpHandler {
 public:
-    UdpHandler(uint16_t port);
+    UdpHandler(uint16_t port, std::shared_ptr<SessionManager> session_manager = nullptr);
     ~UdpHandler();
     
-    bool start();
+    bool start(int inherited_fd = -1);
     void stop();
     void handle_message();
-    void send_message(const std::string& message, const sockaddr_in& client_addr);
+    // EPOLLERR: отметки отправки из очереди ошибок
+    void handle_error_queue();
+    void send_message(std::string_view message, const sockaddr_in& client_addr);
     int get_socket_fd() const { return socket_fd_; }
+    void set_buffer_size(size_t buffer_size) { recv_buffer_.resize(buffer_size); }
+    void set_timestamps(SocketTimestamps mode);
+    // Каждая N-я датаграмма трассируется по этапам, 0 - выключено
+    void set_sample_rate(uint32_t rate) { sample_rate_ = rate; }
     
-    void set_message_callback(std::function<void(const std::string&, const sockaddr_in&)> callback) {
+    void set_message_callback(std::function<void(std::string_view, const sockaddr_in&)> callback) {
         message_callback_ = std::move(callback);
     }
 
 private:
     uint16_t port_;
     int socket_fd_;
-    std::function<void(const std::string&, const sockaddr_in&)> message_callback_;
+    std::shared_ptr<SessionManager> session_manager_;
+    std::vector<char> recv_buffer_ = std::vector<char>(1024);
+    std::function<void(std::string_view, const sockaddr_in&)> message_callback_;
+    SocketTimestamps timestamps_ = SocketTimestamps::Off;
+    uint32_t sample_rate_ = 0;
+    // Время send() по ключу OPT_ID (номеру датаграммы) для последних отправок
+    static constexpr size_t TX_SLOTS = 256;
+    std::array<uint64_t, TX_SLOTS> tx_sent_ns_{};
+    uint32_t tx_count_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "upgrade.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+constexpr int CHANNEL_FD = 3;
+constexpr char READY_BYTE = 'R';
+
+// Порядок сокетов в сообщении задаётся тегами в полезной нагрузке
+constexpr char TAG_TCP = 'T';
+constexpr char TAG_UDP = 'U';
+constexpr char TAG_ADMIN = 'A';
+constexpr size_t MAX_FDS = 3;
+
+std::string errno_text(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+UpgradeChannel::~UpgradeChannel() {
+    close();
+}
+
+bool UpgradeChannel::spawn(const std::vector<std::string>& argv, const ListenSockets& sockets,
+                           std::string& error) {
+    close();
+
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) == -1) {
+        error = errno_text("socketpair");
+        return false;
+    }
+
+    // Всё, что нужно дочернему процессу, готовится до fork: после него
+    // допустимы только async-signal-safe вызовы
+    std::vector<char*> child_argv;
+    for (const auto& arg : argv) {
+        child_argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    child_argv.push_back(nullptr);
+
+    std::string channel_env = std::string(ENV_NAME) + "=" + std::to_string(CHANNEL_FD);
+    std::vector<char*> child_env;
+    for (char** env = environ; *env != nullptr; ++env) {
+        if (std::strncmp(*env, ENV_NAME, std::strlen(ENV_NAME)) != 0) {
+            child_env.push_back(*env);
+        }
+    }
+    child_env.push_back(channel_env.data());
+    child_env.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        error = errno_text("fork");
+        ::close(pair[0]);
+        ::close(pair[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        // Маска сигналов наследуется через exec, а signalfd-режим её блокирует
+        sigset_t empty;
+        sigemptyset(&empty);
+        sigprocmask(SIG_SETMASK, &empty, nullptr);
+
+        // Клиентские соединения старого процесса не должны утечь в новый,
+        // иначе их закрытие не дойдёт до клиента
+        if (dup2(pair[1], CHANNEL_FD) == -1) _exit(127);
+        close_range(CHANNEL_FD + 1, ~0U, 0);
+        execve(child_argv[0], child_argv.data(), child_env.data());
+        _exit(127);
+    }
+
+    ::close(pair[1]);
+    fd_ = pair[0];
+    child_pid_ = pid;
+
+    char tags[MAX_FDS];
+    int fds[MAX_FDS];
+    size_t count = 0;
+    if (sockets.tcp_fd != -1) { tags[count] = TAG_TCP; fds[count++] = sockets.tcp_fd; }
+    if (sockets.udp_fd != -1) { tags[count] = TAG_UDP; fds[count++] = sockets.udp_fd; }
+    if (sockets.admin_fd != -1) { tags[count] = TAG_ADMIN; fds[count++] = sockets.admin_fd; }
+
+    iovec iov{tags, count};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+
+    if (sendmsg(fd_, &msg, MSG_NOSIGNAL) == -1) {
+        error = errno_text("sendmsg");
+        failed_children_.push_back(child_pid_);
+        close();
+        return false;
+    }
+
+    int flags = fcntl(fd_, F_GETFL, 0);
+    fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+    return true;
+}
+
+UpgradeChannel::Status UpgradeChannel::handle_read() {
+    char byte = 0;
+    ssize_t n = recv(fd_, &byte, 1, 0);
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return Status::Pending;
+    }
+
+    Status status = n == 1 && byte == READY_BYTE ? Status::Ready : Status::Failed;
+    if (status == Status::Failed && child_pid_ > 0) {
+        failed_children_.push_back(child_pid_);
+        reap_failed();
+    }
+    close();
+    return status;
+}
+
+void UpgradeChannel::reap_failed() {
+    for (size_t i = 0; i < failed_children_.size();) {
+        pid_t result = waitpid(failed_children_[i], nullptr, WNOHANG);
+        if (result == 0 || (result == -1 && errno == EINTR)) {
+            ++i;
+            continue;
+        }
+        failed_children_[i] = failed_children_.back();
+        failed_children_.pop_back();
+    }
+}
+
+void UpgradeChannel::abort() {
+    if (fd_ != -1 && child_pid_ > 0) {
+        kill(child_pid_, SIGKILL);
+        failed_children_.push_back(child_pid_);
+        reap_failed();
+    }
+    close();
+}
+
+bool UpgradeChannel::requested() {
+    return std::getenv(ENV_NAME) != nullptr;
+}
+
+bool UpgradeChannel::inherit(ListenSockets& sockets, std::string& error) {
+    const char* value = std::getenv(ENV_NAME);
+    if (value == nullptr) {
+        error = std::string(ENV_NAME) + " is not set";
+        return false;
+    }
+    fd_ = std::atoi(value);
+    unsetenv(ENV_NAME);
+    fcntl(fd_, F_SETFD, FD_CLOEXEC);
+
+    char tags[MAX_FDS] = {};
+    iovec iov{tags, sizeof(tags)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(fd_, &msg, MSG_CMSG_CLOEXEC);
+    } while (n == -1 && errno == EINTR);
+    if (n <= 0) {
+        error = n == 0 ? "upgrade channel closed" : errno_text("recvmsg");
+        close();
+        return false;
+    }
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        error = "upgrade message carries no descriptors";
+        close();
+        return false;
+    }
+
+    int fds[MAX_FDS];
+    size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    std::memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * count);
+    for (size_t i = 0; i < count && i < static_cast<size_t>(n); ++i) {
+        switch (tags[i]) {
+            case TAG_TCP: sockets.tcp_fd = fds[i]; break;
+            case TAG_UDP: sockets.udp_fd = fds[i]; break;
+            case TAG_ADMIN: sockets.admin_fd = fds[i]; break;
+            default: ::close(fds[i]); break;
+        }
+    }
+    return true;
+}
+
+void UpgradeChannel::notify_ready() {
+    if (fd_ == -1) {
+        return;
+    }
+    ssize_t ignored = send(fd_, &READY_BYTE, 1, MSG_NOSIGNAL);
+    (void)ignored;
+    close();
+}
+
+void UpgradeChannel::close() {
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void notify_service_manager(std::string_view state) {
+    const char* path = std::getenv("NOTIFY_SOCKET");
+    if (path == nullptr || (path[0] != '/' && path[0] != '@')) {
+        return;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    size_t length = std::strlen(path);
+    if (length >= sizeof(addr.sun_path)) {
+        return;
+    }
+    std::memcpy(addr.sun_path, path, length);
+    if (addr.sun_path[0] == '@') {
+        addr.sun_path[0] = '\0';  // абстрактное пространство имён
+    }
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return;
+    }
+    sendto(fd, state.data(), state.size(), MSG_NOSIGNAL, reinterpret_cast<sockaddr*>(&addr),
+           static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + length));
+    ::close(fd);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+
+// Слушающие сокеты, которые переживают обновление бинарника
+struct ListenSockets {
+    int tcp_fd = -1;
+    int udp_fd = -1;
+    int admin_fd = -1;
+};
+
+// Обновление без простоя: старый процесс запускает новый бинарник и
+// передаёт ему слушающие сокеты через SCM_RIGHTS по socketpair. Новый
+// процесс, начав обслуживать их, отвечает одним байтом готовности;
+// до этого старый продолжает принимать соединения. EOF без готовности
+// означает, что новый процесс не поднялся.
+class UpgradeChannel {
+public:
+    static constexpr const char* ENV_NAME = "UPGRADE_CHANNEL_FD";
+
+    enum class Status { Pending, Ready, Failed };
+
+    UpgradeChannel() = default;
+    ~UpgradeChannel();
+
+    UpgradeChannel(const UpgradeChannel&) = delete;
+    UpgradeChannel& operator=(const UpgradeChannel&) = delete;
+
+    // Старый процесс: fork + exec argv с каналом на fd 3, затем отправка сокетов
+    bool spawn(const std::vector<std::string>& argv, const ListenSockets& sockets, std::string& error);
+    Status handle_read();
+    pid_t child_pid() const { return child_pid_; }
+    // Не поднявшийся процесс закрывает канал раньше, чем становится зомби:
+    // его статус забирается повторными вызовами из цикла событий
+    void reap_failed();
+    // Процесс, не ответивший вовремя: SIGKILL, канал закрывается
+    void abort();
+
+    // Новый процесс: true, если он запущен через spawn
+    static bool requested();
+    bool inherit(ListenSockets& sockets, std::string& error);
+    void notify_ready();
+
+    int get_fd() const { return fd_; }
+    void close();
+
+private:
+    int fd_ = -1;
+    pid_t child_pid_ = -1;
+    std::vector<pid_t> failed_children_;
+};
+
+// sd_notify без libsystemd: пишет состояние в NOTIFY_SOCKET, если он задан
+void notify_service_manager(std::string_view state);
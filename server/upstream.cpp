@@ -0,0 +1,371 @@
+#include "upstream.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+namespace {
+
+constexpr size_t MAX_RESPONSE_LENGTH = 64 * 1024;
+
+uint64_t now_ns() {
+    return monotonic_ns();
+}
+
+} // namespace
+
+UpstreamPool::UpstreamPool(EventLoop& loop, Options options, ResponseHandler handler)
+    : loop_(loop)
+    , options_(std::move(options))
+    , handler_(std::move(handler)) {
+    if (options_.connections_per_upstream == 0) {
+        options_.connections_per_upstream = 1;
+    }
+}
+
+UpstreamPool::~UpstreamPool() {
+    stop();
+}
+
+bool UpstreamPool::parse_address(const std::string& address, sockaddr_in& addr) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        return false;
+    }
+    std::string host = address.substr(0, colon);
+    if (host == "localhost") {
+        host = "127.0.0.1";
+    }
+    int port = 0;
+    try {
+        size_t used = 0;
+        port = std::stoi(address.substr(colon + 1), &used);
+        if (used != address.size() - colon - 1) return false;
+    } catch (const std::exception&) {
+        return false;
+    }
+    addr = sockaddr_in{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    return port > 0 && port <= 65535 && inet_pton(AF_INET, host.c_str(), &addr.sin_addr) == 1;
+}
+
+bool UpstreamPool::add_upstream(const std::string& address) {
+    auto upstream = std::make_unique<Upstream>();
+    if (!parse_address(address, upstream->addr)) {
+        return false;
+    }
+    upstream->name = address;
+    for (size_t i = 0; i < options_.connections_per_upstream; ++i) {
+        upstream->connections.push_back(std::make_unique<Connection>());
+        upstream->connections.back()->upstream = upstream.get();
+    }
+    upstreams_.push_back(std::move(upstream));
+    return true;
+}
+
+void UpstreamPool::start() {
+    last_health_check_ = std::chrono::steady_clock::now();
+    for (auto& upstream : upstreams_) {
+        probe(*upstream);
+    }
+}
+
+void UpstreamPool::stop() {
+    for (auto& upstream : upstreams_) {
+        for (auto& connection : upstream->connections) {
+            if (connection->fd != -1) {
+                fail(*connection, "ERROR: Server shutting down");
+            }
+        }
+        upstream->healthy = false;
+    }
+}
+
+UpstreamPool::Result UpstreamPool::forward(std::string_view line, const ResponseTarget& target) {
+    Upstream* best = nullptr;
+    bool any_healthy = false;
+    for (size_t i = 0; i < upstreams_.size(); ++i) {
+        Upstream& upstream = *upstreams_[(next_ + i) % upstreams_.size()];
+        if (!upstream.healthy) {
+            continue;
+        }
+        any_healthy = true;
+        if (upstream.outstanding < options_.max_pending &&
+            (!best || upstream.outstanding < best->outstanding)) {
+            best = &upstream;
+        }
+    }
+    if (!best) {
+        return any_healthy ? Result::Busy : Result::NoUpstream;
+    }
+    // При равной загрузке бэкенды чередуются
+    next_ = next_ + 1 < upstreams_.size() ? next_ + 1 : 0;
+
+    Connection* chosen = nullptr;
+    for (auto& connection : best->connections) {
+        if (connection->fd == -1) {
+            continue;
+        }
+        if (!chosen || connection->pending.size() < chosen->pending.size()) {
+            chosen = connection.get();
+        }
+    }
+    if (!chosen) {
+        chosen = best->connections.front().get();
+        if (!connect(*chosen)) {
+            return Result::NoUpstream;
+        }
+    }
+    send(*chosen, line, target);
+    ++best->requests;
+    return Result::Ok;
+}
+
+void UpstreamPool::poll() {
+    // Запросы, накопленные за итерацию, уходят одним send на соединение
+    for (Connection* connection : dirty_) {
+        if (connection->fd != -1 && connection->connected) {
+            flush(*connection);
+        }
+    }
+    dirty_.clear();
+
+    uint64_t now = now_ns();
+    uint64_t timeout = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(options_.timeout).count());
+    for (auto& upstream : upstreams_) {
+        for (auto& connection : upstream->connections) {
+            if (connection->fd == -1) {
+                continue;
+            }
+            if (!connection->connected && now - connection->connect_start_ns > timeout) {
+                fail(*connection, "ERROR: Upstream connect timeout");
+            } else if (!connection->pending.empty() && now - connection->pending.front().start_ns > timeout) {
+                fail(*connection, "ERROR: Upstream timeout");
+            }
+        }
+    }
+
+    auto steady = std::chrono::steady_clock::now();
+    if (steady - last_health_check_ >= options_.health_interval) {
+        last_health_check_ = steady;
+        for (auto& upstream : upstreams_) {
+            if (!upstream->healthy && !upstream->probing) {
+                probe(*upstream);
+            }
+        }
+    }
+}
+
+std::vector<UpstreamStats> UpstreamPool::stats() const {
+    std::vector<UpstreamStats> result;
+    for (const auto& upstream : upstreams_) {
+        size_t connections = 0;
+        for (const auto& connection : upstream->connections) {
+            connections += connection->connected ? 1 : 0;
+        }
+        result.push_back(UpstreamStats{upstream->name, upstream->healthy, connections,
+                                       upstream->outstanding, upstream->requests, upstream->failures});
+    }
+    return result;
+}
+
+bool UpstreamPool::connect(Connection& connection) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    const sockaddr_in& addr = connection.upstream->addr;
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1 && errno != EINPROGRESS) {
+        ::close(fd);
+        return false;
+    }
+
+    Connection* conn = &connection;
+    if (!loop_.add_fd(fd, EPOLLIN | EPOLLOUT, [this, conn](uint32_t events) { handle_event(*conn, events); })) {
+        ::close(fd);
+        return false;
+    }
+    connection.fd = fd;
+    connection.connected = false;
+    connection.want_write = true;
+    connection.connect_start_ns = now_ns();
+    return true;
+}
+
+void UpstreamPool::handle_event(Connection& connection, uint32_t events) {
+    if (connection.fd == -1) {
+        return;
+    }
+    if (!connection.connected) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        if (error != 0) {
+            fail(connection, "ERROR: Upstream unavailable");
+            return;
+        }
+        if (!(events & EPOLLOUT)) {
+            return;
+        }
+        connection.connected = true;
+        Upstream& upstream = *connection.upstream;
+        if (upstream.probing && options_.health_check.empty()) {
+            mark_healthy(upstream);
+        }
+        flush(connection);
+        return;
+    }
+
+    if (events & EPOLLOUT) {
+        flush(connection);
+    }
+    if (connection.fd != -1 && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+        read(connection);
+    }
+}
+
+void UpstreamPool::flush(Connection& connection) {
+    while (connection.output_offset < connection.output.size()) {
+        ssize_t sent = ::send(connection.fd, connection.output.data() + connection.output_offset,
+                              connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                if (!connection.want_write) {
+                    connection.want_write = true;
+                    loop_.modify_fd(connection.fd, EPOLLIN | EPOLLOUT);
+                }
+                return;
+            }
+            fail(connection, "ERROR: Upstream connection lost");
+            return;
+        }
+        connection.output_offset += static_cast<size_t>(sent);
+    }
+    connection.output.clear();
+    connection.output_offset = 0;
+    if (connection.want_write) {
+        connection.want_write = false;
+        loop_.modify_fd(connection.fd, EPOLLIN);
+    }
+}
+
+void UpstreamPool::read(Connection& connection) {
+    static thread_local std::vector<char> buffer(64 * 1024);
+    ssize_t received = recv(connection.fd, buffer.data(), buffer.size(), 0);
+    if (received < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            fail(connection, "ERROR: Upstream connection lost");
+        }
+        return;
+    }
+    if (received == 0) {
+        fail(connection, "ERROR: Upstream connection closed");
+        return;
+    }
+
+    connection.input.append(buffer.data(), static_cast<size_t>(received));
+    size_t begin = 0;
+    for (size_t end = connection.input.find('\n'); end != std::string::npos;
+         end = connection.input.find('\n', begin)) {
+        std::string_view line(connection.input.data() + begin, end - begin);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        begin = end + 1;
+        respond(connection, line);
+        if (connection.fd == -1) {
+            return;
+        }
+    }
+    connection.input.erase(0, begin);
+    if (connection.input.size() > MAX_RESPONSE_LENGTH) {
+        fail(connection, "ERROR: Upstream response too long");
+    }
+}
+
+void UpstreamPool::send(Connection& connection, std::string_view line, const ResponseTarget& target) {
+    if (connection.output.size() == connection.output_offset && connection.connected) {
+        dirty_.push_back(&connection);
+    }
+    connection.output.append(line.data(), line.size()).push_back('\n');
+    connection.pending.push_back(Pending{target, now_ns()});
+    ++connection.upstream->outstanding;
+}
+
+void UpstreamPool::respond(Connection& connection, std::string_view response) {
+    if (connection.pending.empty()) {
+        fail(connection, "ERROR: Unexpected upstream response");
+        return;
+    }
+    Pending pending = connection.pending.front();
+    connection.pending.pop_front();
+    Upstream& upstream = *connection.upstream;
+    --upstream.outstanding;
+
+    if (pending.target.kind == ResponseTarget::Kind::Probe) {
+        if (response.compare(0, 5, "ERROR") != 0) {
+            mark_healthy(upstream);
+        } else {
+            upstream.probing = false;
+        }
+        return;
+    }
+    handler_(pending.target, response);
+}
+
+void UpstreamPool::fail(Connection& connection, std::string_view reason) {
+    Upstream& upstream = *connection.upstream;
+    loop_.remove_fd(connection.fd);
+    ::close(connection.fd);
+    connection.fd = -1;
+    connection.connected = false;
+    connection.want_write = false;
+    connection.output.clear();
+    connection.output_offset = 0;
+    connection.input.clear();
+
+    upstream.healthy = false;
+    upstream.probing = false;
+    ++upstream.failures;
+    upstream.outstanding -= connection.pending.size();
+
+    // Обработчик может снова войти в пул, поэтому очередь забирается заранее
+    std::deque<Pending> pending;
+    pending.swap(connection.pending);
+    for (const auto& request : pending) {
+        if (request.target.kind != ResponseTarget::Kind::Probe) {
+            handler_(request.target, reason);
+        }
+    }
+}
+
+void UpstreamPool::probe(Upstream& upstream) {
+    Connection& connection = *upstream.connections.front();
+    if (connection.fd == -1 && !connect(connection)) {
+        ++upstream.failures;
+        return;
+    }
+    upstream.probing = true;
+    if (!options_.health_check.empty()) {
+        ResponseTarget target{};
+        target.kind = ResponseTarget::Kind::Probe;
+        send(connection, options_.health_check, target);
+    } else if (connection.connected) {
+        mark_healthy(upstream);
+    }
+}
+
+void UpstreamPool::mark_healthy(Upstream& upstream) {
+    upstream.healthy = true;
+    upstream.probing = false;
+    for (auto& connection : upstream.connections) {
+        if (connection->fd == -1) {
+            connect(*connection);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "eventloop.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <netinet/in.h>
+
+// Куда вернуть ответ бэкенда: TCP-соединение (fd и id, чтобы не ответить
+// в чужое соединение на переиспользованном fd), UDP-адрес или сам пул
+// (проверка здоровья)
+struct ResponseTarget {
+    enum class Kind : uint8_t { Tcp, Udp, Probe };
+
+    Kind kind;
+    int fd;
+    uint64_t connection_id;
+    sockaddr_in peer;
+    // Рабочий реактор, которому принадлежит fd; -1 - основной
+    int worker = -1;
+    // Номер отложенного ответа в TCP-соединении (TcpConnection::defer_reply)
+    uint64_t sequence = 0;
+};
+
+struct UpstreamStats {
+    std::string name;
+    bool healthy;
+    size_t connections;
+    size_t outstanding;
+    uint64_t requests;
+    uint64_t failures;
+};
+
+// Пересылка строк на бэкенды по постоянным неблокирующим соединениям в
+// том же EventLoop. Протокол бэкенда построчный, как у сервера: одна
+// строка ответа на строку запроса, ответы приходят в порядке запросов,
+// поэтому на соединении запросы конвейеризуются, а ответы сопоставляются
+// с очередью ожидающих. Запрос уходит на здоровый бэкенд с наименьшим
+// числом ожидающих ответов.
+class UpstreamPool {
+public:
+    using ResponseHandler = std::function<void(const ResponseTarget&, std::string_view)>;
+
+    struct Options {
+        size_t connections_per_upstream = 2;
+        size_t max_pending = 1024;  // на бэкенд
+        std::chrono::milliseconds timeout{5000};
+        std::chrono::milliseconds health_interval{1000};
+        // Строка, которой проверяется упавший бэкенд; пусто - достаточно connect
+        std::string health_check;
+    };
+
+    enum class Result { Ok, NoUpstream, Busy };
+
+    UpstreamPool(EventLoop& loop, Options options, ResponseHandler handler);
+    ~UpstreamPool();
+    UpstreamPool(const UpstreamPool&) = delete;
+    UpstreamPool& operator=(const UpstreamPool&) = delete;
+
+    // "host:port"; false - адрес не разобран
+    bool add_upstream(const std::string& address);
+    void start();
+    void stop();
+
+    Result forward(std::string_view line, const ResponseTarget& target);
+
+    // Вызывается после каждой итерации цикла: отправляет накопленные
+    // запросы, проверяет таймауты и здоровье упавших бэкендов
+    void poll();
+
+    std::vector<UpstreamStats> stats() const;
+
+    static bool parse_address(const std::string& address, sockaddr_in& addr);
+
+private:
+    struct Pending {
+        ResponseTarget target;
+        uint64_t start_ns;
+    };
+
+    struct Upstream;
+
+    struct Connection {
+        Upstream* upstream = nullptr;
+        int fd = -1;
+        bool connected = false;
+        bool want_write = false;
+        uint64_t connect_start_ns = 0;
+        std::string output;
+        size_t output_offset = 0;
+        std::string input;
+        std::deque<Pending> pending;
+    };
+
+    struct Upstream {
+        std::string name;
+        sockaddr_in addr{};
+        bool healthy = false;
+        bool probing = false;
+        size_t outstanding = 0;
+        uint64_t requests = 0;
+        uint64_t failures = 0;
+        std::vector<std::unique_ptr<Connection>> connections;
+    };
+
+    bool connect(Connection& connection);
+    void handle_event(Connection& connection, uint32_t events);
+    void flush(Connection& connection);
+    void read(Connection& connection);
+    void send(Connection& connection, std::string_view line, const ResponseTarget& target);
+    // Закрывает соединение, отвечая ошибкой всем ожидающим; бэкенд
+    // считается упавшим до успешной проверки
+    void fail(Connection& connection, std::string_view reason);
+    void respond(Connection& connection, std::string_view response);
+    void probe(Upstream& upstream);
+    void mark_healthy(Upstream& upstream);
+
+    EventLoop& loop_;
+    Options options_;
+    ResponseHandler handler_;
+    std::vector<std::unique_ptr<Upstream>> upstreams_;
+    // Соединения с новыми запросами, ещё не отправленными в этой итерации
+    std::vector<Connection*> dirty_;
+    size_t next_ = 0;
+    std::chrono::steady_clock::time_point last_health_check_{};
+};
@@ -0,0 +1,229 @@
+#include "worker_pool.hpp"
+#include "affinity.hpp"
+
+#include <future>
+
+const char* placement_policy_name(PlacementPolicy policy) {
+    switch (policy) {
+        case PlacementPolicy::RoundRobin: return "round_robin";
+        case PlacementPolicy::LeastConnections: return "least_connections";
+        case PlacementPolicy::LeastLoaded: return "least_loaded";
+    }
+    return "unknown";
+}
+
+Worker::Worker(size_t index, std::shared_ptr<SessionManager> session_manager)
+    : index_(index), session_manager_(std::move(session_manager)) {}
+
+Worker::~Worker() {
+    stop();
+}
+
+bool Worker::start(const std::vector<int>& cpus, size_t trace_events,
+                   const std::function<void(Worker&)>& setup, std::string& error) {
+    std::promise<std::string> ready;
+    std::future<std::string> result = ready.get_future();
+    thread_ = std::thread([this, cpus, trace_events, &setup, &ready] {
+        std::string pin_error;
+        if (!pin_thread(pthread_self(), cpus, pin_error)) {
+            ready.set_value(pin_error);
+            return;
+        }
+        loop_ = std::make_unique<EventLoop>();
+        loop_->set_trace_capacity(trace_events);
+        tcp_handler_ = std::make_unique<TcpHandler>(0, session_manager_);
+        arena_ = std::make_unique<RequestArena>();
+        loop_->set_wakeup_handler([this] { adopt_handoffs(); });
+        // /publish из другого потока: доставка и учёт результата здесь
+        tcp_handler_->set_owner(std::this_thread::get_id(),
+            [this](int fd, uint64_t id, const SharedMessage& message) {
+                loop_->post([this, fd, id, message] {
+                    TcpConnection* connection = tcp_handler_->find_connection(fd);
+                    if (connection && connection->get_id() == id && connection->get_fd() != -1) {
+                        session_manager_->topics().record(connection->deliver(message));
+                    }
+                });
+            });
+        setup(*this);
+        ready.set_value({});
+        run();
+    });
+    error = result.get();
+    if (!error.empty()) {
+        thread_.join();
+        return false;
+    }
+    return true;
+}
+
+void Worker::run() {
+    while (!stopping_.load(std::memory_order_acquire)) {
+        loop_->run(100);
+        tcp_handler_->release_closed();
+        connections_.store(tcp_handler_->connection_count(), std::memory_order_relaxed);
+        arena_->reset();
+    }
+    // Последняя итерация: задачи, отправленные до stop() (ответы бэкендов),
+    // выполняются, пока соединения ещё открыты; соединения, не успевшие
+    // попасть в таблицу, закрываются вместе с остальными
+    loop_->run(0);
+    adopt_handoffs();
+    tcp_handler_->stop();
+    tcp_handler_->release_closed();
+    arena_->reset();
+    connections_.store(0, std::memory_order_relaxed);
+}
+
+void Worker::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    stopping_.store(true, std::memory_order_release);
+    loop_->wake();
+    thread_.join();
+}
+
+bool Worker::hand_off(int fd, const sockaddr_in& addr) {
+    if (!handoffs_.push({fd, addr})) {
+        return false;
+    }
+    loop_->wake();
+    return true;
+}
+
+void Worker::adopt_handoffs() {
+    HandoffQueue::Item item;
+    while (handoffs_.pop(item)) {
+        tcp_handler_->adopt(item.fd, item.addr);
+        accepted_.store(accepted_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    connections_.store(tcp_handler_->connection_count(), std::memory_order_relaxed);
+}
+
+Worker::Stats Worker::stats() const {
+    Stats stats{};
+    stats.connections = connections();
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    if (loop_) {
+        stats.lag_ns = loop_->lag_ns();
+        stats.loop = loop_->get_stats();
+    }
+    if (arena_) {
+        stats.arena = arena_->stats();
+    }
+    return stats;
+}
+
+WorkerPool::WorkerPool(const Options& options, std::shared_ptr<SessionManager> session_manager)
+    : options_(options), policy_(options.policy) {
+    for (size_t i = 0; i < options_.workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>(i, session_manager));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+bool WorkerPool::start(const std::function<void(Worker&)>& setup, std::string& error) {
+    for (auto& worker : workers_) {
+        std::vector<int> cpus;
+        if (!options_.cpus.empty()) {
+            cpus.push_back(options_.cpus[(worker->index() + 1) % options_.cpus.size()]);
+        }
+        if (!worker->start(cpus, options_.trace_events, setup, error)) {
+            error = "worker " + std::to_string(worker->index()) + ": " + error;
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WorkerPool::start_acceptor(TcpHandler& listener) {
+    acceptor_loop_ = std::make_unique<EventLoop>();
+    acceptor_loop_->set_trace_capacity(options_.trace_events);
+    listen_fd_ = listener.get_socket_fd();
+    listener.set_handoff([this](int fd, const sockaddr_in& addr) { return dispatch(fd, addr); });
+    if (!acceptor_loop_->add_fd(listen_fd_, EPOLLIN, [&listener](uint32_t events) {
+            if (events & EPOLLIN) listener.handle_accept();
+        })) {
+        return false;
+    }
+    accepting_.store(true, std::memory_order_release);
+    acceptor_ = std::thread([this] {
+        while (accepting_.load(std::memory_order_acquire)) {
+            acceptor_loop_->run(100);
+        }
+    });
+    return true;
+}
+
+void WorkerPool::stop_acceptor() {
+    if (!acceptor_.joinable()) {
+        return;
+    }
+    accepting_.store(false, std::memory_order_release);
+    acceptor_loop_->wake();
+    acceptor_.join();
+    acceptor_loop_->remove_fd(listen_fd_);
+}
+
+void WorkerPool::set_accepting(bool accepting) {
+    // epoll_ctl безопасен из любого потока, колбэк остаётся на месте
+    if (acceptor_.joinable()) {
+        acceptor_loop_->modify_fd(listen_fd_, accepting ? uint32_t(EPOLLIN) : 0u);
+    }
+}
+
+void WorkerPool::stop() {
+    stop_acceptor();
+    for (auto& worker : workers_) {
+        worker->stop();
+    }
+}
+
+size_t WorkerPool::pick() {
+    size_t count = workers_.size();
+    size_t start = next_++ % count;
+    PlacementPolicy policy = policy_.load(std::memory_order_relaxed);
+    if (policy == PlacementPolicy::RoundRobin) {
+        return start;
+    }
+    // Обход начинается со следующего по кругу: равные достаются по очереди
+    size_t best = start;
+    for (size_t step = 1; step < count; ++step) {
+        size_t i = (start + step) % count;
+        const Worker& candidate = *workers_[i];
+        const Worker& current = *workers_[best];
+        bool better = policy == PlacementPolicy::LeastConnections
+            ? candidate.load() < current.load()
+            : candidate.lag_ns() < current.lag_ns() ||
+              (candidate.lag_ns() == current.lag_ns() && candidate.load() < current.load());
+        if (better) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool WorkerPool::dispatch(int fd, const sockaddr_in& addr) {
+    if (workers_.empty()) {
+        return false;
+    }
+    size_t first = pick();
+    for (size_t step = 0; step < workers_.size(); ++step) {
+        if (workers_[(first + step) % workers_.size()]->hand_off(fd, addr)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t WorkerPool::connections() const {
+    size_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->connections();
+    }
+    return total;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+#include "arena.hpp"
+#include "eventloop.hpp"
+#include "tcp_handler.hpp"
+
+// Куда акцептор отдаёт новое соединение
+enum class PlacementPolicy {
+    RoundRobin,        // по кругу
+    LeastConnections,  // меньше всего открытых соединений
+    LeastLoaded,       // наименьшая задержка цикла (EventLoop::lag_ns)
+};
+
+const char* placement_policy_name(PlacementPolicy policy);
+
+// Принятые соединения от акцептора рабочему реактору: один писатель и один
+// читатель, без блокировок
+class HandoffQueue {
+public:
+    static constexpr size_t CAPACITY = 1024;
+
+    struct Item {
+        int fd;
+        sockaddr_in addr;
+    };
+
+    bool push(const Item& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == CAPACITY) {
+            return false;
+        }
+        items_[tail & (CAPACITY - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(Item& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items_[head & (CAPACITY - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::array<Item, CAPACITY> items_;
+};
+
+// Рабочий реактор: свой поток, EventLoop, таблица TCP-соединений и арена
+// запросов. Всё это создаётся в потоке реактора после привязки к CPU, чтобы
+// память досталась его узлу NUMA. Соединения приходят от акцептора через
+// HandoffQueue, остальная работа из других потоков - через loop().post().
+class Worker {
+public:
+    struct Stats {
+        size_t connections;
+        uint64_t accepted;
+        uint64_t lag_ns;
+        EventLoop::Stats loop;
+        RequestArena::Stats arena;
+    };
+
+    Worker(size_t index, std::shared_ptr<SessionManager> session_manager);
+    ~Worker();
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    // setup настраивает обработчики tcp_handler() в потоке реактора;
+    // start() возвращается, когда он отработал
+    bool start(const std::vector<int>& cpus, size_t trace_events,
+               const std::function<void(Worker&)>& setup, std::string& error);
+    // Закрывает соединения в потоке реактора и ждёт его завершения
+    void stop();
+
+    // Поток акцептора; false - очередь переполнена
+    bool hand_off(int fd, const sockaddr_in& addr);
+
+    size_t index() const { return index_; }
+    EventLoop& loop() { return *loop_; }
+    const EventLoop& loop() const { return *loop_; }
+    TcpHandler& tcp_handler() { return *tcp_handler_; }
+    RequestArena& arena() { return *arena_; }
+
+    // Открытые соединения вместе с ещё не разобранными из очереди
+    size_t load() const { return connections_.load(std::memory_order_relaxed) + handoffs_.size(); }
+    size_t connections() const { return connections_.load(std::memory_order_relaxed); }
+    uint64_t lag_ns() const { return loop_->lag_ns(); }
+    Stats stats() const;
+
+private:
+    void run();
+    void adopt_handoffs();
+
+    size_t index_;
+    std::shared_ptr<SessionManager> session_manager_;
+    std::unique_ptr<EventLoop> loop_;
+    std::unique_ptr<TcpHandler> tcp_handler_;
+    std::unique_ptr<RequestArena> arena_;
+    HandoffQueue handoffs_;
+    std::atomic<size_t> connections_{0};
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+// Рабочие реакторы и поток акцептора, который принимает соединения на
+// общем слушающем сокете и раздаёт их по политике размещения. В отличие от
+// SO_REUSEPORT, распределение учитывает текущую нагрузку реакторов.
+class WorkerPool {
+public:
+    struct Options {
+        size_t workers = 0;
+        PlacementPolicy policy = PlacementPolicy::RoundRobin;
+        // Рабочий i занимает cpus[(i + 1) % size]: первый CPU списка остаётся
+        // основному реактору, акцептор наследует его привязку
+        std::vector<int> cpus;
+        size_t trace_events = 0;
+    };
+
+    WorkerPool(const Options& options, std::shared_ptr<SessionManager> session_manager);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    bool start(const std::function<void(Worker&)>& setup, std::string& error);
+    // listener.handle_accept() выполняется в потоке акцептора со своим циклом
+    bool start_acceptor(TcpHandler& listener);
+    void stop_acceptor();
+    // false - слушающий сокет снимается с опроса, соединения ждут в очереди listen
+    void set_accepting(bool accepting);
+    void stop();
+
+    // Поток акцептора: выбирает реактор; если его очередь полна - следующий
+    bool dispatch(int fd, const sockaddr_in& addr);
+
+    void set_policy(PlacementPolicy policy) { policy_.store(policy, std::memory_order_relaxed); }
+    PlacementPolicy policy() const { return policy_.load(std::memory_order_relaxed); }
+
+    size_t size() const { return workers_.size(); }
+    Worker& worker(size_t index) { return *workers_[index]; }
+    const Worker& worker(size_t index) const { return *workers_[index]; }
+    size_t connections() const;
+    const EventLoop* acceptor_loop() const { return acceptor_loop_.get(); }
+
+private:
+    size_t pick();
+
+    Options options_;
+    std::atomic<PlacementPolicy> policy_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    size_t next_ = 0;  // только поток акцептора
+
+    std::unique_ptr<EventLoop> acceptor_loop_;
+    int listen_fd_ = -1;
+    std::atomic<bool> accepting_{false};
+    std::thread acceptor_;
+};
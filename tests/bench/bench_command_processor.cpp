@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../server/arena.hpp"
+#include "../../server/command.hpp"
+#include "../../server/command_processor.hpp"
+#include "../../server/session_manager.hpp"
+
+namespace {
+
+std::vector<std::unique_ptr<Command>> make_commands(SessionManager& session_manager) {
+    std::vector<std::unique_ptr<Command>> commands;
+    commands.push_back(std::make_unique<TimeCommand>());
+    commands.push_back(std::make_unique<StatsCommand>(session_manager));
+    commands.push_back(std::make_unique<ShutdownCommand>());
+    commands.push_back(std::make_unique<SessionsCommand>(session_manager));
+    return commands;
+}
+
+// Таблица сессий с заполненными слотами, чтобы /sessions сортировал реальные данные
+void populate_sessions(SessionManager& session_manager, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        sockaddr_in peer{};
+        peer.sin_family = AF_INET;
+        peer.sin_addr.s_addr = htonl(0x7f000001);
+        peer.sin_port = htons(static_cast<uint16_t>(10000 + i));
+        int slot = session_manager.sessions().open(peer);
+        session_manager.sessions().record_read(slot, 100 + i * 7, 1 + i % 5);
+    }
+}
+
+void run_command(benchmark::State& state, const std::string& input) {
+    SessionManager session_manager;
+    populate_sessions(session_manager, 64);
+    CommandProcessor processor(make_commands(session_manager));
+
+    for (auto _ : state) {
+        auto response = processor.process_command(input);
+        benchmark::DoNotOptimize(response);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+static void BM_ProcessCommand_Echo(benchmark::State& state) {
+    run_command(state, std::string(static_cast<size_t>(state.range(0)), 'x'));
+}
+BENCHMARK(BM_ProcessCommand_Echo)->Arg(16)->Arg(256)->Arg(4096);
+
+// Ответ из арены, сбрасываемой после каждого запроса, как в цикле сервера
+static void BM_ProcessCommand_EchoArena(benchmark::State& state) {
+    SessionManager session_manager;
+    CommandProcessor processor(make_commands(session_manager));
+    RequestArena arena;
+    std::string input(static_cast<size_t>(state.range(0)), 'x');
+
+    for (auto _ : state) {
+        {
+            auto response = processor.process_command(input, nullptr, &arena);
+            benchmark::DoNotOptimize(response);
+        }
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProcessCommand_EchoArena)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_ProcessCommand_Time(benchmark::State& state) {
+    run_command(state, "/time");
+}
+BENCHMARK(BM_ProcessCommand_Time);
+
+static void BM_ProcessCommand_Stats(benchmark::State& state) {
+    run_command(state, "/stats");
+}
+BENCHMARK(BM_ProcessCommand_Stats);
+
+static void BM_ProcessCommand_Sessions(benchmark::State& state) {
+    run_command(state, "/sessions traffic 10");
+}
+BENCHMARK(BM_ProcessCommand_Sessions);
+
+static void BM_ProcessCommand_Unknown(benchmark::State& state) {
+    run_command(state, "/nosuchcommand");
+}
+BENCHMARK(BM_ProcessCommand_Unknown);
+
+// Сами команды без диспетчеризации и метрик процессора
+static void BM_TimeCommand_Execute(benchmark::State& state) {
+    TimeCommand command;
+    CommandContext context;
+    for (auto _ : state) {
+        auto response = command.execute(context);
+        benchmark::DoNotOptimize(response);
+    }
+}
+BENCHMARK(BM_TimeCommand_Execute);
+
+static void BM_StatsCommand_Execute(benchmark::State& state) {
+    SessionManager session_manager;
+    StatsCommand command(session_manager);
+    CommandContext context;
+    for (auto _ : state) {
+        auto response = command.execute(context);
+        benchmark::DoNotOptimize(response);
+    }
+}
+BENCHMARK(BM_StatsCommand_Execute);
@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../../server/eventloop.hpp"
+
+namespace {
+
+// N зарегистрированных eventfd, из которых active остаются готовыми к
+// чтению (level-triggered, колбэк их не вычитывает)
+class EventFdSet {
+public:
+    EventFdSet(EventLoop& loop, size_t registered, size_t active, uint64_t& counter) {
+        for (size_t i = 0; i < registered; ++i) {
+            int fd = eventfd(i < active ? 1 : 0, EFD_NONBLOCK | EFD_CLOEXEC);
+            fds_.push_back(fd);
+            loop.add_fd(fd, EPOLLIN, [&counter](uint32_t) { ++counter; });
+        }
+    }
+    ~EventFdSet() {
+        for (int fd : fds_) close(fd);
+    }
+
+private:
+    std::vector<int> fds_;
+};
+
+} // namespace
+
+// Стоимость итерации цикла, когда готовы все fd (до MAX_EVENTS за вызов)
+static void BM_EventLoop_DispatchAllReady(benchmark::State& state) {
+    EventLoop loop;
+    uint64_t dispatched = 0;
+    EventFdSet fds(loop, static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(0)), dispatched);
+
+    for (auto _ : state) {
+        loop.run(0);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(dispatched));
+}
+BENCHMARK(BM_EventLoop_DispatchAllReady)->Arg(1)->Arg(16)->Arg(64)->Arg(256);
+
+// Один готовый fd среди N: epoll не должен дорожать с числом соединений
+static void BM_EventLoop_DispatchOneOfN(benchmark::State& state) {
+    EventLoop loop;
+    uint64_t dispatched = 0;
+    EventFdSet fds(loop, static_cast<size_t>(state.range(0)), 1, dispatched);
+
+    for (auto _ : state) {
+        loop.run(0);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(dispatched));
+}
+BENCHMARK(BM_EventLoop_DispatchOneOfN)->Arg(1)->Arg(64)->Arg(512);
+
+// Пустой опрос: нижняя граница стоимости итерации
+static void BM_EventLoop_IdlePoll(benchmark::State& state) {
+    EventLoop loop;
+    uint64_t dispatched = 0;
+    EventFdSet fds(loop, static_cast<size_t>(state.range(0)), 0, dispatched);
+
+    for (auto _ : state) {
+        loop.run(0);
+    }
+}
+BENCHMARK(BM_EventLoop_IdlePoll)->Arg(64);
@@ -0,0 +1,152 @@
+#include <benchmark/benchmark.h>
+#include <arpa/inet.h>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fstream>
+#include <vector>
+
+#include "../../server/eventloop.hpp"
+#include "../../server/tcp_handler.hpp"
+
+namespace {
+
+// На один адрес источника приходится ~28k эфемерных портов, поэтому
+// клиенты раскладываются по 127.0.0.1, 127.0.0.2, ...
+constexpr size_t CLIENTS_PER_ADDRESS = 20000;
+
+size_t rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t size = 0;
+    size_t resident = 0;
+    statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Клиент и сервер в одном процессе: по два дескриптора на соединение
+bool raise_fd_limit(size_t needed) {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_max < needed) {
+        return false;
+    }
+    if (limit.rlim_cur < needed) {
+        limit.rlim_cur = needed;
+        return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+    }
+    return true;
+}
+
+uint16_t local_port(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    return ntohs(addr.sin_port);
+}
+
+int connect_client(uint16_t port, size_t index) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK + static_cast<uint32_t>(index / CLIENTS_PER_ADDRESS));
+    sockaddr_in server{};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+        connect(fd, reinterpret_cast<sockaddr*>(&server), sizeof(server)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+// Память сервера на простаивающее соединение: TcpHandler и EventLoop,
+// связанные как в Server, N клиентов присылают по строке и замолкают.
+// rss_bytes_per_conn - прирост RSS процесса, heap_bytes_per_conn - занятая
+// куча (mallinfo2) без учёта уже освобождённой памяти. Сюда же входит
+// слот таблицы сессий, которая при старте сервера размечается под
+// max_connections. Для 100000 нужен ulimit -n не меньше 200100.
+static void BM_IdleConnections(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    if (!raise_fd_limit(2 * count + 100)) {
+        state.SkipWithError("RLIMIT_NOFILE hard limit is below 2 fds per connection");
+        return;
+    }
+
+    for (auto _ : state) {
+        std::vector<int> clients;
+        clients.reserve(count);
+        size_t rss_before = rss_bytes();
+        size_t heap_before = mallinfo2().uordblks;
+        size_t rss_after = 0;
+        size_t heap_after = 0;
+        bool failed = false;
+
+        {
+            auto session_manager = std::make_shared<SessionManager>(count);
+            EventLoop loop;
+            TcpHandler handler(0, session_manager);
+            size_t received = 0;
+
+            handler.set_connection_callback([&loop](TcpConnection& connection) {
+                TcpConnection* conn = &connection;
+                loop.add_fd(connection.get_fd(), EPOLLIN, [conn](uint32_t events) {
+                    if (events & EPOLLIN) conn->handle_read();
+                });
+            });
+            handler.set_message_handler([&received](TcpConnection&, std::string_view) { ++received; });
+            handler.set_close_handler([&loop, &handler](int fd) {
+                loop.remove_fd(fd);
+                handler.remove_connection(fd);
+            });
+
+            if (!handler.start()) {
+                state.SkipWithError("listen failed");
+                return;
+            }
+            loop.add_fd(handler.get_socket_fd(), EPOLLIN, [&handler](uint32_t) { handler.handle_accept(); });
+            uint16_t port = local_port(handler.get_socket_fd());
+
+            for (size_t i = 0; i < count && !failed; ++i) {
+                int fd = connect_client(port, i);
+                failed = fd < 0 || send(fd, "ping\n", 5, MSG_NOSIGNAL) != 5;
+                if (fd >= 0) clients.push_back(fd);
+                loop.run(0);
+            }
+            for (int spins = 0; !failed && (handler.connection_count() < count || received < count); ++spins) {
+                failed = spins > 10000;
+                loop.run(1);
+            }
+            handler.release_closed();
+
+            rss_after = rss_bytes();
+            heap_after = mallinfo2().uordblks;
+        }
+
+        for (int fd : clients) {
+            close(fd);
+        }
+        if (failed) {
+            state.SkipWithError("could not open all connections");
+            return;
+        }
+
+        double n = static_cast<double>(count);
+        state.counters["rss_bytes_per_conn"] = static_cast<double>(rss_after - std::min(rss_after, rss_before)) / n;
+        state.counters["heap_bytes_per_conn"] = static_cast<double>(heap_after - std::min(heap_after, heap_before)) / n;
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_IdleConnections)->Arg(1000)->Arg(8000)->Arg(100000)
+    ->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../server/command_processor.hpp"
+#include "../../server/kv_store.hpp"
+
+namespace {
+
+std::vector<std::string> make_keys(size_t count) {
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        keys.push_back("user:" + std::to_string(i * 7919));
+    }
+    return keys;
+}
+
+} // namespace
+
+// Попадание в заполненное хранилище; range(1) - размер значения
+// (до 48 байт вместе с ключом лежит прямо в ячейке таблицы)
+static void BM_KvGet(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    KvStore store;
+    auto keys = make_keys(count);
+    std::string payload(static_cast<size_t>(state.range(1)), 'v');
+    for (const auto& key : keys) {
+        store.set(key, payload);
+    }
+
+    std::string value;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store.get(keys[i], value));
+        i = i + 1 == count ? 0 : i + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KvGet)->Args({1000, 16})->Args({1000000, 16})->Args({1000000, 256});
+
+static void BM_KvSet(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    KvStore store;
+    auto keys = make_keys(count);
+    std::string payload(16, 'v');
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store.set(keys[i], payload));
+        i = i + 1 == count ? 0 : i + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_KvSet)->Arg(1000)->Arg(1000000);
+
+// Полный путь команды: разбор строки, поиск команды и формирование ответа
+static void BM_ProcessCommand_Get(benchmark::State& state) {
+    KvStore store;
+    store.set("user:42", "Alice");
+    std::vector<std::unique_ptr<Command>> commands;
+    commands.push_back(std::make_unique<GetCommand>(store));
+    CommandProcessor processor(std::move(commands));
+
+    for (auto _ : state) {
+        auto response = processor.process_command("/get user:42");
+        benchmark::DoNotOptimize(response);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProcessCommand_Get);
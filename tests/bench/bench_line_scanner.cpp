@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../server/line_scanner.hpp"
+
+namespace {
+
+// Поток запросов, похожий на реальный трафик: короткие команды вперемешку с
+// эхо-сообщениями разной длины, часть строк с "\r\n" и хвостовыми пробелами.
+std::string make_request_stream(size_t target_size) {
+    std::mt19937 rng(2024);
+    std::string stream;
+    stream.reserve(target_size + 2048);
+
+    while (stream.size() < target_size) {
+        unsigned kind = rng() % 10;
+        if (kind < 3) {
+            stream += "/time";
+        } else if (kind < 4) {
+            stream += "/stats";
+        } else {
+            static const size_t sizes[] = {8, 16, 32, 64, 128, 512, 1024};
+            size_t len = sizes[rng() % (kind < 8 ? 4 : 7)];
+            for (size_t i = 0; i < len; ++i) {
+                stream += static_cast<char>('a' + rng() % 26);
+            }
+        }
+        if (rng() % 4 == 0) {
+            stream += "  ";
+        }
+        stream += (rng() % 3 == 0) ? "\r\n" : "\n";
+    }
+    return stream;
+}
+
+// Прежний подход: find('\n') + find_last_not_of по каждой строке.
+size_t scan_baseline(const char* data, size_t size, std::vector<LineSpan>& lines) {
+    std::string_view view(data, size);
+    size_t begin = 0;
+    size_t nl;
+    while ((nl = view.find('\n', begin)) != std::string_view::npos) {
+        std::string_view line = view.substr(begin, nl - begin);
+        size_t end = line.find_last_not_of(" \t\n\r\f\v");
+        lines.push_back({begin, end == std::string_view::npos ? 0 : end + 1});
+        begin = nl + 1;
+    }
+    return begin;
+}
+
+void run_scanner(benchmark::State& state, LineScanner::ScanFn scan) {
+    const std::string stream = make_request_stream(static_cast<size_t>(state.range(0)));
+    std::vector<LineSpan> lines;
+    lines.reserve(stream.size() / 8);
+
+    for (auto _ : state) {
+        lines.clear();
+        benchmark::DoNotOptimize(scan(stream.data(), stream.size(), lines));
+        benchmark::DoNotOptimize(lines.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stream.size()));
+    state.counters["lines"] = static_cast<double>(lines.size());
+}
+
+void BM_LineScan_Baseline(benchmark::State& state) { run_scanner(state, &scan_baseline); }
+void BM_LineScan_Scalar(benchmark::State& state) { run_scanner(state, &LineScanner::scan_scalar); }
+void BM_LineScan_Sse2(benchmark::State& state) { run_scanner(state, &LineScanner::scan_sse2); }
+void BM_LineScan_Dispatch(benchmark::State& state) { run_scanner(state, &LineScanner::scan); }
+
+void BM_LineScan_Avx2(benchmark::State& state) {
+    if (!LineScanner::supported(LineScanner::Isa::Avx2)) {
+        state.SkipWithError("AVX2 is not supported on this CPU");
+        return;
+    }
+    run_scanner(state, &LineScanner::scan_avx2);
+}
+
+} // namespace
+
+BENCHMARK(BM_LineScan_Baseline)->Arg(1024)->Arg(16 * 1024)->Arg(256 * 1024);
+BENCHMARK(BM_LineScan_Scalar)->Arg(1024)->Arg(16 * 1024)->Arg(256 * 1024);
+BENCHMARK(BM_LineScan_Sse2)->Arg(1024)->Arg(16 * 1024)->Arg(256 * 1024);
+BENCHMARK(BM_LineScan_Avx2)->Arg(1024)->Arg(16 * 1024)->Arg(256 * 1024);
+BENCHMARK(BM_LineScan_Dispatch)->Arg(1024)->Arg(16 * 1024)->Arg(256 * 1024);
@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+
+#include "../../server/session_manager.hpp"
+
+namespace {
+
+// Общий на все потоки бенчмарка экземпляр: проверяем разделяемые счётчики
+SessionManager& shared_manager() {
+    static SessionManager manager;
+    return manager;
+}
+
+} // namespace
+
+static void BM_SessionManager_RecordReceived(benchmark::State& state) {
+    SessionManager& manager = shared_manager();
+    for (auto _ : state) {
+        manager.record_received(Protocol::Tcp, 64, 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SessionManager_RecordReceived)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_SessionManager_ConnectDisconnect(benchmark::State& state) {
+    SessionManager& manager = shared_manager();
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(static_cast<uint16_t>(1000 + state.thread_index()));
+
+    for (auto _ : state) {
+        manager.add_connection();
+        int slot = manager.sessions().open(peer);
+        manager.sessions().close(slot);
+        manager.remove_connection();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SessionManager_ConnectDisconnect)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_SessionManager_GetStats(benchmark::State& state) {
+    SessionManager& manager = shared_manager();
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            ServerStats stats = manager.get_stats();
+            benchmark::DoNotOptimize(stats);
+        } else {
+            manager.record_received(Protocol::Udp, 32, 1);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SessionManager_GetStats)->Threads(1)->Threads(4)->UseRealTime();
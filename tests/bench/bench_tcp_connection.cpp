@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../../server/tcp_connection.hpp"
+
+namespace {
+
+// Пачка из lines строк длиной line_size, как от конвейерного клиента
+std::string make_batch(size_t lines, size_t line_size) {
+    std::string batch;
+    for (size_t i = 0; i < lines; ++i) {
+        batch.append(line_size, static_cast<char>('a' + i % 26));
+        batch += '\n';
+    }
+    return batch;
+}
+
+void run_handle_read(benchmark::State& state, bool with_sessions) {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds);
+
+    const size_t lines = static_cast<size_t>(state.range(0));
+    const size_t line_size = static_cast<size_t>(state.range(1));
+    const std::string batch = make_batch(lines, line_size);
+
+    auto session_manager = with_sessions ? std::make_shared<SessionManager>() : nullptr;
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    TcpSettings settings;
+    settings.buffer_size = 64 * 1024;
+    size_t received = 0;
+    settings.on_message = [&received](TcpConnection&, std::string_view message) {
+        benchmark::DoNotOptimize(message.data());
+        ++received;
+    };
+
+    {
+        TcpConnection connection(fds[0], peer, session_manager.get(), &settings);
+
+        for (auto _ : state) {
+            received = 0;
+            ssize_t written = write(fds[1], batch.data(), batch.size());
+            benchmark::DoNotOptimize(written);
+            while (received < lines) {
+                connection.handle_read();
+            }
+        }
+    }
+    close(fds[1]);
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lines));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(batch.size()));
+}
+
+} // namespace
+
+// Разбор строк и создание std::string на каждое сообщение (write в socketpair
+// входит в замер и одинаков для всех вариантов)
+static void BM_TcpConnection_HandleRead(benchmark::State& state) {
+    run_handle_read(state, false);
+}
+BENCHMARK(BM_TcpConnection_HandleRead)
+    ->Args({1, 16})->Args({32, 16})->Args({32, 256})->Args({8, 4096});
+
+static void BM_TcpConnection_HandleReadWithSessions(benchmark::State& state) {
+    run_handle_read(state, true);
+}
+BENCHMARK(BM_TcpConnection_HandleReadWithSessions)->Args({32, 16});
@@ -0,0 +1,708 @@
+// Нагрузочный регрессионный тест: поднимает сервер на loopback, прогоняет
+// фиксированные сценарии и сравнивает результат с сохранённым базовым JSON.
+// Код возврата: 0 - без регрессий, 1 - регрессия, 2 - ошибка запуска.
+
+#include "hdr_histogram.hpp"
+#include "load_generator.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t NS_PER_SEC = 1000000000ULL;
+constexpr const char* LOOPBACK = "127.0.0.1";
+
+struct PerfOptions {
+    std::string server = "build/async_tcp_udp_server";
+    std::string config = "tests/perf/server.conf";
+    std::string baseline = "tests/perf/baseline.json";
+    std::string output = "build/perf.json";
+    std::string log = "build/perf_server.log";
+    uint16_t port = 9300;
+    double tolerance = 0.2;
+    std::chrono::seconds duration{3};
+    std::chrono::seconds warmup{1};
+    size_t idle_connections = 2000;
+    std::vector<std::string> workloads;
+    bool update_baseline = false;
+};
+
+// Для пропускной способности рост - улучшение, для задержки, памяти и
+// CPU - ухудшение. slack - абсолютный допуск поверх относительного, чтобы
+// шум на малых значениях (микросекунды, килобайты) не считался регрессией.
+enum class Better { Higher, Lower };
+
+struct Metric {
+    std::string name;
+    double value;
+    Better better;
+    double slack;
+};
+
+struct WorkloadResult {
+    std::string name;
+    std::vector<Metric> metrics;
+
+    void add(std::string metric, double value, Better better, double slack = 0) {
+        metrics.push_back({std::move(metric), value, better, slack});
+    }
+};
+
+// workload -> metric -> value
+using Results = std::map<std::string, std::map<std::string, double>>;
+
+uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * NS_PER_SEC + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+struct ProcessUsage {
+    uint64_t cpu_ns = 0;
+    uint64_t rss_kb = 0;
+    uint64_t hwm_kb = 0;
+};
+
+// Процесс сервера: stdout/stderr в лог, конфигурация только из файла
+class ServerProcess {
+public:
+    ~ServerProcess() { stop(); }
+
+    bool start(const PerfOptions& options, std::string& error) {
+        pid_ = fork();
+        if (pid_ < 0) {
+            error = std::string("fork failed: ") + std::strerror(errno);
+            return false;
+        }
+        if (pid_ == 0) {
+            int log = open(options.log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (log >= 0) {
+                dup2(log, STDOUT_FILENO);
+                dup2(log, STDERR_FILENO);
+                close(log);
+            }
+            for (const char* name : {"SERVER_PORT", "ADMIN_PORT", "SIGNAL_MODE", "STATS_SHM", "SERVER_CONFIG"}) {
+                unsetenv(name);
+            }
+            std::string port = std::to_string(options.port);
+            execl(options.server.c_str(), options.server.c_str(), "--config", options.config.c_str(),
+                  port.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+
+        uint64_t deadline = now_ns() + 5 * NS_PER_SEC;
+        while (now_ns() < deadline) {
+            int status;
+            if (waitpid(pid_, &status, WNOHANG) == pid_) {
+                pid_ = -1;
+                error = "server exited during startup, see " + options.log;
+                return false;
+            }
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            sockaddr_in addr = loopback(options.port);
+            bool ready = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+            close(fd);
+            if (ready) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        error = "server did not accept connections within 5s";
+        return false;
+    }
+
+    void stop() {
+        if (pid_ <= 0) {
+            return;
+        }
+        kill(pid_, SIGTERM);
+        uint64_t deadline = now_ns() + 5 * NS_PER_SEC;
+        int status;
+        while (waitpid(pid_, &status, WNOHANG) == 0) {
+            if (now_ns() > deadline) {
+                kill(pid_, SIGKILL);
+                waitpid(pid_, &status, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        pid_ = -1;
+    }
+
+    // utime + stime из /proc/<pid>/stat, VmRSS и VmHWM из /proc/<pid>/status
+    ProcessUsage usage() const {
+        ProcessUsage usage;
+        std::ifstream stat("/proc/" + std::to_string(pid_) + "/stat");
+        std::string line;
+        std::getline(stat, line);
+        size_t paren = line.rfind(')');
+        if (paren != std::string::npos) {
+            std::istringstream fields(line.substr(paren + 1));
+            std::string field;
+            uint64_t utime = 0;
+            uint64_t stime = 0;
+            // Поля после имени процесса начинаются с третьего (state)
+            for (int index = 3; fields >> field && index <= 15; ++index) {
+                if (index == 14) utime = std::stoull(field);
+                if (index == 15) stime = std::stoull(field);
+            }
+            usage.cpu_ns = (utime + stime) * NS_PER_SEC / static_cast<uint64_t>(sysconf(_SC_CLK_TCK));
+        }
+
+        std::ifstream status("/proc/" + std::to_string(pid_) + "/status");
+        while (std::getline(status, line)) {
+            if (line.rfind("VmRSS:", 0) == 0) {
+                usage.rss_kb = std::stoull(line.substr(6));
+            } else if (line.rfind("VmHWM:", 0) == 0) {
+                usage.hwm_kb = std::stoull(line.substr(6));
+            }
+        }
+        return usage;
+    }
+
+    static sockaddr_in loopback(uint16_t port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, LOOPBACK, &addr.sin_addr);
+        return addr;
+    }
+
+private:
+    pid_t pid_ = -1;
+};
+
+int connect_tcp(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in addr = ServerProcess::loopback(port);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Блокирующий запрос-ответ: одна строка туда, одна строка обратно
+bool round_trip(int fd, const std::string& request) {
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        return false;
+    }
+    char buffer[512];
+    for (;;) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return false;
+        }
+        if (buffer[n - 1] == '\n') {
+            return true;
+        }
+    }
+}
+
+// Закрытие через RST: иначе за несколько секунд churn исчерпает
+// эфемерные порты соединениями в TIME_WAIT
+void close_abortive(int fd) {
+    linger lg{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+void add_latency(WorkloadResult& result, const HdrHistogram& latency) {
+    result.add("p50_us", static_cast<double>(latency.value_at_percentile(50.0)) / 1000.0, Better::Lower, 50);
+    result.add("p99_us", static_cast<double>(latency.value_at_percentile(99.0)) / 1000.0, Better::Lower, 250);
+}
+
+void add_usage(WorkloadResult& result, const ProcessUsage& before, const ProcessUsage& after, uint64_t requests) {
+    double cpu_us = static_cast<double>(after.cpu_ns - before.cpu_ns) / 1000.0;
+    result.add("cpu_us_per_request", requests ? cpu_us / static_cast<double>(requests) : 0.0, Better::Lower, 2);
+    result.add("rss_peak_kb", static_cast<double>(after.hwm_kb), Better::Lower, 1024);
+}
+
+void add_errors(WorkloadResult& result, uint64_t errors, uint64_t completed) {
+    uint64_t total = errors + completed;
+    result.add("error_rate", total ? static_cast<double>(errors) / static_cast<double>(total) : 0.0,
+               Better::Lower, 0.001);
+}
+
+// Новое соединение на каждый запрос
+bool run_churn(const PerfOptions& options, ServerProcess& server, WorkloadResult& result, std::string&) {
+    HdrHistogram latency;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+
+    ProcessUsage before = server.usage();
+    uint64_t start = now_ns();
+    uint64_t end = start + static_cast<uint64_t>(options.duration.count()) * NS_PER_SEC;
+    uint64_t now = start;
+    while (now < end) {
+        int fd = connect_tcp(options.port);
+        if (fd < 0 || !round_trip(fd, "/time\n")) {
+            ++errors;
+        } else {
+            ++completed;
+        }
+        if (fd >= 0) {
+            close_abortive(fd);
+        }
+        uint64_t finished = now_ns();
+        latency.record(finished - now);
+        now = finished;
+    }
+    double elapsed = static_cast<double>(now - start) / NS_PER_SEC;
+
+    result.add("connections_per_sec", static_cast<double>(completed) / elapsed, Better::Higher);
+    add_latency(result, latency);
+    add_usage(result, before, server.usage(), completed);
+    add_errors(result, errors, completed);
+    return true;
+}
+
+// Много простаивающих соединений: стоимость соединения в памяти и
+// задержка запросов активного клиента на их фоне
+bool run_idle(const PerfOptions& options, ServerProcess& server, WorkloadResult& result, std::string& error) {
+    std::vector<int> idle;
+    idle.reserve(options.idle_connections);
+
+    ProcessUsage before = server.usage();
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < options.idle_connections; ++i) {
+        int fd = connect_tcp(options.port);
+        if (fd < 0 || !round_trip(fd, "/time\n")) {
+            if (fd >= 0) close(fd);
+            error = "idle connection " + std::to_string(i) + " failed";
+            break;
+        }
+        idle.push_back(fd);
+    }
+    double open_elapsed = static_cast<double>(now_ns() - start) / NS_PER_SEC;
+    ProcessUsage opened = server.usage();
+
+    HdrHistogram latency;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    int probe = error.empty() ? connect_tcp(options.port) : -1;
+    if (probe >= 0) {
+        uint64_t end = now_ns() + static_cast<uint64_t>(options.duration.count()) * NS_PER_SEC;
+        uint64_t now = now_ns();
+        while (now < end) {
+            bool ok = round_trip(probe, "/time\n");
+            uint64_t finished = now_ns();
+            latency.record(finished - now);
+            now = finished;
+            ok ? ++completed : ++errors;
+            if (!ok) break;
+        }
+        close(probe);
+    }
+    for (int fd : idle) {
+        close(fd);
+    }
+    if (!error.empty()) {
+        return false;
+    }
+
+    double per_connection = idle.empty() ? 0.0
+        : static_cast<double>(opened.rss_kb - std::min(opened.rss_kb, before.rss_kb)) * 1024.0 / static_cast<double>(idle.size());
+    result.add("connections_per_sec", static_cast<double>(idle.size()) / open_elapsed, Better::Higher);
+    result.add("rss_bytes_per_connection", per_connection, Better::Lower, 512);
+    add_latency(result, latency);
+    add_usage(result, before, server.usage(), completed + idle.size());
+    add_errors(result, errors, completed);
+    return true;
+}
+
+// Сценарий на генераторе нагрузки: отдельный прогрев, затем замер, чтобы
+// CPU сервера делился только на запросы измеряемого интервала
+bool run_generator(const PerfOptions& options, ServerProcess& server, WorkloadResult& result, std::string& error,
+                   bool udp, size_t connections, size_t pipeline, const char* mix) {
+    LoadOptions load;
+    load.udp = udp;
+    load.server_ip = LOOPBACK;
+    load.port = options.port;
+    load.connections = connections;
+    load.pipeline = pipeline;
+    load.warmup = std::chrono::seconds(0);
+    if (!parse_mix(mix, load.mix, error)) {
+        return false;
+    }
+
+    if (options.warmup.count() > 0) {
+        LoadOptions warmup = load;
+        warmup.duration = options.warmup;
+        LoadGenerator generator(std::move(warmup));
+        if (!generator.run(error)) {
+            return false;
+        }
+    }
+
+    load.duration = options.duration;
+    LoadGenerator generator(std::move(load));
+    ProcessUsage before = server.usage();
+    if (!generator.run(error)) {
+        return false;
+    }
+    ProcessUsage after = server.usage();
+
+    result.add("requests_per_sec", generator.throughput(), Better::Higher);
+    add_latency(result, generator.latency());
+    add_usage(result, before, after, generator.completed());
+    add_errors(result, generator.errors() + generator.timeouts(), generator.completed());
+    return true;
+}
+
+struct Workload {
+    const char* name;
+    std::function<bool(const PerfOptions&, ServerProcess&, WorkloadResult&, std::string&)> run;
+};
+
+const std::vector<Workload>& workloads() {
+    using namespace std::placeholders;
+    static const std::vector<Workload> all = {
+        {"churn", run_churn},
+        {"idle", run_idle},
+        {"pipelined_echo", std::bind(run_generator, _1, _2, _3, _4, false, 16, 8, "echo64")},
+        {"udp_flood", std::bind(run_generator, _1, _2, _3, _4, true, 8, 16, "echo64")},
+        {"mixed_commands", std::bind(run_generator, _1, _2, _3, _4, false, 16, 2, "time:1,stats:1,echo16:4,echo1024:2")},
+    };
+    return all;
+}
+
+// Минимальный разбор JSON: вложенные объекты с числовыми значениями,
+// остальные типы пропускаются. Ключи склеиваются через точку.
+class JsonReader {
+public:
+    explicit JsonReader(std::string text) : text_(std::move(text)) {}
+
+    bool read(std::map<std::string, double>& values) {
+        return value("", values) && (skip_space(), pos_ == text_.size());
+    }
+
+private:
+    void skip_space() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+    }
+
+    bool string(std::string& out) {
+        if (pos_ >= text_.size() || text_[pos_] != '"') return false;
+        size_t end = text_.find('"', ++pos_);
+        if (end == std::string::npos) return false;
+        out = text_.substr(pos_, end - pos_);
+        pos_ = end + 1;
+        return true;
+    }
+
+    bool value(const std::string& key, std::map<std::string, double>& values) {
+        skip_space();
+        if (pos_ >= text_.size()) return false;
+        char c = text_[pos_];
+        if (c == '{' || c == '[') {
+            char close = c == '{' ? '}' : ']';
+            ++pos_;
+            skip_space();
+            if (pos_ < text_.size() && text_[pos_] == close) {
+                ++pos_;
+                return true;
+            }
+            for (;;) {
+                std::string child = key;
+                if (c == '{') {
+                    std::string name;
+                    skip_space();
+                    if (!string(name)) return false;
+                    skip_space();
+                    if (pos_ >= text_.size() || text_[pos_++] != ':') return false;
+                    child = key.empty() ? name : key + "." + name;
+                }
+                if (!value(c == '{' ? child : std::string(), values)) return false;
+                skip_space();
+                if (pos_ >= text_.size()) return false;
+                char next = text_[pos_++];
+                if (next == close) return true;
+                if (next != ',') return false;
+            }
+        }
+        if (c == '"') {
+            std::string ignored;
+            return string(ignored);
+        }
+        size_t end = pos_;
+        while (end < text_.size() && std::string_view("+-.0123456789eEtruefalsn").find(text_[end]) != std::string_view::npos) ++end;
+        std::string token = text_.substr(pos_, end - pos_);
+        pos_ = end;
+        if (token == "true" || token == "false" || token == "null") return true;
+        try {
+            if (!key.empty()) values[key] = std::stod(token);
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+
+    std::string text_;
+    size_t pos_ = 0;
+};
+
+bool load_results(const std::string& path, Results& results, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::map<std::string, double> values;
+    if (!JsonReader(buffer.str()).read(values)) {
+        error = "malformed JSON in " + path;
+        return false;
+    }
+    static const std::string prefix = "workloads.";
+    for (const auto& [key, value] : values) {
+        if (key.rfind(prefix, 0) != 0) continue;
+        size_t dot = key.find('.', prefix.size());
+        if (dot == std::string::npos) continue;
+        results[key.substr(prefix.size(), dot - prefix.size())][key.substr(dot + 1)] = value;
+    }
+    return true;
+}
+
+bool write_results(const std::string& path, const Results& results, const PerfOptions& options) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"duration_s\": " << options.duration.count()
+        << ",\n  \"idle_connections\": " << options.idle_connections
+        << ",\n  \"workloads\": {";
+    const char* separator = "\n";
+    for (const auto& [workload, metrics] : results) {
+        out << separator << "    \"" << workload << "\": {";
+        const char* inner = "\n";
+        for (const auto& [name, value] : metrics) {
+            out << inner << "      \"" << name << "\": " << value;
+            inner = ",\n";
+        }
+        out << "\n    }";
+        separator = ",\n";
+    }
+    out << "\n  }\n}\n";
+    return static_cast<bool>(out);
+}
+
+// Сравнение с базой: true, если регрессий нет
+bool compare(const std::vector<WorkloadResult>& current, const Results& baseline, double tolerance) {
+    bool passed = true;
+    std::cout << std::left << std::setw(16) << "workload" << std::setw(26) << "metric"
+              << std::right << std::setw(14) << "baseline" << std::setw(14) << "current"
+              << std::setw(10) << "change" << "  status" << std::endl;
+
+    for (const auto& result : current) {
+        auto workload = baseline.find(result.name);
+        for (const auto& metric : result.metrics) {
+            std::cout << std::left << std::setw(16) << result.name << std::setw(26) << metric.name << std::right
+                      << std::fixed << std::setprecision(2);
+            if (workload == baseline.end() || !workload->second.count(metric.name)) {
+                std::cout << std::setw(14) << "-" << std::setw(14) << metric.value << std::setw(10) << "-"
+                          << "  new" << std::endl;
+                continue;
+            }
+            double base = workload->second.at(metric.name);
+            bool regressed = metric.better == Better::Higher
+                ? metric.value < base * (1.0 - tolerance) - metric.slack
+                : metric.value > base * (1.0 + tolerance) + metric.slack;
+            passed = passed && !regressed;
+
+            std::cout << std::setw(14) << base << std::setw(14) << metric.value;
+            if (base != 0) {
+                std::ostringstream change;
+                change << std::showpos << std::fixed << std::setprecision(1) << (metric.value - base) / std::fabs(base) * 100 << '%';
+                std::cout << std::setw(10) << change.str();
+            } else {
+                std::cout << std::setw(10) << "-";
+            }
+            std::cout << (regressed ? "  REGRESSION" : "  ok") << std::endl;
+        }
+    }
+    return passed;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --server <path>         server binary (build/async_tcp_udp_server)\n"
+              << "  --config <path>         server config (tests/perf/server.conf)\n"
+              << "  --port <port>           loopback port (9300)\n"
+              << "  --baseline <path>       baseline JSON (tests/perf/baseline.json)\n"
+              << "  --output <path>         results JSON (build/perf.json)\n"
+              << "  --tolerance <fraction>  allowed relative regression (0.2)\n"
+              << "  --duration <seconds>    measured time per workload (3)\n"
+              << "  --warmup <seconds>      warmup per generator workload (1)\n"
+              << "  --idle <count>          idle connections (2000)\n"
+              << "  --workloads <list>      comma-separated subset of churn,idle,pipelined_echo,udp_flood,mixed_commands\n"
+              << "  --update-baseline       store results as the new baseline\n";
+}
+
+bool parse_args(int argc, char* argv[], PerfOptions& options) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--update-baseline") {
+                options.update_baseline = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                return false;
+            }
+            std::string value = argv[++i];
+            if (arg == "--server") {
+                options.server = value;
+            } else if (arg == "--config") {
+                options.config = value;
+            } else if (arg == "--port") {
+                options.port = static_cast<uint16_t>(std::stoi(value));
+            } else if (arg == "--baseline") {
+                options.baseline = value;
+            } else if (arg == "--output") {
+                options.output = value;
+            } else if (arg == "--tolerance") {
+                options.tolerance = std::stod(value);
+            } else if (arg == "--duration") {
+                options.duration = std::chrono::seconds(std::stoul(value));
+            } else if (arg == "--warmup") {
+                options.warmup = std::chrono::seconds(std::stoul(value));
+            } else if (arg == "--idle") {
+                options.idle_connections = std::stoul(value);
+            } else if (arg == "--workloads") {
+                std::stringstream list(value);
+                std::string name;
+                while (std::getline(list, name, ',')) {
+                    if (!name.empty()) options.workloads.push_back(name);
+                }
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return options.duration.count() > 0;
+}
+
+bool selected(const PerfOptions& options, const std::string& name) {
+    if (options.workloads.empty()) return true;
+    return std::find(options.workloads.begin(), options.workloads.end(), name) != options.workloads.end();
+}
+
+// Сервер и генератор держат тысячи сокетов; сервер наследует лимит
+void raise_fd_limit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    PerfOptions options;
+    if (!parse_args(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    for (const auto& name : options.workloads) {
+        bool known = false;
+        for (const auto& workload : workloads()) known = known || name == workload.name;
+        if (!known) {
+            std::cerr << "Error: unknown workload " << name << std::endl;
+            return 2;
+        }
+    }
+    raise_fd_limit();
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<WorkloadResult> current;
+    for (const auto& workload : workloads()) {
+        if (!selected(options, workload.name)) continue;
+
+        std::cout << "=== " << workload.name << " ===" << std::endl;
+        ServerProcess server;
+        std::string error;
+        if (!server.start(options, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 2;
+        }
+        WorkloadResult result{workload.name, {}};
+        if (!workload.run(options, server, result, error)) {
+            std::cerr << "Error: " << workload.name << ": " << error << std::endl;
+            return 2;
+        }
+        current.push_back(std::move(result));
+    }
+
+    Results results;
+    for (const auto& result : current) {
+        for (const auto& metric : result.metrics) {
+            results[result.name][metric.name] = metric.value;
+        }
+    }
+    if (!write_results(options.output, results, options)) {
+        std::cerr << "Error: cannot write " << options.output << std::endl;
+        return 2;
+    }
+    std::cout << "Results written to " << options.output << std::endl;
+
+    Results baseline;
+    std::string error;
+    bool have_baseline = load_results(options.baseline, baseline, error);
+    if (!have_baseline && access(options.baseline.c_str(), F_OK) == 0) {
+        std::cerr << "Error: " << error << std::endl;
+        return 2;
+    }
+
+    if (options.update_baseline || !have_baseline) {
+        // Сценарии, не попавшие в --workloads, сохраняют прежние значения
+        for (auto& [workload, metrics] : results) {
+            baseline[workload] = metrics;
+        }
+        if (!write_results(options.baseline, baseline, options)) {
+            std::cerr << "Error: cannot write " << options.baseline << std::endl;
+            return 2;
+        }
+        std::cout << "Baseline " << (have_baseline ? "updated" : "created") << ": " << options.baseline << std::endl;
+        return 0;
+    }
+
+    bool passed = compare(current, baseline, options.tolerance);
+    std::cout << (passed ? "PASSED" : "FAILED") << " (tolerance " << std::setprecision(0)
+              << options.tolerance * 100 << "%)" << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+#!/bin/bash
+# Обучающая нагрузка для PGO: инструментированный сервер на loopback,
+# смесь TCP/UDP-команд и эхо разных размеров, конвейер, много соединений
+# и churn. Профиль (.gcda) записывается при штатном завершении сервера.
+# Использование: pgo_train.sh <server> <client_app> [port]
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+SERVER="$1"
+CLIENT="$2"
+PORT="${3:-9310}"
+HOST="127.0.0.1"
+LOG="$(dirname "$SERVER")/pgo_train.log"
+
+if [ ! -x "$SERVER" ] || [ ! -x "$CLIENT" ]; then
+    echo "Usage: $0 <server> <client_app> [port]"
+    exit 1
+fi
+
+unset SERVER_PORT ADMIN_PORT SIGNAL_MODE STATS_SHM SERVER_CONFIG
+"$SERVER" --config "$SCRIPT_DIR/server.conf" "$PORT" > "$LOG" 2>&1 &
+SERVER_PID=$!
+trap 'kill -TERM $SERVER_PID 2>/dev/null || true' EXIT
+
+for i in {1..50}; do
+    if (exec 3<>/dev/tcp/$HOST/$PORT) 2>/dev/null; then
+        break
+    fi
+    sleep 0.1
+done
+
+bench() {
+    echo "  bench $*"
+    "$CLIENT" bench "$@" --warmup 0 > /dev/null
+}
+
+bench tcp $HOST "$PORT" --connections 32 --pipeline 8 --duration 3 \
+    --mix time:2,stats:1,echo16:8,echo256:4,echo4096:1
+bench udp $HOST "$PORT" --connections 8 --pipeline 8 --duration 2 \
+    --mix time:1,stats:1,echo16:4,echo512:2
+bench tcp $HOST "$PORT" --connections 512 --pipeline 1 --rate 20000 --duration 2 \
+    --mix echo64:4,time:1
+
+# Соединение на запрос: accept/close и команды, которых нет в bench
+echo "  churn"
+COMMANDS=("/time" "/stats" "/sessions traffic 5" "/sessions idle" "/unknown" "hello")
+for i in $(seq 1 1500); do
+    exec 3<>/dev/tcp/$HOST/$PORT
+    echo "${COMMANDS[$((i % ${#COMMANDS[@]}))]}" >&3
+    read -r -u 3 _
+    exec 3>&-
+done
+
+trap - EXIT
+kill -TERM $SERVER_PID
+wait $SERVER_PID
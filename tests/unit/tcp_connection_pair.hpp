@@ -0,0 +1,54 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+
+#include "../../server/tcp_connection.hpp"
+
+// TcpConnection поверх socketpair: fds[0] - неблокирующий конец сервера,
+// fds[1] - клиент, которым тест пишет запросы и читает ответы
+class TcpConnectionPairTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        settings.on_want_write = [this](int, bool want) { want_write = want; };
+    }
+
+    void TearDown() override {
+        if (connection) {
+            connection.reset();
+        } else {
+            close(fds[0]);
+        }
+        close(fds[1]);
+    }
+
+    // Соединение читает settings при каждом вызове: их можно менять и после open
+    void open() {
+        connection = std::make_unique<TcpConnection>(fds[0], sockaddr_in{}, nullptr, &settings);
+    }
+
+    // Вычитывает всё, что уже дошло до клиента; received - куда дописать байты
+    size_t drain_peer(std::string* received = nullptr) {
+        char buffer[65536];
+        size_t total = 0;
+        ssize_t n;
+        while ((n = recv(fds[1], buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            total += static_cast<size_t>(n);
+            if (received) {
+                received->append(buffer, static_cast<size_t>(n));
+            }
+        }
+        return total;
+    }
+
+    int fds[2] = {-1, -1};
+    TcpSettings settings;
+    bool want_write = false;
+    std::unique_ptr<TcpConnection> connection;
+};
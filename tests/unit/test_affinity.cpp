@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../server/affinity.hpp"
+
+TEST(AffinityTest, ParsesAndFormatsCpuLists) {
+    std::vector<int> cpus;
+    std::string error;
+    ASSERT_TRUE(parse_cpu_list(" 8, 0-3 ,2 ", cpus, error)) << error;
+    EXPECT_EQ(cpus, (std::vector<int>{0, 1, 2, 3, 8}));
+    EXPECT_EQ(format_cpu_list(cpus), "0-3,8");
+
+    ASSERT_TRUE(parse_cpu_list("", cpus, error));
+    EXPECT_TRUE(cpus.empty());
+
+    EXPECT_FALSE(parse_cpu_list("1-", cpus, error));
+    EXPECT_FALSE(parse_cpu_list("a", cpus, error));
+    EXPECT_FALSE(parse_cpu_list("5-2", cpus, error));
+    EXPECT_FALSE(parse_cpu_list("100000", cpus, error));
+    EXPECT_FALSE(parse_cpu_list("node:999", cpus, error));
+    EXPECT_NE(error.find("NUMA node"), std::string::npos);
+}
+
+TEST(AffinityTest, NodeListMatchesCpuNode) {
+    if (cpu_node(0) < 0) {
+        GTEST_SKIP() << "no NUMA topology in sysfs";
+    }
+    int node = cpu_node(0);
+    std::vector<int> cpus;
+    std::string error;
+    ASSERT_TRUE(parse_cpu_list("node:" + std::to_string(node), cpus, error)) << error;
+    ASSERT_FALSE(cpus.empty());
+    for (int cpu : cpus) {
+        EXPECT_EQ(cpu_node(cpu), node);
+    }
+}
+
+TEST(AffinityTest, PinsThreadAndBindsMemory) {
+    // Последний из разрешённых процессу CPU (cgroup может ограничить набор)
+    cpu_set_t allowed;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    int target = CPU_SETSIZE - 1;
+    while (target > 0 && !CPU_ISSET(target, &allowed)) {
+        --target;
+    }
+    int cpu = -1;
+    std::string error;
+    std::thread thread([&] {
+        if (pin_thread(pthread_self(), {target}, error)) {
+            cpu = sched_getcpu();
+        }
+    });
+    thread.join();
+    ASSERT_TRUE(error.empty()) << error;
+    EXPECT_EQ(cpu, target);
+    EXPECT_FALSE(pin_thread(pthread_self(), {CPU_SETSIZE - 1}, error));
+
+    // mbind может быть запрещён в контейнере; проверяется только, что
+    // меньше страницы не привязывается и вызов не портит память
+    std::vector<char> small(16, 'x');
+    EXPECT_FALSE(bind_memory_to_node(small.data(), small.size(), 0));
+    std::vector<char> large(1 << 20, 'y');
+    bind_memory_to_node(large.data(), large.size(), 0);
+    EXPECT_EQ(large[12345], 'y');
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    set_incoming_cpu(fd, 0);
+    close(fd);
+}
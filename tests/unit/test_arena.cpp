@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../server/alloc_counter.hpp"
+#include "../../server/arena.hpp"
+#include "../../server/command_processor.hpp"
+#include "../../server/kv_store.hpp"
+#include "../../server/session_manager.hpp"
+
+TEST(RequestArenaTest, ResetReusesBufferAndCountsOverflow) {
+    RequestArena arena(1024);
+    void* first = arena.allocate(100, 8);
+    void* second = arena.allocate(200, 8);
+    EXPECT_NE(second, nullptr);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(arena.used(), 300u);
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_EQ(arena.allocate(100, 8), first);
+
+    EXPECT_NE(arena.allocate(4096, 8), nullptr);
+    arena.reset();
+    // Пустая итерация не считается сбросом
+    arena.reset();
+    RequestArena::Stats stats = arena.stats();
+    EXPECT_EQ(stats.resets, 2u);
+    EXPECT_EQ(stats.bytes, 300u + 100u + 4096u);
+    EXPECT_EQ(stats.overflows, 1u);
+    EXPECT_EQ(stats.high_water, 4196u);
+    EXPECT_EQ(arena.allocate(16, 8), first);
+}
+
+TEST(RequestArenaTest, SteadyStateCommandsDoNotTouchHeap) {
+    SessionManager session_manager;
+    KvStore store;
+    std::vector<std::unique_ptr<Command>> commands;
+    commands.push_back(std::make_unique<TimeCommand>());
+    commands.push_back(std::make_unique<StatsCommand>(session_manager));
+    commands.push_back(std::make_unique<SetCommand>(store));
+    commands.push_back(std::make_unique<GetCommand>(store));
+    commands.push_back(std::make_unique<IncrCommand>(store));
+    commands.push_back(std::make_unique<MgetCommand>(store));
+    CommandProcessor processor(std::move(commands));
+    RequestArena arena;
+
+    const std::vector<std::string> requests = {
+        "Hello, world", "/time", "/stats", "/set user:1 Alice", "/get user:1",
+        "/incr hits", "/mget user:1 hits missing", "/get missing", "/nosuchcommand",
+    };
+    auto run = [&] {
+        for (const auto& request : requests) {
+            auto response = processor.process_command(request, nullptr, &arena);
+            EXPECT_FALSE(response.empty()) << request;
+        }
+        arena.reset();
+    };
+    // Первый проход создаёт ключи и метрики команд
+    run();
+
+    uint64_t before = thread_allocations();
+    for (int i = 0; i < 100; ++i) {
+        run();
+    }
+    EXPECT_EQ(thread_allocations() - before, 0u);
+    EXPECT_EQ(processor.process_command("/get user:1", nullptr, &arena), "Alice");
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../client/async_client.hpp"
+#include "../../server/command.hpp"
+#include "../../server/command_processor.hpp"
+#include "../../server/kv_store.hpp"
+
+TEST(AsyncClientFramingTest, CountsLinesPerCommand) {
+    EXPECT_EQ(tcp_response_length("hello", "hel"), 0u);
+    EXPECT_EQ(tcp_response_length("hello", "hello\nnext"), 6u);
+
+    std::string sessions = "Active sessions: 3, top 2 by traffic\na\nb\n";
+    EXPECT_EQ(tcp_response_length("/sessions", sessions), sessions.size());
+    EXPECT_EQ(tcp_response_length("/sessions", sessions.substr(0, sessions.size() - 1)), 0u);
+    EXPECT_EQ(tcp_response_length("/sessions", "ERROR: Usage: /sessions [traffic|idle] [N]\n"), 43u);
+}
+
+// Ответ, как его отправляет сервер, и следующий за ним в потоке
+TEST(AsyncClientFramingTest, FramesServerStatsReply) {
+    SessionManager sessions;
+    OverloadController overload;
+    const OverloadController* controllers[] = {&overload, nullptr};
+    for (const OverloadController* controller : controllers) {
+        StatsCommand stats(sessions, controller);
+        std::string reply(stats.execute(CommandContext{}));
+        reply.push_back('\n');
+        EXPECT_EQ(static_cast<size_t>(std::count(reply.begin(), reply.end(), '\n')), StatsCommand::STATS_LINES);
+        EXPECT_EQ(tcp_response_length("/stats", reply + "hello\n"), reply.size()) << reply;
+        EXPECT_EQ(tcp_response_length("/stats", reply.substr(0, reply.size() - 1)), 0u);
+    }
+}
+
+TEST(AsyncClientFramingTest, FramesServerLatencyReply) {
+    CommandProcessor* processor = nullptr;
+    std::vector<std::unique_ptr<Command>> commands;
+    commands.push_back(std::make_unique<TimeCommand>());
+    commands.push_back(std::make_unique<LatencyCommand>([&processor](std::string_view command) {
+        return processor->latency_report(command);
+    }));
+    CommandProcessor owner(std::move(commands));
+    processor = &owner;
+
+    auto frame = [&](std::string_view request) {
+        std::string reply(processor->process_command(request));
+        reply.push_back('\n');
+        EXPECT_EQ(tcp_response_length("/latency", reply + "hello\n"), reply.size()) << reply;
+        return static_cast<size_t>(std::count(reply.begin(), reply.end(), '\n'));
+    };
+    EXPECT_EQ(frame("/latency"), 1u);
+
+    // По запросу из выборки на эхо и /time: заголовок и две строки
+    for (std::string_view request : {"hello", "/time"}) {
+        RequestSample sample{monotonic_ns(), monotonic_ns()};
+        RequestSample::set_current(&sample);
+        processor->process_command(request);
+        RequestSample::set_current(nullptr);
+        sample.queued = monotonic_ns();
+        sample.record(monotonic_ns());
+    }
+    EXPECT_EQ(frame("/latency"), 3u);
+    EXPECT_EQ(frame("/latency time"), 2u);
+}
+
+TEST(AsyncClientFramingTest, FramesServerMgetReply) {
+    KvStore store(1);
+    std::vector<std::unique_ptr<Command>> commands;
+    commands.push_back(std::make_unique<SetCommand>(store));
+    commands.push_back(std::make_unique<MgetCommand>(store));
+    CommandProcessor processor(std::move(commands));
+    processor.process_command("/set user:1 Alice");
+
+    // Ответ /mget a b перед /time не должен отдать вторую строку ответу /time
+    for (std::string_view request : {"/mget user:1", "/mget missing user:1 other", "/mget"}) {
+        std::string reply(processor.process_command(request));
+        reply.push_back('\n');
+        EXPECT_EQ(tcp_response_length("/mget", reply + "12:00:00\n"), reply.size()) << reply;
+        EXPECT_EQ(tcp_response_length("/mget", reply.substr(0, reply.size() - 1)), 0u) << reply;
+    }
+}
+
+namespace {
+
+// Однопоточный поддельный сервер на loopback: ответы пишет сам тест
+class FakeServer {
+public:
+    FakeServer() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(listen_fd_, 4);
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+    }
+    ~FakeServer() {
+        if (client_fd_ != -1) close(client_fd_);
+        close(listen_fd_);
+    }
+
+    uint16_t port() const { return port_; }
+    void accept_client() {
+        if (client_fd_ != -1) close(client_fd_);
+        client_fd_ = accept(listen_fd_, nullptr, nullptr);
+    }
+    void write(const std::string& data) {
+        ASSERT_EQ(::send(client_fd_, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+    }
+    std::string read() {
+        char buffer[1024];
+        ssize_t n = recv(client_fd_, buffer, sizeof(buffer), 0);
+        return n > 0 ? std::string(buffer, static_cast<size_t>(n)) : std::string();
+    }
+
+private:
+    int listen_fd_ = -1;
+    int client_fd_ = -1;
+    uint16_t port_ = 0;
+};
+
+void run_until(AsyncTcpClient& client, const std::function<bool()>& done) {
+    for (int i = 0; i < 100 && !done(); ++i) {
+        client.run_once(10);
+    }
+}
+
+} // namespace
+
+TEST(AsyncClientTest, CorrelatesPipelinedResponses) {
+    FakeServer server;
+    AsyncClientOptions options;
+    options.pool_size = 1;
+    AsyncTcpClient client("127.0.0.1", server.port(), options);
+    server.accept_client();
+
+    std::vector<std::string> responses;
+    auto collect = [&](AsyncResponse&& response) {
+        EXPECT_TRUE(response.ok());
+        responses.push_back(response.body);
+    };
+    ASSERT_TRUE(client.request("first", collect));
+    ASSERT_TRUE(client.request("/stats", collect));
+    ASSERT_TRUE(client.request("third\n", collect));
+    int iterations = 0;
+    run_until(client, [&] { return ++iterations > 3; });
+
+    std::string received;
+    while (received.size() < 19) received += server.read();
+    EXPECT_EQ(received, "first\n/stats\nthird\n");
+
+    // Слитые и разрезанные ответы: рамки восстанавливаются по командам
+    server.write("first\nTotal: 1\n");
+    run_until(client, [&] { return responses.size() == 1; });
+    server.write("Current: 1\nOverload state: normal\nOverload time (ms): -\nthi");
+    run_until(client, [&] { return responses.size() == 2; });
+    server.write("rd\n");
+    run_until(client, [&] { return responses.size() == 3; });
+
+    ASSERT_EQ(responses.size(), 3u);
+    EXPECT_EQ(responses[0], "first");
+    EXPECT_EQ(responses[1], "Total: 1\nCurrent: 1\nOverload state: normal\nOverload time (ms): -");
+    EXPECT_EQ(responses[2], "third");
+    EXPECT_EQ(client.pending(), 0u);
+}
+
+TEST(AsyncClientTest, RejectsSubscribeOnPooledConnections) {
+    FakeServer server;
+    AsyncClientOptions options;
+    options.pool_size = 1;
+    AsyncTcpClient client("127.0.0.1", server.port(), options);
+    server.accept_client();
+
+    AsyncStatus status = AsyncStatus::Ok;
+    bool done = false;
+    ASSERT_TRUE(client.request("/subscribe news", [&](AsyncResponse&& response) {
+        status = response.status;
+        done = true;
+    }));
+    run_until(client, [&] { return done; });
+    EXPECT_EQ(status, AsyncStatus::Error);
+    EXPECT_EQ(client.pending(), 0u);
+
+    // До сервера уходит только следующий запрос
+    ASSERT_TRUE(client.request("/unsubscribe", nullptr));
+    int iterations = 0;
+    run_until(client, [&] { return ++iterations > 3; });
+    EXPECT_EQ(server.read(), "/unsubscribe\n");
+}
+
+TEST(AsyncClientTest, TimesOutAndReconnects) {
+    FakeServer server;
+    AsyncClientOptions options;
+    options.pool_size = 1;
+    options.timeout = std::chrono::milliseconds(30);
+    AsyncTcpClient client("127.0.0.1", server.port(), options);
+    server.accept_client();
+
+    AsyncStatus status = AsyncStatus::Ok;
+    bool done = false;
+    client.request("/time", [&](AsyncResponse&& response) {
+        status = response.status;
+        done = true;
+    });
+    run_until(client, [&] { return done; });
+    EXPECT_TRUE(done);
+    EXPECT_EQ(status, AsyncStatus::Timeout);
+
+    // Следующий запрос уходит по новому соединению
+    done = false;
+    client.request("again", [&](AsyncResponse&& response) {
+        status = response.status;
+        done = true;
+    });
+    server.accept_client();
+    int iterations = 0;
+    run_until(client, [&] { return ++iterations > 3; });
+    EXPECT_EQ(server.read(), "again\n");
+    server.write("again\n");
+    run_until(client, [&] { return done; });
+    EXPECT_EQ(status, AsyncStatus::Ok);
+}
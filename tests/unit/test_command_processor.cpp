@@ -16,6 +16,7 @@ protected:
         commands.push_back(std::make_unique<TimeCommand>());
         commands.push_back(std::make_unique<StatsCommand>(*session_manager));
         commands.push_back(std::make_unique<ShutdownCommand>());
+        commands.push_back(std::make_unique<SessionsCommand>(*session_manager));
         
         processor = std::make_unique<CommandProcessor>(std::move(commands));
     }
@@ -25,7 +26,7 @@ protected:
 };
 
 TEST_F(CommandProcessorTest, ProcessTimeCommand) {
-    std::string result = processor->process_command("/time");
+    auto result = processor->process_command("/time");
     EXPECT_EQ(result.size(), 19);
     EXPECT_EQ(result[4], '-');
     EXPECT_EQ(result[7], '-');
@@ -37,7 +38,7 @@ TEST_F(CommandProcessorTest, ProcessTimeCommand) {
 TEST_F(CommandProcessorTest, ProcessStatsCommand) {
     session_manager->add_connection();
     
-    std::string result = processor->process_command("/stats");
+    auto result = processor->process_command("/stats");
     EXPECT_NE(result.find("Total connections"), std::string::npos);
     EXPECT_NE(result.find("Current connections"), std::string::npos);
     EXPECT_NE(result.find("1"), std::string::npos); 
@@ -46,23 +47,38 @@ TEST_F(CommandProcessorTest, ProcessStatsCommand) {
 }
 
 TEST_F(CommandProcessorTest, ProcessShutdownCommand) {
-    std::string result = processor->process_command("/shutdown");
+    auto result = processor->process_command("/shutdown");
     EXPECT_EQ(result, "/SHUTDOWN_ACK");
 }
 
 TEST_F(CommandProcessorTest, ProcessUnknownCommand) {
-    std::string result = processor->process_command("/unknown");
+    auto result = processor->process_command("/unknown");
 
     EXPECT_EQ(result, "ERROR: Unknown command '/unknown'");
 
 }
 
+TEST_F(CommandProcessorTest, ProcessSessionsCommand) {
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(4242);
+    peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int slot = session_manager->sessions().open(peer);
+    session_manager->sessions().record_read(slot, 64, 1);
+
+    auto result = processor->process_command("/sessions traffic 5");
+    EXPECT_NE(result.find("Active sessions: 1"), std::string::npos);
+    EXPECT_NE(result.find("127.0.0.1:4242 bytes_in=64"), std::string::npos);
+
+    EXPECT_EQ(processor->process_command("/sessions bogus"), "ERROR: Usage: /sessions [traffic|idle] [N]");
+}
+
 TEST_F(CommandProcessorTest, ProcessEchoMessage) {
-    std::string result = processor->process_command("Hello World");
+    auto result = processor->process_command("Hello World");
     EXPECT_EQ(result, "Hello World");
 }
 
 TEST_F(CommandProcessorTest, ProcessEmptyMessage) {
-    std::string result = processor->process_command("");
+    auto result = processor->process_command("");
     EXPECT_EQ(result, "");
 }
\ No newline at end of file
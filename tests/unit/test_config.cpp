@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "../../server/config.hpp"
+
+TEST(ConfigTest, ParsesExampleFormat) {
+    std::istringstream in(
+        "# comment\n"
+        "port=9090\n"
+        "log_level = warning\n"
+        "max_connections=50   # inline comment\n"
+        "tcp_timeout=30\n"
+        "tcp_buffer_size=8192\n"
+        "udp_buffer_size=2048\n"
+        "drain_timeout=5\n"
+        "upgrade_timeout=10\n"
+        "subscriber_policy=disconnect\n"
+        "subscriber_queue_limit=16\n"
+        "journal_dir=/var/lib/journal\n"
+        "journal_fsync=batch\n"
+        "upstreams=127.0.0.1:7001, 10.0.0.2:7002\n"
+        "upstream_prefix=/api\n"
+        "reactor_cpus=4, 0-2\n"
+        "tcp_workers=4\n"
+        "worker_placement=least_loaded\n"
+        "overload_lag_ms=0\n"
+        "overload_connections=500\n"
+        "socket_timestamps=rx_tx\n"
+        "latency_sample_rate=100\n"
+        "\n");
+
+    ServerConfig config;
+    std::string error;
+    ASSERT_TRUE(parse_config(in, config, error)) << error;
+    EXPECT_EQ(config.port, 9090);
+    EXPECT_EQ(config.log_level, "warning");
+    EXPECT_EQ(config.max_connections, 50u);
+    EXPECT_EQ(config.tcp_timeout, std::chrono::seconds(30));
+    EXPECT_EQ(config.tcp_buffer_size, 8192u);
+    EXPECT_EQ(config.udp_buffer_size, 2048u);
+    EXPECT_EQ(config.drain_timeout, std::chrono::seconds(5));
+    EXPECT_EQ(config.upgrade_timeout, std::chrono::seconds(10));
+    EXPECT_EQ(config.subscriber_policy, SlowSubscriberPolicy::Disconnect);
+    EXPECT_EQ(config.subscriber_queue_limit, 16u);
+    EXPECT_EQ(config.journal_dir, "/var/lib/journal");
+    EXPECT_EQ(config.journal_fsync, JournalFsync::Batch);
+    ASSERT_EQ(config.upstreams.size(), 2u);
+    EXPECT_EQ(config.upstreams[1], "10.0.0.2:7002");
+    EXPECT_EQ(config.upstream_prefix, "/api");
+    EXPECT_EQ(config.reactor_cpus, (std::vector<int>{0, 1, 2, 4}));
+    EXPECT_TRUE(config.logger_cpus.empty());
+    EXPECT_EQ(config.tcp_workers, 4u);
+    EXPECT_EQ(config.worker_placement, PlacementPolicy::LeastLoaded);
+    EXPECT_EQ(config.overload_lag, std::chrono::milliseconds(0));
+    EXPECT_EQ(config.overload_connections, 500u);
+    EXPECT_EQ(config.socket_timestamps, SocketTimestamps::RxTx);
+    EXPECT_EQ(config.latency_sample_rate, 100u);
+}
+
+TEST(ConfigTest, RejectsInvalidValues) {
+    ServerConfig config;
+    std::string error;
+
+    std::istringstream bad_number("max_connections=lots\n");
+    EXPECT_FALSE(parse_config(bad_number, config, error));
+    EXPECT_NE(error.find("line 1"), std::string::npos);
+
+    std::istringstream no_equals("port 8080\n");
+    EXPECT_FALSE(parse_config(no_equals, config, error));
+
+    std::istringstream bad_level("log_level=verbose\n");
+    EXPECT_FALSE(parse_config(bad_level, config, error));
+
+    std::istringstream bad_policy("subscriber_policy=block\n");
+    EXPECT_FALSE(parse_config(bad_policy, config, error));
+
+    std::istringstream bad_upstream("upstreams=127.0.0.1:7001,,\n");
+    EXPECT_FALSE(parse_config(bad_upstream, config, error));
+
+    std::istringstream bad_cpus("reactor_cpus=3-1\n");
+    EXPECT_FALSE(parse_config(bad_cpus, config, error));
+
+    std::istringstream bad_placement("worker_placement=random\n");
+    EXPECT_FALSE(parse_config(bad_placement, config, error));
+}
+
+TEST(ConfigTest, UnknownKeysAreWarnings) {
+    std::istringstream in("colour=blue\nport=1234\n");
+    ServerConfig config;
+    std::string error;
+    std::vector<std::string> warnings;
+
+    ASSERT_TRUE(parse_config(in, config, error, &warnings));
+    ASSERT_EQ(warnings.size(), 1u);
+    EXPECT_NE(warnings[0].find("colour"), std::string::npos);
+    EXPECT_EQ(config.port, 1234);
+}
+
+TEST(ConfigTest, ResolvesStatsSegmentName) {
+    ServerConfig config;
+    config.port = 8080;
+    resolve_config_defaults(config);
+    EXPECT_EQ(config.stats_shm_name, "/async_tcp_udp_server.8080");
+    EXPECT_EQ(config.trace_file, "async_tcp_udp_server.8080.trace.json");
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "../../client/hdr_histogram.hpp"
+
+TEST(HdrHistogramTest, SmallValuesAreExact) {
+    HdrHistogram histogram;
+    for (uint64_t v = 1; v <= 100; ++v) {
+        histogram.record(v);
+    }
+
+    EXPECT_EQ(histogram.count(), 100u);
+    EXPECT_EQ(histogram.min(), 1u);
+    EXPECT_EQ(histogram.max(), 100u);
+    EXPECT_EQ(histogram.value_at_percentile(50), 50u);
+    EXPECT_EQ(histogram.value_at_percentile(99), 99u);
+    EXPECT_EQ(histogram.value_at_percentile(100), 100u);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 50.5);
+}
+
+TEST(HdrHistogramTest, LargeValuesKeepRelativePrecision) {
+    HdrHistogram histogram;
+    const uint64_t values[] = {12345, 1234567, 123456789, 12345678901ULL};
+    for (uint64_t v : values) {
+        histogram.reset();
+        histogram.record(v);
+        uint64_t reported = histogram.value_at_percentile(50);
+        EXPECT_GE(reported, v - v / 1000) << v;
+        EXPECT_LE(reported, v + v / 1000) << v;
+    }
+}
+
+TEST(HdrHistogramTest, MergeAndClampToHighest) {
+    HdrHistogram a(1000000);
+    HdrHistogram b(1000000);
+    a.record(10, 3);
+    b.record(5000000);  // выше highest_value
+
+    a.merge(b);
+    EXPECT_EQ(a.count(), 4u);
+    EXPECT_EQ(a.max(), 1000000u);
+    EXPECT_EQ(a.value_at_percentile(75), 10u);
+
+    uint64_t buckets = 0;
+    a.for_each_bucket([&](uint64_t, uint64_t count) { buckets += count; });
+    EXPECT_EQ(buckets, 4u);
+}
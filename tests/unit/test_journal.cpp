@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../../server/journal.hpp"
+
+namespace {
+
+class JournalTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char pattern[] = "/tmp/journal_test.XXXXXX";
+        ASSERT_NE(mkdtemp(pattern), nullptr);
+        dir = pattern;
+        peer.sin_family = AF_INET;
+        peer.sin_addr.s_addr = htonl(0x7f000001);
+        peer.sin_port = htons(40000);
+    }
+
+    void TearDown() override {
+        for (const auto& path : Journal::list_segments(dir)) {
+            unlink(path.c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    std::vector<std::string> read_all() {
+        std::vector<std::string> payloads;
+        for (const auto& path : Journal::list_segments(dir)) {
+            JournalReader reader;
+            std::string error;
+            EXPECT_TRUE(reader.open(path, error)) << error;
+            JournalRecord record;
+            while (reader.next(record)) {
+                payloads.emplace_back(record.payload);
+            }
+            EXPECT_FALSE(reader.corrupt());
+        }
+        return payloads;
+    }
+
+    std::string dir;
+    sockaddr_in peer{};
+};
+
+} // namespace
+
+TEST_F(JournalTest, RecordsRoundTrip) {
+    Journal journal;
+    std::string error;
+    ASSERT_TRUE(journal.open(dir, Journal::MIN_SEGMENT_SIZE, error)) << error;
+    journal.set_fsync(JournalFsync::Batch, std::chrono::milliseconds(1000));
+
+    EXPECT_TRUE(journal.append(0, peer, "/set a 1"));
+    EXPECT_TRUE(journal.append(1, peer, ""));
+    journal.commit();
+    EXPECT_TRUE(journal.append(0, peer, "hello"));
+    journal.commit();
+    journal.commit();
+
+    JournalStats stats = journal.stats();
+    EXPECT_EQ(stats.records, 3u);
+    EXPECT_EQ(stats.commits, 2u);
+    EXPECT_EQ(stats.syncs, 2u);
+
+    JournalReader reader;
+    ASSERT_TRUE(reader.open(journal.segment_path(), error)) << error;
+    JournalRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.payload, "/set a 1");
+    EXPECT_EQ(record.protocol, 0);
+    EXPECT_EQ(ntohs(record.peer.sin_port), 40000);
+    EXPECT_EQ(record.peer.sin_addr.s_addr, peer.sin_addr.s_addr);
+    EXPECT_GT(record.timestamp_ns, 0u);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.payload, "");
+    EXPECT_EQ(record.protocol, 1);
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.payload, "hello");
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_FALSE(reader.corrupt());
+    EXPECT_EQ(reader.header().committed, reader.offset());
+}
+
+TEST_F(JournalTest, RotatesSegmentsAndNeverReusesOldFiles) {
+    std::string payload(100 * 1024, 'p');
+    {
+        Journal journal;
+        std::string error;
+        ASSERT_TRUE(journal.open(dir, Journal::MIN_SEGMENT_SIZE, error)) << error;
+        for (int i = 0; i < 25; ++i) {
+            payload[0] = static_cast<char>('a' + i);
+            ASSERT_TRUE(journal.append(0, peer, payload));
+            journal.commit();
+        }
+        EXPECT_EQ(journal.stats().segments, 3u);
+    }
+    {
+        Journal journal;
+        std::string error;
+        ASSERT_TRUE(journal.open(dir, Journal::MIN_SEGMENT_SIZE, error)) << error;
+        EXPECT_NE(journal.segment_path().find(Journal::segment_name(3)), std::string::npos);
+        ASSERT_TRUE(journal.append(0, peer, "after restart"));
+    }
+
+    auto payloads = read_all();
+    ASSERT_EQ(payloads.size(), 26u);
+    for (int i = 0; i < 25; ++i) {
+        EXPECT_EQ(payloads[static_cast<size_t>(i)][0], 'a' + i);
+    }
+    EXPECT_EQ(payloads.back(), "after restart");
+}
+
+TEST_F(JournalTest, DetectsDamagedRecord) {
+    std::string path;
+    {
+        Journal journal;
+        std::string error;
+        ASSERT_TRUE(journal.open(dir, Journal::MIN_SEGMENT_SIZE, error)) << error;
+        journal.append(0, peer, "first");
+        journal.append(0, peer, "second");
+        path = journal.segment_path();
+    }
+
+    // Порча байта payload второй записи
+    int fd = open(path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    off_t second = sizeof(JournalSegmentHeader) + 32 + sizeof(JournalRecordHeader);
+    ASSERT_EQ(pwrite(fd, "X", 1, second), 1);
+    close(fd);
+
+    JournalReader reader;
+    std::string error;
+    ASSERT_TRUE(reader.open(path, error)) << error;
+    JournalRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.payload, "first");
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_TRUE(reader.corrupt());
+}
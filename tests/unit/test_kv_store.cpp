@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../server/command_processor.hpp"
+#include "../../server/kv_store.hpp"
+
+TEST(KvTableTest, GrowsAndReusesTombstones) {
+    KvTable table;
+    std::hash<std::string> hash;
+    for (int i = 0; i < 1000; ++i) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_FALSE(table.assign(key, hash(key), std::to_string(i), 0));
+    }
+    EXPECT_EQ(table.size(), 1000u);
+    EXPECT_GE(table.capacity(), 1000u * 4 / 3);
+
+    for (int i = 0; i < 1000; i += 2) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_TRUE(table.erase(key, hash(key)));
+    }
+    size_t capacity = table.capacity();
+    // Вставки и удаления без роста числа ключей не раздувают таблицу
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 1000; i += 2) {
+            std::string key = "tmp" + std::to_string(i);
+            table.assign(key, hash(key), "x", 0);
+            table.erase(key, hash(key));
+        }
+    }
+    EXPECT_EQ(table.capacity(), capacity);
+    EXPECT_EQ(table.size(), 500u);
+
+    const KvTable::Entry* entry = table.find("key999", hash(std::string("key999")), 0);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->value(), "999");
+    EXPECT_EQ(table.find("key998", hash(std::string("key998")), 0), nullptr);
+}
+
+TEST(KvStoreTest, InlineAndHeapValues) {
+    KvStore store(4);
+    std::string value;
+    std::string large(1000, 'v');
+
+    EXPECT_EQ(store.set("k", "small"), KvStore::Result::Ok);
+    EXPECT_EQ(store.set("k", large), KvStore::Result::Ok);
+    ASSERT_TRUE(store.get("k", value));
+    EXPECT_EQ(value, large);
+    EXPECT_EQ(store.set("k", "small again"), KvStore::Result::Ok);
+    ASSERT_TRUE(store.get("k", value));
+    EXPECT_EQ(value, "small again");
+
+    EXPECT_TRUE(store.del("k"));
+    EXPECT_FALSE(store.del("k"));
+    EXPECT_FALSE(store.get("k", value));
+    KvStats stats = store.stats();
+    EXPECT_EQ(stats.keys, 0u);
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 1u);
+}
+
+TEST(KvStoreTest, IncrAndLimits) {
+    KvStore store(2, 2);
+    int64_t value = 0;
+    EXPECT_EQ(store.incr("n", 5, value), KvStore::Result::Ok);
+    EXPECT_EQ(store.incr("n", -7, value), KvStore::Result::Ok);
+    EXPECT_EQ(value, -2);
+
+    store.set("s", "text");
+    EXPECT_EQ(store.incr("s", 1, value), KvStore::Result::NotInteger);
+    EXPECT_EQ(store.set("third", "x"), KvStore::Result::Full);
+    EXPECT_EQ(store.set("s", "replace is fine"), KvStore::Result::Ok);
+
+    store.set("s", "9223372036854775807");
+    EXPECT_EQ(store.incr("s", 1, value), KvStore::Result::Overflow);
+}
+
+TEST(KvStoreTest, ExpiresLazilyAndBySweep) {
+    KvStore store(2);
+    std::string value;
+    store.set("lazy", "1", 1);
+    store.set("swept", "2", 1);
+    store.set("kept", "3");
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    EXPECT_FALSE(store.get("lazy", value));
+    EXPECT_EQ(store.sweep_expired(1024), 1u);
+    EXPECT_TRUE(store.get("kept", value));
+    KvStats stats = store.stats();
+    EXPECT_EQ(stats.keys, 1u);
+    EXPECT_EQ(stats.expired, 2u);
+}
+
+TEST(KvStoreTest, Commands) {
+    KvStore store;
+    std::vector<std::unique_ptr<Command>> commands;
+    commands.push_back(std::make_unique<SetCommand>(store));
+    commands.push_back(std::make_unique<GetCommand>(store));
+    commands.push_back(std::make_unique<DelCommand>(store));
+    commands.push_back(std::make_unique<IncrCommand>(store));
+    commands.push_back(std::make_unique<MgetCommand>(store));
+    CommandProcessor processor(std::move(commands));
+
+    EXPECT_EQ(processor.process_command("/set user:1 Alice Smith"), "OK");
+    EXPECT_EQ(processor.process_command("/get user:1"), "Alice Smith");
+    EXPECT_EQ(processor.process_command("/set session abc EX 60"), "OK");
+    EXPECT_EQ(processor.process_command("/get session"), "abc");
+    EXPECT_EQ(processor.process_command("/set session abc EX soon"),
+              "ERROR: Usage: /set <key> <value> [EX <seconds>]");
+    EXPECT_EQ(processor.process_command("/set lonely"), "ERROR: Usage: /set <key> <value> [EX <seconds>]");
+    // EX - только последние два слова, внутри значения это обычный текст
+    EXPECT_EQ(processor.process_command("/set note ship EX works today"), "OK");
+    EXPECT_EQ(processor.process_command("/get note"), "ship EX works today");
+    EXPECT_EQ(processor.process_command("/set note EX 60"), "OK");
+    EXPECT_EQ(processor.process_command("/get note"), "EX 60");
+    EXPECT_EQ(processor.process_command("/set note a EX b EX 5"), "OK");
+    EXPECT_EQ(processor.process_command("/get note"), "a EX b");
+    EXPECT_EQ(processor.process_command("/set note (nil)"), "ERROR: Value (nil) is reserved for missing keys");
+    EXPECT_EQ(processor.process_command("/set note (nil) EX 60"), "ERROR: Value (nil) is reserved for missing keys");
+    EXPECT_EQ(processor.process_command("/get note"), "a EX b");
+    EXPECT_EQ(processor.process_command("/get missing"), "(nil)");
+
+    EXPECT_EQ(processor.process_command("/incr hits"), "1");
+    EXPECT_EQ(processor.process_command("/incr hits 10"), "11");
+    EXPECT_EQ(processor.process_command("/incr user:1"), "ERROR: Value is not an integer");
+    EXPECT_EQ(processor.process_command("/mget user:1 missing hits"), "Values: 3\nAlice Smith\n(nil)\n11");
+
+    EXPECT_EQ(processor.process_command("/del user:1 missing hits"), "2");
+    EXPECT_EQ(processor.process_command("/del"), "ERROR: Usage: /del <key> [key...]");
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../server/line_scanner.hpp"
+
+namespace {
+
+std::vector<std::string> split(LineScanner::ScanFn scan, const std::string& input, size_t* consumed = nullptr) {
+    std::vector<LineSpan> spans;
+    size_t used = scan(input.data(), input.size(), spans);
+    if (consumed) {
+        *consumed = used;
+    }
+    std::vector<std::string> lines;
+    for (const auto& span : spans) {
+        lines.emplace_back(input.substr(span.offset, span.length));
+    }
+    return lines;
+}
+
+const std::vector<LineScanner::ScanFn> all_scanners = {
+    &LineScanner::scan_scalar,
+    &LineScanner::scan_sse2,
+    &LineScanner::scan_avx2,
+};
+
+} // namespace
+
+TEST(LineScannerTest, SplitsAndTrimsLines) {
+    for (auto scan : all_scanners) {
+        if (scan == &LineScanner::scan_avx2 && !LineScanner::supported(LineScanner::Isa::Avx2)) {
+            continue;
+        }
+        size_t consumed = 0;
+        auto lines = split(scan, "/time\r\nHello World  \n\n/stats\t\npartial", &consumed);
+        ASSERT_EQ(lines.size(), 4u);
+        EXPECT_EQ(lines[0], "/time");
+        EXPECT_EQ(lines[1], "Hello World");
+        EXPECT_EQ(lines[2], "");
+        EXPECT_EQ(lines[3], "/stats");
+        EXPECT_EQ(consumed, std::string("/time\r\nHello World  \n\n/stats\t\n").size());
+    }
+}
+
+TEST(LineScannerTest, NoNewlineConsumesNothing) {
+    size_t consumed = 42;
+    auto lines = split(&LineScanner::scan, "no newline here, still waiting", &consumed);
+    EXPECT_TRUE(lines.empty());
+    EXPECT_EQ(consumed, 0u);
+}
+
+TEST(LineScannerTest, VectorScannersMatchScalar) {
+    std::mt19937 rng(12345);
+    const std::string alphabet = "abc /\r\t \n";
+
+    for (int round = 0; round < 500; ++round) {
+        std::string input(rng() % 300, ' ');
+        for (auto& c : input) {
+            c = alphabet[rng() % alphabet.size()];
+        }
+
+        size_t expected_consumed = 0;
+        auto expected = split(&LineScanner::scan_scalar, input, &expected_consumed);
+        for (auto scan : all_scanners) {
+            if (scan == &LineScanner::scan_avx2 && !LineScanner::supported(LineScanner::Isa::Avx2)) {
+                continue;
+            }
+            size_t consumed = 0;
+            EXPECT_EQ(split(scan, input, &consumed), expected);
+            EXPECT_EQ(consumed, expected_consumed);
+        }
+    }
+}
+
+TEST(LineScannerTest, TrimRemovesTrailingWhitespaceOnly) {
+    EXPECT_EQ(LineScanner::trim("  Hello \r\n\t"), "  Hello");
+    EXPECT_EQ(LineScanner::trim(" \n"), "");
+    EXPECT_EQ(LineScanner::trim(""), "");
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../client/load_generator.hpp"
+
+namespace {
+
+// Сервер на другом конце socketpair: на каждую строку отвечает частями из
+// replies, делая паузу между частями
+class FakeProbeServer {
+public:
+    void reply(std::vector<std::string> parts) { replies_.push_back(std::move(parts)); }
+
+    void start(int fd) {
+        fd_ = fd;
+        thread_ = std::thread([this] {
+            std::string input;
+            char buffer[4096];
+            for (const auto& parts : replies_) {
+                while (input.find('\n') == std::string::npos) {
+                    ssize_t n = recv(fd_, buffer, sizeof(buffer), 0);
+                    if (n <= 0) return;
+                    input.append(buffer, static_cast<size_t>(n));
+                }
+                input.erase(0, input.find('\n') + 1);
+                for (size_t i = 0; i < parts.size(); ++i) {
+                    if (i > 0) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+                    }
+                    send(fd_, parts[i].data(), parts[i].size(), MSG_NOSIGNAL);
+                }
+            }
+        });
+    }
+
+    void join() {
+        if (thread_.joinable()) thread_.join();
+    }
+
+private:
+    int fd_ = -1;
+    std::vector<std::vector<std::string>> replies_;
+    std::thread thread_;
+};
+
+class ProbeTest : public ::testing::Test {
+protected:
+    void SetUp() override { ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0); }
+
+    void TearDown() override {
+        close(fds[0]);
+        server.join();
+        close(fds[1]);
+    }
+
+    int fds[2] = {-1, -1};
+    FakeProbeServer server;
+};
+
+} // namespace
+
+TEST(LoadMixTest, ParsesWeightedCommands) {
+    std::vector<BenchRequest> mix;
+    std::string error;
+    ASSERT_TRUE(parse_mix("time:2,stats,echo64:5", mix, error)) << error;
+    ASSERT_EQ(mix.size(), 3u);
+    EXPECT_EQ(mix[0].name, "time");
+    EXPECT_EQ(mix[0].payload, "/time\n");
+    EXPECT_EQ(mix[0].weight, 2u);
+    EXPECT_EQ(mix[1].payload, "/stats\n");
+    EXPECT_EQ(mix[1].weight, 1u);
+    EXPECT_EQ(mix[2].payload, std::string(64, 'x') + "\n");
+    EXPECT_EQ(mix[2].weight, 5u);
+
+    ASSERT_TRUE(parse_mix("echo", mix, error)) << error;
+    EXPECT_EQ(mix[0].payload.size(), 17u);
+}
+
+TEST(LoadMixTest, RejectsInvalidEntries) {
+    std::vector<BenchRequest> mix;
+    std::string error;
+    EXPECT_FALSE(parse_mix("time:0", mix, error));
+    EXPECT_EQ(error, "invalid weight in mix entry 'time:0'");
+    EXPECT_FALSE(parse_mix("time:2x", mix, error));
+    EXPECT_EQ(error, "invalid weight in mix entry 'time:2x'");
+    EXPECT_FALSE(parse_mix("time:", mix, error));
+    EXPECT_FALSE(parse_mix("shutdown", mix, error));
+    EXPECT_EQ(error, "unknown mix entry 'shutdown' (expected time, stats or echo<N>)");
+    EXPECT_FALSE(parse_mix("echo0", mix, error));
+    EXPECT_FALSE(parse_mix("echo60001", mix, error));
+    EXPECT_FALSE(parse_mix("echo12ab", mix, error));
+    EXPECT_FALSE(parse_mix("time,,stats", mix, error));
+    EXPECT_FALSE(parse_mix("", mix, error));
+    EXPECT_EQ(error, "empty request mix");
+}
+
+TEST_F(ProbeTest, FramesRepliesRegardlessOfTiming) {
+    std::vector<BenchRequest> mix;
+    std::string error;
+    ASSERT_TRUE(parse_mix("stats,time,echo8", mix, error)) << error;
+
+    // Ответ /stats приходит с паузами посреди рамки и одной строкой на стыке частей
+    server.reply({"Active connections: 1\nTotal", " connections: 7\n", "Overload stage: normal\nStage time: normal 5s\n"});
+    server.reply({"2026-10-19 12:00:00\n"});
+    server.reply({"xxxx", "xxxx\n"});
+    server.start(fds[1]);
+
+    ASSERT_TRUE(probe_response_lines(fds[0], mix, error)) << error;
+    EXPECT_EQ(mix[0].response_lines, 4u);
+    EXPECT_EQ(mix[1].response_lines, 1u);
+    EXPECT_EQ(mix[2].response_lines, 1u);
+}
+
+TEST_F(ProbeTest, FailsOnClosedOrOverlongReply) {
+    std::vector<BenchRequest> mix;
+    std::string error;
+    ASSERT_TRUE(parse_mix("time", mix, error)) << error;
+
+    // Лишняя строка после ответа /time - рамки сервера и клиента расходятся
+    server.reply({"2026-10-19 12:00:00\nextra\n"});
+    server.start(fds[1]);
+    EXPECT_FALSE(probe_response_lines(fds[0], mix, error));
+    EXPECT_EQ(error, "unexpected data after 'time' probe reply");
+
+    // Сервер закрыл соединение, не дописав ответ
+    server.join();
+    shutdown(fds[1], SHUT_WR);
+    EXPECT_FALSE(probe_response_lines(fds[0], mix, error));
+    EXPECT_EQ(error, "no response to 'time' probe");
+}
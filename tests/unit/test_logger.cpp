@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../../server/logger.hpp"
+
+namespace {
+
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char pattern[] = "/tmp/logger_test.XXXXXX";
+        int fd = mkstemp(pattern);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        path = pattern;
+    }
+
+    void TearDown() override {
+        unlink(path.c_str());
+    }
+
+    std::vector<std::string> read_lines() {
+        std::vector<std::string> lines;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    std::string path;
+};
+
+} // namespace
+
+TEST_F(LoggerTest, FormatsArgumentsInBackground) {
+    Logger logger;
+    std::string error;
+    ASSERT_TRUE(logger.start(path, error)) << error;
+
+    std::string owned = "owned";
+    logger.write(LogLevel::Info, "ints {} {} chars {}{} bool {}", -5, 7u, 'o', 'k', true);
+    logger.write(LogLevel::Warning, "strings {} {} {}", owned, std::string_view("view"), "literal");
+    logger.write(LogLevel::Error, "double {} missing {} {}", 0.5);
+    logger.write(LogLevel::Info, "long {}", std::string(1000, 'x'));
+    logger.stop();
+
+    auto lines = read_lines();
+    ASSERT_EQ(lines.size(), 4u);
+    // 2026-10-19T06:59:13.123456Z info ...
+    EXPECT_EQ(lines[0].substr(27), " info ints -5 7 chars ok bool true");
+    EXPECT_EQ(lines[1].substr(27), " warning strings owned view literal");
+    EXPECT_EQ(lines[2].substr(27), " error double 0.5 missing {} {}");
+    EXPECT_LT(lines[3].size(), 300u);
+    EXPECT_EQ(lines[3].substr(lines[3].size() - 6), "xxx...");
+    EXPECT_EQ(logger.stats().records, 4u);
+}
+
+TEST_F(LoggerTest, LevelFilteringAndSynchronousFallback) {
+    Logger logger;
+    std::string error;
+    ASSERT_TRUE(logger.start(path, error)) << error;
+    logger.set_level(LogLevel::Warning);
+    EXPECT_FALSE(logger.enabled(LogLevel::Info));
+    EXPECT_TRUE(logger.enabled(LogLevel::Error));
+    logger.stop();
+    logger.write(LogLevel::Error, "after stop {}", 1);
+
+    auto lines = read_lines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0].substr(27), " error after stop 1");
+
+    LogLevel level;
+    EXPECT_TRUE(parse_log_level("debug", level));
+    EXPECT_EQ(level, LogLevel::Debug);
+    EXPECT_FALSE(parse_log_level("verbose", level));
+    EXPECT_STREQ(log_level_name(LogLevel::Warning), "warning");
+}
+
+TEST_F(LoggerTest, CountsDroppedRecordsPerThread) {
+    Logger logger(8);
+    std::string error;
+    ASSERT_TRUE(logger.start(path, error)) << error;
+
+    constexpr int THREADS = 4;
+    constexpr int PER_THREAD = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&logger, t] {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                logger.write(LogLevel::Info, "thread {} record {}", t, i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    logger.stop();
+
+    LoggerStats stats = logger.stats();
+    EXPECT_EQ(stats.records + stats.dropped, static_cast<uint64_t>(THREADS * PER_THREAD));
+    auto lines = read_lines();
+    size_t reports = 0;
+    for (const auto& line : lines) {
+        reports += line.find("Logger: ") != std::string::npos ? 1 : 0;
+    }
+    EXPECT_EQ(lines.size(), stats.records + reports);
+    if (stats.dropped > 0) {
+        EXPECT_GE(reports, 1u);
+    }
+}
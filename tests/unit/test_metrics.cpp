@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "../../server/metrics.hpp"
+#include "../../server/prometheus.hpp"
+
+TEST(LatencyHistogramTest, ObservesIntoBuckets) {
+    LatencyHistogram histogram;
+    histogram.observe(500);       // <= 1us
+    histogram.observe(1000);      // граница включается в корзину
+    histogram.observe(3000);      // <= 5us
+    histogram.observe(1000000000); // +Inf
+
+    EXPECT_EQ(histogram.bucket(0), 2u);
+    EXPECT_EQ(histogram.bucket(2), 1u);
+    EXPECT_EQ(histogram.bucket(LatencyHistogram::BUCKET_COUNT - 1), 1u);
+    EXPECT_EQ(histogram.count(), 4u);
+    EXPECT_EQ(histogram.sum_ns(), 1000004500u);
+}
+
+TEST(PrometheusWriterTest, WritesSamplesAndCumulativeHistogram) {
+    LatencyHistogram histogram;
+    histogram.observe(2000);
+    histogram.observe(2000000);
+
+    std::string out;
+    PrometheusWriter writer(out);
+    writer.header("requests_total", "Requests.", "counter");
+    writer.sample("requests_total", "command", "time", 7);
+    writer.sample_seconds("uptime_seconds", 1500000000);
+    writer.histogram("latency_seconds", "", "", histogram);
+
+    EXPECT_NE(out.find("# TYPE requests_total counter\n"), std::string::npos);
+    EXPECT_NE(out.find("requests_total{command=\"time\"} 7\n"), std::string::npos);
+    EXPECT_NE(out.find("uptime_seconds 1.5\n"), std::string::npos);
+    EXPECT_NE(out.find("latency_seconds_bucket{le=\"0.000001\"} 0\n"), std::string::npos);
+    EXPECT_NE(out.find("latency_seconds_bucket{le=\"0.0000025\"} 1\n"), std::string::npos);
+    EXPECT_NE(out.find("latency_seconds_bucket{le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(out.find("latency_seconds_sum 0.002002\n"), std::string::npos);
+    EXPECT_NE(out.find("latency_seconds_count 2\n"), std::string::npos);
+}
+
+TEST(PrometheusWriterTest, WritesHistogramWithTwoLabels) {
+    LatencyHistogram histogram;
+    histogram.observe(2000);
+
+    std::string out;
+    PrometheusWriter writer(out);
+    writer.histogram("stage_seconds", "command", "get", "stage", "parse", histogram);
+
+    EXPECT_NE(out.find("stage_seconds_bucket{command=\"get\",stage=\"parse\",le=\"+Inf\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("stage_seconds_sum{command=\"get\",stage=\"parse\"} 0.000002\n"), std::string::npos);
+    EXPECT_NE(out.find("stage_seconds_count{command=\"get\",stage=\"parse\"} 1\n"), std::string::npos);
+}
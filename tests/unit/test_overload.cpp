@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../server/command_processor.hpp"
+#include "../../server/overload.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+OverloadThresholds thresholds() {
+    OverloadThresholds t;
+    t.lag = 10ms;
+    t.queued_bytes = 1000;
+    t.connections = 100;
+    t.cooldown = 1s;
+    return t;
+}
+
+OverloadLoad lag(std::chrono::nanoseconds value) {
+    return {static_cast<uint64_t>(value.count()), 0, 0};
+}
+
+} // namespace
+
+TEST(OverloadTest, StagesFollowTheWorstSignal) {
+    OverloadController controller;
+    controller.set_thresholds(thresholds());
+    EXPECT_EQ(controller.target({0, 999, 99}), OverloadState::Normal);
+    EXPECT_EQ(controller.target({0, 1000, 0}), OverloadState::NoAccept);
+    EXPECT_EQ(controller.target({0, 0, 250}), OverloadState::RejectUdp);
+    EXPECT_EQ(controller.target({50000000, 0, 0}), OverloadState::Shed);
+
+    // Нулевой порог сигнал отключает
+    OverloadThresholds lag_only = thresholds();
+    lag_only.queued_bytes = 0;
+    lag_only.connections = 0;
+    controller.set_thresholds(lag_only);
+    EXPECT_EQ(controller.target({0, 1u << 30, 1000000}), OverloadState::Normal);
+}
+
+TEST(OverloadTest, EscalatesAtOnceAndRecoversStepwise) {
+    auto start = OverloadController::Clock::time_point{};
+    OverloadController controller(start);
+    controller.set_thresholds(thresholds());
+
+    EXPECT_TRUE(controller.update(lag(45ms), start + 10ms));
+    EXPECT_EQ(controller.state(), OverloadState::Shed);
+    EXPECT_FALSE(controller.accepting());
+    EXPECT_TRUE(controller.rejecting_udp());
+
+    // Нагрузка спала, но до конца cooldown ступень держится
+    EXPECT_FALSE(controller.update(lag(0ms), start + 20ms));
+    EXPECT_FALSE(controller.update(lag(0ms), start + 500ms));
+    EXPECT_EQ(controller.state(), OverloadState::Shed);
+    EXPECT_TRUE(controller.update(lag(0ms), start + 1020ms));
+    EXPECT_EQ(controller.state(), OverloadState::RejectUdp);
+    // Следующий шаг вниз - через ещё один cooldown
+    EXPECT_FALSE(controller.update(lag(0ms), start + 1500ms));
+    EXPECT_TRUE(controller.update(lag(0ms), start + 2020ms));
+    EXPECT_EQ(controller.state(), OverloadState::NoAccept);
+
+    // Новый всплеск сбрасывает отсчёт cooldown
+    EXPECT_TRUE(controller.update(lag(25ms), start + 2030ms));
+    EXPECT_EQ(controller.state(), OverloadState::RejectUdp);
+    EXPECT_EQ(controller.transitions(), 4u);
+
+    auto time = controller.time_in_state_ns();
+    EXPECT_EQ(time[static_cast<size_t>(OverloadState::Normal)], 10000000u);
+    EXPECT_EQ(time[static_cast<size_t>(OverloadState::Shed)], 1010000000u);
+    EXPECT_EQ(time[static_cast<size_t>(OverloadState::RejectUdp)], 1000000000u);
+    EXPECT_EQ(time[static_cast<size_t>(OverloadState::NoAccept)], 10000000u);
+}
+
+TEST(OverloadTest, ShedsLowPriorityCommandsAndReportsStats) {
+    SessionManager sessions;
+    OverloadController controller;
+    controller.set_thresholds(thresholds());
+    std::vector<std::unique_ptr<Command>> commands;
+    commands.push_back(std::make_unique<StatsCommand>(sessions, &controller));
+    commands.push_back(std::make_unique<SessionsCommand>(sessions));
+    commands.push_back(std::make_unique<TimeCommand>());
+    CommandProcessor processor(std::move(commands));
+
+    processor.set_min_priority(CommandPriority::Normal);
+    EXPECT_EQ(processor.process_command("/sessions"), "BUSY: Server overloaded, try again later");
+    EXPECT_EQ(processor.process_command("/time").size(), 19u);
+    EXPECT_EQ(processor.process_command("hello"), "hello");
+    EXPECT_EQ(processor.shed_commands(), 1u);
+
+    auto stats = processor.process_command("/stats");
+    EXPECT_NE(stats.find("Overload state: normal"), std::string::npos);
+    EXPECT_NE(stats.find("Overload time (ms): normal="), std::string::npos);
+    EXPECT_NE(stats.find("shed="), std::string::npos);
+
+    processor.set_min_priority(CommandPriority::Low);
+    EXPECT_EQ(processor.process_command("/sessions").find("BUSY"), std::string::npos);
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../server/command_processor.hpp"
+#include "../../server/pubsub.hpp"
+#include "../../server/tcp_connection.hpp"
+#include "../../server/tcp_handler.hpp"
+#include "tcp_connection_pair.hpp"
+
+namespace {
+
+class RecordingSubscriber : public Subscriber {
+public:
+    Delivery deliver(const SharedMessage& message) override {
+        received.push_back(message);
+        return Delivery::Sent;
+    }
+
+    std::vector<SharedMessage> received;
+};
+
+} // namespace
+
+TEST(TopicRegistryTest, FanOutSharesOneBuffer) {
+    TopicRegistry registry;
+    RecordingSubscriber first;
+    RecordingSubscriber second;
+    RecordingSubscriber other;
+
+    EXPECT_EQ(registry.subscribe("news", &first), TopicRegistry::Result::Ok);
+    EXPECT_EQ(registry.subscribe("news", &second), TopicRegistry::Result::Ok);
+    EXPECT_EQ(registry.subscribe("news", &second), TopicRegistry::Result::AlreadySubscribed);
+    EXPECT_EQ(registry.subscribe("sport", &other), TopicRegistry::Result::Ok);
+
+    EXPECT_EQ(registry.publish("news", "hello world"), 2u);
+    ASSERT_EQ(first.received.size(), 1u);
+    ASSERT_EQ(second.received.size(), 1u);
+    EXPECT_TRUE(other.received.empty());
+    EXPECT_EQ(*first.received[0], "message news hello world\n");
+    EXPECT_EQ(first.received[0].get(), second.received[0].get());
+
+    EXPECT_EQ(registry.publish("nobody", "x"), 0u);
+    PubSubStats stats = registry.stats();
+    EXPECT_EQ(stats.published, 2u);
+    EXPECT_EQ(stats.sent, 2u);
+    EXPECT_EQ(stats.topics, 2u);
+    EXPECT_EQ(stats.subscriptions, 3u);
+}
+
+TEST(TopicRegistryTest, UnsubscribeAllRemovesEmptyTopics) {
+    TopicRegistry registry;
+    RecordingSubscriber subscriber;
+    registry.subscribe("a", &subscriber);
+    registry.subscribe("b", &subscriber);
+    EXPECT_EQ(subscriber.subscriptions(), 2u);
+
+    EXPECT_EQ(registry.unsubscribe("a", &subscriber), TopicRegistry::Result::Ok);
+    EXPECT_EQ(registry.unsubscribe("a", &subscriber), TopicRegistry::Result::NotSubscribed);
+    EXPECT_EQ(registry.unsubscribe_all(&subscriber), 1u);
+    EXPECT_EQ(subscriber.subscriptions(), 0u);
+    EXPECT_EQ(registry.stats().topics, 0u);
+    EXPECT_EQ(registry.publish("b", "x"), 0u);
+}
+
+TEST(TopicRegistryTest, Commands) {
+    SessionManager session_manager;
+    std::vector<std::unique_ptr<Command>> commands;
+    commands.push_back(std::make_unique<SubscribeCommand>(session_manager));
+    commands.push_back(std::make_unique<UnsubscribeCommand>(session_manager));
+    commands.push_back(std::make_unique<PublishCommand>(session_manager));
+    CommandProcessor processor(std::move(commands));
+    RecordingSubscriber subscriber;
+
+    EXPECT_EQ(processor.process_command("/subscribe news", &subscriber), "Subscribed to 'news'");
+    EXPECT_EQ(processor.process_command("/subscribe news"), "ERROR: /subscribe requires a TCP connection");
+    EXPECT_EQ(processor.process_command("/subscribe", &subscriber), "ERROR: Usage: /subscribe <topic>");
+    EXPECT_EQ(processor.process_command("/publish news breaking story"), "Published to 1 subscribers");
+    EXPECT_EQ(processor.process_command("/publish news"), "ERROR: Usage: /publish <topic> <message>");
+    ASSERT_EQ(subscriber.received.size(), 1u);
+    EXPECT_EQ(*subscriber.received[0], "message news breaking story\n");
+
+    EXPECT_EQ(processor.process_command("/unsubscribe news", &subscriber), "Unsubscribed from 'news'");
+    EXPECT_EQ(processor.process_command("/unsubscribe news", &subscriber), "ERROR: Not subscribed to 'news'");
+    EXPECT_EQ(processor.process_command("/unsubscribe", &subscriber), "Unsubscribed from 0 topics");
+}
+
+class SlowSubscriberTest : public TcpConnectionPairTest {
+protected:
+    void SetUp() override {
+        TcpConnectionPairTest::SetUp();
+        int size = 4096;
+        setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+
+    // Забивает буфер сокета, пока сообщение не встанет в очередь
+    void fill() {
+        open();
+        for (int i = 0; i < 1000 && connection->queued_messages() == 0; ++i) {
+            connection->deliver(message);
+        }
+        ASSERT_EQ(connection->queued_messages(), 1u);
+        ASSERT_TRUE(want_write);
+    }
+
+    SharedMessage message = std::make_shared<const std::string>(std::string(1000, 'x') + "\n");
+};
+
+TEST_F(SlowSubscriberTest, QueueIsBoundedAndDrains) {
+    settings.subscriber_queue_limit = 3;
+    fill();
+    EXPECT_EQ(connection->deliver(message), Subscriber::Delivery::Queued);
+    EXPECT_EQ(connection->deliver(message), Subscriber::Delivery::Queued);
+    EXPECT_EQ(connection->deliver(message), Subscriber::Delivery::Dropped);
+    EXPECT_EQ(connection->queued_messages(), 3u);
+
+    for (int i = 0; i < 100 && want_write; ++i) {
+        drain_peer();
+        connection->handle_write();
+    }
+    EXPECT_FALSE(want_write);
+    EXPECT_EQ(connection->queued_messages(), 0u);
+    drain_peer();
+    EXPECT_EQ(connection->deliver(message), Subscriber::Delivery::Sent);
+}
+
+TEST_F(SlowSubscriberTest, DropPolicyQueuesNothingBehindBacklog) {
+    settings.subscriber_policy = SlowSubscriberPolicy::Drop;
+    fill();
+    EXPECT_EQ(connection->deliver(message), Subscriber::Delivery::Dropped);
+    EXPECT_EQ(connection->queued_messages(), 1u);
+}
+
+TEST_F(SlowSubscriberTest, DisconnectPolicyClosesWhenFull) {
+    settings.subscriber_policy = SlowSubscriberPolicy::Disconnect;
+    settings.subscriber_queue_limit = 2;
+    fill();
+    EXPECT_EQ(connection->deliver(message), Subscriber::Delivery::Queued);
+    EXPECT_EQ(connection->deliver(message), Subscriber::Delivery::Disconnected);
+    EXPECT_EQ(connection->get_fd(), -1);
+}
+
+TEST_F(SlowSubscriberTest, ResponsesKeepOrderBehindQueue) {
+    fill();
+    connection->send("reply\n");
+    EXPECT_EQ(connection->queued_messages(), 2u);
+
+    std::string tail;
+    for (int i = 0; i < 100 && want_write; ++i) {
+        drain_peer(&tail);
+        connection->handle_write();
+    }
+    drain_peer(&tail);
+    ASSERT_GE(tail.size(), 8u);
+    EXPECT_EQ(tail.substr(tail.size() - 8), "x\nreply\n");
+}
+
+TEST(IdleSweepTest, DeliveriesKeepSubscriberAlive) {
+    auto sessions = std::make_shared<SessionManager>();
+    TcpHandler handler(0, sessions);
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+    handler.adopt(fds[0], sockaddr_in{});
+    TcpConnection* subscriber = handler.find_connection(fds[0]);
+    ASSERT_NE(subscriber, nullptr);
+
+    // Клиент ничего не пишет, но получает сообщения: соединение не простаивает
+    auto message = std::make_shared<const std::string>("message news story\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(subscriber->deliver(message), Subscriber::Delivery::Sent);
+    EXPECT_EQ(handler.close_idle_connections(std::chrono::milliseconds(40)), 0u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(handler.close_idle_connections(std::chrono::milliseconds(40)), 1u);
+    close(fds[1]);
+}
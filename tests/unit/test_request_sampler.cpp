@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../../server/command.hpp"
+#include "../../server/command_processor.hpp"
+#include "../../server/request_sampler.hpp"
+#include "tcp_connection_pair.hpp"
+
+namespace {
+
+const LatencyHistogram& stage(const CommandMetrics& metrics, RequestStage stage) {
+    return metrics.stages[static_cast<size_t>(stage)];
+}
+
+// Строки из сокета уходят в CommandProcessor, как в сервере
+class RequestSamplerTest : public TcpConnectionPairTest {
+protected:
+    void SetUp() override {
+        TcpConnectionPairTest::SetUp();
+        std::vector<std::unique_ptr<Command>> commands;
+        commands.push_back(std::make_unique<TimeCommand>());
+        processor = std::make_unique<CommandProcessor>(std::move(commands));
+
+        settings.sample_rate = 1;
+        settings.on_message = [this](TcpConnection& connection, std::string_view message) {
+            Response response = processor->process_command(message, &connection);
+            response.push_back('\n');
+            connection.send(response);
+        };
+        open();
+    }
+
+    const CommandMetrics& metrics(std::string_view name) const {
+        const CommandMetrics* found = nullptr;
+        processor->visit_metrics([&](std::string_view command, const CommandMetrics& metrics) {
+            if (command == name) {
+                found = &metrics;
+            }
+        });
+        return *found;
+    }
+
+    std::unique_ptr<CommandProcessor> processor;
+};
+
+} // namespace
+
+TEST(RequestSampleTest, TakesEveryNthRequest) {
+    int taken = 0;
+    for (int i = 0; i < 9; ++i) {
+        taken += RequestSample::take(0);
+    }
+    EXPECT_EQ(taken, 0);
+    for (int i = 0; i < 9; ++i) {
+        taken += RequestSample::take(3);
+    }
+    EXPECT_EQ(taken, 3);
+}
+
+TEST(RequestSampleTest, ReportsQuantileBucketsPerStage) {
+    CommandMetrics metrics;
+    std::string out;
+    EXPECT_FALSE(append_request_stages(out, "get", metrics));
+    EXPECT_TRUE(out.empty());
+
+    RequestSample sample{1000};
+    sample.parsed = 1500;       // 0.5 мкс -> корзина 1
+    sample.dispatched = 3500;   // 2 мкс -> 2.5
+    sample.executed = 13500;    // 10 мкс -> 10
+    sample.queued = 13500;
+    sample.metrics = &metrics;
+    sample.record(213500);      // запись 200 мкс -> 250
+    EXPECT_TRUE(append_request_stages(out, "get", metrics));
+    EXPECT_EQ(out, "get samples=1 parse=1/1 dispatch=2.5/2.5 execute=10/10 queue=1/1 write=250/250 "
+                   "total=250/250\n");
+}
+
+TEST_F(RequestSamplerTest, RecordsEveryStageOfAnImmediateResponse) {
+    ASSERT_EQ(write(fds[1], "/time\nhello\n", 12), 12);
+    connection->handle_read();
+    EXPECT_EQ(drain_peer(), 26u);
+
+    for (size_t i = 0; i < REQUEST_STAGE_COUNT; ++i) {
+        EXPECT_EQ(metrics("time").stages[i].count(), 1u) << request_stage_name(static_cast<RequestStage>(i));
+        EXPECT_EQ(metrics("echo").stages[i].count(), 1u) << request_stage_name(static_cast<RequestStage>(i));
+    }
+    EXPECT_EQ(RequestSample::current(), nullptr);
+
+    settings.sample_rate = 0;
+    ASSERT_EQ(write(fds[1], "/time\n", 6), 6);
+    connection->handle_read();
+    EXPECT_EQ(metrics("time").requests.load(), 2u);
+    EXPECT_EQ(stage(metrics("time"), RequestStage::Total).count(), 1u);
+}
+
+TEST_F(RequestSamplerTest, WriteStageEndsWhenQueuedResponseIsSent) {
+    // Сокет забит ответом вне выборки: ответ /time встаёт за ним в очередь
+    connection->send(std::string(1 << 20, 'x'));
+    ASSERT_GT(connection->queued_messages(), 0u);
+    ASSERT_EQ(write(fds[1], "/time\n", 6), 6);
+    connection->handle_read();
+    EXPECT_EQ(metrics("time").requests.load(), 1u);
+    EXPECT_EQ(stage(metrics("time"), RequestStage::Total).count(), 0u);
+
+    size_t received = 0;
+    while (connection->queued_messages() > 0) {
+        received += drain_peer();
+        connection->handle_write();
+    }
+    received += drain_peer();
+    EXPECT_EQ(received, (1u << 20) + 20);
+    EXPECT_EQ(stage(metrics("time"), RequestStage::Write).count(), 1u);
+    EXPECT_EQ(stage(metrics("time"), RequestStage::Total).count(), 1u);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+
+#include "../../server/session_table.hpp"
+
+namespace {
+
+sockaddr_in make_peer(const char* ip, uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, ip, &addr.sin_addr);
+    return addr;
+}
+
+} // namespace
+
+TEST(SessionTableTest, OpenAndCloseReuseSlots) {
+    SessionTable table(2);
+
+    int first = table.open(make_peer("10.0.0.1", 1000));
+    int second = table.open(make_peer("10.0.0.2", 2000));
+    EXPECT_NE(first, SessionTable::INVALID_SLOT);
+    EXPECT_NE(second, SessionTable::INVALID_SLOT);
+    EXPECT_EQ(table.open(make_peer("10.0.0.3", 3000)), SessionTable::INVALID_SLOT);
+    EXPECT_EQ(table.active(), 2u);
+
+    table.close(first);
+    EXPECT_EQ(table.active(), 1u);
+    EXPECT_EQ(table.open(make_peer("10.0.0.4", 4000)), first);
+}
+
+TEST(SessionTableTest, RecordsTrafficPerSlot) {
+    SessionTable table(4);
+    int slot = table.open(make_peer("127.0.0.1", 5555));
+
+    table.record_read(slot, 100, 2);
+    table.record_write(slot, 40);
+
+    SessionInfo info = table.get(slot);
+    EXPECT_EQ(info.peer, "127.0.0.1:5555");
+    EXPECT_EQ(info.bytes_in, 100u);
+    EXPECT_EQ(info.messages_in, 2u);
+    EXPECT_EQ(info.bytes_out, 40u);
+    EXPECT_EQ(info.messages_out, 1u);
+}
+
+TEST(SessionTableTest, TopByTraffic) {
+    SessionTable table(8);
+    int quiet = table.open(make_peer("10.0.0.1", 1));
+    int busy = table.open(make_peer("10.0.0.2", 2));
+    int medium = table.open(make_peer("10.0.0.3", 3));
+
+    table.record_read(quiet, 10, 1);
+    table.record_read(busy, 5000, 50);
+    table.record_read(medium, 500, 5);
+
+    auto top = table.top(SessionTable::Order::Traffic, 2);
+    ASSERT_EQ(top.size(), 2u);
+    EXPECT_EQ(top[0].slot, busy);
+    EXPECT_EQ(top[1].slot, medium);
+}
+
+TEST(SessionTableTest, TopByIdleSkipsClosedSlots) {
+    SessionTable table(8);
+    int idle = table.open(make_peer("10.0.0.1", 1));
+    int closed = table.open(make_peer("10.0.0.2", 2));
+    int active = table.open(make_peer("10.0.0.3", 3));
+    table.close(closed);
+    table.record_read(active, 1, 1);
+
+    auto top = table.top(SessionTable::Order::Idle, 10);
+    ASSERT_EQ(top.size(), 2u);
+    EXPECT_EQ(top[0].slot, idle);
+    EXPECT_EQ(top[1].slot, active);
+}
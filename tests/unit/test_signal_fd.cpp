@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <stdexcept>
+
+#include "../../server/eventloop.hpp"
+#include "../../server/signal_fd.hpp"
+
+namespace {
+
+bool is_pending(int signo) {
+    sigset_t pending;
+    sigpending(&pending);
+    return sigismember(&pending, signo) == 1;
+}
+
+bool is_blocked(int signo) {
+    sigset_t mask;
+    pthread_sigmask(SIG_BLOCK, nullptr, &mask);
+    return sigismember(&mask, signo) == 1;
+}
+
+} // namespace
+
+TEST(SignalFdTest, HandlerRunsFromEventLoop) {
+    ASSERT_FALSE(is_blocked(SIGUSR1));
+
+    SignalFd signals;
+    ASSERT_TRUE(signals.open({SIGUSR1, SIGUSR2}));
+    EXPECT_TRUE(is_blocked(SIGUSR1));
+
+    int handled = 0;
+    signalfd_siginfo received{};
+    signals.set_handler(SIGUSR1, [&](const signalfd_siginfo& info) {
+        ++handled;
+        received = info;
+    });
+
+    EventLoop loop;
+    ASSERT_TRUE(loop.add_fd(signals.get_fd(), EPOLLIN, [&](uint32_t) { signals.handle_read(); }));
+
+    // Сигнал заблокирован: он ждёт в очереди, пока его не прочтёт цикл
+    ASSERT_EQ(raise(SIGUSR1), 0);
+    EXPECT_TRUE(is_pending(SIGUSR1));
+    EXPECT_EQ(handled, 0);
+
+    loop.run(1000);
+    EXPECT_EQ(handled, 1);
+    EXPECT_EQ(received.ssi_signo, static_cast<uint32_t>(SIGUSR1));
+    EXPECT_EQ(received.ssi_pid, static_cast<uint32_t>(getpid()));
+    EXPECT_FALSE(is_pending(SIGUSR1));
+
+    // Без новых сигналов цикл не вызывает обработчик повторно
+    loop.run(10);
+    EXPECT_EQ(handled, 1);
+
+    loop.remove_fd(signals.get_fd());
+    signals.close();
+    EXPECT_FALSE(is_blocked(SIGUSR1));
+}
+
+TEST(SignalFdTest, SignalWithoutHandlerIsConsumed) {
+    SignalFd signals;
+    ASSERT_TRUE(signals.open({SIGUSR1, SIGUSR2}));
+    int handled = 0;
+    signals.set_handler(SIGUSR1, [&](const signalfd_siginfo&) {
+        ++handled;
+        throw std::runtime_error("handler failed");
+    });
+
+    // Исключение обработчика не прерывает разбор остальных сигналов пачки
+    ASSERT_EQ(raise(SIGUSR2), 0);
+    ASSERT_EQ(raise(SIGUSR1), 0);
+    signals.handle_read();
+    EXPECT_EQ(handled, 1);
+    EXPECT_FALSE(is_pending(SIGUSR1));
+    EXPECT_FALSE(is_pending(SIGUSR2));
+}
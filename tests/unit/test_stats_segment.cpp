@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "../../server/stats_segment.hpp"
+
+namespace {
+
+class StatsSegmentTest : public ::testing::Test {
+protected:
+    void SetUp() override { name = "/async_tcp_udp_server.test." + std::to_string(getpid()); }
+
+    std::string name;
+};
+
+} // namespace
+
+TEST_F(StatsSegmentTest, ReaderSeesPublishedSnapshot) {
+    StatsSegment writer;
+    ASSERT_TRUE(writer.open(name));
+
+    StatsValues published{};
+    for (size_t i = 0; i < STATS_FIELD_COUNT; ++i) {
+        published[i] = 1000 + i;
+    }
+    writer.publish(published);
+
+    StatsSegmentReader reader;
+    std::string error;
+    ASSERT_TRUE(reader.open(name, error)) << error;
+    EXPECT_EQ(reader.pid(), static_cast<uint32_t>(getpid()));
+
+    StatsValues values{};
+    size_t field_count = 0;
+    ASSERT_TRUE(reader.read(values, field_count));
+    EXPECT_EQ(field_count, STATS_FIELD_COUNT);
+    EXPECT_EQ(values, published);
+
+    // Следующий снимок виден через то же отображение
+    published[static_cast<size_t>(StatsField::TcpMessages)] = 42;
+    writer.publish(published);
+    ASSERT_TRUE(reader.read(values, field_count));
+    EXPECT_EQ(values, published);
+}
+
+TEST_F(StatsSegmentTest, ReaderNeverSeesTornSnapshot) {
+    StatsSegment writer;
+    ASSERT_TRUE(writer.open(name));
+    StatsSegmentReader reader;
+    std::string error;
+    ASSERT_TRUE(reader.open(name, error)) << error;
+
+    // Писатель публикует снимки, где все поля равны; разнобой - разорванное чтение
+    std::atomic<bool> stop{false};
+    std::thread publisher([&] {
+        StatsValues values{};
+        for (uint64_t round = 1; !stop.load(std::memory_order_relaxed); ++round) {
+            values.fill(round);
+            writer.publish(values);
+        }
+    });
+
+    size_t consistent = 0;
+    uint64_t last = 0;
+    for (int i = 0; i < 20000; ++i) {
+        StatsValues values{};
+        size_t field_count = 0;
+        if (!reader.read(values, field_count)) {
+            continue;  // писатель не дал окна за все попытки - это не разрыв
+        }
+        ++consistent;
+        for (size_t f = 1; f < field_count; ++f) {
+            ASSERT_EQ(values[f], values[0]) << "field " << f << " read " << i;
+        }
+        EXPECT_GE(values[0], last);
+        last = values[0];
+    }
+    stop = true;
+    publisher.join();
+    EXPECT_GT(consistent, 0u);
+}
+
+TEST_F(StatsSegmentTest, CloseUnlinksButDetachKeepsSegment) {
+    StatsSegmentReader missing;
+    std::string error;
+    EXPECT_FALSE(missing.open(name, error));
+    EXPECT_NE(error.find("shm_open"), std::string::npos);
+
+    {
+        StatsSegment writer;
+        ASSERT_TRUE(writer.open(name));
+        writer.detach();
+    }
+    StatsSegmentReader reader;
+    EXPECT_TRUE(reader.open(name, error)) << error;
+
+    StatsSegment owner;
+    ASSERT_TRUE(owner.open(name));
+    owner.close();
+    StatsSegmentReader after_close;
+    EXPECT_FALSE(after_close.open(name, error));
+}
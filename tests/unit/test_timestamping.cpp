@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "../../server/tcp_connection.hpp"
+#include "../../server/timestamping.hpp"
+
+namespace {
+
+int bound_udp_socket(sockaddr_in& addr) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    return fd;
+}
+
+// Отметки отправки приходят асинхронно: ждём EPOLLERR-эквивалент через poll
+bool wait_error_queue(int fd) {
+    pollfd pfd{fd, 0, 0};
+    return poll(&pfd, 1, 1000) == 1 && (pfd.revents & POLLERR);
+}
+
+// Ядро включает программные отметки приёма отложенно (net_enable_timestamp
+// через workqueue), поэтому пакеты первых миллисекунд после setsockopt могут
+// прийти без них. Ждём первую отметку до секунды; пара сокетов с отметками
+// держит их включёнными, пока жив объект.
+class RxTimestampsEnabled {
+public:
+    RxTimestampsEnabled() {
+        sockaddr_in target{};
+        sockaddr_in source{};
+        receiver_ = bound_udp_socket(target);
+        sender_ = bound_udp_socket(source);
+        enable_timestamping(receiver_, SocketTimestamps::Rx);
+        char buffer[8];
+        uint64_t kernel_ns = 0;
+        for (int i = 0; i < 1000 && kernel_ns == 0; ++i) {
+            sendto(sender_, "warm", 4, 0, reinterpret_cast<sockaddr*>(&target), sizeof(target));
+            pollfd pfd{receiver_, POLLIN, 0};
+            poll(&pfd, 1, 10);
+            while (recv_timestamped(receiver_, buffer, sizeof(buffer), nullptr, kernel_ns) > 0 && kernel_ns == 0) {
+            }
+            if (kernel_ns == 0) {
+                usleep(1000);
+            }
+        }
+    }
+    ~RxTimestampsEnabled() {
+        close(receiver_);
+        close(sender_);
+    }
+
+private:
+    int receiver_ = -1;
+    int sender_ = -1;
+};
+
+} // namespace
+
+TEST(TimestampingTest, UdpReceiveAndTransmitTimestamps) {
+    RxTimestampsEnabled rx_timestamps;
+    sockaddr_in server_addr{};
+    sockaddr_in client_addr{};
+    int server = bound_udp_socket(server_addr);
+    int client = bound_udp_socket(client_addr);
+    ASSERT_TRUE(enable_timestamping(server, SocketTimestamps::Rx));
+    ASSERT_TRUE(enable_timestamping(client, SocketTimestamps::RxTx));
+
+    uint64_t before = realtime_ns();
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(sendto(client, "ping", 4, 0, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)), 4);
+    }
+
+    char buffer[16];
+    sockaddr_in from{};
+    uint64_t kernel_ns = 0;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(recv_timestamped(server, buffer, sizeof(buffer), &from, kernel_ns), 4);
+        EXPECT_EQ(from.sin_port, client_addr.sin_port);
+        EXPECT_GE(kernel_ns, before);
+        EXPECT_LE(kernel_ns, realtime_ns());
+    }
+
+    // Ключи OPT_ID - номера датаграмм с момента включения
+    std::vector<uint32_t> keys;
+    ASSERT_TRUE(wait_error_queue(client));
+    read_tx_timestamps(client, [&](uint32_t key, uint64_t sent_ns) {
+        keys.push_back(key);
+        EXPECT_GE(sent_ns, before);
+    });
+    EXPECT_EQ(keys, (std::vector<uint32_t>{0, 1, 2}));
+
+    // Без отметок recv_timestamped читает данные и оставляет kernel_ns пустым
+    ASSERT_TRUE(enable_timestamping(server, SocketTimestamps::Off));
+    sendto(client, "pong", 4, 0, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr));
+    ASSERT_EQ(recv_timestamped(server, buffer, sizeof(buffer), nullptr, kernel_ns), 4);
+    EXPECT_EQ(kernel_ns, 0u);
+    close(server);
+    close(client);
+}
+
+TEST(TimestampingTest, TcpConnectionFillsLatencyHistograms) {
+    RxTimestampsEnabled rx_timestamps;
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    socklen_t len = sizeof(addr);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len);
+    listen(listener, 1);
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    int fd = accept(listener, nullptr, nullptr);
+    ASSERT_NE(fd, -1);
+    ASSERT_TRUE(enable_timestamping(fd, SocketTimestamps::RxTx));
+
+    SessionManager sessions;
+    TcpSettings settings;
+    settings.timestamps = SocketTimestamps::RxTx;
+    settings.on_message = [](TcpConnection& connection, std::string_view message) {
+        connection.send(std::string(message) + "\n");
+    };
+    TcpConnection connection(fd, addr, &sessions, &settings);
+
+    ASSERT_EQ(write(client, "ping\n", 5), 5);
+    pollfd pfd{fd, POLLIN, 0};
+    ASSERT_EQ(poll(&pfd, 1, 1000), 1);
+    connection.handle_read();
+    char reply[16];
+    ASSERT_EQ(read(client, reply, sizeof(reply)), 5);
+
+    const PacketLatency& latency = sessions.packet_latency();
+    EXPECT_EQ(latency.socket_queue[static_cast<size_t>(Protocol::Tcp)].count(), 1u);
+    EXPECT_EQ(latency.processing[static_cast<size_t>(Protocol::Tcp)].count(), 1u);
+    ASSERT_TRUE(wait_error_queue(fd));
+    connection.handle_error_queue();
+    EXPECT_EQ(latency.tx[static_cast<size_t>(Protocol::Tcp)].count(), 1u);
+
+    connection.close();
+    close(client);
+    close(listener);
+}
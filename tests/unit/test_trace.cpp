@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "../../server/trace.hpp"
+
+TEST(TraceRingTest, DisabledRingRecordsNothing) {
+    TraceRing ring;
+    EXPECT_FALSE(ring.enabled());
+    ring.record(TraceType::Read, 5, 10);
+    EXPECT_EQ(ring.recorded(), 0u);
+    EXPECT_TRUE(ring.snapshot().empty());
+}
+
+TEST(TraceRingTest, KeepsLatestEventsInOrder) {
+    TraceRing ring(3);
+    ASSERT_EQ(ring.capacity(), 4u);
+
+    for (int i = 0; i < 10; ++i) {
+        ring.record(TraceType::Send, i, static_cast<uint64_t>(i) * 100);
+    }
+
+    // Самый старый слот заполненного кольца отбрасывается: его может
+    // перезаписывать следующая запись
+    auto events = ring.snapshot();
+    ASSERT_EQ(events.size(), 3u);
+    for (size_t i = 0; i < events.size(); ++i) {
+        EXPECT_EQ(events[i].type, TraceType::Send);
+        EXPECT_EQ(events[i].fd, static_cast<int32_t>(7 + i));
+        EXPECT_EQ(events[i].bytes, (7 + i) * 100);
+    }
+    EXPECT_EQ(ring.recorded(), 10u);
+}
+
+TEST(TraceRingTest, WritesChromeTrace) {
+    TraceRing ring(16);
+    ring.record(TraceType::Accept, 7, 0);
+    uint64_t start = trace_clock();
+    ring.record(TraceType::Dispatch, 7, 6, start, 1000);
+    ring.record(TraceType::Loop, -1, 3, start, 2000);
+
+    std::ostringstream out;
+    EXPECT_EQ(write_chrome_trace(out, {&ring}, 42), 3u);
+    std::string json = out.str();
+
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(json.find("\"name\":\"accept\",\"pid\":42,\"tid\":0"), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"i\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"dispatch\""), std::string::npos);
+    EXPECT_NE(json.find("\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"fd\":7,\"bytes\":6}"), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"events\":3}"), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+}
+
+TEST(TraceRingTest, CurrentRingIsThreadLocal) {
+    TraceRing ring(8);
+    TraceRing::set_current(&ring);
+    SERVER_TRACE(read, TraceType::Read, 3, 42);
+    TraceRing::set_current(nullptr);
+    SERVER_TRACE(read, TraceType::Read, 4, 1);
+
+    auto events = ring.snapshot();
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].fd, 3);
+    EXPECT_EQ(events[0].bytes, 42u);
+}
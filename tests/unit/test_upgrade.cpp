@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../server/upgrade.hpp"
+
+namespace {
+
+int listening_socket(int type) {
+    int fd = socket(AF_INET, type, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    if (type == SOCK_STREAM) {
+        listen(fd, 1);
+    }
+    return fd;
+}
+
+int socket_type(int fd) {
+    int type = -1;
+    socklen_t len = sizeof(type);
+    getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len);
+    return type;
+}
+
+std::string self_path() {
+    char path[4096];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    return n > 0 ? std::string(path, static_cast<size_t>(n)) : std::string();
+}
+
+// Как цикл событий сервера: ждём данных в канале и читаем статус
+UpgradeChannel::Status wait_status(UpgradeChannel& channel, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    UpgradeChannel::Status status = UpgradeChannel::Status::Pending;
+    while (status == UpgradeChannel::Status::Pending && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{channel.get_fd(), POLLIN, 0};
+        if (poll(&pfd, 1, 10) == 1) {
+            status = channel.handle_read();
+        }
+    }
+    return status;
+}
+
+// Статус процесса забирает reap_failed из цикла событий, а не сам тест
+bool reaped(UpgradeChannel& channel, pid_t pid) {
+    for (int i = 0; i < 500; ++i) {
+        channel.reap_failed();
+        if (kill(pid, 0) == -1 && errno == ESRCH) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+class UpgradeChannelTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sockets.tcp_fd = listening_socket(SOCK_STREAM);
+        sockets.udp_fd = listening_socket(SOCK_DGRAM);
+    }
+
+    void TearDown() override {
+        close(sockets.tcp_fd);
+        close(sockets.udp_fd);
+    }
+
+    // Дочерний процесс - оболочка со сценарием; канал у неё на fd 3
+    bool spawn_shell(const std::string& script) {
+        std::string error;
+        bool spawned = channel.spawn({"/bin/sh", "-c", script}, sockets, error);
+        EXPECT_TRUE(spawned) << error;
+        return spawned;
+    }
+
+    ListenSockets sockets;
+    UpgradeChannel channel;
+};
+
+} // namespace
+
+TEST_F(UpgradeChannelTest, ChildInheritsSocketsAndReportsReady) {
+    // Новый процесс - этот же бинарник, запускающий только дочерний тест ниже
+    std::string error;
+    ASSERT_TRUE(channel.spawn({self_path(), "--gtest_filter=UpgradeChildTest.InheritsSockets", "--gtest_brief=1"},
+                              sockets, error)) << error;
+    pid_t child = channel.child_pid();
+    EXPECT_EQ(wait_status(channel, 5000), UpgradeChannel::Status::Ready);
+    EXPECT_EQ(channel.get_fd(), -1);
+
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+TEST(UpgradeChildTest, InheritsSockets) {
+    if (!UpgradeChannel::requested()) {
+        GTEST_SKIP() << "runs in the process started by ChildInheritsSocketsAndReportsReady";
+    }
+    UpgradeChannel channel;
+    ListenSockets sockets;
+    std::string error;
+    ASSERT_TRUE(channel.inherit(sockets, error)) << error;
+    EXPECT_FALSE(UpgradeChannel::requested());
+    EXPECT_EQ(socket_type(sockets.tcp_fd), SOCK_STREAM);
+    EXPECT_EQ(socket_type(sockets.udp_fd), SOCK_DGRAM);
+    EXPECT_EQ(sockets.admin_fd, -1);
+    // Без готовности родитель увидит EOF и сочтёт обновление неудачным
+    if (!HasFailure()) {
+        channel.notify_ready();
+    }
+}
+
+TEST_F(UpgradeChannelTest, UnexpectedReplyFails) {
+    ASSERT_TRUE(spawn_shell("printf X >&3"));
+    pid_t child = channel.child_pid();
+    EXPECT_EQ(wait_status(channel, 5000), UpgradeChannel::Status::Failed);
+    EXPECT_EQ(channel.get_fd(), -1);
+    EXPECT_TRUE(reaped(channel, child));
+}
+
+TEST_F(UpgradeChannelTest, ExitBeforeReadyFails) {
+    ASSERT_TRUE(spawn_shell("exit 3"));
+    pid_t child = channel.child_pid();
+    EXPECT_EQ(wait_status(channel, 5000), UpgradeChannel::Status::Failed);
+    EXPECT_TRUE(reaped(channel, child));
+
+    // Несуществующий бинарник: exec не удался, дочерний процесс вышел с 127
+    std::string error;
+    ASSERT_TRUE(channel.spawn({"/nonexistent/async_tcp_udp_server"}, sockets, error)) << error;
+    child = channel.child_pid();
+    EXPECT_EQ(wait_status(channel, 5000), UpgradeChannel::Status::Failed);
+    EXPECT_TRUE(reaped(channel, child));
+}
+
+TEST_F(UpgradeChannelTest, AbortKillsHungChild) {
+    ASSERT_TRUE(spawn_shell("exec sleep 30"));
+    pid_t child = channel.child_pid();
+    EXPECT_EQ(wait_status(channel, 50), UpgradeChannel::Status::Pending);
+    ASSERT_NE(channel.get_fd(), -1);
+
+    channel.abort();
+    EXPECT_EQ(channel.get_fd(), -1);
+    EXPECT_TRUE(reaped(channel, child));
+}
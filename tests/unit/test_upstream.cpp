@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../../server/upstream.hpp"
+#include "tcp_connection_pair.hpp"
+
+namespace {
+
+// Построчный бэкенд в том же цикле: отвечает "echo:<строка>", в режиме
+// silent только принимает запросы
+class Backend {
+public:
+    explicit Backend(EventLoop& loop, uint16_t port = 0) : loop_(loop) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(listen_fd_, 16);
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        loop_.add_fd(listen_fd_, EPOLLIN, [this](uint32_t) { accept_client(); });
+    }
+
+    ~Backend() {
+        close_clients();
+        loop_.remove_fd(listen_fd_);
+        close(listen_fd_);
+    }
+
+    std::string address() const { return "127.0.0.1:" + std::to_string(port_); }
+    uint16_t port() const { return port_; }
+
+    void close_clients() {
+        for (int fd : clients_) {
+            loop_.remove_fd(fd);
+            close(fd);
+        }
+        clients_.clear();
+    }
+
+    bool silent = false;
+    size_t received = 0;
+
+private:
+    void accept_client() {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK);
+        if (fd == -1) return;
+        clients_.push_back(fd);
+        loop_.add_fd(fd, EPOLLIN, [this, fd](uint32_t) { read_client(fd); });
+    }
+
+    void read_client(int fd) {
+        char buffer[4096];
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return;
+        std::string reply;
+        for (ssize_t i = 0; i < n; ++i) {
+            if (buffer[i] == '\n') {
+                ++received;
+                reply += "echo:" + line_ + "\n";
+                line_.clear();
+            } else {
+                line_.push_back(buffer[i]);
+            }
+        }
+        if (!silent) {
+            send(fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+        }
+    }
+
+    EventLoop& loop_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::vector<int> clients_;
+    std::string line_;
+};
+
+class UpstreamPoolTest : public ::testing::Test {
+protected:
+    std::unique_ptr<UpstreamPool> make_pool(UpstreamPool::Options options = {}) {
+        return std::make_unique<UpstreamPool>(loop, options,
+            [this](const ResponseTarget& target, std::string_view response) {
+                responses.push_back(std::to_string(target.fd) + " " + std::string(response));
+            });
+    }
+
+    template <typename Predicate>
+    bool pump(UpstreamPool& pool, Predicate done) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!done()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            loop.run(10);
+            pool.poll();
+        }
+        return true;
+    }
+
+    static ResponseTarget client(int id) {
+        return ResponseTarget{ResponseTarget::Kind::Tcp, id, static_cast<uint64_t>(id), {}};
+    }
+
+    EventLoop loop;
+    std::vector<std::string> responses;
+};
+
+} // namespace
+
+TEST_F(UpstreamPoolTest, ParsesAddresses) {
+    sockaddr_in addr{};
+    EXPECT_TRUE(UpstreamPool::parse_address("127.0.0.1:8080", addr));
+    EXPECT_EQ(ntohs(addr.sin_port), 8080);
+    EXPECT_TRUE(UpstreamPool::parse_address("localhost:1", addr));
+    EXPECT_FALSE(UpstreamPool::parse_address("127.0.0.1", addr));
+    EXPECT_FALSE(UpstreamPool::parse_address("127.0.0.1:0", addr));
+    EXPECT_FALSE(UpstreamPool::parse_address("127.0.0.1:80x", addr));
+    EXPECT_FALSE(UpstreamPool::parse_address("example.com:80", addr));
+}
+
+TEST_F(UpstreamPoolTest, MatchesPipelinedResponsesToRequests) {
+    Backend backend(loop);
+    auto pool = make_pool();
+    ASSERT_TRUE(pool->add_upstream(backend.address()));
+    pool->start();
+    ASSERT_TRUE(pump(*pool, [&] { return pool->stats()[0].healthy; }));
+
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_EQ(pool->forward("req" + std::to_string(i), client(i)), UpstreamPool::Result::Ok);
+    }
+    ASSERT_TRUE(pump(*pool, [&] { return responses.size() == 50; }));
+    // Порядок сохраняется в пределах соединения, между соединениями - нет
+    std::sort(responses.begin(), responses.end());
+    std::vector<std::string> expected;
+    for (int i = 0; i < 50; ++i) {
+        expected.push_back(std::to_string(i) + " echo:req" + std::to_string(i));
+    }
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(responses, expected);
+    UpstreamStats stats = pool->stats()[0];
+    EXPECT_EQ(stats.requests, 50u);
+    EXPECT_EQ(stats.outstanding, 0u);
+    EXPECT_EQ(stats.connections, 2u);
+}
+
+TEST_F(UpstreamPoolTest, PrefersLeastLoadedUpstream) {
+    Backend stuck(loop);
+    Backend fast(loop);
+    stuck.silent = true;
+    auto pool = make_pool();
+    ASSERT_TRUE(pool->add_upstream(stuck.address()));
+    ASSERT_TRUE(pool->add_upstream(fast.address()));
+    pool->start();
+    ASSERT_TRUE(pump(*pool, [&] { return pool->stats()[0].healthy && pool->stats()[1].healthy; }));
+
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(pool->forward("x", client(i)), UpstreamPool::Result::Ok);
+        size_t expected = responses.size() + 1;
+        if (pool->stats()[1].outstanding > 0) {
+            ASSERT_TRUE(pump(*pool, [&] { return responses.size() == expected; }));
+        }
+    }
+    auto stats = pool->stats();
+    EXPECT_EQ(stats[0].requests, 1u);
+    EXPECT_EQ(stats[1].requests, 19u);
+}
+
+TEST_F(UpstreamPoolTest, FailsPendingRequestsAndRecovers) {
+    auto backend = std::make_unique<Backend>(loop);
+    uint16_t port = backend->port();
+    UpstreamPool::Options options;
+    options.health_interval = std::chrono::milliseconds(20);
+    auto pool = make_pool(options);
+    ASSERT_TRUE(pool->add_upstream(backend->address()));
+    pool->start();
+    ASSERT_TRUE(pump(*pool, [&] { return pool->stats()[0].healthy; }));
+
+    backend->silent = true;
+    ASSERT_EQ(pool->forward("a", client(1)), UpstreamPool::Result::Ok);
+    ASSERT_EQ(pool->forward("b", client(2)), UpstreamPool::Result::Ok);
+    ASSERT_TRUE(pump(*pool, [&] { return backend->received == 2; }));
+    backend.reset();
+
+    ASSERT_TRUE(pump(*pool, [&] { return responses.size() == 2; }));
+    EXPECT_EQ(responses[0], "1 ERROR: Upstream connection closed");
+    EXPECT_EQ(responses[1], "2 ERROR: Upstream connection closed");
+    EXPECT_FALSE(pool->stats()[0].healthy);
+    EXPECT_EQ(pool->forward("c", client(3)), UpstreamPool::Result::NoUpstream);
+
+    backend = std::make_unique<Backend>(loop, port);
+    ASSERT_TRUE(pump(*pool, [&] { return pool->stats()[0].healthy; }));
+    ASSERT_EQ(pool->forward("d", client(4)), UpstreamPool::Result::Ok);
+    ASSERT_TRUE(pump(*pool, [&] { return responses.size() == 3; }));
+    EXPECT_EQ(responses[2], "4 echo:d");
+}
+
+TEST_F(UpstreamPoolTest, TimesOutSlowUpstreamAndLimitsPending) {
+    Backend backend(loop);
+    backend.silent = true;
+    UpstreamPool::Options options;
+    options.timeout = std::chrono::milliseconds(50);
+    options.max_pending = 2;
+    options.connections_per_upstream = 1;
+    auto pool = make_pool(options);
+    ASSERT_TRUE(pool->add_upstream(backend.address()));
+    pool->start();
+    ASSERT_TRUE(pump(*pool, [&] { return pool->stats()[0].healthy; }));
+
+    EXPECT_EQ(pool->forward("a", client(1)), UpstreamPool::Result::Ok);
+    EXPECT_EQ(pool->forward("b", client(2)), UpstreamPool::Result::Ok);
+    EXPECT_EQ(pool->forward("c", client(3)), UpstreamPool::Result::Busy);
+    ASSERT_TRUE(pump(*pool, [&] { return responses.size() == 2; }));
+    EXPECT_EQ(responses[0], "1 ERROR: Upstream timeout");
+    EXPECT_EQ(pool->stats()[0].outstanding, 0u);
+}
+
+class DeferredReplyTest : public TcpConnectionPairTest {
+protected:
+    void SetUp() override {
+        TcpConnectionPairTest::SetUp();
+        open();
+    }
+};
+
+TEST_F(DeferredReplyTest, LocalRepliesWaitForEarlierUpstreamReplies) {
+    std::string received;
+    connection->send("first\n");
+    uint64_t slow = connection->defer_reply();
+    connection->send("local\n");
+    uint64_t fast = connection->defer_reply();
+    connection->send("last\n");
+    drain_peer(&received);
+    EXPECT_EQ(received, "first\n");
+    EXPECT_EQ(connection->deferred_replies(), 4u);
+
+    // Второй бэкенд ответил раньше первого: его ответ тоже ждёт
+    connection->complete_reply(fast, "upstream fast\n");
+    drain_peer(&received);
+    EXPECT_EQ(received, "first\n");
+
+    connection->complete_reply(slow, "upstream slow\n");
+    drain_peer(&received);
+    EXPECT_EQ(received, "first\nupstream slow\nlocal\nupstream fast\nlast\n");
+    EXPECT_EQ(connection->deferred_replies(), 0u);
+
+    // Без отложенных ответов send пишет сразу, повторное завершение не доходит
+    connection->complete_reply(slow, "late\n");
+    connection->send("after\n");
+    received.clear();
+    drain_peer(&received);
+    EXPECT_EQ(received, "after\n");
+}
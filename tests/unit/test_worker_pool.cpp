@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../../server/session_manager.hpp"
+#include "../../server/worker_pool.hpp"
+
+namespace {
+
+template <typename Predicate>
+bool wait_for(Predicate predicate) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Рабочие реакторы без обработчиков: соединение только попадает в таблицу
+class WorkerPoolTest : public ::testing::Test {
+protected:
+    void start(size_t workers, PlacementPolicy policy) {
+        WorkerPool::Options options;
+        options.workers = workers;
+        options.policy = policy;
+        pool_ = std::make_unique<WorkerPool>(options, sessions_);
+        std::string error;
+        ASSERT_TRUE(pool_->start([](Worker&) {}, error)) << error;
+    }
+
+    // Отдаёт пулу один конец socketpair, второй остаётся у теста
+    void connect() {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+        peers_.push_back(fds[1]);
+        ASSERT_TRUE(pool_->dispatch(fds[0], sockaddr_in{}));
+    }
+
+    bool wait_connections(std::vector<size_t> expected) {
+        return wait_for([&] {
+            for (size_t i = 0; i < expected.size(); ++i) {
+                if (pool_->worker(i).connections() != expected[i]) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    void TearDown() override {
+        pool_.reset();
+        for (int fd : peers_) {
+            close(fd);
+        }
+    }
+
+    std::shared_ptr<SessionManager> sessions_ = std::make_shared<SessionManager>();
+    std::unique_ptr<WorkerPool> pool_;
+    std::vector<int> peers_;
+};
+
+} // namespace
+
+TEST(HandoffQueueTest, KeepsOrderAndRejectsWhenFull) {
+    auto queue = std::make_unique<HandoffQueue>();
+    HandoffQueue::Item item{};
+    EXPECT_FALSE(queue->pop(item));
+    for (size_t i = 0; i < HandoffQueue::CAPACITY; ++i) {
+        ASSERT_TRUE(queue->push({static_cast<int>(i), {}}));
+    }
+    EXPECT_FALSE(queue->push({-1, {}}));
+    EXPECT_EQ(queue->size(), HandoffQueue::CAPACITY);
+    for (size_t i = 0; i < HandoffQueue::CAPACITY; ++i) {
+        ASSERT_TRUE(queue->pop(item));
+        EXPECT_EQ(item.fd, static_cast<int>(i));
+    }
+    EXPECT_EQ(queue->size(), 0u);
+}
+
+TEST(EventLoopPostTest, RunsTasksOnLoopThread) {
+    EventLoop loop;
+    std::atomic<bool> running{true};
+    std::thread::id loop_thread;
+    std::thread thread([&] {
+        loop_thread = std::this_thread::get_id();
+        while (running) {
+            loop.run(1000);
+        }
+    });
+    std::atomic<int> done{0};
+    std::thread::id task_thread;
+    loop.post([&] {
+        task_thread = std::this_thread::get_id();
+        ++done;
+    });
+    // post будит epoll_wait: задача не ждёт таймаута цикла
+    EXPECT_TRUE(wait_for([&] { return done == 1; }));
+    running = false;
+    loop.wake();
+    thread.join();
+    EXPECT_EQ(task_thread, loop_thread);
+}
+
+TEST_F(WorkerPoolTest, RoundRobinSpreadsConnectionsEvenly) {
+    start(3, PlacementPolicy::RoundRobin);
+    for (int i = 0; i < 6; ++i) {
+        connect();
+    }
+    EXPECT_TRUE(wait_connections({2, 2, 2}));
+    EXPECT_EQ(pool_->connections(), 6u);
+    EXPECT_EQ(pool_->worker(1).stats().accepted, 2u);
+}
+
+TEST_F(WorkerPoolTest, LeastConnectionsFillsTheEmptiestWorker) {
+    start(2, PlacementPolicy::RoundRobin);
+    connect();
+    connect();
+    connect();
+    ASSERT_TRUE(wait_connections({2, 1}));
+
+    pool_->set_policy(PlacementPolicy::LeastConnections);
+    connect();
+    ASSERT_TRUE(wait_connections({2, 2}));
+    connect();
+    connect();
+    EXPECT_TRUE(wait_connections({3, 3}));
+}
+
+TEST_F(WorkerPoolTest, StopClosesAdoptedConnections) {
+    start(2, PlacementPolicy::LeastLoaded);
+    connect();
+    connect();
+    ASSERT_TRUE(wait_for([&] { return pool_->connections() == 2; }));
+    pool_->stop();
+    EXPECT_EQ(pool_->connections(), 0u);
+    EXPECT_EQ(sessions_->get_stats().current_connections, 0u);
+    char byte;
+    EXPECT_EQ(read(peers_[0], &byte, 1), 0);
+}
@@ -0,0 +1,112 @@
+#include "journal.hpp"
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+void print_usage() {
+    std::cout << "Usage: journal_replay [--raw] [--tcp|--udp] [--since <unix_ns>] <dir|segment>..." << std::endl;
+    std::cout << "Arguments:" << std::endl;
+    std::cout << "  dir       - journal_dir of the server, all segments in order" << std::endl;
+    std::cout << "  segment   - single journal-<index>.seg file" << std::endl;
+    std::cout << "  --raw     - print payloads only, one per line (pipe into nc to replay)" << std::endl;
+    std::cout << "  --tcp, --udp - only messages received over that protocol" << std::endl;
+    std::cout << "  --since <unix_ns> - skip messages received before the timestamp" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Examples:" << std::endl;
+    std::cout << "  journal_replay /var/lib/async-tcp-udp-server/journal" << std::endl;
+    std::cout << "  journal_replay --raw --tcp journal/ | nc 127.0.0.1 8080" << std::endl;
+}
+
+std::string format_time(uint64_t ns) {
+    time_t seconds = static_cast<time_t>(ns / 1000000000ull);
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char buffer[40];
+    size_t len = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+    std::snprintf(buffer + len, sizeof(buffer) - len, ".%06lluZ",
+                  static_cast<unsigned long long>(ns % 1000000000ull / 1000));
+    return buffer;
+}
+
+int main(int argc, char* argv[]) {
+    bool raw = false;
+    int protocol = -1;
+    uint64_t since = 0;
+    std::vector<std::string> segments;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--raw") {
+            raw = true;
+        } else if (arg == "--tcp") {
+            protocol = 0;
+        } else if (arg == "--udp") {
+            protocol = 1;
+        } else if (arg == "--since" && i + 1 < argc) {
+            try {
+                since = std::stoull(argv[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid timestamp" << std::endl;
+                return 1;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage();
+            return 0;
+        } else {
+            struct stat st{};
+            if (stat(arg.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                auto found = Journal::list_segments(arg);
+                segments.insert(segments.end(), found.begin(), found.end());
+            } else {
+                segments.push_back(arg);
+            }
+        }
+    }
+
+    if (segments.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    int status = 0;
+    for (const auto& path : segments) {
+        JournalReader reader;
+        std::string error;
+        if (!reader.open(path, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            status = 1;
+            continue;
+        }
+
+        JournalRecord record;
+        while (reader.next(record)) {
+            if (record.timestamp_ns < since || (protocol >= 0 && record.protocol != protocol)) {
+                continue;
+            }
+            if (raw) {
+                std::cout << record.payload << '\n';
+                continue;
+            }
+            char ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &record.peer.sin_addr, ip, sizeof(ip));
+            std::cout << format_time(record.timestamp_ns) << ' '
+                      << (record.protocol == 0 ? "tcp" : "udp") << ' '
+                      << ip << ':' << ntohs(record.peer.sin_port) << ' '
+                      << record.payload << '\n';
+        }
+        // Обрыв после committed - недописанный хвост после падения, до него - порча
+        if (reader.corrupt() && reader.offset() < reader.header().committed) {
+            std::cerr << "Warning: " << path << ": damaged record at offset " << reader.offset()
+                      << ", rest of segment skipped" << std::endl;
+            status = 1;
+        } else if (reader.corrupt()) {
+            std::cerr << "Note: " << path << ": incomplete record after the last commit" << std::endl;
+        }
+    }
+    return status;
+}
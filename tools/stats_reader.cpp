@@ -0,0 +1,116 @@
+#include "stats_segment.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+
+void print_usage() {
+    std::cout << "Usage: stats_reader [--json] [--interval <ms>] <port|shm_name>" << std::endl;
+    std::cout << "Arguments:" << std::endl;
+    std::cout << "  port      - port of a local server, segment /async_tcp_udp_server.<port>" << std::endl;
+    std::cout << "  shm_name  - explicit segment name (STATS_SHM of the server)" << std::endl;
+    std::cout << "  --json    - print one JSON object per snapshot" << std::endl;
+    std::cout << "  --interval <ms> - keep polling with the given period (0 - single snapshot)" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Examples:" << std::endl;
+    std::cout << "  stats_reader 8080" << std::endl;
+    std::cout << "  stats_reader --json --interval 100 8080" << std::endl;
+}
+
+// Число целиком из цифр в пределах [min, max]; иначе - ошибка использования
+bool parse_number(const std::string& text, long min, long max, long& value) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size() && value >= min && value <= max;
+}
+
+void print_snapshot(const StatsValues& values, size_t field_count, uint32_t pid, bool json) {
+    if (json) {
+        std::cout << "{\"pid\":" << pid;
+        for (size_t i = 0; i < field_count; ++i) {
+            std::cout << ",\"" << STATS_FIELD_NAMES[i] << "\":" << values[i];
+        }
+        std::cout << "}" << std::endl;
+        return;
+    }
+
+    std::cout << "pid: " << pid << std::endl;
+    for (size_t i = 0; i < field_count; ++i) {
+        std::cout << STATS_FIELD_NAMES[i] << ": " << values[i] << std::endl;
+    }
+    auto start = values[static_cast<size_t>(StatsField::StartTimeNs)];
+    auto published = values[static_cast<size_t>(StatsField::PublishTimeNs)];
+    if (published >= start) {
+        std::cout << "uptime_seconds: " << (published - start) / 1000000000ull << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    long interval_ms = 0;
+    std::string target;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--interval" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 0, 3600000, interval_ms)) {
+                std::cerr << "Error: Invalid interval (expected 0..3600000 ms)" << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage();
+            return 0;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Error: Unknown option or missing value: " << arg << std::endl;
+            print_usage();
+            return 1;
+        } else {
+            target = arg;
+        }
+    }
+
+    if (target.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    std::string name = target;
+    if (target.find_first_not_of("0123456789") == std::string::npos) {
+        long port = 0;
+        if (!parse_number(target, 1, 65535, port)) {
+            std::cerr << "Error: Invalid port number" << std::endl;
+            print_usage();
+            return 1;
+        }
+        name = StatsSegment::default_name(static_cast<uint16_t>(port));
+    }
+
+    StatsSegmentReader reader;
+    std::string error;
+    if (!reader.open(name, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    while (true) {
+        StatsValues values{};
+        size_t field_count = 0;
+        if (!reader.read(values, field_count)) {
+            std::cerr << "Error: could not get a consistent snapshot" << std::endl;
+            return 1;
+        }
+        print_snapshot(values, field_count, reader.pid(), json);
+
+        if (interval_ms <= 0) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+
+    return 0;
+}